@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+/**
+ * @brief Debug check that a loop performs no heap allocations once warmed up.
+ *
+ * When the program is compiled with -DSCOP_ALLOC_GUARD (see `make
+ * alloc-guard`), the global operator new/delete are replaced by versions that
+ * count allocations per thread. beginFrame()/endFrame() bracket one
+ * iteration of the calling thread's loop; any allocation inside a frame past
+ * the warm-up period is reported and marks the run as failed. Without the
+ * flag every method is a cheap no-op and failed() is always false.
+ */
+class AllocationGuard {
+public:
+  /**
+   * @param warmupFrames Frames allowed to allocate (caches, first-use
+   * statics, driver setup) before the check starts.
+   */
+  explicit AllocationGuard(size_t warmupFrames = 120);
+
+  /**
+   * @brief true if the allocation counting hooks are compiled in.
+   */
+  static bool enabled();
+
+  /**
+   * @brief Number of operator new calls made by the calling thread so far
+   * (always 0 when disabled).
+   */
+  static size_t threadAllocationCount();
+
+  void beginFrame();
+  void endFrame();
+
+  bool failed() const { return violatingFrames_ > 0; }
+  size_t frameCount() const { return frames_; }
+
+  /**
+   * @brief Prints checked frames, offending frames and the worst frame.
+   */
+  void printSummary(std::ostream &out) const;
+
+private:
+  static constexpr size_t kMaxReports = 5; ///< Offending frames logged.
+
+  size_t warmupFrames_;
+  size_t frames_ = 0;
+  size_t frameStartCount_ = 0;
+  size_t violatingFrames_ = 0;
+  size_t worstFrameAllocations_ = 0;
+};
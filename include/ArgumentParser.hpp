@@ -1,14 +1,17 @@
 #pragma once
 
-#include "OBJLoader.hpp"
-#include "OBJModel.hpp"
+#include "Scene.hpp"
+#include "ViewerOptions.hpp"
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 class Parser {
 private:
   bool success = false;
+  ViewerOptions options;
+  std::vector<SceneEntry> scene;
 
   /**
    * @brief Prints usage instructions for the program.
@@ -17,15 +20,24 @@ private:
    */
   void printUsage(const char *programName);
 
+  /**
+   * @brief Consumes a "--name value" option starting at argv[index].
+   *
+   * @param argc   Number of command-line arguments.
+   * @param argv   Command-line argument values.
+   * @param index  Index of the option name; advanced past its value.
+   * @return true if the option was recognized and valid, false otherwise.
+   */
+  bool parseOption(int argc, char **argv, int &index);
+
 public:
   /**
    * @brief Constructor for the Parser class.
    *
    * @param argc   Number of command-line arguments.
    * @param argv   Command-line argument values.
-   * @param model  Reference to an OBJModel to be filled on success.
    */
-  Parser(int argc, char **argv, OBJModel &model);
+  Parser(int argc, char **argv);
 
   /**
    * @brief Gets the success state of the parsing process.
@@ -35,11 +47,28 @@ public:
   bool getSuccess() const;
 
   /**
-   * @brief Parses the command-line arguments, loads the OBJ model if valid.
+   * @brief Gets the runtime options collected from the command line.
+   *
+   * @return Parsed viewer options (defaults for anything not given).
+   */
+  const ViewerOptions &getOptions() const;
+
+  /**
+   * @brief Gets the models named on the command line, loaded.
+   *
+   * @return One entry per .obj argument, in order. Repeated paths share
+   * their RenderModel.
+   */
+  const std::vector<SceneEntry> &getScene() const;
+
+  /**
+   * @brief Parses the command-line arguments and loads the OBJ models, in
+   * parallel, if valid.
+   *
+   * Each .obj path may be followed by a texture path for that model.
    *
    * @param argc   Number of command-line arguments.
    * @param argv   Command-line argument values.
-   * @param model  Reference to an OBJModel to be filled on success.
    */
-  void parseArguments(int argc, char **argv, OBJModel &model);
+  void parseArguments(int argc, char **argv);
 };
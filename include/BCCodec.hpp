@@ -0,0 +1,63 @@
+#pragma once
+
+#include "DecodedImage.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief S3TC block formats (4x4 texel blocks).
+ */
+enum class BlockFormat {
+  BC1,  ///< DXT1, opaque RGB, 8 bytes per block.
+  BC1A, ///< DXT1 with 1-bit punch-through alpha.
+  BC2,  ///< DXT3, explicit 4-bit alpha, 16 bytes per block.
+  BC3   ///< DXT5, interpolated alpha, 16 bytes per block.
+};
+
+/**
+ * @brief BC1/BC3 encoder and BC1/BC2/BC3 decoder.
+ *
+ * The encoder is a bounding-box range fit: endpoints are the inset per-channel
+ * min/max of each block and texels are assigned by projecting onto the
+ * endpoint axis. The bounding box and projections run on SSE2 (bit-identical
+ * to the scalar kernel) and block rows are split across threads. The decoder
+ * exists for the no-S3TC fallback and for quality checks.
+ */
+class BCCodec {
+public:
+  /**
+   * @brief Bytes per 4x4 block (8 for BC1, 16 for BC2/BC3).
+   */
+  static size_t blockBytes(BlockFormat format);
+
+  /**
+   * @brief Size of a width x height level, partial blocks rounded up.
+   */
+  static size_t encodedSize(BlockFormat format, int width, int height);
+
+  /**
+   * @brief true if every texel of an RGBA image is fully opaque (always true
+   * for RGB).
+   */
+  static bool isOpaque(const DecodedImage &image);
+
+  /**
+   * @brief Compresses an RGB or RGBA image to BC1 or BC3. Edge blocks repeat
+   * the last row/column.
+   * @param useSimd false forces the scalar kernel (for benchmarks).
+   */
+  static void encode(const DecodedImage &image, BlockFormat format,
+                     std::vector<unsigned char> &out, bool useSimd = true);
+
+  /**
+   * @brief Expands compressed blocks to an RGBA image.
+   * @return false if `size` is too small for the dimensions.
+   */
+  static bool decode(const unsigned char *data, size_t size,
+                     BlockFormat format, int width, int height,
+                     DecodedImage &out);
+
+private:
+  BCCodec() = default; // Disallow instantiation
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DecodedImage.hpp"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Decoder for uncompressed 24-bit and 32-bit BMP files.
+ *
+ * The file is memory-mapped and each row is swizzled from BGR(A) to RGB(A)
+ * straight into the output buffer, using AVX2 or SSSE3 byte shuffles when the
+ * CPU supports them and splitting large images into row bands decoded in
+ * parallel. Bottom-up and top-down files both produce top-row-first output.
+ */
+class BMPDecoder {
+public:
+  /**
+   * @brief Maps and decodes a BMP file.
+   * @param filePath Path to the .bmp file.
+   * @param out Receives the decoded image.
+   * @return false (with a message on std::cerr) if the file is unreadable or
+   * uses an unsupported format.
+   */
+  static bool load(const std::string &filePath, DecodedImage &out);
+
+  /**
+   * @brief Decodes a BMP already in memory.
+   * @param data File contents.
+   * @param size Size of data in bytes.
+   * @param out Receives the decoded image.
+   * @param useSimd false forces the scalar row kernels (for benchmarks).
+   */
+  static bool decode(const unsigned char *data, size_t size, DecodedImage &out,
+                     bool useSimd = true);
+
+  /**
+   * @brief Name of the row kernels decode() uses on this CPU.
+   */
+  static const char *simdPathName();
+
+private:
+  BMPDecoder() = default; // Disallow instantiation
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "OBJModel.hpp"
+#include "Vector3.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Result of a ray query against a BVH.
+ */
+struct RayHit {
+  bool hit = false;
+  float distance = 0.0f; ///< Ray parameter t of the hit (origin + t * dir).
+  size_t faceIndex = 0;  ///< Index into OBJModel::faces.
+  float u = 0.0f;        ///< Barycentric coordinates within the triangle.
+  float v = 0.0f;
+};
+
+/**
+ * @brief Bounding volume hierarchy over the triangles of an OBJModel, built
+ * with binned SAH splits. Polygons are fan-triangulated; every triangle keeps
+ * the index of the face it came from.
+ *
+ * The top levels are built on several threads; nodes are stored depth-first
+ * so a node's left child immediately follows it.
+ */
+class BVH {
+public:
+  BVH() = default;
+
+  /**
+   * @brief Builds the hierarchy for a model, replacing any previous one.
+   */
+  void build(const OBJModel &model);
+
+  /**
+   * @brief Adds the faces of `model` from `firstFace` on, which were
+   * appended after the hierarchy was built: they get a subtree of their own
+   * under a new root. Falls back to build() after kMaxAppendedTrees appends
+   * or once the model has doubled since the last build.
+   */
+  void append(const OBJModel &model, size_t firstFace);
+
+  /**
+   * @brief Finds the nearest triangle hit by the ray, if any.
+   * @param origin Ray origin (object space).
+   * @param direction Ray direction (object space, need not be normalized).
+   * @param acceptFace If set, triangles of faces it rejects are ignored
+   * (e.g. hidden submeshes).
+   */
+  RayHit intersect(const Vector3 &origin, const Vector3 &direction,
+                   const std::function<bool(size_t)> &acceptFace = {}) const;
+
+  bool empty() const { return nodes_.empty(); }
+  size_t triangleCount() const { return triangles_.size(); }
+  size_t nodeCount() const { return nodes_.size(); }
+  size_t memoryBytes() const {
+    return triangles_.capacity() * sizeof(Triangle) +
+           nodes_.capacity() * sizeof(Node);
+  }
+
+private:
+  static constexpr size_t kMaxAppendedTrees = 8;
+
+  struct Triangle {
+    Vector3 v0, v1, v2;
+    uint32_t face;
+  };
+
+  struct Node {
+    float min[3];
+    float max[3];
+    uint32_t start; ///< First triangle (leaf only).
+    uint32_t count; ///< Triangle count; 0 for interior nodes.
+    uint32_t right; ///< Right child (interior only); left child is index+1.
+  };
+
+  /**
+   * @brief Recursively builds the subtree for triangles [begin, end) into
+   * `out` in depth-first order, with node indices relative to `out`.
+   */
+  void buildRange(uint32_t begin, uint32_t end, int parallelDepth,
+                  std::vector<Node> &out);
+
+  /**
+   * @brief Appends the triangles and centroids of the faces from
+   * `firstFace` on.
+   */
+  void addTriangles(const OBJModel &model, size_t firstFace);
+
+  /**
+   * @brief Levels of the build that fork onto threads.
+   */
+  static int parallelDepth();
+
+  std::vector<Triangle> triangles_;
+  std::vector<Vector3> centroids_;
+  std::vector<Node> nodes_;
+  size_t builtTriangles_ = 0; ///< Triangles at the last build().
+  size_t appendedTrees_ = 0;  ///< append() subtrees since then.
+};
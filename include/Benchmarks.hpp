@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Built-in microbenchmarks, run with `scop --bench <suite>` without
+ * opening a window. Each suite also checks its optimized paths against the
+ * scalar reference and fails on any mismatch.
+ */
+class Benchmarks {
+public:
+  /**
+   * @brief Runs the named suite ("math", "bounds", "bmp", "mip", "bc",
+   * "hiz").
+   * @param suite Suite name.
+   * @return true if the suite exists and all checks passed.
+   */
+  static bool run(const std::string &suite);
+
+private:
+  Benchmarks() = default; // Disallow instantiation
+
+  /**
+   * @brief Matrix4 multiply / inverse / transpose and batch transforms.
+   */
+  static bool runMath();
+
+  /**
+   * @brief AABB / sphere / oriented box over a large random point cloud.
+   */
+  static bool runBounds();
+
+  /**
+   * @brief BMP decoding of the sample textures, old loader vs BMPDecoder,
+   * plus exactness checks for every supported pixel layout.
+   */
+  static bool runBmp();
+
+  /**
+   * @brief Mip chain generation for the sample textures against a per-pixel
+   * pow() reference, plus a gamma-correctness check.
+   */
+  static bool runMipmaps();
+
+  /**
+   * @brief BC1 encoding of the sample textures, scalar vs SSE2 kernels, with
+   * a PSNR floor, plus BC3 alpha and DDS round-trip checks.
+   */
+  static bool runBlockCompression();
+
+  /**
+   * @brief Occluder rasterization, scalar vs SSE2 kernels, plus pyramid
+   * build, box tests and a conservativeness check.
+   */
+  static bool runOcclusion();
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Matrix4.hpp"
+#include "OBJModel.hpp"
+#include "Vector3.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Axis-aligned bounding box. Empty boxes have min > max.
+ */
+struct AABB {
+  Vector3 min;
+  Vector3 max;
+
+  bool isEmpty() const { return min.x > max.x; }
+  Vector3 center() const { return (min + max) * 0.5f; }
+  Vector3 size() const { return max - min; }
+};
+
+/**
+ * @brief Bounding sphere.
+ */
+struct BoundingSphere {
+  Vector3 center;
+  float radius = 0.0f;
+};
+
+/**
+ * @brief Oriented bounding box: orthonormal axes plus half extents along them.
+ */
+struct OrientedBox {
+  Vector3 center;
+  Vector3 axes[3] = {Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1)};
+  Vector3 halfExtents;
+};
+
+/**
+ * @brief The six clip planes of a view volume, as (a, b, c, d) with
+ * a*x + b*y + c*z + d >= 0 inside. Order: left, right, bottom, top, near, far.
+ */
+struct Frustum {
+  float planes[6][4] = {};
+};
+
+/**
+ * @brief Bounding-volume computation over vertex arrays. Reductions are split
+ * across threads; the AABB kernel is vectorized with SSE.
+ */
+class BoundingVolumes {
+public:
+  /**
+   * @brief Computes the AABB of `count` vertices (empty box if count == 0).
+   */
+  static AABB computeAABB(const Vertex *vertices, size_t count);
+
+  /**
+   * @brief Computes a tight bounding sphere using Ritter's algorithm.
+   */
+  static BoundingSphere computeSphere(const Vertex *vertices, size_t count);
+
+  /**
+   * @brief Grows `sphere` just enough to include the vertices (the last
+   * step of computeSphere(), e.g. for vertices added to a model).
+   */
+  static void growSphere(BoundingSphere &sphere, const Vertex *vertices,
+                         size_t count);
+
+  /**
+   * @brief Computes an oriented box aligned to the principal axes of the
+   * vertex distribution (PCA of the covariance matrix).
+   */
+  static OrientedBox computeOrientedBox(const Vertex *vertices, size_t count);
+
+  /**
+   * @brief Extracts the frustum planes of a projection * view * model matrix,
+   * so the planes are in that model's object space (Gribb-Hartmann).
+   */
+  static Frustum computeFrustum(const Matrix4 &clipFromObject);
+
+  /**
+   * @brief Conservative box/frustum test: false only if the box lies fully
+   * outside one plane. Empty boxes never intersect.
+   */
+  static bool intersects(const Frustum &frustum, const AABB &box);
+
+private:
+  BoundingVolumes() = default; // Disallow instantiation
+};
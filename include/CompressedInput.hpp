@@ -0,0 +1,127 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "MemoryTracker.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Line reader over a gzip (.gz) or zstd (.zst) compressed file.
+ *
+ * A worker thread inflates the memory-mapped file into a ring of
+ * kBufferCount buffers while the caller consumes lines from the filled
+ * ones, so decompression overlaps parsing and the uncompressed text is
+ * never written to disk. zstd input needs <zstd.h> at build time.
+ */
+class CompressedInput {
+public:
+  static constexpr size_t kBufferSize = 1 << 20;
+  static constexpr size_t kBufferCount = 4;
+
+  /**
+   * @brief true if the path ends in .gz or .zst (any case).
+   */
+  static bool isCompressedPath(const std::string &filePath);
+
+  /**
+   * @brief The path without its .gz or .zst extension ("a.obj.gz" ->
+   * "a.obj"); other paths are returned unchanged.
+   */
+  static std::string uncompressedPath(const std::string &filePath);
+
+  CompressedInput() = default;
+
+  /**
+   * @brief Stops the worker, even if not all lines were read.
+   */
+  ~CompressedInput();
+
+  CompressedInput(const CompressedInput &) = delete;
+  CompressedInput &operator=(const CompressedInput &) = delete;
+
+  /**
+   * @brief Maps `filePath`, recognizes gzip or zstd from its magic bytes and
+   * starts decompressing.
+   * @return false (with a message on std::cerr) if the file can't be mapped
+   * or its format is not supported.
+   */
+  bool open(const std::string &filePath);
+
+  /**
+   * @brief Reads the next line, without its '\n', like std::getline.
+   * @return false at the end of the data or on a decompression error.
+   */
+  bool getline(std::string &line);
+
+  /**
+   * @brief true if decompression stopped on corrupt or truncated data.
+   */
+  bool failed() const;
+
+  /**
+   * @brief Prints the sizes and the throughput of both stages: the
+   * decompressor's busy time and the caller's time spent on the lines,
+   * along with how long each stage waited for the other. Call after
+   * getline() returned false.
+   */
+  void printReport(std::ostream &out) const;
+
+private:
+  enum class Format { GZIP, ZSTD };
+
+  struct Buffer {
+    std::vector<char> data;
+    size_t size = 0;
+  };
+
+  void workerLoop();
+  bool decodeGzip();
+  bool decodeZstd();
+
+  /**
+   * @brief Waits for a free ring slot. nullptr if the reader is stopping.
+   */
+  Buffer *acquireFree();
+
+  /**
+   * @brief Hands the slot from acquireFree() to the reader.
+   */
+  void publish(size_t size);
+
+  std::string path_;
+  MappedFile file_;
+  Format format_ = Format::GZIP;
+  std::vector<Buffer> ring_;
+  MemoryTracker::Allocation ringMemory_; ///< Charges ring_ to LOADER.
+
+  // Reader side
+  Buffer *current_ = nullptr; ///< Slot being read, still counted as full.
+  size_t position_ = 0;       ///< Next unread byte of current_.
+  double readerWaitMillis_ = 0.0;
+  double readerMillis_ = 0.0; ///< open() to the end of the data.
+  std::chrono::steady_clock::time_point start_;
+
+  // Shared with the worker, guarded by mutex_
+  mutable std::mutex mutex_;
+  std::condition_variable filled_;
+  std::condition_variable drained_;
+  size_t produced_ = 0; ///< Slots published so far.
+  size_t consumed_ = 0; ///< Slots the reader finished.
+  bool finished_ = false;
+  bool failed_ = false;
+  bool stopping_ = false;
+
+  // Worker statistics, read once finished_ is set
+  size_t outputBytes_ = 0;
+  double decodeMillis_ = 0.0;
+  double workerWaitMillis_ = 0.0;
+
+  std::thread worker_;
+};
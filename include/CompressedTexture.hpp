@@ -0,0 +1,75 @@
+#pragma once
+
+#include "BCCodec.hpp"
+#include "MappedFile.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One mip level of block-compressed data.
+ */
+struct CompressedLevel {
+  int width = 0;
+  int height = 0;
+  const unsigned char *data = nullptr; ///< Into the owning CompressedImage.
+  size_t size = 0;
+};
+
+/**
+ * @brief Block-compressed texture with its mip chain, top row first. Level
+ * data points either into a memory-mapped file (DDS/KTX passthrough) or into
+ * `storage` (encoded at runtime). Move-only.
+ */
+struct CompressedImage {
+  BlockFormat format = BlockFormat::BC1;
+  std::vector<CompressedLevel> levels;
+  MappedFile file;
+  std::vector<unsigned char> storage;
+
+  int width() const { return levels.empty() ? 0 : levels[0].width; }
+  int height() const { return levels.empty() ? 0 : levels[0].height; }
+
+  /**
+   * @brief Total bytes of all levels.
+   */
+  size_t byteSize() const;
+};
+
+/**
+ * @brief Reads DDS and KTX (1.1) containers holding BC1/BC2/BC3 data, and
+ * writes DDS for the compressed texture cache.
+ *
+ * Files are memory-mapped and levels reference the mapping directly, so
+ * loading does no decoding or copying before glCompressedTexImage2D.
+ */
+class CompressedTextureFile {
+public:
+  /**
+   * @brief true if the path has a .dds or .ktx extension.
+   */
+  static bool isContainerPath(const std::string &filePath);
+
+  /**
+   * @brief Maps and parses a DDS or KTX file.
+   * @return false (with a message on std::cerr) if the file is unreadable,
+   * truncated or not BC1/BC2/BC3.
+   */
+  static bool load(const std::string &filePath, CompressedImage &out);
+
+  /**
+   * @brief Writes `image` as a DDS file (legacy DXT1/DXT3/DXT5 header),
+   * through a temporary file renamed into place.
+   */
+  static bool writeDDS(const std::string &filePath,
+                       const CompressedImage &image);
+
+private:
+  CompressedTextureFile() = default; // Disallow instantiation
+
+  static bool parseDDS(const unsigned char *data, size_t size,
+                       CompressedImage &out);
+  static bool parseKTX(const unsigned char *data, size_t size,
+                       CompressedImage &out);
+};
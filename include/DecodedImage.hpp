@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief Tightly packed 8-bit image, top row first.
+ */
+struct DecodedImage {
+  int width = 0;
+  int height = 0;
+  int channels = 0; ///< 3 = RGB, 4 = RGBA.
+  std::vector<unsigned char> pixels;
+};
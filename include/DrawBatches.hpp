@@ -0,0 +1,117 @@
+#pragma once
+
+#include "BoundingVolumes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Consecutive triangles of DrawBatches that share one material.
+ */
+struct MaterialRange {
+  int material = -1; ///< Index into OBJModel::materials, -1 for none.
+  int submesh = 0;   ///< Index into OBJModel::submeshes.
+  size_t first = 0;  ///< First corner.
+  size_t count = 0;  ///< Number of corners (3 per triangle).
+};
+
+/**
+ * @brief Where one OBJModel::submeshes entry lives in DrawBatches.
+ */
+struct SubmeshRange {
+  size_t firstRange = 0; ///< Into DrawBatches::ranges.
+  size_t rangeCount = 0;
+  size_t firstCorner = 0;
+  size_t cornerCount = 0;
+  AABB bounds; ///< Object space; empty if the submesh has no triangles.
+};
+
+/**
+ * @brief Per-submesh draw state bits. A submesh is drawn when none are set.
+ */
+namespace SubmeshState {
+constexpr unsigned char HIDDEN = 1; ///< Hidden by the user, or isolated away.
+constexpr unsigned char CULLED = 2; ///< Outside the view frustum.
+constexpr unsigned char OCCLUDED = 4; ///< Hidden behind nearer geometry.
+} // namespace SubmeshState
+
+/**
+ * @brief Large triangles of a model that can hide what lies behind them,
+ * picked at load time by OcclusionCuller::selectOccluders().
+ */
+struct OccluderSet {
+  std::vector<float> positions;    ///< 9 floats per triangle, object space.
+  std::vector<uint32_t> submeshes; ///< Submesh of each triangle.
+
+  size_t triangleCount() const { return submeshes.size(); }
+
+  size_t memoryBytes() const {
+    return positions.capacity() * sizeof(float) +
+           submeshes.capacity() * sizeof(uint32_t);
+  }
+};
+
+/**
+ * @brief Compact vertex attributes that replace the float arrays of a
+ * quantized DrawBatches (see VertexQuantizer).
+ *
+ * Positions and texture coordinates are 16-bit integers spread over their
+ * range; the matrices that map them back are applied as part of the
+ * modelview and texture matrices, so GL reads the integers directly. Normals
+ * are signed bytes, which GL maps to [-1, 1] (GL_NORMALIZE restores unit
+ * length).
+ */
+struct QuantizedVertices {
+  std::vector<int16_t> positions; ///< xyz + one padding short per corner.
+  std::vector<int8_t> normals;    ///< xyz + one padding byte per corner.
+  std::vector<int16_t> texCoords; ///< uv per corner.
+  Matrix4 positionDecode; ///< Quantized position -> object space.
+  Matrix4 texCoordDecode; ///< Quantized uv -> texture coordinates.
+  float maxPositionError = 0.0f; ///< Object-space distance.
+  float maxNormalError = 0.0f;   ///< Degrees.
+  float maxTexCoordError = 0.0f; ///< Texture coordinate units.
+  size_t floatBytes = 0; ///< Size of the float arrays this replaced.
+
+  bool empty() const { return positions.empty(); }
+
+  size_t memoryBytes() const {
+    return positions.capacity() * sizeof(int16_t) + normals.capacity() +
+           texCoords.capacity() * sizeof(int16_t);
+  }
+};
+
+/**
+ * @brief The model flattened into triangle vertex arrays at load time, in
+ * material order, so a frame is one glDrawArrays per material instead of a
+ * glBegin/glEnd pair per face, and submeshes can be skipped individually.
+ * Polygons are fanned; edge flags hide the fan diagonals in wireframe mode.
+ * Once quantized, positions, normals and texCoords are empty and `quantized`
+ * holds them instead.
+ */
+struct DrawBatches {
+  std::vector<float> positions;            ///< xyz per corner.
+  std::vector<float> normals;              ///< xyz per corner.
+  std::vector<float> texCoords;            ///< uv per corner, V flipped.
+  std::vector<unsigned char> grayColors;   ///< RGBA per corner.
+  std::vector<unsigned char> randomColors; ///< RGBA per corner.
+  std::vector<unsigned char> edgeFlags;    ///< GL_TRUE on polygon edges.
+  std::vector<MaterialRange> ranges;       ///< Cover every corner in order.
+  std::vector<SubmeshRange> submeshes;     ///< Parallel to OBJModel::submeshes.
+  QuantizedVertices quantized; ///< Compact attributes, if quantized.
+
+  size_t cornerCount() const { return edgeFlags.size(); }
+
+  /**
+   * @brief Heap bytes of all arrays.
+   */
+  size_t memoryBytes() const {
+    return positions.capacity() * sizeof(float) +
+           normals.capacity() * sizeof(float) +
+           texCoords.capacity() * sizeof(float) + grayColors.capacity() +
+           randomColors.capacity() + edgeFlags.capacity() +
+           ranges.capacity() * sizeof(MaterialRange) +
+           submeshes.capacity() * sizeof(SubmeshRange) +
+           quantized.memoryBytes();
+  }
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Reports files that changed on disk, through inotify on Linux.
+ *
+ * The directories of the files are watched rather than the files, so an
+ * editor that saves by writing a new file and renaming it over the old one
+ * is seen too. A file is reported once it had no events for kSettleMillis,
+ * so a save written in several pieces is reported once, when complete. A
+ * worker thread reads the events and calls `onChange` (from that thread)
+ * when files are ready to be collected with takeChanged(). Without inotify
+ * nothing is ever reported.
+ */
+class FileWatcher {
+public:
+  static constexpr int kSettleMillis = 150;
+
+  explicit FileWatcher(std::function<void()> onChange);
+
+  /**
+   * @brief Stops the worker.
+   */
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  /**
+   * @brief Watches exactly these files from now on; changes pending for
+   * the others are forgotten. A missing file is reported once created.
+   */
+  void watch(const std::vector<std::string> &filePaths);
+
+  /**
+   * @brief The files that changed since the last call, spelled as they
+   * were passed to watch().
+   */
+  std::vector<std::string> takeChanged();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  void watchLoop();
+
+  /**
+   * @brief Reads the pending inotify events into pending_. Caller holds
+   * mutex_.
+   */
+  void readEvents();
+
+  std::function<void()> onChange_;
+  int inotify_ = -1;       ///< inotify instance, -1 if unavailable.
+  int wake_[2] = {-1, -1}; ///< Pipe that interrupts the worker's poll.
+
+  // Guarded by mutex_
+  std::mutex mutex_;
+  /// Paths given to watch(), by canonical path.
+  std::unordered_map<std::string, std::vector<std::string>> files_;
+  std::unordered_map<std::string, int> directories_; ///< Watch by directory.
+  std::unordered_map<int, std::string> directoryOf_; ///< By watch.
+  /// Time of the last event, by canonical path, until reported.
+  std::unordered_map<std::string, Clock::time_point> pending_;
+  std::vector<std::string> changed_;
+  bool stopping_ = false;
+
+  std::thread worker_;
+};
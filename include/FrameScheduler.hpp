@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * @brief Decides when the render thread draws and how it waits for events.
+ *
+ * While the scene animates, frames are paced to the FPS cap with a coarse
+ * sleep followed by a short spin. Once the scene is static the scheduler
+ * switches to idle and blocks in glfwWaitEventsTimeout until input, a drop or
+ * a new snapshot from the update thread arrives.
+ */
+class FrameScheduler {
+public:
+  enum class Mode { ACTIVE, IDLE };
+
+  /**
+   * @brief Constructs a scheduler.
+   * @param fpsCap Maximum frames per second while active (0 = uncapped).
+   */
+  explicit FrameScheduler(double fpsCap);
+
+  /**
+   * @brief Forces the next call to shouldRender() to return true.
+   */
+  void requestRedraw();
+
+  /**
+   * @brief Returns whether a frame must be drawn, consuming pending redraw
+   * requests.
+   * @param newSnapshot true if a new FrameState was acquired this iteration.
+   */
+  bool shouldRender(bool newSnapshot);
+
+  /**
+   * @brief Selects the mode for the frame about to be drawn.
+   * @param animating true if the scene changes without further input.
+   */
+  void beginFrame(bool animating);
+
+  /**
+   * @brief Waits for the next frame slot (active) or for events (idle), and
+   * processes pending GLFW events.
+   */
+  void waitForNextFrame();
+
+  Mode mode() const { return mode_; }
+  bool isIdle() const { return mode_ == Mode::IDLE; }
+  double fpsCap() const { return fpsCap_; }
+
+  /**
+   * @brief Human readable name of the current mode.
+   */
+  const char *modeName() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  void sleepUntil(Clock::time_point deadline) const;
+
+  double fpsCap_;
+  Clock::duration frameInterval_;
+  Clock::time_point nextFrame_;
+  Mode mode_;
+  bool redrawRequested_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "BVH.hpp"
+#include "BoundingVolumes.hpp"
+#include "Camera.hpp"
+#include "DrawBatches.hpp"
+#include "Matrix4.hpp"
+#include "MemoryTracker.hpp"
+#include "OBJLoader.hpp"
+#include "OBJModel.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+class PagedMesh;
+
+/**
+ * @brief Model data plus everything derived from it at load time. Shared
+ * read-only between the update and render threads and replaced as a whole
+ * when a new model is loaded.
+ */
+struct RenderModel {
+  OBJModel model;
+  DrawBatches batches; ///< Per-material triangle arrays for drawing.
+  Matrix4 translation; ///< Moves the model's bounding box center to the origin.
+  AABB bounds;          ///< Object-space bounds, computed once at load.
+  BoundingSphere sphere;
+  float scaleFactor = 1.0f; ///< Fits the largest side of bounds to 2 units.
+  BVH bvh;                  ///< Triangle hierarchy for picking.
+  OccluderSet occluders;    ///< Largest triangles, for occlusion culling.
+  MemoryTracker::Allocation meshMemory;    ///< Charges `model` to MESH.
+  MemoryTracker::Allocation derivedMemory; ///< Charges the rest to DERIVED.
+  /// Out-of-core mesh drawn instead of `batches` (model is then empty).
+  /// Streamed by the render thread.
+  std::shared_ptr<PagedMesh> pages;
+  /// End of the parsed OBJ file, for parsing appended records on reload.
+  OBJLoader::ResumePoint resume;
+};
+
+/**
+ * @brief One scene node as drawn in a frame.
+ */
+struct FrameNode {
+  std::shared_ptr<const RenderModel> model;
+  Matrix4 modelMatrix;
+  unsigned int texture = 0; ///< GL texture for TEXTURE mode (0 = default).
+};
+
+/**
+ * @brief Immutable snapshot of everything the render thread needs to draw one
+ * frame. Produced by the update thread and handed over via a TripleBuffer.
+ */
+struct FrameState {
+  Camera camera;
+  Matrix4 projection;
+  Matrix4 view;
+  std::vector<FrameNode> nodes; ///< Nodes sharing a model are adjacent.
+  unsigned sceneVersion = 0;    ///< Renderer scene the nodes came from.
+  RenderMode renderMode = RenderMode::GRAYSCALE;
+  bool transitioning = false;
+  float transitionAlpha = 0.0f;
+  float rotationSpeed = 0.0f;
+  bool freeCameraMode = false;
+  bool animating = false; ///< true if the next snapshot will differ on its own.
+};
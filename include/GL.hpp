@@ -0,0 +1,7 @@
+#pragma once
+
+// Single entry point for the OpenGL headers. GLEW must be included before
+// anything that pulls in <GL/gl.h> (GLFW, freeglut), so every file includes
+// this instead of <GLFW/glfw3.h>.
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
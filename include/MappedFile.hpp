@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file (POSIX mmap), unmapped on
+ * destruction. Move-only.
+ */
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief Maps `path`, replacing any previous mapping.
+   * @return false (with a message on std::cerr) if the file can't be opened
+   * or mapped. Empty files map successfully with size() == 0.
+   */
+  bool open(const std::string &path);
+
+  /**
+   * @brief Unmaps the file, if any.
+   */
+  void close();
+
+  /**
+   * @brief Hints that the file will be read in scattered pieces rather than
+   * front to back (disables the read-ahead open() asks for).
+   */
+  void adviseRandomAccess() const;
+
+  /**
+   * @brief Lets the kernel drop the cached pages of [offset, offset + length)
+   * from this mapping; they are read again on the next access. Partial pages
+   * at either end are kept.
+   */
+  void dropRange(size_t offset, size_t length) const;
+
+  const unsigned char *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool isOpen() const { return open_; }
+
+private:
+  const unsigned char *data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+};
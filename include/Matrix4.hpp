@@ -1,17 +1,24 @@
 #pragma once
 
 #include <cmath>   // for tanf
+#include <cstddef> // for size_t
 #include <cstring> // for memset
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
 
 #include "Vector3.hpp"
 
 struct Matrix4 {
   // Stored in column-major order to be directly usable by OpenGL
-  float m[16];
+  alignas(16) float m[16];
 
-  Matrix4() { setIdentity(); }
+  constexpr Matrix4()
+      : m{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1} {}
 
-  void setIdentity() {
+  constexpr void setIdentity() {
     // clang-format off
             m[0] = 1;  m[1] = 0;  m[2] = 0;  m[3] = 0;
             m[4] = 0;  m[5] = 1;  m[6] = 0;  m[7] = 0;
@@ -21,7 +28,9 @@ struct Matrix4 {
   }
 
   // Multiply two Matrix4 (lhs * rhs), result stored in 'out'.
-  static Matrix4 multiply(const Matrix4 &lhs, const Matrix4 &rhs) {
+  // Scalar reference; multiply() produces bit-identical results.
+  static constexpr Matrix4 multiplyScalar(const Matrix4 &lhs,
+                                          const Matrix4 &rhs) {
     Matrix4 out;
     for (int row = 0; row < 4; ++row) {
       for (int col = 0; col < 4; ++col) {
@@ -35,6 +44,111 @@ struct Matrix4 {
     return out;
   }
 
+  // Multiply two Matrix4 (lhs * rhs). Each output column is a linear
+  // combination of lhs columns, accumulated in the same order as the scalar
+  // loop so both paths round identically.
+  static constexpr Matrix4 multiply(const Matrix4 &lhs, const Matrix4 &rhs) {
+#if defined(__SSE2__)
+    if (!std::is_constant_evaluated()) {
+      Matrix4 out;
+      __m128 c0 = _mm_load_ps(lhs.m + 0);
+      __m128 c1 = _mm_load_ps(lhs.m + 4);
+      __m128 c2 = _mm_load_ps(lhs.m + 8);
+      __m128 c3 = _mm_load_ps(lhs.m + 12);
+      for (int col = 0; col < 4; ++col) {
+        const float *b = rhs.m + col * 4;
+        __m128 sum = _mm_mul_ps(c0, _mm_set1_ps(b[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(b[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(b[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(b[3])));
+        _mm_store_ps(out.m + col * 4, sum);
+      }
+      return out;
+    }
+#endif
+    return multiplyScalar(lhs, rhs);
+  }
+
+  /// Returns the transpose of this matrix.
+  constexpr Matrix4 transposed() const {
+#if defined(__SSE2__)
+    if (!std::is_constant_evaluated()) {
+      Matrix4 out;
+      __m128 c0 = _mm_load_ps(m + 0);
+      __m128 c1 = _mm_load_ps(m + 4);
+      __m128 c2 = _mm_load_ps(m + 8);
+      __m128 c3 = _mm_load_ps(m + 12);
+      _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+      _mm_store_ps(out.m + 0, c0);
+      _mm_store_ps(out.m + 4, c1);
+      _mm_store_ps(out.m + 8, c2);
+      _mm_store_ps(out.m + 12, c3);
+      return out;
+    }
+#endif
+    Matrix4 out;
+    for (int row = 0; row < 4; ++row) {
+      for (int col = 0; col < 4; ++col) {
+        out.m[col + row * 4] = m[row + col * 4];
+      }
+    }
+    return out;
+  }
+
+  /// Scalar cofactor inverse. Returns false (and leaves 'out' untouched) if
+  /// the matrix is singular.
+  constexpr bool inverseScalar(Matrix4 &out) const {
+    float inv[16] = {};
+    // clang-format off
+    inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] +
+             m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+    inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] -
+             m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+    inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] +
+             m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+    inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] -
+              m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+    inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] -
+             m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+    inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] +
+             m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+    inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] -
+             m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+    inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] +
+              m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+    inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] +
+             m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+    inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] -
+             m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+    inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] +
+              m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+    inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] -
+              m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+    inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] -
+             m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+    inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] +
+             m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+    inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] -
+              m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+    inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] +
+              m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+    // clang-format on
+
+    float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+    if (det == 0.0f) {
+      return false;
+    }
+    float invDet = 1.0f / det;
+    for (int i = 0; i < 16; ++i) {
+      out.m[i] = inv[i] * invDet;
+    }
+    return true;
+  }
+
+  /// General 4x4 inverse (SSE Cramer's rule when available). Returns false
+  /// (and leaves 'out' untouched) if the matrix is singular.
+  bool inverse(Matrix4 &out) const;
+
   /// Creates a "look-at" view matrix, from an eye position,
   /// looking at a center position, with a given up vector.
   static Matrix4 lookAt(const Vector3 &eye, const Vector3 &center,
@@ -94,7 +208,7 @@ struct Matrix4 {
    * @param v The vector to transform.
    * @return Transformed Vector3.
    */
-  Vector3 transform(const Vector3 &v) const {
+  constexpr Vector3 transform(const Vector3 &v) const {
     float x = m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12];
     float y = m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13];
     float z = m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14];
@@ -108,4 +222,22 @@ struct Matrix4 {
 
     return Vector3(x, y, z);
   }
+
+  /**
+   * @brief Transforms `count` packed xyz triples (Vector3, Vertex, or any
+   * tightly packed float[3] array). Results match transform() exactly.
+   * @param in Source positions (3 * count floats).
+   * @param out Destination positions; may alias `in`.
+   * @param count Number of positions.
+   */
+  void transformPoints(const float *in, float *out, size_t count) const;
+
+  /**
+   * @brief Transforms positions stored as separate x/y/z arrays (SoA). Uses
+   * AVX when the CPU supports it, SSE otherwise. Results match transform()
+   * exactly. Output arrays may alias the inputs.
+   */
+  void transformPointsSoA(const float *x, const float *y, const float *z,
+                          float *outX, float *outY, float *outZ,
+                          size_t count) const;
 };
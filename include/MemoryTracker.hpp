@@ -0,0 +1,101 @@
+#pragma once
+
+#include "OBJModel.hpp"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Subsystems memory is accounted to.
+ *
+ * The overlay has no tag: it formats its text into stack buffers and draws
+ * it as GLUT bitmap characters, so it owns no memory to count.
+ */
+enum class MemoryTag {
+  LOADER = 0,   ///< Staging data while a file is parsed.
+  MESH,         ///< OBJModel data owned by loaded models.
+  DERIVED,      ///< Per-face colors, BVH and other load-time derived data.
+  TEXTURES,     ///< Decoded texture pixels on the CPU.
+  GPU_TEXTURES, ///< Estimated size of uploaded OpenGL textures.
+  PAGES,        ///< Resident pages of out-of-core meshes.
+  GPU_BUFFERS,  ///< OpenGL vertex buffers.
+  COUNT
+};
+
+/**
+ * @brief Process-wide per-subsystem byte counters with current and peak
+ * values. Counters are lock-free and may be updated from any thread.
+ *
+ * Subsystems report the size of the containers they own (capacity, not
+ * size), typically through an Allocation handle whose lifetime matches the
+ * data it describes.
+ */
+class MemoryTracker {
+public:
+  /**
+   * @brief RAII record of bytes charged to a tag; released on destruction.
+   */
+  class Allocation {
+  public:
+    Allocation() = default;
+    Allocation(MemoryTag tag, size_t bytes);
+    ~Allocation();
+
+    Allocation(Allocation &&other) noexcept;
+    Allocation &operator=(Allocation &&other) noexcept;
+    Allocation(const Allocation &) = delete;
+    Allocation &operator=(const Allocation &) = delete;
+
+    /**
+     * @brief Changes the recorded size (e.g. as a container grows).
+     */
+    void resize(size_t bytes);
+
+    size_t bytes() const { return bytes_; }
+
+  private:
+    MemoryTag tag_ = MemoryTag::COUNT;
+    size_t bytes_ = 0;
+  };
+
+  static void allocate(MemoryTag tag, size_t bytes);
+  static void release(MemoryTag tag, size_t bytes);
+
+  static size_t current(MemoryTag tag);
+  static size_t peak(MemoryTag tag);
+  static size_t totalCurrent();
+  static size_t totalPeak();
+
+  /**
+   * @brief Human-readable name of a tag ("Mesh data", ...).
+   */
+  static const char *tagName(MemoryTag tag);
+
+  /**
+   * @brief Formats a byte count as "512 B", "12.3 KiB", "4.56 MiB", ...
+   */
+  static void formatBytes(size_t bytes, char *buffer, size_t bufferSize);
+
+  /**
+   * @brief Prints one line per tag plus the total to `out`.
+   * @param context Short label for what just happened ("after load", ...).
+   */
+  static void printReport(std::ostream &out, const std::string &context);
+
+  /**
+   * @brief Heap bytes held by a vector's storage.
+   */
+  template <typename T> static size_t bytesOf(const std::vector<T> &v) {
+    return v.capacity() * sizeof(T);
+  }
+
+  /**
+   * @brief Heap bytes held by an OBJModel, including every per-face vector.
+   */
+  static size_t bytesOf(const OBJModel &model);
+
+private:
+  MemoryTracker() = default; // Disallow instantiation
+};
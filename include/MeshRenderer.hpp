@@ -1,9 +1,11 @@
 #pragma once
 
+#include "DrawBatches.hpp"
 #include "OBJLoader.hpp"
+#include "PagedMesh.hpp"
+#include "PointCloud.hpp"
 
-#include <GLFW/glfw3.h>
-#include <array>
+#include "GL.hpp"
 #include <vector>
 
 /**
@@ -14,26 +16,91 @@ class MeshRenderer {
 public:
   /**
    * @brief Draws all faces of the model with the given render mode and texture.
-   * @param model The OBJ model to draw.
+   *
+   * Grayscale, random-color and wireframe modes draw each run of adjacent
+   * drawn submeshes at once (a single draw when nothing is skipped). Texture
+   * and lit modes issue one draw per material range of the drawn submeshes,
+   * changing the bound texture (map_Kd) or the diffuse color (Kd) only
+   * between ranges.
+   * @param batches The model's triangle arrays.
+   * @param materials The model's materials, indexed by MaterialRange.
    * @param mode The mode used to set the face color or texture.
-   * @param textureID The texture ID (if mode == TEXTURE).
-   * @param faceGrayColors Precomputed face-based grayscale colors.
-   * @param faceRandomColors Precomputed face-based random colors.
-   * @param faceMaterialColors Precomputed face-based material colors.
+   * @param textureID Texture for ranges without a map_Kd (if mode == TEXTURE).
+   * @param materialTextures Texture per material (0 = use textureID); may be
+   * shorter than materials.
+   * @param submeshState SubmeshState bits per submesh; submeshes with any bit
+   * set are skipped. Empty draws everything.
+   * @return Number of draw calls issued.
    */
-  static void
-  drawAllFaces(const OBJModel &model, RenderMode mode, GLuint textureID,
-               const std::vector<std::array<float, 3>> &faceGrayColors,
-               const std::vector<std::array<float, 3>> &faceRandomColors,
-               const std::vector<std::array<float, 3>> &faceMaterialColors);
+  static size_t drawAllFaces(const DrawBatches &batches,
+                             const std::vector<Material> &materials,
+                             RenderMode mode, GLuint textureID,
+                             const std::vector<GLuint> &materialTextures,
+                             const std::vector<unsigned char> &submeshState);
+
+  /**
+   * @brief Points the client arrays at `batches` and sets up the state of
+   * `mode`, for one or more drawBatches() calls. Pair with unbindBatches().
+   *
+   * Lets a scene draw every placement of a mesh with one array setup,
+   * changing only the modelview matrix in between. Quantized batches are
+   * read as integers: the texture matrix is loaded with their texture
+   * coordinate decode here, and drawBatches() multiplies their position
+   * decode onto the modelview matrix.
+   */
+  static void bindBatches(const DrawBatches &batches, RenderMode mode);
+
+  /**
+   * @brief Issues the draw calls of drawAllFaces() against arrays set up by
+   * bindBatches() for the same batches and mode.
+   * @return Number of draw calls issued.
+   */
+  static size_t drawBatches(const DrawBatches &batches,
+                            const std::vector<Material> &materials,
+                            RenderMode mode, GLuint textureID,
+                            const std::vector<GLuint> &materialTextures,
+                            const std::vector<unsigned char> &submeshState);
+
+  /**
+   * @brief Restores the state changed by bindBatches().
+   */
+  static void unbindBatches(RenderMode mode);
+
+  /**
+   * @brief Draws a point cloud as GL_POINTS whose size shrinks with distance.
+   *
+   * With more points than `budget`, only the first `budget` points of the
+   * shuffled buffer are drawn (split over its runs, see PointCloudBuffer),
+   * a uniform random sample read in order.
+   * @param budget Most points to draw (0 = all).
+   * @param drawCalls Set to the number of draw calls issued.
+   * @return Number of points drawn.
+   */
+  static size_t drawPoints(const PointCloudBuffer &points, size_t budget,
+                           size_t &drawCalls);
+
+  /**
+   * @brief Draws the visible pages of an out-of-core mesh: resident pages as
+   * triangles, the others as their placeholder points.
+   *
+   * Pages carry no colors or texture coordinates; every mode but wireframe
+   * is lit by the headlight, and random-color mode tints each page.
+   * @return Number of draw calls issued.
+   */
+  static size_t drawPagedMesh(const PagedMesh &mesh, RenderMode mode);
+
+  /**
+   * @brief Draws a translucent fill and outline over one face, on top of the
+   * already rendered model.
+   * @param model The OBJ model the face belongs to.
+   * @param faceIndex Index into model.faces.
+   */
+  static void drawFaceHighlight(const OBJModel &model, size_t faceIndex);
 
 private:
   /**
-   * @brief Sets the OpenGL face color based on the current rendering mode.
+   * @brief Enables fixed-function lighting with a camera-aligned directional
+   * light. Pushes GL_LIGHTING_BIT | GL_ENABLE_BIT; the caller pops them.
    */
-  static void
-  setFaceColor(RenderMode mode, size_t faceIndex,
-               const std::vector<std::array<float, 3>> &faceGrayColors,
-               const std::vector<std::array<float, 3>> &faceRandomColors,
-               const std::vector<std::array<float, 3>> &faceMaterialColors);
+  static void enableHeadlight();
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "DecodedImage.hpp"
+
+#include <vector>
+
+/**
+ * @brief Gamma-correct image reduction for texture mip chains.
+ *
+ * Color channels are treated as sRGB: each 2x2 box is averaged in linear
+ * light and re-encoded, so minified textures keep their brightness instead of
+ * darkening like a plain byte average. Alpha is averaged linearly. Row sums
+ * are vectorized with SSE and the rows of each level are split across
+ * threads.
+ */
+class MipmapGenerator {
+public:
+  /**
+   * @brief Halves both dimensions (never below 1) with a 2x2 box filter.
+   */
+  static DecodedImage downsample(const DecodedImage &source);
+
+  /**
+   * @brief Builds levels 1..n of the mip chain, down to 1x1.
+   * @param base Level 0.
+   * @return The reduced levels, largest first.
+   */
+  static std::vector<DecodedImage> buildChain(const DecodedImage &base);
+
+  /**
+   * @brief Halves the image until neither side exceeds maxSize.
+   */
+  static DecodedImage fitToSize(DecodedImage image, int maxSize);
+
+private:
+  MipmapGenerator() = default; // Disallow instantiation
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "FrameState.hpp"
+#include "ViewerOptions.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Reloads models whose files changed, one at a time on a worker
+ * thread, through SceneLoader::reloadModel().
+ *
+ * A file that changes again while it is being reloaded is reloaded once
+ * more afterwards, starting from the model just produced, so appends keep
+ * being parsed incrementally however fast they come.
+ */
+class ModelReloader {
+public:
+  /**
+   * @brief A reloaded model, to be swapped in for the one it replaces.
+   */
+  struct Result {
+    std::shared_ptr<const RenderModel> previous;
+    std::shared_ptr<const RenderModel> model;
+    /// `model` is `previous` with faces and vertices appended, both kept in
+    /// place (see SceneLoader::reloadModel()).
+    bool appended = false;
+  };
+
+  /**
+   * @param onFinished Called from the worker whenever a result is ready.
+   */
+  ModelReloader(const ViewerOptions &options,
+                std::function<void()> onFinished);
+
+  /**
+   * @brief Stops the worker after the reload in progress, if any.
+   */
+  ~ModelReloader();
+
+  ModelReloader(const ModelReloader &) = delete;
+  ModelReloader &operator=(const ModelReloader &) = delete;
+
+  /**
+   * @brief Queues a reload of the file `model` was loaded from, unless one
+   * is queued already.
+   */
+  void request(std::shared_ptr<const RenderModel> model);
+
+  /**
+   * @brief The results finished since the last call, in order. A file that
+   * changed twice may give two results, the second replacing the first.
+   */
+  std::vector<Result> takeFinished();
+
+private:
+  void workerLoop();
+
+  ViewerOptions options_;
+  std::function<void()> onFinished_;
+
+  // Guarded by mutex_
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<std::shared_ptr<const RenderModel>> queue_;
+  std::string running_; ///< File being reloaded.
+  bool rerun_ = false;  ///< running_ changed again meanwhile.
+  std::vector<Result> finished_;
+  bool stopping_ = false;
+
+  std::thread worker_;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "BoundingVolumes.hpp"
+#include "DrawBatches.hpp"
 #include "OBJLoader.hpp"
 #include <array>
 #include <vector>
@@ -25,15 +27,104 @@ public:
                                  float &cz);
 
   /**
-   * @brief Builds per-face grayscale, random, and material colors.
+   * @brief Computes the axis-aligned bounding box of the model's vertices.
+   */
+  static AABB computeAABB(const OBJModel &model);
+
+  /**
+   * @brief Computes a tight bounding sphere of the model's vertices.
+   */
+  static BoundingSphere computeBoundingSphere(const OBJModel &model);
+
+  /**
+   * @brief Computes a PCA-aligned oriented bounding box of the model.
+   */
+  static OrientedBox computeOrientedBox(const OBJModel &model);
+
+  /**
+   * @brief Uniform scale that fits the box's largest side to desiredSize.
+   */
+  static float computeNormalizationScale(const AABB &box, float desiredSize);
+
+  /**
+   * @brief Camera distance from the sphere center at which the whole sphere
+   * is visible with the given vertical field of view.
+   */
+  static float computeFramingDistance(const BoundingSphere &sphere,
+                                      float fovyDegrees);
+
+  /**
+   * @brief Builds per-face grayscale and random colors. Material colors come
+   * from OBJModel::materials, per MaterialRange.
    * @param model The OBJ model to process.
    * @param faceGrayColors Output vector of face-based grayscale colors.
    * @param faceRandomColors Output vector of face-based random colors.
-   * @param faceMaterialColors Output vector of face-based "material" colors.
+   * @param firstFace Only faces from this one on get colors (indexed from
+   * 0); each face keeps the color a full build gives it.
    */
   static void
   buildFaceBasedColors(const OBJModel &model,
                        std::vector<std::array<float, 3>> &faceGrayColors,
                        std::vector<std::array<float, 3>> &faceRandomColors,
-                       std::vector<std::array<float, 3>> &faceMaterialColors);
+                       size_t firstFace = 0);
+
+  /**
+   * @brief Recomputes Submesh::firstFace/faceCount from Face::submesh after
+   * faces were added, removed or reordered. Models without submeshes get a
+   * single "default" one.
+   */
+  static void updateSubmeshRanges(OBJModel &model);
+
+  /**
+   * @brief Flattens the model into per-material triangle arrays. Faces must
+   * already be grouped by submesh and material (OBJLoader does this); every
+   * run of equal materials becomes one MaterialRange, and every submesh gets
+   * its corner range, material ranges and bounds.
+   * @param faceGrayColors Per-face colors baked into grayColors.
+   * @param faceRandomColors Per-face colors baked into randomColors.
+   */
+  static DrawBatches
+  buildDrawBatches(const OBJModel &model,
+                   const std::vector<std::array<float, 3>> &faceGrayColors,
+                   const std::vector<std::array<float, 3>> &faceRandomColors);
+
+  /**
+   * @brief Adds the faces from `firstFace` on to `batches`, built from the
+   * faces before it, as buildDrawBatches() would lay them out: the new faces
+   * must sort after the old ones (OBJLoader::AppendResult::APPENDED), and
+   * the batches must not be quantized. Ranges and bounds of the submeshes
+   * the new faces join are extended.
+   * @param faceGrayColors Colors of the new faces (see buildFaceBasedColors()).
+   */
+  static void
+  appendDrawBatches(const OBJModel &model, size_t firstFace,
+                    const std::vector<std::array<float, 3>> &faceGrayColors,
+                    const std::vector<std::array<float, 3>> &faceRandomColors,
+                    DrawBatches &batches);
+
+  /**
+   * @brief true if the two models flatten into DrawBatches with the same
+   * corners, ranges, colors and edge flags: same faces (vertex and texture
+   * coordinate indices, materials, submeshes) and same materials. Vertex
+   * positions, normals and texture coordinate values may differ.
+   */
+  static bool sameTopology(const OBJModel &a, const OBJModel &b);
+
+  /**
+   * @brief Rewrites the positions, normals and texture coordinates of
+   * `batches`, built by buildDrawBatches() from a model with the same
+   * topology (see sameTopology()), from `model`, and updates the submesh
+   * bounds. Colors, edge flags and ranges are left as they are.
+   */
+  static void updateDrawBatchVertices(const OBJModel &model,
+                                      DrawBatches &batches);
+
+  /**
+   * @brief Puts the vertices of a model without faces (a point cloud) in a
+   * fixed random order, so that any prefix of them is a uniform random
+   * sample. Does nothing if the model has faces.
+   * @param firstVertex Vertices before this one keep their place (points
+   * appended to a cloud already shuffled); only the rest are shuffled.
+   */
+  static void shufflePoints(OBJModel &model, size_t firstVertex = 0);
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "OBJModel.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Generates smooth per-vertex normals for models loaded without `vn`
+ * records.
+ *
+ * Face normals are area-weighted. Around each vertex, faces that share an
+ * edge and meet within the crease angle form a smoothing group, and every
+ * corner gets the sum of its group's normals, so hard edges stay sharp while
+ * curved surfaces are smoothed. The cost is linear in the corners (plus a
+ * sort per vertex fan), whatever the valence.
+ * Work is split across threads over faces and vertices and the face normal
+ * kernel is vectorized with SSE for triangle faces.
+ */
+class NormalGenerator {
+public:
+  /**
+   * @brief Fills model.normals and every FaceVertex::normalIndex.
+   * @param model The model to process; existing normals are replaced.
+   * @param creaseAngleDegrees Faces meeting at a larger angle than this are
+   * not smoothed together (180 = fully smooth).
+   * @return Number of normals generated.
+   */
+  static size_t generate(OBJModel &model, float creaseAngleDegrees);
+
+  /**
+   * @brief Runs generate() only when the model has no normals of its own.
+   * @return true if normals were generated.
+   */
+  static bool generateIfMissing(OBJModel &model, float creaseAngleDegrees);
+
+private:
+  NormalGenerator() = default; // Disallow instantiation
+
+  /**
+   * @brief Computes area-weighted face normals into SoA arrays.
+   */
+  static void computeFaceNormals(const OBJModel &model, std::vector<float> &nx,
+                                 std::vector<float> &ny,
+                                 std::vector<float> &nz);
+};
@@ -1,15 +1,30 @@
 #pragma once
 
 #include "OBJModel.hpp"
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class OBJLoader {
 private:
+  /**
+   * @brief State carried between lines of one .obj file.
+   */
+  struct ParseContext {
+    std::string directory;   ///< Directory of the .obj, for mtllib paths.
+    int currentMaterial = -1; ///< Set by the last usemtl.
+    std::unordered_map<std::string, int> materialIndex; ///< By name.
+    std::string objectName;  ///< Set by the last o.
+    std::string groupName;   ///< Set by the last g.
+    int currentSubmesh = -1; ///< Resolved on the next face after o/g.
+    std::unordered_map<std::string, int> submeshIndex; ///< By name.
+  };
+
   /**
    * @brief Parses a single face vertex specification (e.g., "1", "1/2", "1//3",
    * or "1/2/3").
@@ -34,20 +49,104 @@ private:
   /**
    * @brief Parses a line that starts with the "f" prefix (face data).
    */
-  static void parseFace(std::istringstream &ss, OBJModel &model);
+  static void parseFace(std::istringstream &ss, OBJModel &model,
+                        ParseContext &context);
+
+  /**
+   * @brief Parses an "o" or "g" line; the submesh is created with its first
+   * face, so empty groups leave no trace.
+   */
+  static void parseObjectOrGroup(const std::string &prefix,
+                                 std::istringstream &ss,
+                                 ParseContext &context);
+
+  /**
+   * @brief Parses an "mtllib" line and merges the named libraries.
+   */
+  static void parseMaterialLibrary(std::istringstream &ss, OBJModel &model,
+                                   ParseContext &context);
+
+  /**
+   * @brief Parses a "usemtl" line; unknown names get a default material.
+   */
+  static void parseUseMaterial(std::istringstream &ss, OBJModel &model,
+                               ParseContext &context);
+
+  /**
+   * @brief Returns the index of the named material, adding it if needed.
+   */
+  static int findOrAddMaterial(const std::string &name, OBJModel &model,
+                               ParseContext &context);
 
   /**
    * @brief Dispatches a line to the appropriate parse function based on its
    * prefix.
    */
-  static bool parseLine(const std::string &line, OBJModel &model);
+  static bool parseLine(const std::string &line, OBJModel &model,
+                        ParseContext &context);
+
+  /**
+   * @brief Stable counting sort of the faces by submesh, then material, so
+   * that every submesh is one contiguous range made of one run per material.
+   * No-op if already in that order.
+   */
+  static void groupFaces(OBJModel &model);
 
 public:
+  /**
+   * @brief Where loadOBJ() stopped reading a file, so that records appended
+   * to it later can be parsed into the same model by appendOBJ().
+   */
+  struct ResumePoint {
+    bool valid = false; ///< false for compressed files and other formats.
+    uint64_t size = 0;  ///< Bytes parsed.
+    uint64_t hash = 0;  ///< Of those bytes, to tell appends from rewrites.
+    bool partialLine = false; ///< The last line parsed had no '\n'.
+    /// Normals were generated at load, not read (set by SceneLoader).
+    bool normalsGenerated = false;
+    ParseContext context;
+  };
+
+  /**
+   * @brief What appendOBJ() found in the file.
+   */
+  enum class AppendResult {
+    UNCHANGED, ///< Nothing new; the model was left as it was.
+    APPENDED,  ///< New records parsed after the existing faces.
+    REGROUPED, ///< New records parsed, then the faces regrouped (the new
+               ///< ones joined earlier submeshes or materials).
+    REWRITTEN, ///< The parsed part changed or shrank; the model is invalid.
+    FAILED     ///< The file can't be read; the model is invalid.
+  };
+
   /**
    * @brief Loads an .obj file from the given path into the provided OBJModel.
    * @param filePath Path to the .obj file.
    * @param model Reference to an OBJModel to store the parsed data.
+   * @param resume If set, receives where parsing stopped (not valid for
+   * compressed files).
    * @return true if the file was loaded successfully, false otherwise.
    */
-  static bool loadOBJ(const std::string &filePath, OBJModel &model);
+  static bool loadOBJ(const std::string &filePath, OBJModel &model,
+                      ResumePoint *resume = nullptr);
+
+  /**
+   * @brief Parses the records appended to an .obj file since `resume` into
+   * `model`, the model it was loaded into. The bytes parsed before are
+   * hashed again to make sure that they did not change.
+   * @param resume Advanced past the new records.
+   */
+  static AppendResult appendOBJ(const std::string &filePath, OBJModel &model,
+                                ResumePoint &resume);
+
+  /**
+   * @brief Reads the newmtl, Kd and map_Kd records of an .mtl file. Other
+   * records are ignored.
+   * @param filePath Path to the .mtl file.
+   * @param materials Materials are appended, or updated when the name is
+   * already present.
+   * @return false if the file could not be opened.
+   */
+  static bool loadMTL(const std::string &filePath,
+                      std::vector<Material> &materials);
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 
@@ -8,6 +9,8 @@ enum class RenderMode {
   RANDOM_COLOR,
   WIRE_FRAME,
   TEXTURE,
+  LIT,
+  POINT_CLOUD, ///< Vertices as points; always used for models without faces.
   COUNT
 };
 
@@ -31,6 +34,28 @@ struct FaceVertex {
 
 struct Face {
   std::vector<FaceVertex> vertices;
+  int material = -1;    ///< Index into OBJModel::materials, -1 for none.
+  int submesh = 0;      ///< Index into OBJModel::submeshes.
+  size_t fileIndex = 0; ///< Position in the file, before faces are grouped.
+};
+
+/**
+ * @brief A named part of the model (`o` object and/or `g` group) covering a
+ * contiguous range of faces.
+ */
+struct Submesh {
+  std::string name; ///< "object", "group" or "object/group".
+  size_t firstFace = 0;
+  size_t faceCount = 0;
+};
+
+/**
+ * @brief Surface properties from an MTL library (`newmtl` block).
+ */
+struct Material {
+  std::string name;
+  std::array<float, 3> diffuse = {0.8f, 0.8f, 0.8f}; ///< Kd
+  std::string diffuseMap; ///< map_Kd, resolved against the .mtl directory.
 };
 
 struct OBJModel {
@@ -40,4 +65,6 @@ struct OBJModel {
   std::vector<TexCoord> texCoords;
   std::vector<Normal> normals;
   std::vector<Face> faces;
+  std::vector<Material> materials; ///< Faces are grouped by material.
+  std::vector<Submesh> submeshes;  ///< In face order; cover every face.
 };
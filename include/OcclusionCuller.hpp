@@ -0,0 +1,151 @@
+#pragma once
+
+#include "BoundingVolumes.hpp"
+#include "DrawBatches.hpp"
+#include "Matrix4.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One placed model for an occlusion pass.
+ */
+struct OcclusionItem {
+  const DrawBatches *batches = nullptr;
+  const OccluderSet *occluders = nullptr;
+  Matrix4 clipFromObject;
+  std::vector<unsigned char> *state = nullptr; ///< SubmeshState per submesh.
+};
+
+/**
+ * @brief Counts from the last occlusion pass.
+ */
+struct OcclusionStats {
+  size_t tested = 0;   ///< Submeshes still drawn after frustum culling.
+  size_t occluded = 0; ///< Of those, hidden behind occluders.
+  size_t occluderTriangles = 0; ///< Triangles rasterized.
+  double micros = 0.0;
+};
+
+/**
+ * @brief CPU occlusion culling against a small software depth buffer.
+ *
+ * A pass clears a kWidth x kHeight depth buffer, rasterizes the occluder
+ * triangles of every drawn submesh into it, reduces it to a pyramid of
+ * farthest depths and marks each drawn submesh whose bounds lie entirely
+ * behind that pyramid SubmeshState::OCCLUDED. Occluders are real mesh
+ * triangles and boxes reaching the near plane are never culled. Texels
+ * sample the occluders at their centers, so boxes are tested over their
+ * footprint grown by one texel, and geometry peeking past an occluder edge
+ * by less than a texel is still drawn.
+ *
+ * Passes run on a worker thread: submit() starts one and wait() returns once
+ * the submesh states are updated.
+ */
+class OcclusionCuller {
+public:
+  static constexpr int kWidth = 256;
+  static constexpr int kHeight = 128;
+  static constexpr size_t kMaxOccludersPerModel = 256;
+  static constexpr size_t kMaxOccludersPerPass = 4096;
+
+  /**
+   * @brief Picks the largest triangles of a model (at most
+   * kMaxOccludersPerModel, ignoring slivers) as its occluders.
+   */
+  static OccluderSet selectOccluders(const DrawBatches &batches);
+
+  /**
+   * @brief Starts the worker thread.
+   */
+  OcclusionCuller();
+
+  /**
+   * @brief Finishes a pending pass and stops the worker.
+   */
+  ~OcclusionCuller();
+
+  OcclusionCuller(const OcclusionCuller &) = delete;
+  OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+  /**
+   * @brief Starts a pass over `items` on the worker. The items, the buffers
+   * they point to and their states must stay untouched until wait().
+   */
+  void submit(const std::vector<OcclusionItem> &items);
+
+  /**
+   * @brief Blocks until the submitted pass is done (returns at once if none
+   * is pending).
+   */
+  void wait();
+
+  /**
+   * @brief Counts of the last finished pass.
+   */
+  const OcclusionStats &stats() const { return stats_; }
+
+  // The steps of a pass, run by the worker; public for the benchmarks.
+
+  /**
+   * @brief Runs a whole pass on the calling thread.
+   */
+  void cull(const std::vector<OcclusionItem> &items);
+
+  /**
+   * @brief Resets the depth buffer to the far plane.
+   */
+  void clear();
+
+  /**
+   * @brief Rasterizes one triangle (9 floats) into the depth buffer, nearest
+   * depth winning. Triangles reaching the near plane are skipped.
+   * @param simd Use the SSE2 kernel when available; both give identical
+   * depths.
+   * @return false if the triangle was skipped (degenerate, off screen or
+   * reaching the near plane).
+   */
+  bool rasterize(const Matrix4 &clipFromObject, const float *triangle,
+                 bool simd = true);
+
+  /**
+   * @brief Builds the farthest-depth pyramid from the depth buffer.
+   */
+  void buildPyramid();
+
+  /**
+   * @brief true if the box lies behind the rasterized occluders everywhere
+   * it projects. Needs buildPyramid().
+   */
+  bool isOccluded(const Matrix4 &clipFromObject, const AABB &box) const;
+
+  /**
+   * @brief The depth buffer, kWidth * kHeight values in [0, 1], row 0 at
+   * the bottom.
+   */
+  const float *depth() const { return depth_.data(); }
+
+private:
+  struct Level {
+    size_t offset = 0; ///< Into pyramid_.
+    int width = 0;
+    int height = 0;
+  };
+
+  void workerLoop();
+
+  std::vector<float> depth_;
+  std::vector<float> pyramid_; ///< Levels 1.. of the max-depth pyramid.
+  std::vector<Level> levels_;  ///< Level 0 is depth_.
+  OcclusionStats stats_;
+
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  const std::vector<OcclusionItem> *pending_ = nullptr;
+  bool busy_ = false;
+  bool stopping_ = false;
+  std::thread worker_;
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "GL.hpp"
 #include <GL/freeglut.h>
 #include <OBJModel.hpp>
 #include <string>
+#include <vector>
 
 /**
  * @brief Handles rendering of overlay text (HUD) on the screen.
@@ -25,12 +27,21 @@ public:
 
   /**
    * @brief Renders the overlay text.
-   * @param cameraInfo Information about the camera to display.
+   * @param cameraInfo Camera information to display, one line per '\n'.
    * @param currentMode Current rendering mode.
    * @param totalModes Total number of rendering modes.
+   * @param model Model whose details are listed.
+   * @param textureName Name of the currently bound texture.
+   * @param selectedFace Index of the picked face, or -1 for none.
+   * @param pickMicros Duration of the last pick query in microseconds.
+   * @param submeshState SubmeshState bits per model.submeshes entry.
+   * @param currentSubmesh Submesh the hide/isolate keys act on.
    */
-  void render(const std::string &cameraInfo, int currentMode, int totalModes,
-              const OBJModel &model);
+  void render(const char *cameraInfo, int currentMode, int totalModes,
+              const OBJModel &model, const std::string &textureName,
+              int selectedFace, double pickMicros,
+              const std::vector<unsigned char> &submeshState,
+              int currentSubmesh);
 
 private:
   int m_width;  ///< Window width.
@@ -42,6 +53,25 @@ private:
    * @param y Y-coordinate in pixels.
    * @param text Text to render.
    */
-  void drawText(float x, float y, const std::string &text);
-  void drawLargeText(float x, float y, const std::string &text);
+  void drawText(float x, float y, const char *text);
+  void drawText(float x, float y, const char *text, size_t length);
+  void drawLargeText(float x, float y, const char *text);
+
+  /**
+   * @brief Lists index, vertex/texcoord indices and texcoords of a face.
+   */
+  void drawFaceDetails(float x, float y, const OBJModel &model, size_t face,
+                       double pickMicros);
+
+  /**
+   * @brief Lists the submeshes around the current one with their state.
+   */
+  void drawSubmeshList(float x, float y, const OBJModel &model,
+                       const std::vector<unsigned char> &submeshState,
+                       int currentSubmesh);
+
+  /**
+   * @brief Lists current and peak bytes for every MemoryTracker tag.
+   */
+  void drawMemoryStats(float x, float y);
 };
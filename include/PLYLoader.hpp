@@ -0,0 +1,42 @@
+#pragma once
+
+#include "OBJModel.hpp"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Reads PLY meshes (binary little-endian, binary big-endian and
+ * ASCII) from a memory mapping into an OBJModel.
+ *
+ * Vertex positions (x, y, z), normals (nx, ny, nz) and texture coordinates
+ * (u/v, s/t or texture_u/texture_v) are read, along with the vertex index
+ * list of each face (vertex_indices or vertex_index). Other elements and
+ * properties, such as colors, are skipped. Normals and texture coordinates
+ * are per vertex, so faces index them like the positions. Files without
+ * faces load as point clouds.
+ */
+class PLYLoader {
+public:
+  /**
+   * @brief true if the path has the .ply extension (any case).
+   */
+  static bool isPLYPath(const std::string &filePath);
+
+  /**
+   * @brief true if `data`, the start of a file, begins with the PLY magic
+   * line.
+   */
+  static bool hasPLYMagic(const unsigned char *data, size_t size);
+
+  /**
+   * @brief Loads a .ply file into `model`, with one "default" submesh.
+   * Faces referencing missing vertices are dropped.
+   * @return false (with a message on std::cerr) if the file can't be read
+   * or its header is invalid.
+   */
+  static bool loadPLY(const std::string &filePath, OBJModel &model);
+
+private:
+  PLYLoader() = default; // Disallow instantiation
+};
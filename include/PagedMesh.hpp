@@ -0,0 +1,147 @@
+#pragma once
+
+#include "BoundingVolumes.hpp"
+#include "MappedFile.hpp"
+#include "MemoryTracker.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One spatial page of a PagedMesh.
+ */
+struct MeshPage {
+  AABB bounds;
+  uint64_t fileOffset = 0;    ///< Triangle data in the page file.
+  uint32_t triangleCount = 0;
+  uint32_t firstSample = 0;   ///< Placeholder points in PagedMesh::samples().
+  uint32_t sampleCount = 0;
+  bool visible = false;       ///< Inside the frustum at the last update().
+  uint64_t lastUsed = 0;      ///< Last update() that wanted the page.
+  std::vector<float> positions; ///< 9 floats per triangle while resident.
+  std::vector<float> normals;   ///< Flat normal per corner while resident.
+  MemoryTracker::Allocation memory; ///< Charges the arrays to PAGES.
+
+  bool resident() const { return !positions.empty(); }
+};
+
+/**
+ * @brief Out-of-core triangle mesh for models too large to load as an
+ * OBJModel.
+ *
+ * build() converts an OBJ file offline into a page file: triangles sorted
+ * along a Morton curve of their centroids and cut into fixed-size pages, each
+ * with its bounds and a few sample points. The viewer memory-maps that file;
+ * update() picks the pages inside the frustum or near the camera, a worker
+ * thread copies them in (closest first), and pages nobody wants are evicted,
+ * least recently used first, to stay under the memory budget. Pages that are
+ * not resident yet are drawn as their sample points.
+ */
+class PagedMesh {
+public:
+  static constexpr size_t kDefaultTrianglesPerPage = 65536;
+
+  /**
+   * @brief Streams an OBJ file into a page file. Only vertex positions and
+   * triangle indices are held in memory (about 28 bytes per triangle), not
+   * an OBJModel.
+   * @return false (with a message on std::cerr) on read or write errors.
+   */
+  static bool build(const std::string &objPath, const std::string &pagePath,
+                    size_t trianglesPerPage = kDefaultTrianglesPerPage);
+
+  /**
+   * @brief true if the path has the page file extension (.scpg).
+   */
+  static bool isPagePath(const std::string &filePath);
+
+  /**
+   * @brief Maps a page file built by build().
+   * @param budgetBytes Most memory resident pages may use.
+   * @return nullptr (with a message on std::cerr) if the file is invalid.
+   */
+  static std::shared_ptr<PagedMesh> open(const std::string &pagePath,
+                                         size_t budgetBytes);
+
+  /**
+   * @brief Stops the loader thread.
+   */
+  ~PagedMesh();
+
+  PagedMesh(const PagedMesh &) = delete;
+  PagedMesh &operator=(const PagedMesh &) = delete;
+
+  /**
+   * @brief Takes finished loads, decides which pages the view needs and
+   * queues the missing ones, evicting unwanted pages to make room. Call once
+   * per frame from one thread; allocation-free once warmed up.
+   * @param frustum View frustum in the mesh's object space.
+   * @param eye Camera position in object space.
+   */
+  void update(const Frustum &frustum, const Vector3 &eye);
+
+  /**
+   * @brief true while wanted pages are still loading.
+   */
+  bool loading() const { return pendingLoads_ > 0; }
+
+  const AABB &bounds() const { return bounds_; }
+  uint64_t triangleCount() const { return triangleCount_; }
+  const std::vector<MeshPage> &pages() const { return pages_; }
+  const std::vector<float> &samples() const { return samples_; }
+  size_t residentBytes() const { return residentBytes_; }
+  size_t residentPages() const { return residentPages_; }
+  size_t budgetBytes() const { return budgetBytes_; }
+
+  /**
+   * @brief Memory a page takes while resident.
+   */
+  static size_t pageBytes(const MeshPage &page);
+
+private:
+  PagedMesh() = default;
+
+  struct LoadedPage {
+    uint32_t page = 0;
+    std::vector<float> positions;
+    std::vector<float> normals;
+  };
+
+  void workerLoop();
+  void loadPage(uint32_t page, LoadedPage &out);
+  void evict(MeshPage &page);
+
+  MappedFile file_;
+  AABB bounds_;
+  uint64_t triangleCount_ = 0;
+  size_t budgetBytes_ = 0;
+  float nearDistance_ = 0.0f; ///< Pages this close are kept even off-screen.
+  std::vector<MeshPage> pages_;
+  std::vector<float> samples_; ///< Placeholder points, 3 floats each.
+  MemoryTracker::Allocation indexMemory_; ///< pages_ and samples_.
+
+  // update() thread only
+  uint64_t updateCount_ = 0;
+  size_t residentBytes_ = 0;
+  size_t residentPages_ = 0;
+  size_t pendingLoads_ = 0;
+  std::vector<uint32_t> order_;   ///< Scratch: candidate pages.
+  std::vector<float> priority_;   ///< Scratch: per page, lower loads first.
+  std::vector<LoadedPage> arrived_;
+
+  // Loader hand-off, guarded by mutex_
+  std::mutex mutex_;
+  std::condition_variable requestReady_;
+  std::vector<uint32_t> requests_; ///< Pages to load, most wanted first.
+  size_t nextRequest_ = 0;
+  uint32_t inFlight_ = UINT32_MAX; ///< Page the worker is copying.
+  std::vector<LoadedPage> completed_;
+  bool stopping_ = false;
+  std::thread worker_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Minimal fork/join helpers for data-parallel loops over contiguous
+ * index ranges.
+ */
+namespace Parallel {
+
+/**
+ * @brief Number of threads used by forRange (at least 1).
+ */
+inline unsigned workerCount() {
+  unsigned count = std::thread::hardware_concurrency();
+  return count == 0 ? 1 : count;
+}
+
+/**
+ * @brief Number of chunks forRange will split `count` items into.
+ */
+inline size_t chunkCount(size_t count, size_t minChunk) {
+  if (count == 0) {
+    return 0;
+  }
+  size_t byGrain = (count + minChunk - 1) / std::max<size_t>(minChunk, 1);
+  return std::max<size_t>(1, std::min<size_t>(workerCount(), byGrain));
+}
+
+/**
+ * @brief Splits [0, count) into at most workerCount() contiguous chunks of at
+ * least `minChunk` items and calls fn(chunkIndex, begin, end) for each. The
+ * calling thread runs the first chunk; returns once all chunks are done.
+ */
+template <typename Fn>
+void forChunks(size_t count, size_t minChunk, Fn &&fn) {
+  size_t chunks = chunkCount(count, minChunk);
+  if (chunks <= 1) {
+    if (count > 0) {
+      fn(size_t(0), size_t(0), count);
+    }
+    return;
+  }
+
+  size_t chunkSize = (count + chunks - 1) / chunks;
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (size_t chunk = 1; chunk < chunks; ++chunk) {
+    size_t begin = chunk * chunkSize;
+    size_t end = std::min(count, begin + chunkSize);
+    if (begin >= end) {
+      break;
+    }
+    workers.emplace_back([&fn, chunk, begin, end] { fn(chunk, begin, end); });
+  }
+  fn(size_t(0), size_t(0), std::min(count, chunkSize));
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @brief Same as forChunks, for callers that don't need the chunk index.
+ */
+template <typename Fn> void forRange(size_t count, size_t minChunk, Fn &&fn) {
+  forChunks(count, minChunk,
+            [&fn](size_t, size_t begin, size_t end) { fn(begin, end); });
+}
+
+} // namespace Parallel
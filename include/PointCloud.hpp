@@ -0,0 +1,73 @@
+#pragma once
+
+#include "GL.hpp"
+#include "MemoryTracker.hpp"
+#include "OBJModel.hpp"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A model's vertex positions, uploaded once for POINT_CLOUD mode.
+ *
+ * The points are kept in runs of random order, so the first points of each
+ * run are a uniform sample of it: a point cloud is one run as shuffled on
+ * load (ModelUtilities::shufflePoints), plus one per batch of points
+ * appended since. Mesh vertices are uploaded as a shuffled copy.
+ *
+ * Falls back to drawing from the model's client memory when vertex buffer
+ * objects are unavailable, so the model must outlive the buffer.
+ */
+class PointCloudBuffer {
+public:
+  /**
+   * @brief Uploads the vertex positions. Needs a current GL context.
+   */
+  explicit PointCloudBuffer(const OBJModel &model);
+
+  /**
+   * @brief Deletes the buffer. Needs the GL context it was created in.
+   */
+  ~PointCloudBuffer();
+
+  PointCloudBuffer(const PointCloudBuffer &) = delete;
+  PointCloudBuffer &operator=(const PointCloudBuffer &) = delete;
+
+  /**
+   * @brief Uploads the positions of `model` into the existing buffer, for
+   * the next frame of a sequence or points appended to the file. The buffer
+   * is reallocated, with room to grow, only when the points don't fit.
+   * @param firstVertex Positions before this one are already in the buffer.
+   */
+  void update(const OBJModel &model, size_t firstVertex = 0);
+
+  /**
+   * @brief Binds the positions as the vertex array.
+   */
+  void bind() const;
+
+  /**
+   * @brief Unbinds the vertex buffer.
+   */
+  void unbind() const;
+
+  size_t pointCount() const { return count_; }
+
+  /**
+   * @brief First point of each shuffled run, in order; the first is 0.
+   */
+  const std::vector<size_t> &runs() const { return runs_; }
+
+private:
+  void releaseShuffled();
+
+  const Vertex *clientVertices_; ///< Used when buffer_ is 0.
+  size_t count_;
+  size_t capacity_; ///< Points the buffer has room for.
+  std::vector<size_t> runs_;
+  /// Shuffled mesh vertices, kept only while drawn from client memory.
+  std::vector<Vertex> shuffled_;
+  GLuint buffer_ = 0;
+  /// Charges the buffer to GPU_BUFFERS, or the client copy to DERIVED.
+  MemoryTracker::Allocation memory_;
+};
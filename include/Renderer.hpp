@@ -1,13 +1,31 @@
 #pragma once
 
+#include "AllocationGuard.hpp"
 #include "Camera.hpp"
+#include "FileWatcher.hpp"
+#include "FrameScheduler.hpp"
+#include "FrameState.hpp"
 #include "Matrix4.hpp"
+#include "ModelReloader.hpp"
 #include "OBJModel.hpp"
+#include "OcclusionCuller.hpp"
 #include "Overlay.hpp"
-#include <GLFW/glfw3.h>
+#include "PointCloud.hpp"
+#include "Scene.hpp"
+#include "SequencePlayer.hpp"
+#include "TextureCache.hpp"
+#include "TripleBuffer.hpp"
+#include "ViewerOptions.hpp"
+#include "GL.hpp"
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -20,9 +38,12 @@ public:
    * @param window Pointer to the GLFW window.
    * @param width Initial window width.
    * @param height Initial window height.
-   * @param model Reference to the initial OBJ model.
+   * @param scene The loaded command-line models, placed on a grid. The first
+   * entry's texture becomes the default texture.
+   * @param options Runtime options from the command line.
    */
-  Renderer(GLFWwindow *window, int width, int height, OBJModel &model);
+  Renderer(GLFWwindow *window, int width, int height,
+           const std::vector<SceneEntry> &scene, const ViewerOptions &options);
 
   /**
    * @brief Destructor: Cleans up resources.
@@ -30,15 +51,38 @@ public:
   ~Renderer();
 
   /**
-   * @brief Runs the main rendering loop.
+   * @brief Runs the main rendering loop. Simulation runs on a separate update
+   * thread; this thread only polls events and draws the latest FrameState,
+   * idling in glfwWaitEventsTimeout while the scene is static.
    */
   void run();
 
+  /**
+   * @brief true if an allocation-guard build saw a steady-state frame
+   * allocate. Always false in normal builds.
+   */
+  bool allocationCheckFailed() const;
+
 private:
   // Core OpenGL initialization and rendering
   void initializeGL();
-  void computeModelCenter(const OBJModel &model);
-  void renderFrame(const OBJModel &model);
+  void renderFrame(const FrameState &frame);
+  void drawMeshNodes(const FrameState &frame, size_t first, size_t end,
+                     GLuint defaultTexture);
+  void drawPagedNodes(const FrameState &frame, size_t first, size_t end);
+  void drawPointNodes(const FrameState &frame, size_t first, size_t end);
+  const PointCloudBuffer &
+  pointBuffer(const std::shared_ptr<const RenderModel> &model);
+  void drawTransitionOverlay(float alpha);
+
+  // Update thread: simulation and frame preparation
+  void updateLoop();
+  void stepSimulation(float deltaTime);
+  bool isAnimating() const;
+  void markStateDirty();
+  void writeFrameState(FrameState &frame) const;
+  Matrix4 computeModelMatrix(const SceneNode &node) const;
+  void stopUpdateThread();
 
   // OpenGL Callbacks
   static void scrollCallback(GLFWwindow *window, double xoffset,
@@ -55,20 +99,46 @@ private:
   static void mouseButtonCallback(GLFWwindow *window, int button, int action,
                                   int mods);
   void onMouseButton(int button, int action, int mods);
+  void pickFace(double cursorX, double cursorY);
+  void updateSubmeshState(const std::shared_ptr<const RenderModel> &model,
+                          const Matrix4 &clipFromObject, bool currentNode,
+                          std::vector<unsigned char> &state);
+  void onSubmeshKey(int key);
+
+  static void windowRefreshCallback(GLFWwindow *window);
 
   void resetToDefaults();
-  void drawAllFaces(const OBJModel &model);
 
   void loadTextureFromFile(const std::string &filePath);
+  void useTexture(TextureCache::Handle newTexture, const std::string &filePath);
+  void loadMaterialTextures(const std::vector<SceneNode> &nodes);
+  const std::vector<GLuint> &materialTextureIds(const RenderModel &model) const;
   void loadModelFromFile(const std::string &filePath);
-  void buildFaceBasedColors(const OBJModel &model);
+  void addModelsToScene(const std::vector<std::string> &filePaths);
+  void playSequence(const std::string &path);
+  void advanceSequence();
+  void replaceModel(const std::shared_ptr<const RenderModel> &previous,
+                    const std::shared_ptr<const RenderModel> &next,
+                    bool appended);
+  void setScene(std::vector<SceneNode> nodes);
+  void retireUnusedResources();
+
+  // Hot reload of changed files
+  void watchSceneFiles();
+  void processFileChanges();
+  void reloadChangedFile(const std::string &filePath);
 
   void handleFreeCameraMovement(float deltaTime);
   void handleFreeCameraRotation(float deltaTime);
 
 private:
-  // Model
-  OBJModel currentModel_;
+  ViewerOptions options_;
+
+  // Scene nodes; their models are shared with in-flight FrameStates. Nodes
+  // placing the same model are adjacent so it is bound once per frame.
+  // Replaced as a whole, on the render thread, under stateMutex_.
+  std::vector<SceneNode> nodes_;
+  unsigned sceneVersion_; ///< Bumped whenever nodes_ is replaced.
 
   GLFWwindow *window_;
   int width_;
@@ -79,8 +149,6 @@ private:
   float rotationAngle_;
   float rotationSpeed_;
 
-  Matrix4 modelTranslation_;
-
   // Default camera settings for reset
   Vector3 defaultEye_;
   Vector3 defaultCenter_;
@@ -90,18 +158,32 @@ private:
 
   RenderMode currentRenderMode_;
 
-  std::vector<std::array<float, 3>> faceGrayColors_;
-  std::vector<std::array<float, 3>> faceRandomColors_;
-  std::vector<std::array<float, 3>> faceMaterialColors_;
-
-  GLuint textureID_;
+  // Render-thread only
+  TextureCache textureCache_;
+  TextureCache::Handle texture_; ///< Texture bound for TEXTURE mode.
+  std::string textureName_;
+  struct MaterialTextures {
+    std::shared_ptr<const RenderModel> model;   ///< Owner of the maps.
+    std::vector<TextureCache::Handle> textures; ///< map_Kd per material.
+    std::vector<GLuint> ids;                    ///< IDs of textures.
+  };
+  /// Per distinct model in nodes_, loaded once however often it is placed.
+  std::unordered_map<const RenderModel *, MaterialTextures> materialTextures_;
+  /// Textures the scene dropped; kept until no drawn frame can use them.
+  std::vector<TextureCache::Handle> retiredTextures_;
+  struct PointBuffer {
+    std::shared_ptr<const RenderModel> model; ///< Owner of the positions.
+    std::unique_ptr<PointCloudBuffer> buffer;
+  };
+  /// Vertex buffers of models drawn as points, uploaded on first use.
+  std::unordered_map<const RenderModel *, PointBuffer> pointBuffers_;
+  std::vector<PointBuffer> retiredPointBuffers_;
+  unsigned retiredVersion_; ///< sceneVersion_ that no longer uses them.
 
   Overlay overlay_;
 
   bool isFreeCameraMode_;
 
-  double lastFrameTime_;
-
   bool moveForward_;
   bool moveBackward_;
   bool moveLeft_;
@@ -119,8 +201,58 @@ private:
   float transitionDuration_;
   float transitionElapsed_;
   RenderMode nextRenderMode_;
-  float lastDeltaTime_;
 
   // Only for special flip
   float nextFlipAngle_;
+
+  // Update/render thread hand-off. stateMutex_ guards every simulation member
+  // above that is shared between input callbacks and the update thread.
+  TripleBuffer<FrameState> frames_;
+  std::mutex stateMutex_;
+  std::condition_variable stateChanged_;
+  bool stateDirty_; ///< Input arrived since the last published snapshot.
+  std::thread updateThread_;
+  std::atomic<bool> running_;
+
+  // Render loop pacing; renderIdle_ mirrors the scheduler mode for the
+  // update thread so it knows when to wake the render thread.
+  FrameScheduler scheduler_;
+  std::atomic<bool> renderIdle_;
+  AllocationGuard allocationGuard_; ///< Per-frame heap check (debug builds).
+  size_t lastDrawCalls_; ///< Draw calls of the last frame (render thread).
+  size_t lastPointsDrawn_; ///< Points drawn in the last frame.
+  size_t lastPointsTotal_; ///< Points of all point-cloud nodes.
+  bool pagesLoading_; ///< A paged mesh is still streaming (render thread).
+
+  // Submesh visibility (render thread only). Hiding and isolating act on the
+  // current node, and reset when its model changes; other nodes are culled.
+  size_t currentNode_; ///< Node picked last (index into FrameState::nodes).
+  std::shared_ptr<const RenderModel> submeshModel_;
+  std::vector<unsigned char> submeshHidden_; ///< User choice per submesh.
+  /// SubmeshState per submesh of every node, as of the last frame.
+  std::vector<std::vector<unsigned char>> nodeStates_;
+  int currentSubmesh_;
+  bool isolateSubmesh_;
+  bool cullSubmeshes_;
+
+  // Occlusion culling (render thread submits, the culler's worker runs it)
+  OcclusionCuller occlusion_;
+  std::vector<OcclusionItem> occlusionItems_; ///< Mesh nodes of the frame.
+  bool occlusionCulling_;
+
+  // Model sequence playback (render thread only); swaps the frame into
+  // every node showing the previous one.
+  std::unique_ptr<SequencePlayer> sequence_;
+
+  // Hot reload: both run workers that wake the render thread, which swaps
+  // reloaded models and textures in.
+  FileWatcher watcher_;
+  ModelReloader reloader_;
+
+  // Face picking (render thread only). The selection expires with its
+  // model, so a later model at the same address never matches it.
+  std::weak_ptr<const RenderModel> selectedModel_;
+  size_t selectedNode_;
+  int selectedFace_;
+  double lastPickMicros_;
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "OBJModel.hpp"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Reads binary and ASCII STL files from a memory mapping into an
+ * OBJModel.
+ *
+ * STL stores three separate corners per triangle, so the loader welds
+ * exactly coincident corners (VertexWelder with epsilon 0) to give the mesh
+ * shared vertices; generated normals then smooth across triangles. Facet
+ * normals and attribute bytes are ignored.
+ */
+class STLLoader {
+public:
+  /**
+   * @brief true if the path has the .stl extension (any case).
+   */
+  static bool isSTLPath(const std::string &filePath);
+
+  /// Bytes hasSTLMagic() needs to tell binary and ASCII files apart.
+  static constexpr size_t kMagicBytes = 512;
+
+  /**
+   * @brief true if `data`, the start of a file of `fileSize` bytes, is
+   * unambiguously an STL file: either a binary one whose nonzero triangle
+   * count fills the file (give or take less than a triangle of padding), or
+   * an ASCII one starting with "solid" and naming a "facet", but not both.
+   */
+  static bool hasSTLMagic(const unsigned char *data, size_t size,
+                          size_t fileSize);
+
+  /**
+   * @brief Loads a .stl file into `model`, with one "default" submesh.
+   * @return false (with a message on std::cerr) if the file can't be read
+   * or holds no triangles.
+   */
+  static bool loadSTL(const std::string &filePath, OBJModel &model);
+
+private:
+  STLLoader() = default; // Disallow instantiation
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "FrameState.hpp"
+#include "Matrix4.hpp"
+#include "OBJLoader.hpp"
+#include "OBJModel.hpp"
+#include "TextureCache.hpp"
+#include "ViewerOptions.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One model placed in the scene. Nodes placing the same file share
+ * one RenderModel, so its mesh, batches and BVH exist once, and textures come
+ * from the TextureCache, so each file is uploaded once.
+ */
+struct SceneNode {
+  std::shared_ptr<const RenderModel> model;
+  TextureCache::Handle texture; ///< Texture for TEXTURE mode (null = default).
+  Matrix4 placement; ///< Scene position of the normalized, centered model.
+};
+
+/**
+ * @brief A model named on the command line, with the texture that followed
+ * it (if any).
+ */
+struct SceneEntry {
+  std::string modelPath;
+  std::string texturePath;
+  std::shared_ptr<const RenderModel> model; ///< Filled by SceneLoader.
+  /// Every frame of a sequence (SequencePlayer), modelPath being the first;
+  /// empty for a single model.
+  std::vector<std::string> sequenceFrames;
+};
+
+/**
+ * @brief Model file formats SceneLoader reads.
+ */
+enum class ModelFormat {
+  UNKNOWN,
+  OBJ,
+  PLY,
+  STL,
+  PAGES ///< Out-of-core page file (PagedMesh).
+};
+
+/**
+ * @brief Loads models into shared RenderModels and lays nodes out.
+ */
+class SceneLoader {
+public:
+  /**
+   * @brief Builds the shared, immutable render data for a loaded model. The
+   * model is moved in and trimmed of the loader's vector growth slack.
+   * @param quantize Whether the draw arrays get quantized vertex attributes
+   * (decided per model from its size under QuantizeMode::AUTO).
+   */
+  static std::shared_ptr<const RenderModel>
+  makeRenderModel(OBJModel &&loaded, QuantizeMode quantize = QuantizeMode::OFF);
+
+  /**
+   * @brief Format of a model file, from its extension (.obj, .ply, .stl,
+   * .scpg, any case) or else from the magic bytes of PLY and STL files.
+   * Compressed .obj.gz and .obj.zst files are OBJ. Textures are not
+   * recognized; callers check for them first.
+   */
+  static ModelFormat formatOf(const std::string &filePath);
+
+  /**
+   * @brief Loads one OBJ, PLY or STL file (see formatOf()), welds and
+   * generates normals per `options`, and builds its render data. A .scpg
+   * page file is opened as an out-of-core PagedMesh instead.
+   * @return nullptr (with a message on std::cerr) if the file failed to load.
+   */
+  static std::shared_ptr<const RenderModel>
+  loadModel(const std::string &filePath, const ViewerOptions &options);
+
+  /**
+   * @brief Loads the file of `current` again after it changed on disk.
+   *
+   * Records appended to an OBJ file are parsed into a copy of the model,
+   * and when the new faces come after the old ones a copy of its render
+   * data is extended rather than rebuilt (only the BVH gains a subtree).
+   * The copies make this linear in the size of the model, if much cheaper
+   * than a full load. Other appends rebuild the render data from the parsed
+   * model; any other change loads the file again with loadModel().
+   * @param appended Set if the result extends `current`: its faces and
+   * vertices are those of `current` plus new ones at the end.
+   * @return `current` if the file didn't change, nullptr if it failed to
+   * load.
+   */
+  static std::shared_ptr<const RenderModel>
+  reloadModel(const std::shared_ptr<const RenderModel> &current,
+              const ViewerOptions &options, bool &appended);
+
+  /**
+   * @brief The first steps of loadModel() for an OBJ, PLY or STL file: reads
+   * it into `model`, then welds and generates normals per `options`.
+   * @param resume If set, receives where an OBJ file's parsing stopped, for
+   * reloadModel().
+   * @return false (with a message on std::cerr) if the file failed to load.
+   */
+  static bool loadMesh(const std::string &filePath,
+                       const ViewerOptions &options, OBJModel &model,
+                       OBJLoader::ResumePoint *resume = nullptr);
+
+  /**
+   * @brief Loads every distinct path once, one file per worker thread.
+   * @return One model per path, in order; repeated paths get the same
+   * pointer and failed ones nullptr.
+   */
+  static std::vector<std::shared_ptr<const RenderModel>>
+  loadModels(const std::vector<std::string> &filePaths,
+             const ViewerOptions &options);
+
+  /**
+   * @brief Placement of node `index` of `count` on a square grid in the XY
+   * plane, centered on the origin (identity for a single node).
+   */
+  static Matrix4 gridPlacement(size_t index, size_t count);
+
+  /**
+   * @brief Radius around the origin that holds a grid of `count` normalized
+   * models.
+   */
+  static float gridRadius(size_t count);
+
+private:
+  SceneLoader() = default; // Disallow instantiation
+};
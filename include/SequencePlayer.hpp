@@ -0,0 +1,141 @@
+#pragma once
+
+#include "FrameState.hpp"
+#include "ViewerOptions.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Playback state of a SequencePlayer, for the overlay.
+ */
+struct SequenceStats {
+  size_t frame = 0;      ///< Index of the frame on screen.
+  size_t frameCount = 0;
+  size_t dropped = 0;    ///< Frames skipped because they weren't decoded.
+  size_t prefetched = 0; ///< Decoded frames waiting ahead of the playhead.
+  size_t depth = 0;      ///< Size of the prefetch ring.
+  size_t decoded = 0;
+  size_t reused = 0; ///< Decoded frames that reused draw arrays.
+  double decodeMillis = 0.0; ///< Mean decode time of one frame.
+};
+
+/**
+ * @brief Plays a numbered model sequence (frame_0001.obj, frame_0002.obj,
+ * ...) in a loop at a target frame rate.
+ *
+ * Decoder threads load the frames ahead of the playhead into a ring of
+ * ViewerOptions::sequencePrefetch slots; the render thread calls advance()
+ * once per iteration and shows the newest decoded frame that is due. Frames
+ * that were not decoded in time are skipped and counted as dropped.
+ *
+ * A frame whose faces match the last fully built frame (see
+ * ModelUtilities::sameTopology()) starts from that frame's draw arrays and
+ * only rewrites positions, normals and texture coordinates. Every frame
+ * keeps the framing (center and scale) of the first one so that the motion
+ * stays visible, and none has a BVH, so faces can't be picked while a
+ * sequence plays.
+ */
+class SequencePlayer {
+public:
+  static constexpr size_t kMaxDecoders = 4;
+
+  /**
+   * @brief true if `path` names a sequence: a directory, or a file pattern
+   * with one '*' in the file name (frames/frame_*.obj).
+   */
+  static bool isSequencePath(const std::string &path);
+
+  /**
+   * @brief The model files of a directory or matching a pattern, in natural
+   * order (frame_2 before frame_10).
+   */
+  static std::vector<std::string> listFrames(const std::string &path);
+
+  /**
+   * @brief Starts the decoders and the clock.
+   * @param framePaths Frames in playback order (at least 2).
+   * @param first The first frame, already loaded; it is on screen now.
+   */
+  SequencePlayer(std::vector<std::string> framePaths,
+                 std::shared_ptr<const RenderModel> first,
+                 const ViewerOptions &options);
+
+  /**
+   * @brief Stops the decoders; frames still decoding are finished first.
+   */
+  ~SequencePlayer();
+
+  SequencePlayer(const SequencePlayer &) = delete;
+  SequencePlayer &operator=(const SequencePlayer &) = delete;
+
+  /**
+   * @brief Moves the playhead to the current time (render thread).
+   * @return The frame to show if it changed, else nullptr.
+   */
+  std::shared_ptr<const RenderModel> advance();
+
+  /**
+   * @brief The frame on screen.
+   */
+  const std::shared_ptr<const RenderModel> &current() const {
+    return current_;
+  }
+
+  SequenceStats stats() const;
+
+private:
+  /**
+   * @brief One decoded (or decoding) frame. `tick` counts played frames
+   * across loops; the file is framePaths_[tick % size].
+   */
+  struct Slot {
+    size_t tick = 0;
+    bool ready = false;
+    std::shared_ptr<const RenderModel> model; ///< nullptr if loading failed.
+  };
+
+  void decoderLoop();
+
+  /**
+   * @brief Loads one frame; reuses the draw arrays of `topology` when the
+   * faces match.
+   */
+  std::shared_ptr<const RenderModel>
+  decode(const std::string &filePath,
+         const std::shared_ptr<const RenderModel> &topology,
+         bool &reused) const;
+
+  std::vector<std::string> framePaths_;
+  ViewerOptions options_;
+  double fps_;
+  Matrix4 translation_; ///< Framing of the first frame.
+  float scaleFactor_;
+
+  // Render thread
+  std::chrono::steady_clock::time_point start_;
+  size_t shownTick_ = 0;
+  std::shared_ptr<const RenderModel> current_;
+
+  // Shared with the decoders, guarded by mutex_
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<Slot> ring_;
+  size_t playhead_ = 1; ///< Oldest tick still wanted.
+  size_t nextTick_ = 1; ///< Next tick to decode.
+  /// Last frame built from scratch; later frames with its faces reuse it.
+  std::shared_ptr<const RenderModel> topology_;
+  bool stopping_ = false;
+  size_t dropped_ = 0;
+  size_t decoded_ = 0;
+  size_t reused_ = 0;
+  double decodeMillis_ = 0.0;
+
+  std::vector<std::thread> decoders_;
+};
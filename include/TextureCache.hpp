@@ -0,0 +1,138 @@
+#pragma once
+
+#include "GL.hpp"
+#include "TextureStreamer.hpp"
+#include "ViewerOptions.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief An OpenGL texture owned through shared handles; the GL object is
+ * deleted when the last handle goes away.
+ */
+struct CachedTexture {
+  GLuint id = 0;
+  size_t gpuBytes = 0; ///< Estimated GPU footprint.
+  std::string path;    ///< Canonical source path ("" for the fallback).
+
+  CachedTexture() = default;
+  ~CachedTexture();
+  CachedTexture(const CachedTexture &) = delete;
+  CachedTexture &operator=(const CachedTexture &) = delete;
+};
+
+/**
+ * @brief Caches textures by canonical path and modification time.
+ *
+ * acquire() returns the cached texture when the file hasn't changed since it
+ * was uploaded, so switching between known textures costs nothing. Misses
+ * either load synchronously (acquire) or stream in over several frames
+ * through a TextureStreamer (request / pollStream). Textures
+ * nobody holds a handle to stay resident until the GPU budget is exceeded,
+ * then the least recently used ones are released. A single shared white
+ * texture stands in for anything that fails to load. Must be used from the
+ * thread that owns the GL context.
+ */
+class TextureCache {
+public:
+  using Handle = std::shared_ptr<const CachedTexture>;
+
+  /**
+   * @param budgetBytes Resident GPU bytes above which idle textures are
+   * evicted (0 = evict idle textures immediately).
+   * @param settings Upload settings for every texture loaded by the cache.
+   */
+  explicit TextureCache(size_t budgetBytes,
+                        const TextureSettings &settings = {});
+
+  /**
+   * @brief Returns the texture for `filePath`, decoding and uploading it only
+   * on a miss or when the file changed on disk.
+   * @return The texture, or the shared fallback if loading failed.
+   */
+  Handle acquire(const std::string &filePath);
+
+  /**
+   * @brief acquire() for several files at once. Misses are decoded
+   * concurrently on worker threads, then uploaded here in order.
+   * @return One handle per path: null for an empty path, the fallback for a
+   * file that failed to load.
+   */
+  std::vector<Handle> acquireAll(const std::vector<std::string> &filePaths);
+
+  /**
+   * @brief Non-blocking acquire(): returns the cached texture if it is
+   * current, otherwise starts streaming it and returns null. Any earlier
+   * stream is abandoned.
+   */
+  Handle request(const std::string &filePath);
+
+  /**
+   * @brief Advances the stream started by request(); call once per frame.
+   * @return The texture once it is complete (the fallback if it failed to
+   * load), null while it is still in flight or nothing is streaming.
+   */
+  Handle pollStream();
+
+  bool streaming() const { return streamer_.active(); }
+
+  /**
+   * @brief Shared 64x64 white texture, created on first use.
+   */
+  Handle fallback();
+
+  bool isFallback(const Handle &texture) const {
+    return texture && texture == fallback_;
+  }
+
+  /**
+   * @brief Evicts idle textures until the resident size fits the budget.
+   */
+  void trim();
+
+  size_t residentBytes() const { return residentBytes_; }
+  size_t budgetBytes() const { return budgetBytes_; }
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    Handle texture;
+    std::filesystem::file_time_type modified;
+    uint64_t lastUse = 0;
+  };
+
+  /**
+   * @brief Resolves the cache key and modification time of a file.
+   * @return false (with a message on std::cerr) if the file is missing.
+   */
+  static bool identify(const std::string &filePath, std::string &key,
+                       std::filesystem::file_time_type &modified);
+
+  /**
+   * @brief Returns the entry for key if it is still current, dropping it if
+   * the file changed on disk.
+   */
+  Handle findCurrent(const std::string &key,
+                     std::filesystem::file_time_type modified);
+
+  Handle insert(const std::string &key,
+                std::filesystem::file_time_type modified, GLuint id);
+  void erase(std::unordered_map<std::string, Entry>::iterator it);
+
+  std::unordered_map<std::string, Entry> entries_; ///< By canonical path.
+  Handle fallback_;
+  TextureSettings settings_;
+  size_t budgetBytes_;
+  size_t residentBytes_ = 0;
+  uint64_t useClock_ = 0;
+
+  TextureStreamer streamer_;
+  std::string streamKey_; ///< Canonical path being streamed.
+  std::filesystem::file_time_type streamModified_;
+};
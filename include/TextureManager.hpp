@@ -1,22 +1,142 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
+#include "CompressedTexture.hpp"
+#include "DecodedImage.hpp"
 #include "OBJModel.hpp"
-#include <GLFW/glfw3.h>
+#include "GL.hpp"
+#include "ViewerOptions.hpp"
 
 /**
- * @brief TextureManager is responsible for loading textures (e.g., BMP files),
- *        generating fallback textures, and returning OpenGL texture IDs.
+ * @brief Pixel data ready for upload: either uncompressed levels or a
+ * block-compressed chain. Produced off the GL thread by
+ * TextureManager::decodeTexture.
+ */
+struct TextureData {
+  std::vector<DecodedImage> levels; ///< Level 0 first; empty if compressed.
+  CompressedImage compressed;       ///< Used when it has levels.
+
+  bool isCompressed() const { return !compressed.levels.empty(); }
+  int width() const;
+  int height() const;
+
+  /**
+   * @brief Heap bytes held (mapped files excluded).
+   */
+  size_t cpuBytes() const;
+};
+
+/**
+ * @brief What the current GL context supports, captured on the GL thread
+ * for decoding on another one.
+ */
+struct TextureLimits {
+  int maxSize = 0;   ///< GL_MAX_TEXTURE_SIZE, lowered by settings.maxSize.
+  bool s3tc = false; ///< EXT_texture_compression_s3tc is available.
+};
+
+/**
+ * @brief TextureManager is responsible for loading textures (BMP, DDS or KTX
+ *        files), generating fallback textures, and returning OpenGL texture
+ *        IDs.
  */
 class TextureManager {
 public:
   /**
-   * @brief Loads a BMP texture from file and returns its OpenGL texture ID.
-   * @param filePath The path to the .bmp file.
+   * @brief Loads a texture file and returns its OpenGL texture ID.
+   *
+   * BMP images larger than GL_MAX_TEXTURE_SIZE or settings.maxSize are halved
+   * until they fit. Unless mipmaps are off, the full chain is uploaded and
+   * the texture is sampled trilinearly. DDS/KTX files are uploaded as stored
+   * with glCompressedTexImage2D.
+   * @param filePath The path to the .bmp, .dds or .ktx file.
+   * @param settings Mipmap mode, size cap and compression.
    * @return GLuint OpenGL texture ID (0 if loading failed).
    */
-  static GLuint loadBMPTexture(const std::string &filePath);
+  static GLuint loadTexture(const std::string &filePath,
+                            const TextureSettings &settings = {});
+
+  /**
+   * @brief Uploads data decoded by decodeTexture() in one go: createTexture()
+   * plus finishTexture().
+   * @param filePath Source of the data, for the log line.
+   * @return The new texture ID.
+   */
+  static GLuint uploadTexture(const std::string &filePath,
+                              const TextureData &data,
+                              const TextureSettings &settings);
+
+  /**
+   * @brief Queries the limits decodeTexture needs. Needs a current GL
+   * context.
+   */
+  static TextureLimits queryLimits(const TextureSettings &settings);
+
+  /**
+   * @brief Reads a texture file into uploadable data. Touches no GL state, so
+   * it may run on any thread.
+   *
+   * DDS/KTX files are memory-mapped and passed through, or decompressed when
+   * S3TC is unavailable. BMPs are decoded, downscaled to limits.maxSize and,
+   * for MipmapMode::CPU, given a mip chain; with settings.compress they are
+   * then BC1/BC3-encoded, or loaded from the encoded-texture cache.
+   * @return false if the file could not be read.
+   */
+  static bool decodeTexture(const std::string &filePath,
+                            const TextureSettings &settings,
+                            const TextureLimits &limits, TextureData &data);
+
+  /**
+   * @brief Creates a texture for decoded data and charges its GPU memory.
+   * @param withPixels false leaves the levels empty; the caller then fills
+   * them with uploadRows() or uploadCompressedLevel().
+   * @return The new texture, left bound to GL_TEXTURE_2D.
+   */
+  static GLuint createTexture(const TextureData &data,
+                              const TextureSettings &settings,
+                              bool withPixels);
+
+  /**
+   * @brief Number of levels of `data` that createTexture() uses.
+   */
+  static size_t uploadLevelCount(const TextureData &data,
+                                 const TextureSettings &settings);
+
+  /**
+   * @brief Uploads rows [firstRow, firstRow + rowCount) of one level into the
+   * bound texture. `pixels` is a client pointer, or an offset into the bound
+   * GL_PIXEL_UNPACK_BUFFER.
+   */
+  static void uploadRows(GLint level, const DecodedImage &image, int firstRow,
+                         int rowCount, const void *pixels);
+
+  /**
+   * @brief Uploads one compressed level into the bound texture. `pixels` is
+   * a client pointer or an unpack buffer offset, as for uploadRows().
+   */
+  static void uploadCompressedLevel(GLint level, BlockFormat format,
+                                    const CompressedLevel &image,
+                                    const void *pixels);
+
+  /**
+   * @brief Completes a texture once every level is uploaded (driver mipmap
+   * generation for MipmapMode::GL).
+   */
+  static void finishTexture(GLuint textureID, const TextureData &data,
+                            const TextureSettings &settings);
+
+  /**
+   * @brief "cpu", "gl" or "off".
+   */
+  static const char *mipmapModeName(MipmapMode mode);
+
+  /**
+   * @brief "BC1", "BC3", ...
+   */
+  static const char *blockFormatName(BlockFormat format);
 
   /**
    * @brief Generates a solid-white texture of the specified size and returns
@@ -27,6 +147,20 @@ public:
    */
   static GLuint generateWhiteTexture(unsigned int width, unsigned int height);
 
+  /**
+   * @brief Deletes a texture created by this class and releases its memory
+   *        accounting. Does nothing for texture 0.
+   * @param textureID OpenGL texture ID.
+   */
+  static void deleteTexture(GLuint textureID);
+
+  /**
+   * @brief Estimated GPU bytes of a texture created by this class.
+   * @param textureID OpenGL texture ID.
+   * @return Size charged to MemoryTag::GPU_TEXTURES, or 0 if unknown.
+   */
+  static size_t textureBytes(GLuint textureID);
+
 private:
   TextureManager() = default; // Disallow instantiation
 };
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "GL.hpp"
+#include "MemoryTracker.hpp"
+#include "TextureManager.hpp"
+#include "ViewerOptions.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Loads one texture at a time without stalling the render thread.
+ *
+ * start() hands the file to a worker thread that runs
+ * TextureManager::decodeTexture (decode, downscale, mip chain, BC encoding).
+ * pump(), called once per frame from the GL thread, then streams the levels
+ * into the texture through a pixel unpack buffer, uploading at most
+ * `uploadBytesPerFrame` per call so large images spread over several frames:
+ * uncompressed levels in row bands, compressed ones a level at a time.
+ * Starting a new load abandons the previous one.
+ */
+class TextureStreamer {
+public:
+  enum class Status {
+    IDLE,   ///< Nothing requested.
+    BUSY,   ///< Decoding or uploading.
+    DONE,   ///< The texture is complete; ownership passed to the caller.
+    FAILED  ///< The file could not be decoded.
+  };
+
+  /**
+   * @param settings Mipmap mode and size cap applied to every load.
+   * @param uploadBytesPerFrame Upload budget of a single pump() call.
+   */
+  TextureStreamer(const TextureSettings &settings, size_t uploadBytesPerFrame);
+
+  /**
+   * @brief Stops the worker and deletes any partially uploaded texture. Must
+   * run on the GL thread.
+   */
+  ~TextureStreamer();
+
+  TextureStreamer(const TextureStreamer &) = delete;
+  TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+  /**
+   * @brief Starts loading `filePath`, abandoning any load in progress.
+   */
+  void start(const std::string &filePath);
+
+  /**
+   * @brief Abandons the load in progress, if any.
+   */
+  void cancel();
+
+  /**
+   * @brief true from start() until pump() reports DONE or FAILED.
+   */
+  bool active() const { return active_; }
+
+  /**
+   * @brief Advances the current load by one frame's upload budget.
+   * @param textureID Receives the finished texture when DONE is returned.
+   */
+  Status pump(GLuint &textureID);
+
+private:
+  struct Job {
+    uint64_t generation = 0;
+    std::string path;
+    TextureLimits limits;
+  };
+
+  struct Result {
+    bool ok = false;
+    TextureData data;
+  };
+
+  void workerLoop();
+  const void *stage(const unsigned char *src, size_t bytes);
+  void unstage();
+  void releaseUpload();
+
+  TextureSettings settings_;
+  size_t uploadBytesPerFrame_;
+  TextureLimits limits_;
+  bool limitsKnown_ = false; ///< limits_ is queried on the first start().
+
+  // Worker hand-off, guarded by mutex_
+  std::mutex mutex_;
+  std::condition_variable jobReady_;
+  Job job_;
+  bool hasJob_ = false;
+  Result result_;
+  bool hasResult_ = false;
+  uint64_t latestGeneration_ = 0;
+  bool stopping_ = false;
+  std::thread worker_;
+
+  // GL thread only
+  bool active_ = false;
+  std::string path_;
+  GLuint texture_ = 0;
+  GLuint pixelBuffer_ = 0;
+  TextureData data_; ///< Decoded levels being uploaded.
+  MemoryTracker::Allocation decodedMemory_;
+  size_t levelCount_ = 0; ///< Levels createTexture() set up.
+  size_t level_ = 0;      ///< Next level to upload.
+  int row_ = 0;      ///< Next row of that level.
+  size_t frames_ = 0; ///< pump() calls spent uploading.
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free single-producer / single-consumer triple buffer.
+ *
+ * The producer fills writeBuffer() and calls publish(); the consumer calls
+ * acquire() and then reads readBuffer(). Neither side ever blocks: the
+ * consumer always sees the most recently published complete slot, and the
+ * producer always has a private slot to write into.
+ */
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() : middle_(1), frontIndex_(0), backIndex_(2) {}
+
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  /**
+   * @brief Slot owned by the producer until the next publish().
+   */
+  T &writeBuffer() { return buffers_[backIndex_]; }
+
+  /**
+   * @brief Makes the write slot visible to the consumer and takes ownership
+   * of the previous middle slot for the next write.
+   */
+  void publish() {
+    std::uint8_t previous = middle_.exchange(
+        static_cast<std::uint8_t>(backIndex_ | kDirtyBit),
+        std::memory_order_acq_rel);
+    backIndex_ = previous & kIndexMask;
+  }
+
+  /**
+   * @brief Swaps in the latest published slot, if any.
+   * @return true if a new slot became readable, false if nothing changed.
+   */
+  bool acquire() {
+    if ((middle_.load(std::memory_order_relaxed) & kDirtyBit) == 0) {
+      return false;
+    }
+    std::uint8_t previous =
+        middle_.exchange(frontIndex_, std::memory_order_acq_rel);
+    frontIndex_ = previous & kIndexMask;
+    return true;
+  }
+
+  /**
+   * @brief Slot owned by the consumer until the next acquire().
+   */
+  const T &readBuffer() const { return buffers_[frontIndex_]; }
+
+private:
+  static constexpr std::uint8_t kIndexMask = 0x3;
+  static constexpr std::uint8_t kDirtyBit = 0x4;
+
+  std::array<T, 3> buffers_;
+  std::atomic<std::uint8_t> middle_; ///< Shared slot index plus dirty bit.
+  std::uint8_t frontIndex_;          ///< Consumer-owned slot.
+  std::uint8_t backIndex_;           ///< Producer-owned slot.
+};
@@ -5,34 +5,34 @@
 struct Vector3 {
   float x, y, z;
 
-  Vector3() : x(0), y(0), z(0) {}
-  Vector3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+  constexpr Vector3() : x(0), y(0), z(0) {}
+  constexpr Vector3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
 
-  Vector3 operator+(const Vector3 &rhs) const {
+  constexpr Vector3 operator+(const Vector3 &rhs) const {
     return Vector3(x + rhs.x, y + rhs.y, z + rhs.z);
   }
 
-  Vector3 operator-(const Vector3 &rhs) const {
+  constexpr Vector3 operator-(const Vector3 &rhs) const {
     return Vector3(x - rhs.x, y - rhs.y, z - rhs.z);
   }
 
-  Vector3 operator*(float scalar) const {
+  constexpr Vector3 operator*(float scalar) const {
     return Vector3(x * scalar, y * scalar, z * scalar);
   }
 
   // Overload operator+=
-  Vector3 &operator+=(const Vector3 &rhs) {
+  constexpr Vector3 &operator+=(const Vector3 &rhs) {
     x += rhs.x;
     y += rhs.y;
     z += rhs.z;
     return *this;
   }
 
-  float dot(const Vector3 &rhs) const {
+  constexpr float dot(const Vector3 &rhs) const {
     return x * rhs.x + y * rhs.y + z * rhs.z;
   }
 
-  Vector3 cross(const Vector3 &rhs) const {
+  constexpr Vector3 cross(const Vector3 &rhs) const {
     return Vector3(y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z,
                    x * rhs.y - y * rhs.x);
   }
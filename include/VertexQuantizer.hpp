@@ -0,0 +1,37 @@
+#pragma once
+
+#include "DrawBatches.hpp"
+#include "ViewerOptions.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Packs the float vertex attributes of DrawBatches into
+ * QuantizedVertices: 16 bytes per corner instead of 32.
+ *
+ * Positions become 16-bit integers over the model's bounding box, per axis,
+ * and texture coordinates 16-bit integers over their own range; both are
+ * mapped back by a matrix applied on the GPU side. Normals become signed
+ * bytes. The worst error of each attribute is measured against the float
+ * data and reported.
+ */
+class VertexQuantizer {
+public:
+  /// Corners from which QuantizeMode::AUTO quantizes a mesh.
+  static constexpr size_t kAutoMinCorners = 1000000;
+
+  /**
+   * @brief true if a mesh of `corners` corners is quantized under `mode`.
+   */
+  static bool shouldQuantize(QuantizeMode mode, size_t corners);
+
+  /**
+   * @brief Fills batches.quantized and releases the float positions,
+   * normals and texture coordinates. Anything that reads those (submesh
+   * bounds, occluder selection) must run first. Prints the sizes and errors.
+   */
+  static void quantize(DrawBatches &batches);
+
+private:
+  VertexQuantizer() = default; // Disallow instantiation
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "OBJModel.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Merges vertex positions that lie within an epsilon of each other.
+ *
+ * Vertices are bucketed into a spatial hash grid whose cells are at least
+ * epsilon wide, so every candidate lies in one of the 27 cells around a
+ * vertex. Each vertex picks the lowest-indexed neighbour within epsilon as
+ * its representative and chains are collapsed afterwards, which keeps the
+ * result deterministic regardless of how the work is split across threads.
+ */
+class VertexWelder {
+public:
+  /**
+   * @brief Welds positions, remaps every FaceVertex::vertexIndex and drops
+   * faces left with fewer than three distinct corners.
+   * @param model The model to clean up in place.
+   * @param epsilon Maximum distance between merged positions (0 = exact
+   * duplicates only).
+   * @return Number of vertices removed.
+   */
+  static size_t weld(OBJModel &model, float epsilon);
+
+private:
+  VertexWelder() = default; // Disallow instantiation
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief How texture mip levels are produced.
+ */
+enum class MipmapMode {
+  CPU, ///< Gamma-correct box filter in MipmapGenerator (default).
+  GL,  ///< Driver-generated with glGenerateMipmap / GL_GENERATE_MIPMAP.
+  OFF  ///< Level 0 only, bilinear minification.
+};
+
+/**
+ * @brief Which models get quantized vertex attributes (VertexQuantizer).
+ */
+enum class QuantizeMode {
+  OFF,  ///< Float attributes for every model.
+  ON,   ///< Quantize every mesh.
+  AUTO  ///< Quantize meshes with many corners (default).
+};
+
+/**
+ * @brief Texture upload settings.
+ */
+struct TextureSettings {
+  MipmapMode mipmaps = MipmapMode::CPU;
+  int maxSize = 0; ///< Downscale larger images (0 = GL_MAX_TEXTURE_SIZE only).
+  bool compress = false; ///< Encode BMPs to BC1/BC3 on load.
+  std::string cacheDir;  ///< Encoded texture cache ("" = per-user default).
+};
+
+/**
+ * @brief Runtime settings collected from the command line.
+ */
+struct ViewerOptions {
+  double fpsCap = 60.0; ///< Max frames per second while animating (0 = off).
+  float creaseAngle = 60.0f; ///< Smoothing limit for generated normals (deg).
+  float weldEpsilon = -1.0f; ///< Vertex weld distance at load (< 0 = off).
+  size_t benchFrames = 0; ///< Exit after this many rendered frames (0 = off).
+  size_t textureBudgetMB = 256; ///< GPU memory kept for cached textures.
+  size_t pageBudgetMB = 512; ///< Memory for resident out-of-core mesh pages.
+  size_t pointBudget = 5000000; ///< Points drawn per frame (0 = all).
+  QuantizeMode quantize = QuantizeMode::AUTO; ///< Compact vertex formats.
+  double sequenceFps = 24.0;   ///< Playback rate of model sequences.
+  size_t sequencePrefetch = 8; ///< Sequence frames decoded ahead.
+  bool watchFiles = true; ///< Hot-reload changed model and texture files.
+  TextureSettings texture;       ///< Mipmapping, size and compression.
+};
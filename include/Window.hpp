@@ -3,7 +3,7 @@
 
 #include "Camera.hpp"
 #include "OBJModel.hpp"
-#include <GLFW/glfw3.h>
+#include "GL.hpp"
 #include <string>
 
 constexpr int kDefaultWidth = 1920;
@@ -37,6 +37,13 @@ public:
    */
   static GLFWwindow *createWindow(Window windowConfig);
 
+  /**
+   * @brief Loads OpenGL entry points and extensions for the current context.
+   * Must be called after glfwMakeContextCurrent.
+   * @return true if GLEW initialized, false otherwise.
+   */
+  static bool initializeGLEW();
+
   /**
    * @brief Runs the main rendering loop until the user closes the window.
    * @param window Valid pointer to a GLFW window.
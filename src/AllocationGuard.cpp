@@ -0,0 +1,132 @@
+#include "AllocationGuard.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+
+// Per thread, so allocations on the update thread or in the driver's
+// worker threads don't count against the render loop.
+thread_local size_t threadAllocations = 0;
+
+} // end anonymous namespace
+
+#if defined(SCOP_ALLOC_GUARD)
+
+namespace {
+
+void *countedAllocate(std::size_t size) {
+  ++threadAllocations;
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+  ++threadAllocations;
+  std::size_t align = static_cast<std::size_t>(alignment);
+  // aligned_alloc requires the size to be a multiple of the alignment.
+  std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) &
+                        ~(align - 1);
+  return std::aligned_alloc(align, rounded);
+}
+
+} // end anonymous namespace
+
+void *operator new(std::size_t size) {
+  if (void *p = countedAllocate(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+  if (void *p = countedAllocate(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAllocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAllocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  if (void *p = countedAllocateAligned(size, alignment)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  if (void *p = countedAllocateAligned(size, alignment)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+#endif
+
+AllocationGuard::AllocationGuard(size_t warmupFrames)
+    : warmupFrames_(warmupFrames) {}
+
+bool AllocationGuard::enabled() {
+#if defined(SCOP_ALLOC_GUARD)
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t AllocationGuard::threadAllocationCount() { return threadAllocations; }
+
+void AllocationGuard::beginFrame() {
+  if (enabled()) {
+    frameStartCount_ = threadAllocations;
+  }
+}
+
+void AllocationGuard::endFrame() {
+  if (!enabled()) {
+    return;
+  }
+  size_t allocations = threadAllocations - frameStartCount_;
+  if (frames_++ < warmupFrames_ || allocations == 0) {
+    return;
+  }
+
+  if (violatingFrames_ < kMaxReports) {
+    std::cerr << "AllocationGuard: frame " << frames_ << " performed "
+              << allocations << " heap allocation(s)\n";
+  }
+  ++violatingFrames_;
+  worstFrameAllocations_ = std::max(worstFrameAllocations_, allocations);
+}
+
+void AllocationGuard::printSummary(std::ostream &out) const {
+  if (!enabled()) {
+    return;
+  }
+  size_t checked = frames_ > warmupFrames_ ? frames_ - warmupFrames_ : 0;
+  out << "AllocationGuard: " << checked << " frames checked after "
+      << warmupFrames_ << " warm-up frames, " << violatingFrames_
+      << " allocated (worst " << worstFrameAllocations_ << ")\n"
+      << (failed() ? "Checks FAILED.\n" : "All checks passed.\n");
+}
@@ -1,47 +1,315 @@
 #include "ArgumentParser.hpp"
+#include "CompressedTexture.hpp"
+#include "SequencePlayer.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+bool hasExtension(const std::string &path, const char *extension) {
+  const std::string ext(extension);
+  return path.size() >= ext.size() &&
+         path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool isTexturePath(const std::string &path) {
+  return hasExtension(path, ".bmp") ||
+         CompressedTextureFile::isContainerPath(path);
+}
+
+} // end anonymous namespace
 
 void Parser::printUsage(const char *programName) {
-  std::cerr << "Usage: " << programName << " <path/to/your/model.obj>\n";
+  std::cerr << "Usage: " << programName
+            << " [options] <path/to/your/model.obj|.obj.gz|.ply|.stl> "
+               "[path/to/texture.bmp|.dds|.ktx] [more models [texture]]...\n"
+            << "A directory or a quoted pattern (\"frames/frame_*.obj\") "
+               "plays as a sequence.\n"
+            << "Options:\n"
+            << "  --fps-cap <n>       Frame rate cap while animating (0 = off, "
+               "default 60)\n"
+            << "  --crease-angle <d>  Max angle smoothed by generated normals "
+               "(default 60)\n"
+            << "  --weld <eps>        Merge vertices closer than eps on load "
+               "(0 = exact duplicates)\n"
+            << "  --bench-frames <n>  Render n frames, then exit (used by "
+               "make alloc-guard)\n"
+            << "  --texture-budget <MiB>  GPU memory for cached textures "
+               "(default 256)\n"
+            << "  --mipmaps <mode>    cpu (gamma-correct, default), gl or "
+               "off\n"
+            << "  --max-texture-size <px>  Downscale larger textures (default: "
+               "driver limit)\n"
+            << "  --texture-compression <bc|off>  Encode BMP textures to "
+               "BC1/BC3 on load (default off)\n"
+            << "  --texture-cache-dir <dir>  Where encoded textures are kept "
+               "(default ~/.cache/scop/textures)\n"
+            << "  --page-budget <MiB> Memory for resident pages of .scpg "
+               "meshes (default 512)\n"
+            << "  --point-budget <n>  Points drawn per frame for point clouds "
+               "(0 = all, default 5000000)\n"
+            << "  --quantize <mode>   Compact 16-bit vertex attributes: on, "
+               "off or auto (meshes of 1M+ corners, default)\n"
+            << "  --sequence-fps <n>  Playback rate of sequences (default "
+               "24)\n"
+            << "  --prefetch <n>      Sequence frames decoded ahead of "
+               "playback (default 8)\n"
+            << "  --watch <on|off>    Reload models and textures when their "
+               "files change (default on)\n"
+            << "Out-of-core meshes: " << programName
+            << " --build-pages <model.obj> <model.scpg> [triangles per page]\n";
 }
 
-Parser::Parser(int argc, char **argv, OBJModel &model) {
-  parseArguments(argc, argv, model);
+bool Parser::parseOption(int argc, char **argv, int &index) {
+  const std::string name = argv[index];
+  if (index + 1 >= argc) {
+    std::cerr << "Missing value for option " << name << "\n";
+    return false;
+  }
+  const std::string value = argv[++index];
+
+  try {
+    if (name == "--fps-cap") {
+      options.fpsCap = std::stod(value);
+      if (options.fpsCap < 0.0) {
+        std::cerr << "--fps-cap must not be negative.\n";
+        return false;
+      }
+      return true;
+    }
+    if (name == "--crease-angle") {
+      options.creaseAngle = std::stof(value);
+      if (options.creaseAngle < 0.0f || options.creaseAngle > 180.0f) {
+        std::cerr << "--crease-angle must be within [0, 180].\n";
+        return false;
+      }
+      return true;
+    }
+    if (name == "--bench-frames") {
+      long frames = std::stol(value);
+      if (frames <= 0) {
+        std::cerr << "--bench-frames must be positive.\n";
+        return false;
+      }
+      options.benchFrames = static_cast<size_t>(frames);
+      return true;
+    }
+    if (name == "--texture-budget") {
+      long budget = std::stol(value);
+      if (budget < 0) {
+        std::cerr << "--texture-budget must not be negative.\n";
+        return false;
+      }
+      options.textureBudgetMB = static_cast<size_t>(budget);
+      return true;
+    }
+    if (name == "--mipmaps") {
+      if (value == "cpu") {
+        options.texture.mipmaps = MipmapMode::CPU;
+      } else if (value == "gl") {
+        options.texture.mipmaps = MipmapMode::GL;
+      } else if (value == "off") {
+        options.texture.mipmaps = MipmapMode::OFF;
+      } else {
+        std::cerr << "--mipmaps must be cpu, gl or off.\n";
+        return false;
+      }
+      return true;
+    }
+    if (name == "--max-texture-size") {
+      options.texture.maxSize = std::stoi(value);
+      if (options.texture.maxSize < 1) {
+        std::cerr << "--max-texture-size must be positive.\n";
+        return false;
+      }
+      return true;
+    }
+    if (name == "--texture-compression") {
+      if (value != "bc" && value != "off") {
+        std::cerr << "--texture-compression must be bc or off.\n";
+        return false;
+      }
+      options.texture.compress = value == "bc";
+      return true;
+    }
+    if (name == "--texture-cache-dir") {
+      options.texture.cacheDir = value;
+      return true;
+    }
+    if (name == "--page-budget") {
+      long budget = std::stol(value);
+      if (budget <= 0) {
+        std::cerr << "--page-budget must be positive.\n";
+        return false;
+      }
+      options.pageBudgetMB = static_cast<size_t>(budget);
+      return true;
+    }
+    if (name == "--point-budget") {
+      long budget = std::stol(value);
+      if (budget < 0) {
+        std::cerr << "--point-budget must not be negative.\n";
+        return false;
+      }
+      options.pointBudget = static_cast<size_t>(budget);
+      return true;
+    }
+    if (name == "--quantize") {
+      if (value == "on") {
+        options.quantize = QuantizeMode::ON;
+      } else if (value == "off") {
+        options.quantize = QuantizeMode::OFF;
+      } else if (value == "auto") {
+        options.quantize = QuantizeMode::AUTO;
+      } else {
+        std::cerr << "--quantize must be on, off or auto.\n";
+        return false;
+      }
+      return true;
+    }
+    if (name == "--sequence-fps") {
+      options.sequenceFps = std::stod(value);
+      if (options.sequenceFps <= 0.0) {
+        std::cerr << "--sequence-fps must be positive.\n";
+        return false;
+      }
+      return true;
+    }
+    if (name == "--prefetch") {
+      long frames = std::stol(value);
+      if (frames <= 0) {
+        std::cerr << "--prefetch must be positive.\n";
+        return false;
+      }
+      options.sequencePrefetch = static_cast<size_t>(frames);
+      return true;
+    }
+    if (name == "--watch") {
+      if (value != "on" && value != "off") {
+        std::cerr << "--watch must be on or off.\n";
+        return false;
+      }
+      options.watchFiles = value == "on";
+      return true;
+    }
+    if (name == "--weld") {
+      options.weldEpsilon = std::stof(value);
+      if (options.weldEpsilon < 0.0f) {
+        std::cerr << "--weld must not be negative.\n";
+        return false;
+      }
+      return true;
+    }
+  } catch (const std::exception &) {
+    std::cerr << "Invalid value for option " << name << ": " << value << "\n";
+    return false;
+  }
+
+  std::cerr << "Unknown option: " << name << "\n";
+  return false;
 }
 
+Parser::Parser(int argc, char **argv) { parseArguments(argc, argv); }
+
 bool Parser::getSuccess() const { return this->success; }
 
-void Parser::parseArguments(int argc, char **argv, OBJModel &model) {
-  // We expect exactly one argument for the path to the .obj file.
-  if (argc != 2 && argc != 3) {
-    printUsage(argv[0]);
-    return;
-  }
+const ViewerOptions &Parser::getOptions() const { return this->options; }
 
-  model.textureName = (argc == 3) ? argv[2] : "objs/texturized/white.bmp";
+const std::vector<SceneEntry> &Parser::getScene() const { return this->scene; }
 
-  // The user-provided .obj file path
-  const std::string filePath = argv[1];
-  model.objectName = filePath;
-  if (filePath.substr(filePath.size() - 4) != ".obj") {
-    std::cerr << "Invalid file extension. Please provide a .obj file.\n";
-    return;
+void Parser::parseArguments(int argc, char **argv) {
+  // Split "--option value" pairs from the positional arguments.
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]).rfind("--", 0) == 0) {
+      if (!parseOption(argc, argv, i)) {
+        printUsage(argv[0]);
+        return;
+      }
+    } else {
+      positional.push_back(argv[i]);
+    }
   }
-  std::cerr << "Loading OBJ file: " << filePath << "\n";
 
-  // Attempt to load the OBJ file
-  if (!OBJLoader::loadOBJ(filePath, model)) {
-    std::cerr << "Failed to load OBJ file.\n";
+  // We expect .obj paths, each optionally followed by its texture path.
+  if (positional.empty()) {
+    printUsage(argv[0]);
     return;
   }
+  for (const std::string &path : positional) {
+    if (SequencePlayer::isSequencePath(path)) {
+      std::vector<std::string> frames = SequencePlayer::listFrames(path);
+      if (frames.size() < 2) {
+        std::cerr << "Sequence " << path
+                  << " needs at least two model files.\n";
+        return;
+      }
+      for (const SceneEntry &entry : scene) {
+        if (!entry.sequenceFrames.empty()) {
+          std::cerr << "Only one sequence can play at a time.\n";
+          return;
+        }
+      }
+      std::cout << "Sequence " << path << ": " << frames.size()
+                << " frames\n";
+      scene.push_back({frames[0], "", nullptr, std::move(frames)});
+    } else if (!isTexturePath(path) &&
+               SceneLoader::formatOf(path) != ModelFormat::UNKNOWN) {
+      scene.push_back({path, "", nullptr, {}});
+    } else if (isTexturePath(path) && !scene.empty() &&
+               scene.back().texturePath.empty()) {
+      scene.back().texturePath = path;
+    } else {
+      std::cerr << "Invalid argument " << path
+                << ". Please provide model files (.obj, .obj.gz, .obj.zst, "
+                   ".ply, .stl or .scpg), each optionally followed by one "
+                   "texture.\n";
+      printUsage(argv[0]);
+      return;
+    }
+  }
+  if (scene[0].texturePath.empty()) {
+    scene[0].texturePath = "objs/texturized/white.bmp";
+  }
+
+  std::vector<std::string> modelPaths;
+  for (const SceneEntry &entry : scene) {
+    modelPaths.push_back(entry.modelPath);
+  }
+  std::cerr << "Loading " << modelPaths.size() << " model file(s)\n";
+  std::vector<std::shared_ptr<const RenderModel>> models =
+      SceneLoader::loadModels(modelPaths, options);
 
-  // If successful, print some stats
-  std::cout << "Loaded OBJ file successfully!\n";
-  std::cout << "Object Name:    " << model.objectName << "\n";
-  std::cout << "Texture Name:   " << model.textureName << "\n";
-  std::cout << "Vertices:       " << model.vertices.size() << "\n";
-  std::cout << "Texture Coords: " << model.texCoords.size() << "\n";
-  std::cout << "Normals:        " << model.normals.size() << "\n";
-  std::cout << "Faces:          " << model.faces.size() << "\n";
+  // If successful, print some stats once per distinct model
+  std::unordered_set<const RenderModel *> printed;
+  for (size_t i = 0; i < scene.size(); ++i) {
+    if (!models[i]) {
+      std::cerr << "Failed to load model file.\n";
+      return;
+    }
+    scene[i].model = models[i];
+    if (!printed.insert(models[i].get()).second) {
+      continue;
+    }
+    const OBJModel &model = models[i]->model;
+    if (models[i]->pages) {
+      continue; // PagedMesh::open printed its summary.
+    }
+    std::cout << "Loaded OBJ file successfully!\n";
+    std::cout << "Object Name:    " << model.objectName << "\n";
+    std::cout << "Texture Name:   " << scene[i].texturePath << "\n";
+    std::cout << "Vertices:       " << model.vertices.size() << "\n";
+    std::cout << "Texture Coords: " << model.texCoords.size() << "\n";
+    std::cout << "Normals:        " << model.normals.size() << "\n";
+    std::cout << "Faces:          " << model.faces.size() << "\n";
+  }
+  if (scene.size() > 1) {
+    std::cout << "Scene:          " << scene.size() << " nodes, "
+              << printed.size() << " distinct models\n";
+  }
 
   this->success = true;
 }
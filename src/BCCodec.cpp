@@ -0,0 +1,409 @@
+#include "BCCodec.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Block rows per worker; a row of a 4096-wide texture is 1024 blocks.
+constexpr size_t kBlockRowsPerChunk = 4;
+
+// Position along the endpoint axis (0 = first endpoint) -> BC color index.
+constexpr uint8_t kColorIndex[4] = {0, 2, 3, 1};
+
+struct ColorEndpoints {
+  uint16_t c0 = 0, c1 = 0;
+  int p0[3] = {0, 0, 0};  ///< c0 expanded back to 8 bits.
+  int dir[3] = {0, 0, 0}; ///< Expanded c1 - c0.
+  float scale = 0.0f;     ///< 3 / |dir|^2, or 0 for a flat block.
+};
+
+uint16_t pack565(int r, int g, int b) {
+  return static_cast<uint16_t>(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+void expand565(uint16_t c, int rgb[3]) {
+  int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * @brief Endpoints from the block's per-channel min/max, inset by 1/16 of the
+ * range to pull them toward the bulk of the texels. Since max >= min on every
+ * channel, c0 >= c1 and the block always decodes in 4-color mode unless it is
+ * flat.
+ */
+ColorEndpoints colorEndpoints(const uint8_t mn[4], const uint8_t mx[4]) {
+  int lo[3], hi[3];
+  for (int c = 0; c < 3; ++c) {
+    int inset = (mx[c] - mn[c]) >> 4;
+    lo[c] = mn[c] + inset;
+    hi[c] = mx[c] - inset;
+  }
+  ColorEndpoints e;
+  e.c0 = pack565(hi[0], hi[1], hi[2]);
+  e.c1 = pack565(lo[0], lo[1], lo[2]);
+  if (e.c0 == e.c1) {
+    return e;
+  }
+  int p1[3];
+  expand565(e.c0, e.p0);
+  expand565(e.c1, p1);
+  int length2 = 0;
+  for (int c = 0; c < 3; ++c) {
+    e.dir[c] = p1[c] - e.p0[c];
+    length2 += e.dir[c] * e.dir[c];
+  }
+  e.scale = 3.0f / static_cast<float>(length2);
+  return e;
+}
+
+void writeColorBlock(const ColorEndpoints &e, const int positions[16],
+                     uint8_t out[8]) {
+  uint32_t indices = 0;
+  if (e.c0 != e.c1) {
+    for (int i = 0; i < 16; ++i) {
+      int t = std::min(std::max(positions[i], 0), 3);
+      indices |= static_cast<uint32_t>(kColorIndex[t]) << (2 * i);
+    }
+  }
+  out[0] = static_cast<uint8_t>(e.c0);
+  out[1] = static_cast<uint8_t>(e.c0 >> 8);
+  out[2] = static_cast<uint8_t>(e.c1);
+  out[3] = static_cast<uint8_t>(e.c1 >> 8);
+  std::memcpy(out + 4, &indices, 4);
+}
+
+void blockBounds(const uint8_t rgba[64], uint8_t mn[4], uint8_t mx[4]) {
+  for (int c = 0; c < 4; ++c) {
+    mn[c] = 255;
+    mx[c] = 0;
+  }
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      mn[c] = std::min(mn[c], rgba[i * 4 + c]);
+      mx[c] = std::max(mx[c], rgba[i * 4 + c]);
+    }
+  }
+}
+
+/**
+ * @brief Reference color kernel. Projections go through float exactly as in
+ * the SSE2 kernel (lrintf and cvtps2dq both round to nearest even), so both
+ * produce identical blocks.
+ */
+void encodeColorScalar(const uint8_t rgba[64], uint8_t mn[4], uint8_t mx[4],
+                       uint8_t out[8]) {
+  blockBounds(rgba, mn, mx);
+  ColorEndpoints e = colorEndpoints(mn, mx);
+  int positions[16] = {};
+  if (e.c0 != e.c1) {
+    for (int i = 0; i < 16; ++i) {
+      int d = (rgba[i * 4] - e.p0[0]) * e.dir[0] +
+              (rgba[i * 4 + 1] - e.p0[1]) * e.dir[1] +
+              (rgba[i * 4 + 2] - e.p0[2]) * e.dir[2];
+      positions[i] = static_cast<int>(std::lrintf(static_cast<float>(d) * e.scale));
+    }
+  }
+  writeColorBlock(e, positions, out);
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief Horizontal min/max of the four RGBA texels in a register, broadcast
+ * to every texel slot.
+ */
+__m128i reduceTexels(__m128i v, bool takeMin) {
+  __m128i swapped = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  v = takeMin ? _mm_min_epu8(v, swapped) : _mm_max_epu8(v, swapped);
+  swapped = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+  return takeMin ? _mm_min_epu8(v, swapped) : _mm_max_epu8(v, swapped);
+}
+
+/**
+ * @brief Dot products of four texels (relative to p0) with the axis.
+ */
+__m128i projectTexels(__m128i texels, __m128i p0, __m128i dir) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(texels, zero), p0),
+                              dir);
+  __m128i hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(texels, zero), p0),
+                              dir);
+  // lo = [rg0, ba0, rg1, ba1], hi = [rg2, ba2, rg3, ba3]
+  __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                               _MM_SHUFFLE(2, 0, 2, 0));
+  __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi),
+                              _MM_SHUFFLE(3, 1, 3, 1));
+  return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+void encodeColorSse2(const uint8_t rgba[64], uint8_t mn[4], uint8_t mx[4],
+                     uint8_t out[8]) {
+  __m128i texels[4];
+  for (int i = 0; i < 4; ++i) {
+    texels[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgba) + i);
+  }
+  __m128i lo = _mm_min_epu8(_mm_min_epu8(texels[0], texels[1]),
+                            _mm_min_epu8(texels[2], texels[3]));
+  __m128i hi = _mm_max_epu8(_mm_max_epu8(texels[0], texels[1]),
+                            _mm_max_epu8(texels[2], texels[3]));
+  uint32_t packedMin = static_cast<uint32_t>(
+      _mm_cvtsi128_si32(reduceTexels(lo, true)));
+  uint32_t packedMax = static_cast<uint32_t>(
+      _mm_cvtsi128_si32(reduceTexels(hi, false)));
+  std::memcpy(mn, &packedMin, 4);
+  std::memcpy(mx, &packedMax, 4);
+
+  ColorEndpoints e = colorEndpoints(mn, mx);
+  alignas(16) int32_t positions[16] = {};
+  if (e.c0 != e.c1) {
+    const __m128i p0 = _mm_setr_epi16(
+        static_cast<short>(e.p0[0]), static_cast<short>(e.p0[1]),
+        static_cast<short>(e.p0[2]), 0, static_cast<short>(e.p0[0]),
+        static_cast<short>(e.p0[1]), static_cast<short>(e.p0[2]), 0);
+    const __m128i dir = _mm_setr_epi16(
+        static_cast<short>(e.dir[0]), static_cast<short>(e.dir[1]),
+        static_cast<short>(e.dir[2]), 0, static_cast<short>(e.dir[0]),
+        static_cast<short>(e.dir[1]), static_cast<short>(e.dir[2]), 0);
+    const __m128 scale = _mm_set1_ps(e.scale);
+    for (int i = 0; i < 4; ++i) {
+      __m128i d = projectTexels(texels[i], p0, dir);
+      _mm_store_si128(reinterpret_cast<__m128i *>(positions) + i,
+                      _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(d), scale)));
+    }
+  }
+  writeColorBlock(e, positions, out);
+}
+#endif
+
+/**
+ * @brief BC3 alpha block: 8-value mode between the block's alpha extremes,
+ * so fully opaque and fully transparent texels stay exact.
+ */
+void encodeAlpha(const uint8_t rgba[64], uint8_t amin, uint8_t amax,
+                 uint8_t out[8]) {
+  out[0] = amax;
+  out[1] = amin;
+  uint64_t bits = 0;
+  if (amax != amin) {
+    float scale = 7.0f / static_cast<float>(amax - amin);
+    for (int i = 0; i < 16; ++i) {
+      int t = static_cast<int>(
+          std::lrintf(static_cast<float>(rgba[i * 4 + 3] - amin) * scale));
+      t = std::min(std::max(t, 0), 7);
+      // t = 7 is amax (index 0), t = 0 is amin (index 1), the rest
+      // interpolate from amax downwards (indices 2..7).
+      uint64_t index = t == 7 ? 0 : t == 0 ? 1 : 8 - t;
+      bits |= index << (3 * i);
+    }
+  }
+  for (int i = 0; i < 6; ++i) {
+    out[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+}
+
+/**
+ * @brief Gathers a 4x4 block as RGBA, repeating the last row/column past the
+ * image edge. RGB images get opaque alpha.
+ */
+void gatherBlock(const DecodedImage &image, int bx, int by, uint8_t rgba[64]) {
+  const int channels = image.channels;
+  for (int y = 0; y < 4; ++y) {
+    int sy = std::min(by * 4 + y, image.height - 1);
+    const unsigned char *row =
+        image.pixels.data() + static_cast<size_t>(sy) * image.width * channels;
+    for (int x = 0; x < 4; ++x) {
+      int sx = std::min(bx * 4 + x, image.width - 1);
+      const unsigned char *p = row + static_cast<size_t>(sx) * channels;
+      uint8_t *dst = rgba + (y * 4 + x) * 4;
+      dst[0] = p[0];
+      dst[1] = p[1];
+      dst[2] = p[2];
+      dst[3] = channels == 4 ? p[3] : 255;
+    }
+  }
+}
+
+void decodeColorBlock(const unsigned char *block, bool allowPunchThrough,
+                      uint8_t rgba[64]) {
+  uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+  uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+  int p[4][4];
+  expand565(c0, p[0]);
+  expand565(c1, p[1]);
+  p[0][3] = p[1][3] = 255;
+  bool fourColor = c0 > c1 || !allowPunchThrough;
+  for (int c = 0; c < 3; ++c) {
+    if (fourColor) {
+      p[2][c] = (2 * p[0][c] + p[1][c]) / 3;
+      p[3][c] = (p[0][c] + 2 * p[1][c]) / 3;
+    } else {
+      p[2][c] = (p[0][c] + p[1][c]) / 2;
+      p[3][c] = 0;
+    }
+  }
+  p[2][3] = 255;
+  p[3][3] = fourColor ? 255 : 0;
+
+  uint32_t indices;
+  std::memcpy(&indices, block + 4, 4);
+  for (int i = 0; i < 16; ++i) {
+    const int *color = p[(indices >> (2 * i)) & 3];
+    for (int c = 0; c < 4; ++c) {
+      rgba[i * 4 + c] = static_cast<uint8_t>(color[c]);
+    }
+  }
+}
+
+void decodeAlphaBlock(const unsigned char *block, uint8_t rgba[64]) {
+  int a0 = block[0], a1 = block[1];
+  int palette[8] = {a0, a1};
+  if (a0 > a1) {
+    for (int i = 2; i < 8; ++i) {
+      palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+  } else {
+    for (int i = 2; i < 6; ++i) {
+      palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+  uint64_t bits = 0;
+  for (int i = 0; i < 6; ++i) {
+    bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+  }
+  for (int i = 0; i < 16; ++i) {
+    rgba[i * 4 + 3] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+  }
+}
+
+void decodeExplicitAlpha(const unsigned char *block, uint8_t rgba[64]) {
+  for (int i = 0; i < 16; ++i) {
+    int nibble = (block[i / 2] >> (4 * (i & 1))) & 15;
+    rgba[i * 4 + 3] = static_cast<uint8_t>(nibble * 17);
+  }
+}
+
+} // end anonymous namespace
+
+size_t BCCodec::blockBytes(BlockFormat format) {
+  return format == BlockFormat::BC1 || format == BlockFormat::BC1A ? 8 : 16;
+}
+
+size_t BCCodec::encodedSize(BlockFormat format, int width, int height) {
+  size_t blocksX = static_cast<size_t>(std::max(1, (width + 3) / 4));
+  size_t blocksY = static_cast<size_t>(std::max(1, (height + 3) / 4));
+  return blocksX * blocksY * blockBytes(format);
+}
+
+bool BCCodec::isOpaque(const DecodedImage &image) {
+  if (image.channels != 4) {
+    return true;
+  }
+  for (size_t i = 3; i < image.pixels.size(); i += 4) {
+    if (image.pixels[i] != 255) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BCCodec::encode(const DecodedImage &image, BlockFormat format,
+                     std::vector<unsigned char> &out, bool useSimd) {
+  const int blocksX = std::max(1, (image.width + 3) / 4);
+  const int blocksY = std::max(1, (image.height + 3) / 4);
+  const size_t bytesPerBlock = blockBytes(format);
+  const bool withAlpha = format == BlockFormat::BC3;
+  out.assign(encodedSize(format, image.width, image.height), 0);
+  if (image.width <= 0 || image.height <= 0) {
+    return;
+  }
+
+#if defined(__SSE2__)
+  auto colorKernel = useSimd ? encodeColorSse2 : encodeColorScalar;
+#else
+  (void)useSimd;
+  auto colorKernel = encodeColorScalar;
+#endif
+
+  Parallel::forRange(blocksY, kBlockRowsPerChunk, [&](size_t begin,
+                                                      size_t end) {
+    alignas(16) uint8_t rgba[64];
+    uint8_t mn[4], mx[4];
+    for (size_t by = begin; by < end; ++by) {
+      unsigned char *dst = out.data() + by * blocksX * bytesPerBlock;
+      for (int bx = 0; bx < blocksX; ++bx, dst += bytesPerBlock) {
+        gatherBlock(image, bx, static_cast<int>(by), rgba);
+        if (withAlpha) {
+          colorKernel(rgba, mn, mx, dst + 8);
+          encodeAlpha(rgba, mn[3], mx[3], dst);
+        } else {
+          colorKernel(rgba, mn, mx, dst);
+        }
+      }
+    }
+  });
+}
+
+bool BCCodec::decode(const unsigned char *data, size_t size,
+                     BlockFormat format, int width, int height,
+                     DecodedImage &out) {
+  if (width <= 0 || height <= 0 || size < encodedSize(format, width, height)) {
+    return false;
+  }
+  const int blocksX = (width + 3) / 4;
+  const int blocksY = (height + 3) / 4;
+  const size_t bytesPerBlock = blockBytes(format);
+  out.width = width;
+  out.height = height;
+  out.channels = 4;
+  out.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+  Parallel::forRange(blocksY, kBlockRowsPerChunk, [&](size_t begin,
+                                                      size_t end) {
+    uint8_t rgba[64];
+    for (size_t by = begin; by < end; ++by) {
+      for (int bx = 0; bx < blocksX; ++bx) {
+        const unsigned char *block =
+            data + (by * blocksX + bx) * bytesPerBlock;
+        switch (format) {
+        case BlockFormat::BC1:
+        case BlockFormat::BC1A:
+          decodeColorBlock(block, format == BlockFormat::BC1A, rgba);
+          break;
+        case BlockFormat::BC2:
+          decodeColorBlock(block + 8, false, rgba);
+          decodeExplicitAlpha(block, rgba);
+          break;
+        case BlockFormat::BC3:
+          decodeColorBlock(block + 8, false, rgba);
+          decodeAlphaBlock(block, rgba);
+          break;
+        }
+        for (int y = 0; y < 4; ++y) {
+          int py = static_cast<int>(by) * 4 + y;
+          if (py >= height) {
+            break;
+          }
+          for (int x = 0; x < 4 && bx * 4 + x < width; ++x) {
+            std::memcpy(&out.pixels[(static_cast<size_t>(py) * width +
+                                     bx * 4 + x) *
+                                    4],
+                        rgba + (y * 4 + x) * 4, 4);
+          }
+        }
+      }
+    }
+  });
+  return true;
+}
@@ -0,0 +1,294 @@
+#include "BMPDecoder.hpp"
+#include "MappedFile.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Rows are split into bands of at least this many bytes per thread.
+constexpr size_t kBytesPerChunk = 1 << 20;
+
+constexpr uint32_t kCompressionRGB = 0;
+constexpr uint32_t kCompressionBitfields = 3;
+
+uint16_t readU16(const unsigned char *p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readU32(const unsigned char *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+int32_t readS32(const unsigned char *p) {
+  return static_cast<int32_t>(readU32(p));
+}
+
+/**
+ * @brief Converts one row of `width` pixels from BGR(A) to RGB(A).
+ */
+using RowKernel = void (*)(const unsigned char *src, unsigned char *dst,
+                           size_t width, bool opaque);
+
+// Scalar tails: convert pixels [begin, width).
+void swizzleRow24Scalar(const unsigned char *src, unsigned char *dst,
+                        size_t width, size_t begin) {
+  for (size_t x = begin; x < width; ++x) {
+    dst[x * 3 + 0] = src[x * 3 + 2];
+    dst[x * 3 + 1] = src[x * 3 + 1];
+    dst[x * 3 + 2] = src[x * 3 + 0];
+  }
+}
+
+void swizzleRow32Scalar(const unsigned char *src, unsigned char *dst,
+                        size_t width, bool opaque, size_t begin) {
+  for (size_t x = begin; x < width; ++x) {
+    dst[x * 4 + 0] = src[x * 4 + 2];
+    dst[x * 4 + 1] = src[x * 4 + 1];
+    dst[x * 4 + 2] = src[x * 4 + 0];
+    dst[x * 4 + 3] = opaque ? 255 : src[x * 4 + 3];
+  }
+}
+
+void rowScalar24(const unsigned char *src, unsigned char *dst, size_t width,
+                 bool) {
+  swizzleRow24Scalar(src, dst, width, 0);
+}
+
+void rowScalar32(const unsigned char *src, unsigned char *dst, size_t width,
+                 bool opaque) {
+  swizzleRow32Scalar(src, dst, width, opaque, 0);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Four BGR pixels (12 bytes) -> RGB; the last four lanes pass through and
+// are overwritten by the next iteration.
+__attribute__((target("ssse3"))) void
+rowSsse3_24(const unsigned char *src, unsigned char *dst, size_t width, bool) {
+  const __m128i mask =
+      _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+  const size_t bytes = width * 3;
+  size_t x = 0;
+  // Every 16-byte load/store must stay inside this row.
+  for (; x * 3 + 16 <= bytes; x += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 3),
+                     _mm_shuffle_epi8(v, mask));
+  }
+  swizzleRow24Scalar(src, dst, width, x);
+}
+
+__attribute__((target("ssse3"))) void rowSsse3_32(const unsigned char *src,
+                                                  unsigned char *dst,
+                                                  size_t width, bool opaque) {
+  const __m128i mask =
+      _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  const __m128i alpha =
+      opaque ? _mm_set1_epi32(static_cast<int>(0xFF000000u)) : _mm_setzero_si128();
+  size_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4),
+                     _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+  }
+  swizzleRow32Scalar(src, dst, width, opaque, x);
+}
+
+// Eight BGR pixels: 12 bytes into each 128-bit lane, shuffle per lane, then
+// pack the two 12-byte halves together with a dword permute.
+__attribute__((target("avx2"))) void
+rowAvx2_24(const unsigned char *src, unsigned char *dst, size_t width, bool) {
+  const __m256i mask = _mm256_setr_epi8(
+      2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15, 2, 1, 0, 5, 4, 3,
+      8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+  const __m256i pack = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+  const size_t bytes = width * 3;
+  size_t x = 0;
+  for (; x * 3 + 32 <= bytes; x += 8) {
+    const unsigned char *p = src + x * 3;
+    __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 12)), 1);
+    v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, mask), pack);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x * 3), v);
+  }
+  rowSsse3_24(src + x * 3, dst + x * 3, width - x, false);
+}
+
+__attribute__((target("avx2"))) void rowAvx2_32(const unsigned char *src,
+                                                unsigned char *dst,
+                                                size_t width, bool opaque) {
+  const __m256i mask = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5,
+      4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  const __m256i alpha = opaque
+                            ? _mm256_set1_epi32(static_cast<int>(0xFF000000u))
+                            : _mm256_setzero_si256();
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x * 4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x * 4),
+                        _mm256_or_si256(_mm256_shuffle_epi8(v, mask), alpha));
+  }
+  rowSsse3_32(src + x * 4, dst + x * 4, width - x, opaque);
+}
+#endif
+
+enum class SimdLevel { SCALAR, SSSE3, AVX2 };
+
+SimdLevel detectSimdLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return SimdLevel::SSSE3;
+  }
+#endif
+  return SimdLevel::SCALAR;
+}
+
+SimdLevel simdLevel() {
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+RowKernel selectKernel(int bitsPerPixel, bool useSimd) {
+  SimdLevel level = useSimd ? simdLevel() : SimdLevel::SCALAR;
+#if defined(__x86_64__) || defined(__i386__)
+  if (level == SimdLevel::AVX2) {
+    return bitsPerPixel == 24 ? rowAvx2_24 : rowAvx2_32;
+  }
+  if (level == SimdLevel::SSSE3) {
+    return bitsPerPixel == 24 ? rowSsse3_24 : rowSsse3_32;
+  }
+#else
+  (void)level;
+#endif
+  return bitsPerPixel == 24 ? rowScalar24 : rowScalar32;
+}
+
+} // end anonymous namespace
+
+const char *BMPDecoder::simdPathName() {
+  switch (simdLevel()) {
+  case SimdLevel::AVX2:
+    return "AVX2";
+  case SimdLevel::SSSE3:
+    return "SSSE3";
+  default:
+    return "scalar";
+  }
+}
+
+bool BMPDecoder::load(const std::string &filePath, DecodedImage &out) {
+  MappedFile file;
+  if (!file.open(filePath)) {
+    return false;
+  }
+  if (!decode(file.data(), file.size(), out)) {
+    std::cerr << "Error: Failed to decode BMP: " << filePath << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool BMPDecoder::decode(const unsigned char *data, size_t size,
+                        DecodedImage &out, bool useSimd) {
+  // File header (14 bytes) + at least a BITMAPINFOHEADER (40 bytes)
+  if (size < 54 || data[0] != 'B' || data[1] != 'M') {
+    std::cerr << "Error: Not a BMP file.\n";
+    return false;
+  }
+
+  const uint32_t dataOffset = readU32(data + 10);
+  const uint32_t infoSize = readU32(data + 14);
+  const int32_t width = readS32(data + 18);
+  const int32_t rawHeight = readS32(data + 22);
+  const uint16_t planes = readU16(data + 26);
+  const uint16_t bpp = readU16(data + 28);
+  const uint32_t compression = readU32(data + 30);
+
+  if (infoSize < 40 || planes != 1) {
+    std::cerr << "Error: Unsupported BMP header (size " << infoSize
+              << ", planes " << planes << ").\n";
+    return false;
+  }
+  if (bpp != 24 && bpp != 32) {
+    std::cerr << "Error: BMP bit depth (" << bpp << ") is not 24 or 32.\n";
+    return false;
+  }
+  if (width <= 0 || rawHeight == 0 || rawHeight == INT32_MIN) {
+    std::cerr << "Error: Invalid BMP dimensions.\n";
+    return false;
+  }
+
+  // 32-bit files may be BI_RGB (4th byte unused) or BI_BITFIELDS with the
+  // standard BGRA masks; anything else would need per-channel shifts.
+  bool opaque = true;
+  if (compression == kCompressionBitfields && bpp == 32) {
+    if (size < 66 ||
+        readU32(data + 54) != 0x00FF0000u || // red
+        readU32(data + 58) != 0x0000FF00u || // green
+        readU32(data + 62) != 0x000000FFu) { // blue
+      std::cerr << "Error: Unsupported BMP channel masks.\n";
+      return false;
+    }
+    uint32_t alphaMask = (infoSize >= 56 && size >= 70) ? readU32(data + 66) : 0;
+    if (alphaMask != 0 && alphaMask != 0xFF000000u) {
+      std::cerr << "Error: Unsupported BMP alpha mask.\n";
+      return false;
+    }
+    opaque = alphaMask == 0;
+  } else if (compression != kCompressionRGB) {
+    std::cerr << "Error: BMP compression (" << compression
+              << ") is not supported.\n";
+    return false;
+  }
+
+  const bool bottomUp = rawHeight > 0;
+  const size_t height = static_cast<size_t>(bottomUp ? rawHeight : -rawHeight);
+  const size_t bytesPerPixel = bpp / 8;
+  const size_t srcRowSize = (static_cast<size_t>(width) * bytesPerPixel + 3) &
+                            ~static_cast<size_t>(3);
+  // The last row needn't carry its padding.
+  const uint64_t required = static_cast<uint64_t>(dataOffset) +
+                            static_cast<uint64_t>(srcRowSize) * (height - 1) +
+                            static_cast<uint64_t>(width) * bytesPerPixel;
+  if (required > size) {
+    std::cerr << "Error: BMP pixel data is truncated.\n";
+    return false;
+  }
+
+  out.width = width;
+  out.height = static_cast<int>(height);
+  out.channels = static_cast<int>(bytesPerPixel);
+  const size_t dstRowSize = static_cast<size_t>(width) * bytesPerPixel;
+  out.pixels.resize(dstRowSize * height);
+
+  const RowKernel kernel = selectKernel(bpp, useSimd);
+  const unsigned char *pixelData = data + dataOffset;
+  unsigned char *dstPixels = out.pixels.data();
+  const size_t rowsPerChunk =
+      std::max<size_t>(1, kBytesPerChunk / std::max<size_t>(dstRowSize, 1));
+
+  Parallel::forRange(height, rowsPerChunk, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; ++y) {
+      // Output is top row first; bottom-up files store the bottom row first.
+      size_t srcRow = bottomUp ? (height - 1 - y) : y;
+      kernel(pixelData + srcRow * srcRowSize, dstPixels + y * dstRowSize,
+             static_cast<size_t>(width), opaque);
+    }
+  });
+  return true;
+}
@@ -0,0 +1,463 @@
+#include "BVH.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+
+namespace {
+
+constexpr int kBinCount = 12;
+constexpr uint32_t kMaxLeafSize = 4;
+constexpr size_t kFacesPerChunk = 1 << 14;
+// Subtrees smaller than this are built on the current thread.
+constexpr uint32_t kParallelThreshold = 1 << 14;
+
+struct Bounds {
+  float min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+  float max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+  void extend(const Vector3 &p) {
+    min[0] = std::min(min[0], p.x);
+    min[1] = std::min(min[1], p.y);
+    min[2] = std::min(min[2], p.z);
+    max[0] = std::max(max[0], p.x);
+    max[1] = std::max(max[1], p.y);
+    max[2] = std::max(max[2], p.z);
+  }
+
+  void extend(const Bounds &b) {
+    for (int k = 0; k < 3; ++k) {
+      min[k] = std::min(min[k], b.min[k]);
+      max[k] = std::max(max[k], b.max[k]);
+    }
+  }
+
+  float area() const {
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    if (dx < 0.0f) {
+      return 0.0f;
+    }
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+  }
+};
+
+float component(const Vector3 &v, int axis) {
+  return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+} // end anonymous namespace
+
+void BVH::build(const OBJModel &model) {
+  auto start = std::chrono::steady_clock::now();
+
+  triangles_.clear();
+  centroids_.clear();
+  nodes_.clear();
+  appendedTrees_ = 0;
+
+  addTriangles(model, 0);
+  if (triangles_.empty()) {
+    return;
+  }
+  builtTriangles_ = triangles_.size();
+  buildRange(0, static_cast<uint32_t>(triangles_.size()), parallelDepth(),
+             nodes_);
+
+  // Centroids are only needed while building.
+  centroids_.clear();
+  centroids_.shrink_to_fit();
+
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Built BVH: " << triangles_.size() << " triangles, "
+            << nodes_.size() << " nodes in " << elapsed << " ms\n";
+}
+
+void BVH::append(const OBJModel &model, size_t firstFace) {
+  // Each append adds a level above the old root, and the appended subtrees
+  // overlap it; past a limit, one balanced build is cheaper to query.
+  if (nodes_.empty() || appendedTrees_ >= kMaxAppendedTrees ||
+      triangles_.size() > 2 * builtTriangles_) {
+    build(model);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  const uint32_t first = static_cast<uint32_t>(triangles_.size());
+  addTriangles(model, firstFace);
+  const uint32_t end = static_cast<uint32_t>(triangles_.size());
+  if (end == first) {
+    return;
+  }
+  std::vector<Node> tail;
+  buildRange(first, end, parallelDepth(), tail);
+  centroids_.clear();
+  centroids_.shrink_to_fit();
+
+  // New root: the old tree on the left, the new triangles on the right.
+  Node root;
+  for (int k = 0; k < 3; ++k) {
+    root.min[k] = std::min(nodes_[0].min[k], tail[0].min[k]);
+    root.max[k] = std::max(nodes_[0].max[k], tail[0].max[k]);
+  }
+  root.start = 0;
+  root.count = 0;
+  std::vector<Node> merged;
+  merged.reserve(1 + nodes_.size() + tail.size());
+  merged.push_back(root);
+  for (Node n : nodes_) {
+    if (n.count == 0) {
+      n.right += 1;
+    }
+    merged.push_back(n);
+  }
+  const uint32_t rightOffset = static_cast<uint32_t>(merged.size());
+  for (Node n : tail) {
+    if (n.count == 0) {
+      n.right += rightOffset;
+    }
+    merged.push_back(n);
+  }
+  merged[0].right = rightOffset;
+  nodes_ = std::move(merged);
+  ++appendedTrees_;
+
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Extended BVH: +" << end - first << " triangles, "
+            << nodes_.size() << " nodes in " << elapsed << " ms\n";
+}
+
+int BVH::parallelDepth() {
+  int depth = 0;
+  for (unsigned n = Parallel::workerCount(); n > 1; n >>= 1) {
+    ++depth;
+  }
+  return depth;
+}
+
+void BVH::addTriangles(const OBJModel &model, size_t firstFace) {
+  // Fan-triangulate faces. Offsets are computed first so the triangles can
+  // be written by several threads.
+  const size_t faceCount = model.faces.size() - firstFace;
+  const int vertexCount = static_cast<int>(model.vertices.size());
+  const size_t base = triangles_.size();
+  std::vector<uint32_t> firstTriangle(faceCount + 1, 0);
+  for (size_t f = 0; f < faceCount; ++f) {
+    size_t corners = model.faces[firstFace + f].vertices.size();
+    firstTriangle[f + 1] =
+        firstTriangle[f] + static_cast<uint32_t>(corners >= 3 ? corners - 2 : 0);
+  }
+  triangles_.resize(base + firstTriangle[faceCount]);
+
+  auto position = [&](const FaceVertex &fv, Vector3 &out) {
+    if (fv.vertexIndex < 0 || fv.vertexIndex >= vertexCount) {
+      return false;
+    }
+    const Vertex &v = model.vertices[fv.vertexIndex];
+    out = Vector3(v.x, v.y, v.z);
+    return true;
+  };
+
+  std::vector<char> valid(firstTriangle[faceCount], 0);
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      const auto &corners = model.faces[firstFace + f].vertices;
+      uint32_t t = firstTriangle[f];
+      for (size_t i = 1; i + 1 < corners.size(); ++i, ++t) {
+        Triangle &tri = triangles_[base + t];
+        tri.face = static_cast<uint32_t>(firstFace + f);
+        valid[t] = position(corners[0], tri.v0) &&
+                   position(corners[i], tri.v1) &&
+                   position(corners[i + 1], tri.v2);
+      }
+    }
+  });
+
+  // Drop triangles with out-of-range indices.
+  size_t kept = base;
+  for (size_t t = 0; t < valid.size(); ++t) {
+    if (valid[t]) {
+      triangles_[kept++] = triangles_[base + t];
+    }
+  }
+  triangles_.resize(kept);
+
+  centroids_.resize(triangles_.size());
+  Parallel::forRange(kept - base, kFacesPerChunk,
+                     [&](size_t begin, size_t end) {
+                       for (size_t t = base + begin; t < base + end; ++t) {
+                         const Triangle &tri = triangles_[t];
+                         centroids_[t] = (tri.v0 + tri.v1 + tri.v2) *
+                                         (1.0f / 3.0f);
+                       }
+                     });
+}
+
+void BVH::buildRange(uint32_t begin, uint32_t end, int parallelDepth,
+                     std::vector<Node> &out) {
+  Bounds bounds, centroidBounds;
+  for (uint32_t t = begin; t < end; ++t) {
+    bounds.extend(triangles_[t].v0);
+    bounds.extend(triangles_[t].v1);
+    bounds.extend(triangles_[t].v2);
+    centroidBounds.extend(centroids_[t]);
+  }
+
+  Node node;
+  for (int k = 0; k < 3; ++k) {
+    node.min[k] = bounds.min[k];
+    node.max[k] = bounds.max[k];
+  }
+  node.start = begin;
+  node.count = end - begin;
+  node.right = 0;
+
+  const uint32_t count = end - begin;
+  if (count <= kMaxLeafSize) {
+    out.push_back(node);
+    return;
+  }
+
+  // Evaluate SAH over kBinCount bins on every axis.
+  float bestCost = FLT_MAX;
+  int bestAxis = -1;
+  int bestSplit = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    float lo = centroidBounds.min[axis];
+    float extent = centroidBounds.max[axis] - lo;
+    if (extent <= 0.0f) {
+      continue;
+    }
+    float scale = kBinCount / extent;
+
+    Bounds binBounds[kBinCount];
+    uint32_t binCount[kBinCount] = {};
+    for (uint32_t t = begin; t < end; ++t) {
+      int bin = std::min(
+          kBinCount - 1,
+          static_cast<int>((component(centroids_[t], axis) - lo) * scale));
+      ++binCount[bin];
+      binBounds[bin].extend(triangles_[t].v0);
+      binBounds[bin].extend(triangles_[t].v1);
+      binBounds[bin].extend(triangles_[t].v2);
+    }
+
+    // Sweep from the right to get suffix areas, then from the left.
+    float rightArea[kBinCount];
+    uint32_t rightCount[kBinCount];
+    Bounds accum;
+    uint32_t accumCount = 0;
+    for (int i = kBinCount - 1; i > 0; --i) {
+      accum.extend(binBounds[i]);
+      accumCount += binCount[i];
+      rightArea[i] = accum.area();
+      rightCount[i] = accumCount;
+    }
+    accum = Bounds();
+    accumCount = 0;
+    for (int i = 0; i < kBinCount - 1; ++i) {
+      accum.extend(binBounds[i]);
+      accumCount += binCount[i];
+      if (accumCount == 0 || rightCount[i + 1] == 0) {
+        continue;
+      }
+      float cost = accum.area() * accumCount +
+                   rightArea[i + 1] * rightCount[i + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = i + 1;
+      }
+    }
+  }
+
+  // Splitting must beat intersecting every triangle of a leaf.
+  float leafCost = bounds.area() * count;
+  uint32_t mid = begin;
+  if (bestAxis >= 0 && bestCost < leafCost) {
+    float lo = centroidBounds.min[bestAxis];
+    float scale =
+        kBinCount / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+    uint32_t i = begin, j = end;
+    while (i < j) {
+      int bin = std::min(kBinCount - 1,
+                         static_cast<int>(
+                             (component(centroids_[i], bestAxis) - lo) * scale));
+      if (bin < bestSplit) {
+        ++i;
+      } else {
+        --j;
+        std::swap(triangles_[i], triangles_[j]);
+        std::swap(centroids_[i], centroids_[j]);
+      }
+    }
+    mid = i;
+  } else if (count > kMaxLeafSize * 4) {
+    // SAH found no useful split (e.g. all centroids coincide) but the leaf
+    // would be huge: fall back to a median split.
+    mid = begin + count / 2;
+  }
+
+  if (mid == begin || mid == end) {
+    out.push_back(node);
+    return;
+  }
+
+  node.count = 0;
+  size_t self = out.size();
+  out.push_back(node);
+
+  if (parallelDepth > 0 && count >= kParallelThreshold) {
+    // Left and right ranges are disjoint, so both subtrees can partition the
+    // shared triangle arrays concurrently into separate node lists.
+    std::vector<Node> leftNodes, rightNodes;
+    auto rightTask = std::async(std::launch::async, [&] {
+      buildRange(mid, end, parallelDepth - 1, rightNodes);
+    });
+    buildRange(begin, mid, parallelDepth - 1, leftNodes);
+    rightTask.get();
+
+    uint32_t leftOffset = static_cast<uint32_t>(out.size());
+    for (Node n : leftNodes) {
+      if (n.count == 0) {
+        n.right += leftOffset;
+      }
+      out.push_back(n);
+    }
+    uint32_t rightOffset = static_cast<uint32_t>(out.size());
+    for (Node n : rightNodes) {
+      if (n.count == 0) {
+        n.right += rightOffset;
+      }
+      out.push_back(n);
+    }
+    out[self].right = rightOffset;
+    return;
+  }
+
+  // Sequential: node indices are relative to `out`, which is the caller's
+  // list, so children can be appended in place.
+  buildRange(begin, mid, 0, out);
+  out[self].right = static_cast<uint32_t>(out.size());
+  buildRange(mid, end, 0, out);
+}
+
+RayHit BVH::intersect(const Vector3 &origin, const Vector3 &direction,
+                      const std::function<bool(size_t)> &acceptFace) const {
+  RayHit best;
+  if (nodes_.empty()) {
+    return best;
+  }
+
+  float invDir[3] = {1.0f / direction.x, 1.0f / direction.y,
+                     1.0f / direction.z};
+  float orig[3] = {origin.x, origin.y, origin.z};
+  float closest = FLT_MAX;
+
+  // Slab test; returns entry distance or FLT_MAX on a miss.
+  auto boxEntry = [&](const Node &n) {
+    float tmin = 0.0f, tmax = closest;
+    for (int k = 0; k < 3; ++k) {
+      float t0 = (n.min[k] - orig[k]) * invDir[k];
+      float t1 = (n.max[k] - orig[k]) * invDir[k];
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      tmin = std::max(tmin, t0);
+      tmax = std::min(tmax, t1);
+    }
+    return tmin <= tmax ? tmin : FLT_MAX;
+  };
+
+  // Traversal stack: nearly every ray fits the inline part, deeper trees
+  // (skewed splits, appended subtrees) spill into `overflow`.
+  constexpr int kInlineStack = 64;
+  uint32_t stack[kInlineStack];
+  std::vector<uint32_t> overflow;
+  int top = 0;
+  auto push = [&](uint32_t index) {
+    if (top < kInlineStack) {
+      stack[top++] = index;
+    } else {
+      overflow.push_back(index);
+    }
+  };
+  auto pop = [&] {
+    if (overflow.empty()) {
+      return stack[--top];
+    }
+    const uint32_t index = overflow.back();
+    overflow.pop_back();
+    return index;
+  };
+  if (boxEntry(nodes_[0]) == FLT_MAX) {
+    return best;
+  }
+  push(0);
+
+  while (top > 0) {
+    const Node &node = nodes_[pop()];
+
+    if (node.count > 0) {
+      // Möller-Trumbore against every triangle in the leaf.
+      for (uint32_t t = node.start; t < node.start + node.count; ++t) {
+        const Triangle &tri = triangles_[t];
+        if (acceptFace && !acceptFace(tri.face)) {
+          continue;
+        }
+        Vector3 e1 = tri.v1 - tri.v0;
+        Vector3 e2 = tri.v2 - tri.v0;
+        Vector3 p = direction.cross(e2);
+        float det = e1.dot(p);
+        if (std::fabs(det) < 1e-12f) {
+          continue;
+        }
+        float invDet = 1.0f / det;
+        Vector3 s = origin - tri.v0;
+        float u = s.dot(p) * invDet;
+        if (u < 0.0f || u > 1.0f) {
+          continue;
+        }
+        Vector3 q = s.cross(e1);
+        float v = direction.dot(q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) {
+          continue;
+        }
+        float dist = e2.dot(q) * invDet;
+        if (dist > 0.0f && dist < closest) {
+          closest = dist;
+          best.hit = true;
+          best.distance = dist;
+          best.faceIndex = tri.face;
+          best.u = u;
+          best.v = v;
+        }
+      }
+      continue;
+    }
+
+    // Visit the nearer child first so `closest` shrinks early.
+    uint32_t left = static_cast<uint32_t>(&node - nodes_.data()) + 1;
+    uint32_t right = node.right;
+    float tLeft = boxEntry(nodes_[left]);
+    float tRight = boxEntry(nodes_[right]);
+    if (tLeft > tRight) {
+      std::swap(left, right);
+      std::swap(tLeft, tRight);
+    }
+    if (tRight != FLT_MAX) {
+      push(right);
+    }
+    if (tLeft != FLT_MAX) {
+      push(left);
+    }
+  }
+  return best;
+}
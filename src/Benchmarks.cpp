@@ -0,0 +1,860 @@
+#include "Benchmarks.hpp"
+#include "BCCodec.hpp"
+#include "BMPDecoder.hpp"
+#include "BoundingVolumes.hpp"
+#include "CompressedTexture.hpp"
+#include "Matrix4.hpp"
+#include "MipmapGenerator.hpp"
+#include "OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps benchmark results observable so loops aren't optimized away.
+volatile float g_sink = 0.0f;
+
+/**
+ * @brief Runs `body` `repeat` times and returns the best wall time in ms.
+ */
+template <typename Body> double bestOf(int repeat, Body &&body) {
+  double best = 1e30;
+  for (int r = 0; r < repeat; ++r) {
+    Clock::time_point start = Clock::now();
+    body();
+    double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    best = std::min(best, ms);
+  }
+  return best;
+}
+
+void report(const char *name, double scalarMs, double simdMs, size_t items,
+            bool exact) {
+  std::printf("  %-22s scalar %8.3f ms  simd %8.3f ms  x%5.2f  %8.1f M/s  %s\n",
+              name, scalarMs, simdMs, scalarMs / simdMs,
+              static_cast<double>(items) / simdMs / 1000.0,
+              exact ? "ok" : "MISMATCH");
+}
+
+Matrix4 randomMatrix(std::mt19937 &rng) {
+  std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+  Matrix4 mat;
+  for (float &value : mat.m) {
+    value = dist(rng);
+  }
+  return mat;
+}
+
+/**
+ * @brief The stream-based 24-bit BMP loader the viewer used before
+ * BMPDecoder: read everything, then convert byte by byte.
+ */
+bool decodeBmpReference(const char *path, DecodedImage &out) {
+  std::ifstream file(path, std::ios::binary);
+  unsigned char header[54];
+  if (!file.read(reinterpret_cast<char *>(header), sizeof(header))) {
+    return false;
+  }
+  int width, height, dataOffset;
+  short bpp;
+  std::memcpy(&width, header + 18, 4);
+  std::memcpy(&height, header + 22, 4);
+  std::memcpy(&bpp, header + 28, 2);
+  std::memcpy(&dataOffset, header + 10, 4);
+  if (bpp != 24) {
+    return false;
+  }
+  bool bottomUp = height > 0;
+  height = bottomUp ? height : -height;
+  int rowSize = (width * 3 + 3) & ~3;
+
+  file.seekg(dataOffset, std::ios::beg);
+  std::vector<unsigned char> bmpData(static_cast<size_t>(rowSize) * height);
+  file.read(reinterpret_cast<char *>(bmpData.data()), bmpData.size());
+
+  out.width = width;
+  out.height = height;
+  out.channels = 3;
+  out.pixels.assign(static_cast<size_t>(width) * height * 3, 0);
+  for (int y = 0; y < height; ++y) {
+    int bmpY = bottomUp ? (height - 1 - y) : y;
+    for (int x = 0; x < width; ++x) {
+      int bmpIndex = y * rowSize + x * 3;
+      int pixelIndex = (bmpY * width + x) * 3;
+      out.pixels[pixelIndex + 0] = bmpData[bmpIndex + 2];
+      out.pixels[pixelIndex + 1] = bmpData[bmpIndex + 1];
+      out.pixels[pixelIndex + 2] = bmpData[bmpIndex + 0];
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Builds an in-memory BMP whose pixel (x, y) (y = 0 at the top) has a
+ * known BGRA value, to check every layout the decoder accepts.
+ */
+std::vector<unsigned char> makeTestBmp(int width, int height, int bpp,
+                                       bool topDown, uint32_t compression,
+                                       uint32_t alphaMask) {
+  const uint32_t infoSize = compression == 3 ? 56 : 40;
+  const uint32_t dataOffset = 14 + infoSize;
+  const int rowSize = (width * (bpp / 8) + 3) & ~3;
+  std::vector<unsigned char> file(dataOffset + rowSize * height, 0);
+  auto put32 = [&](size_t at, uint32_t value) {
+    std::memcpy(&file[at], &value, 4);
+  };
+  auto put16 = [&](size_t at, uint16_t value) {
+    std::memcpy(&file[at], &value, 2);
+  };
+
+  file[0] = 'B';
+  file[1] = 'M';
+  put32(2, static_cast<uint32_t>(file.size()));
+  put32(10, dataOffset);
+  put32(14, infoSize);
+  put32(18, static_cast<uint32_t>(width));
+  put32(22, static_cast<uint32_t>(topDown ? -height : height));
+  put16(26, 1);
+  put16(28, static_cast<uint16_t>(bpp));
+  put32(30, compression);
+  if (compression == 3) {
+    put32(54, 0x00FF0000u);
+    put32(58, 0x0000FF00u);
+    put32(62, 0x000000FFu);
+    put32(66, alphaMask);
+  }
+
+  for (int y = 0; y < height; ++y) {
+    int fileRow = topDown ? y : height - 1 - y;
+    unsigned char *row = &file[dataOffset + fileRow * rowSize];
+    for (int x = 0; x < width; ++x) {
+      unsigned char *p = row + x * (bpp / 8);
+      p[0] = static_cast<unsigned char>(x * 7 + y);     // B
+      p[1] = static_cast<unsigned char>(x + y * 13);    // G
+      p[2] = static_cast<unsigned char>(x * 3 ^ y * 5); // R
+      if (bpp == 32) {
+        p[3] = static_cast<unsigned char>(x + y);       // A
+      }
+    }
+  }
+  return file;
+}
+
+/**
+ * @brief Straightforward gamma-correct 2x2 reduction: pow() per channel and
+ * per pixel, no tables, no SIMD, one thread.
+ */
+DecodedImage downsampleReference(const DecodedImage &source) {
+  auto toLinear = [](unsigned char c) {
+    float v = c / 255.0f;
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+  };
+  auto toSrgb = [](float l) {
+    float v = l <= 0.0031308f ? l * 12.92f
+                              : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+    return static_cast<unsigned char>(
+        std::lround(std::min(std::max(v, 0.0f), 1.0f) * 255.0f));
+  };
+  DecodedImage out;
+  out.width = std::max(1, source.width / 2);
+  out.height = std::max(1, source.height / 2);
+  out.channels = source.channels;
+  out.pixels.resize(static_cast<size_t>(out.width) * out.height *
+                    out.channels);
+  const int ch = source.channels;
+  for (int y = 0; y < out.height; ++y) {
+    int y0 = std::min(2 * y, source.height - 1);
+    int y1 = std::min(2 * y + 1, source.height - 1);
+    for (int x = 0; x < out.width; ++x) {
+      int x0 = std::min(2 * x, source.width - 1);
+      int x1 = std::min(2 * x + 1, source.width - 1);
+      for (int c = 0; c < ch; ++c) {
+        auto at = [&](int px, int py) {
+          return source.pixels[(static_cast<size_t>(py) * source.width + px) *
+                                   ch + c];
+        };
+        unsigned char *dst =
+            &out.pixels[(static_cast<size_t>(y) * out.width + x) * ch + c];
+        if (c == 3) {
+          *dst = static_cast<unsigned char>(std::lround(
+              (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1)) / 4.0f));
+        } else {
+          *dst = toSrgb((toLinear(at(x0, y0)) + toLinear(at(x1, y0)) +
+                         toLinear(at(x0, y1)) + toLinear(at(x1, y1))) *
+                        0.25f);
+        }
+      }
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief PSNR (dB) of the RGB channels of `decoded` (RGBA) against `source`.
+ */
+double rgbPsnr(const DecodedImage &source, const DecodedImage &decoded) {
+  double squared = 0.0;
+  size_t texels = static_cast<size_t>(source.width) * source.height;
+  for (size_t i = 0; i < texels; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      double d = source.pixels[i * source.channels + c] -
+                 decoded.pixels[i * 4 + c];
+      squared += d * d;
+    }
+  }
+  double mse = squared / (texels * 3.0);
+  return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+/**
+ * @brief Largest per-byte difference between two same-shaped images.
+ */
+int maxDifference(const DecodedImage &a, const DecodedImage &b) {
+  if (a.width != b.width || a.height != b.height ||
+      a.pixels.size() != b.pixels.size()) {
+    return 256;
+  }
+  int worst = 0;
+  for (size_t i = 0; i < a.pixels.size(); ++i) {
+    worst = std::max(worst, std::abs(a.pixels[i] - b.pixels[i]));
+  }
+  return worst;
+}
+
+} // end anonymous namespace
+
+bool Benchmarks::run(const std::string &suite) {
+  if (suite == "math") {
+    return runMath();
+  }
+  if (suite == "bounds") {
+    return runBounds();
+  }
+  if (suite == "bmp") {
+    return runBmp();
+  }
+  if (suite == "mip") {
+    return runMipmaps();
+  }
+  if (suite == "bc") {
+    return runBlockCompression();
+  }
+  if (suite == "hiz") {
+    return runOcclusion();
+  }
+  std::cerr << "Unknown benchmark suite: " << suite
+            << " (available: math, bounds, bmp, mip, bc, hiz)\n";
+  return false;
+}
+
+bool Benchmarks::runMath() {
+  constexpr size_t kMatrices = 1 << 16;
+  constexpr size_t kPoints = 1 << 20;
+  constexpr int kRepeat = 5;
+
+  // The scalar helpers must stay usable in constant expressions.
+  static_assert(Matrix4::multiply(Matrix4(), Matrix4()).m[0] == 1.0f);
+  static_assert(Matrix4().transposed().m[15] == 1.0f);
+  static_assert(Matrix4().transform(Vector3(1, 2, 3)).z == 3.0f);
+
+  std::mt19937 rng(42);
+  std::vector<Matrix4> lhs(kMatrices), rhs(kMatrices);
+  for (size_t i = 0; i < kMatrices; ++i) {
+    lhs[i] = randomMatrix(rng);
+    rhs[i] = randomMatrix(rng);
+  }
+  std::vector<Matrix4> scalarOut(kMatrices), simdOut(kMatrices);
+  bool allPassed = true;
+
+  std::printf("Matrix4 / batch transform benchmark (best of %d)\n", kRepeat);
+
+  // Multiply: bit-identical (== so that +0 and -0 compare equal)
+  double scalarMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kMatrices; ++i)
+      scalarOut[i] = Matrix4::multiplyScalar(lhs[i], rhs[i]);
+  });
+  double simdMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kMatrices; ++i)
+      simdOut[i] = Matrix4::multiply(lhs[i], rhs[i]);
+  });
+  bool exact = true;
+  for (size_t i = 0; i < kMatrices && exact; ++i)
+    for (int k = 0; k < 16; ++k)
+      exact = exact && scalarOut[i].m[k] == simdOut[i].m[k];
+  report("multiply", scalarMs, simdMs, kMatrices, exact);
+  allPassed = allPassed && exact;
+
+  // Transpose: bit-identical
+  scalarMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kMatrices; ++i) {
+      Matrix4 &out = scalarOut[i];
+      for (int row = 0; row < 4; ++row)
+        for (int col = 0; col < 4; ++col)
+          out.m[col + row * 4] = lhs[i].m[row + col * 4];
+    }
+  });
+  simdMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kMatrices; ++i)
+      simdOut[i] = lhs[i].transposed();
+  });
+  exact = true;
+  for (size_t i = 0; i < kMatrices && exact; ++i)
+    for (int k = 0; k < 16; ++k)
+      exact = exact && scalarOut[i].m[k] == simdOut[i].m[k];
+  report("transpose", scalarMs, simdMs, kMatrices, exact);
+  allPassed = allPassed && exact;
+
+  // Inverse: different evaluation order, so compare M * inv(M) to identity
+  // and both results to each other with a relative tolerance.
+  std::vector<bool> scalarOk(kMatrices), simdOk(kMatrices);
+  scalarMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kMatrices; ++i)
+      scalarOk[i] = lhs[i].inverseScalar(scalarOut[i]);
+  });
+  simdMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kMatrices; ++i)
+      simdOk[i] = lhs[i].inverse(simdOut[i]);
+  });
+  bool close = true;
+  for (size_t i = 0; i < kMatrices && close; ++i) {
+    if (scalarOk[i] != simdOk[i] || !scalarOk[i])
+      continue;
+    Matrix4 product = Matrix4::multiply(lhs[i], simdOut[i]);
+    float scale = 0.0f;
+    for (int k = 0; k < 16; ++k)
+      scale = std::max(scale, std::fabs(scalarOut[i].m[k]));
+    // Skip ill-conditioned random matrices; their inverses are noise.
+    if (scale > 100.0f)
+      continue;
+    float tolerance = 1e-3f * std::max(1.0f, scale);
+    for (int k = 0; k < 16; ++k) {
+      float identity = (k % 5 == 0) ? 1.0f : 0.0f;
+      close = close && std::fabs(product.m[k] - identity) < tolerance &&
+              std::fabs(scalarOut[i].m[k] - simdOut[i].m[k]) < tolerance;
+    }
+  }
+  report("inverse", scalarMs, simdMs, kMatrices, close);
+  allPassed = allPassed && close;
+
+  // Batch transforms against Matrix4::transform (projective, with divide)
+  std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+  std::vector<Vector3> points(kPoints);
+  std::vector<float> xs(kPoints), ys(kPoints), zs(kPoints);
+  for (size_t i = 0; i < kPoints; ++i) {
+    points[i] = Vector3(dist(rng), dist(rng), dist(rng));
+    xs[i] = points[i].x;
+    ys[i] = points[i].y;
+    zs[i] = points[i].z;
+  }
+  Matrix4 mvp = Matrix4::multiply(Matrix4::perspective(45.0f, 1.5f, 0.1f, 100.0f),
+                                  Matrix4::lookAt(Vector3(0, 2, 25),
+                                                  Vector3(0, 0, 0),
+                                                  Vector3(0, 1, 0)));
+
+  std::vector<Vector3> reference(kPoints), aos(kPoints);
+  std::vector<float> outX(kPoints), outY(kPoints), outZ(kPoints);
+  scalarMs = bestOf(kRepeat, [&] {
+    for (size_t i = 0; i < kPoints; ++i)
+      reference[i] = mvp.transform(points[i]);
+  });
+  simdMs = bestOf(kRepeat, [&] {
+    mvp.transformPoints(&points[0].x, &aos[0].x, kPoints);
+  });
+  exact = true;
+  for (size_t i = 0; i < kPoints && exact; ++i)
+    exact = reference[i].x == aos[i].x && reference[i].y == aos[i].y &&
+            reference[i].z == aos[i].z;
+  report("transform AoS", scalarMs, simdMs, kPoints, exact);
+  allPassed = allPassed && exact;
+
+  simdMs = bestOf(kRepeat, [&] {
+    mvp.transformPointsSoA(xs.data(), ys.data(), zs.data(), outX.data(),
+                           outY.data(), outZ.data(), kPoints);
+  });
+  exact = true;
+  for (size_t i = 0; i < kPoints && exact; ++i)
+    exact = reference[i].x == outX[i] && reference[i].y == outY[i] &&
+            reference[i].z == outZ[i];
+  report("transform SoA", scalarMs, simdMs, kPoints, exact);
+  allPassed = allPassed && exact;
+
+  g_sink = g_sink + simdOut[0].m[0] + aos[kPoints - 1].x + outZ[0];
+  std::printf("%s\n", allPassed ? "All checks passed." : "Checks FAILED.");
+  return allPassed;
+}
+
+bool Benchmarks::runBounds() {
+  constexpr size_t kVertices = 10000000;
+  constexpr int kRepeat = 5;
+
+  std::mt19937 rng(7);
+  std::normal_distribution<float> dist(0.0f, 3.0f);
+  std::vector<Vertex> vertices(kVertices);
+  for (Vertex &v : vertices) {
+    v = {dist(rng) * 2.0f + 1.0f, dist(rng) - 4.0f, dist(rng) * 0.5f};
+  }
+
+  std::printf("Bounding volumes over %zu vertices (best of %d)\n", kVertices,
+              kRepeat);
+
+  // Reference: the branchy scalar loop the viewer used to run.
+  AABB reference;
+  double scalarMs = bestOf(kRepeat, [&] {
+    reference.min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+    reference.max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (const Vertex &v : vertices) {
+      if (v.x < reference.min.x)
+        reference.min.x = v.x;
+      if (v.x > reference.max.x)
+        reference.max.x = v.x;
+      if (v.y < reference.min.y)
+        reference.min.y = v.y;
+      if (v.y > reference.max.y)
+        reference.max.y = v.y;
+      if (v.z < reference.min.z)
+        reference.min.z = v.z;
+      if (v.z > reference.max.z)
+        reference.max.z = v.z;
+    }
+  });
+  AABB box;
+  double simdMs = bestOf(kRepeat, [&] {
+    box = BoundingVolumes::computeAABB(vertices.data(), kVertices);
+  });
+  bool exact = box.min.x == reference.min.x && box.min.y == reference.min.y &&
+               box.min.z == reference.min.z && box.max.x == reference.max.x &&
+               box.max.y == reference.max.y && box.max.z == reference.max.z;
+  report("aabb", scalarMs, simdMs, kVertices, exact);
+
+  // Sphere and oriented box must contain every vertex.
+  BoundingSphere sphere;
+  double sphereMs = bestOf(kRepeat, [&] {
+    sphere = BoundingVolumes::computeSphere(vertices.data(), kVertices);
+  });
+  OrientedBox obb;
+  double obbMs = bestOf(kRepeat, [&] {
+    obb = BoundingVolumes::computeOrientedBox(vertices.data(), kVertices);
+  });
+
+  bool contained = true;
+  float slack = 1e-4f * sphere.radius;
+  for (const Vertex &v : vertices) {
+    Vector3 p(v.x, v.y, v.z);
+    contained = contained && (p - sphere.center).length() <= sphere.radius + slack;
+    Vector3 d = p - obb.center;
+    contained = contained &&
+                std::fabs(d.dot(obb.axes[0])) <= obb.halfExtents.x + slack &&
+                std::fabs(d.dot(obb.axes[1])) <= obb.halfExtents.y + slack &&
+                std::fabs(d.dot(obb.axes[2])) <= obb.halfExtents.z + slack;
+  }
+  std::printf("  %-22s %8.3f ms  radius %.3f\n", "sphere (ritter)", sphereMs,
+              sphere.radius);
+  std::printf("  %-22s %8.3f ms  half extents (%.3f, %.3f, %.3f)\n",
+              "oriented box (pca)", obbMs, obb.halfExtents.x,
+              obb.halfExtents.y, obb.halfExtents.z);
+  std::printf("  %-22s %s\n", "containment", contained ? "ok" : "FAILED");
+
+  bool allPassed = exact && contained;
+  std::printf("%s\n", allPassed ? "All checks passed." : "Checks FAILED.");
+  return allPassed;
+}
+
+bool Benchmarks::runBmp() {
+  constexpr int kRepeat = 10;
+  const char *files[] = {"objs/texturized/pizza.bmp",
+                         "objs/resources/kitten.bmp"};
+  bool allPassed = true;
+
+  std::printf("BMP decode (best of %d, %s kernels)\n", kRepeat,
+              BMPDecoder::simdPathName());
+
+  for (const char *path : files) {
+    DecodedImage reference, decoded;
+    if (!decodeBmpReference(path, reference)) {
+      std::printf("  %s: could not read reference\n", path);
+      allPassed = false;
+      continue;
+    }
+    // "scalar" is the old ifstream + per-byte loader; "simd" is mmap +
+    // parallel shuffled rows. Throughput is reported in megapixels.
+    double scalarMs = bestOf(kRepeat, [&] {
+      decodeBmpReference(path, reference);
+    });
+    bool loaded = true;
+    double simdMs = bestOf(kRepeat, [&] {
+      loaded = BMPDecoder::load(path, decoded) && loaded;
+    });
+    bool exact = loaded && decoded.width == reference.width &&
+                 decoded.height == reference.height &&
+                 decoded.pixels == reference.pixels;
+    const char *name = std::strrchr(path, '/') + 1;
+    report(name, scalarMs, simdMs,
+           static_cast<size_t>(reference.width) * reference.height, exact);
+    allPassed = allPassed && exact;
+  }
+
+  // Every supported layout, odd widths included so the SIMD tails run.
+  struct Layout {
+    const char *name;
+    int bpp;
+    bool topDown;
+    uint32_t compression, alphaMask;
+  };
+  const Layout layouts[] = {
+      {"24-bit bottom-up", 24, false, 0, 0},
+      {"24-bit top-down", 24, true, 0, 0},
+      {"32-bit bottom-up", 32, false, 0, 0},
+      {"32-bit top-down", 32, true, 0, 0},
+      {"32-bit bitfields+a", 32, false, 3, 0xFF000000u},
+      {"32-bit bitfields", 32, true, 3, 0},
+  };
+  for (const Layout &layout : layouts) {
+    bool ok = true;
+    for (int width : {1, 3, 5, 7, 13, 37, 64, 101}) {
+      const int height = 9;
+      std::vector<unsigned char> file =
+          makeTestBmp(width, height, layout.bpp, layout.topDown,
+                      layout.compression, layout.alphaMask);
+      DecodedImage simd, scalar;
+      ok = ok && BMPDecoder::decode(file.data(), file.size(), simd, true) &&
+           BMPDecoder::decode(file.data(), file.size(), scalar, false) &&
+           simd.pixels == scalar.pixels &&
+           simd.channels == layout.bpp / 8;
+      for (int y = 0; ok && y < height; ++y) {
+        for (int x = 0; ok && x < width; ++x) {
+          const unsigned char *p =
+              &simd.pixels[(static_cast<size_t>(y) * width + x) *
+                           simd.channels];
+          bool opaque = layout.bpp == 24 || layout.alphaMask == 0;
+          ok = p[0] == static_cast<unsigned char>(x * 3 ^ y * 5) &&
+               p[1] == static_cast<unsigned char>(x + y * 13) &&
+               p[2] == static_cast<unsigned char>(x * 7 + y) &&
+               (layout.bpp == 24 ||
+                p[3] == (opaque ? 255 : static_cast<unsigned char>(x + y)));
+        }
+      }
+    }
+    std::printf("  %-22s %s\n", layout.name, ok ? "ok" : "MISMATCH");
+    allPassed = allPassed && ok;
+  }
+
+  std::printf("%s\n", allPassed ? "All checks passed." : "Checks FAILED.");
+  return allPassed;
+}
+
+bool Benchmarks::runMipmaps() {
+  constexpr int kRepeat = 5;
+  const char *files[] = {"objs/texturized/pizza.bmp",
+                         "objs/resources/kitten.bmp"};
+  bool allPassed = true;
+
+  std::printf("Mip chain generation (best of %d)\n", kRepeat);
+
+  for (const char *path : files) {
+    DecodedImage base;
+    if (!BMPDecoder::load(path, base)) {
+      std::printf("  %s: could not load\n", path);
+      allPassed = false;
+      continue;
+    }
+    std::vector<DecodedImage> reference, chain;
+    double scalarMs = bestOf(kRepeat, [&] {
+      reference.clear();
+      const DecodedImage *previous = &base;
+      while (previous->width > 1 || previous->height > 1) {
+        reference.push_back(downsampleReference(*previous));
+        previous = &reference.back();
+      }
+    });
+    double simdMs =
+        bestOf(kRepeat, [&] { chain = MipmapGenerator::buildChain(base); });
+
+    // Table lookups may round one code differently from pow(), and those
+    // differences compound down the chain, so each level is checked against
+    // the reference reduction of the same input level.
+    bool close = chain.size() == reference.size();
+    size_t texels = 0;
+    for (size_t i = 0; close && i < chain.size(); ++i) {
+      const DecodedImage &input = i == 0 ? base : chain[i - 1];
+      close = maxDifference(chain[i], downsampleReference(input)) <= 1;
+      texels += static_cast<size_t>(chain[i].width) * chain[i].height;
+    }
+    report(std::strrchr(path, '/') + 1, scalarMs, simdMs, texels, close);
+    allPassed = allPassed && close;
+  }
+
+  // Black and white average to linear 0.5, i.e. sRGB 188, not 128. Alpha
+  // stays linear. Odd sizes and 1-pixel sides must reach 1x1.
+  DecodedImage checker;
+  checker.width = 2;
+  checker.height = 2;
+  checker.channels = 4;
+  checker.pixels = {0, 0, 0, 0, 255, 255, 255, 255,
+                    255, 255, 255, 255, 0, 0, 0, 0};
+  DecodedImage half = MipmapGenerator::downsample(checker);
+  bool gamma = half.pixels.size() == 4 && half.pixels[0] == 188 &&
+               half.pixels[3] == 128;
+  std::printf("  %-22s %s\n", "gamma-correct average", gamma ? "ok" : "MISMATCH");
+  allPassed = allPassed && gamma;
+
+  bool shapes = true;
+  for (int width : {1, 3, 5, 7, 64, 101}) {
+    for (int height : {1, 2, 9}) {
+      DecodedImage flat;
+      flat.width = width;
+      flat.height = height;
+      flat.channels = 3;
+      flat.pixels.assign(static_cast<size_t>(width) * height * 3, 77);
+      std::vector<DecodedImage> levels = MipmapGenerator::buildChain(flat);
+      const DecodedImage &last = levels.empty() ? flat : levels.back();
+      shapes = shapes && last.width == 1 && last.height == 1 &&
+               maxDifference(MipmapGenerator::fitToSize(flat, 1), last) == 0 &&
+               std::abs(last.pixels[0] - 77) <= 1;
+    }
+  }
+  std::printf("  %-22s %s\n", "odd sizes to 1x1", shapes ? "ok" : "MISMATCH");
+  allPassed = allPassed && shapes;
+
+  std::printf("%s\n", allPassed ? "All checks passed." : "Checks FAILED.");
+  return allPassed;
+}
+
+bool Benchmarks::runBlockCompression() {
+  constexpr int kRepeat = 5;
+  // Range fit on photographic textures lands around 38-41 dB; anything below
+  // this means the encoder broke, not that it is merely imprecise.
+  constexpr double kMinPsnr = 32.0;
+  const char *files[] = {"objs/texturized/pizza.bmp",
+                         "objs/resources/kitten.bmp"};
+  bool allPassed = true;
+
+  std::printf("BC1/BC3 encoding (best of %d)\n", kRepeat);
+
+  for (const char *path : files) {
+    DecodedImage image;
+    if (!BMPDecoder::load(path, image)) {
+      std::printf("  %s: could not load\n", path);
+      allPassed = false;
+      continue;
+    }
+    std::vector<unsigned char> scalar, simd;
+    double scalarMs = bestOf(kRepeat, [&] {
+      BCCodec::encode(image, BlockFormat::BC1, scalar, false);
+    });
+    double simdMs = bestOf(kRepeat, [&] {
+      BCCodec::encode(image, BlockFormat::BC1, simd, true);
+    });
+    DecodedImage decoded;
+    bool ok = simd == scalar &&
+              BCCodec::decode(simd.data(), simd.size(), BlockFormat::BC1,
+                              image.width, image.height, decoded);
+    double psnr = ok ? rgbPsnr(image, decoded) : 0.0;
+    ok = ok && psnr >= kMinPsnr;
+    char name[48];
+    std::snprintf(name, sizeof(name), "%s %.1fdB",
+                  std::strrchr(path, '/') + 1, psnr);
+    report(name, scalarMs, simdMs,
+           static_cast<size_t>(image.width) * image.height, ok);
+    allPassed = allPassed && ok;
+  }
+
+  // BC3 on translucent data with odd sizes: kernels agree, and fully
+  // transparent / opaque texels survive exactly.
+  std::mt19937 rng(7);
+  bool alphaOk = true;
+  for (int width : {1, 3, 6, 37}) {
+    for (int height : {1, 5, 19}) {
+      DecodedImage image;
+      image.width = width;
+      image.height = height;
+      image.channels = 4;
+      image.pixels.resize(static_cast<size_t>(width) * height * 4);
+      for (size_t i = 0; i < image.pixels.size(); ++i) {
+        bool alpha = i % 4 == 3;
+        unsigned value = rng() % 256;
+        image.pixels[i] = static_cast<unsigned char>(
+            alpha && value < 64 ? 0 : alpha && value > 192 ? 255 : value);
+      }
+      std::vector<unsigned char> scalar, simd;
+      BCCodec::encode(image, BlockFormat::BC3, scalar, false);
+      BCCodec::encode(image, BlockFormat::BC3, simd, true);
+      DecodedImage decoded;
+      alphaOk = alphaOk && simd == scalar &&
+                simd.size() ==
+                    BCCodec::encodedSize(BlockFormat::BC3, width, height) &&
+                BCCodec::decode(simd.data(), simd.size(), BlockFormat::BC3,
+                                width, height, decoded);
+      for (size_t i = 3; alphaOk && i < image.pixels.size(); i += 4) {
+        unsigned char a = image.pixels[i];
+        alphaOk = (a != 0 && a != 255) || decoded.pixels[i] == a;
+      }
+    }
+  }
+  std::printf("  %-22s %s\n", "BC3 alpha / odd sizes", alphaOk ? "ok" : "MISMATCH");
+  allPassed = allPassed && alphaOk;
+
+  // DDS written for the cache reads back as the same blocks.
+  CompressedImage written;
+  written.format = BlockFormat::BC1;
+  int width = 13, height = 7;
+  for (int level = 0; level < 4; ++level) {
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.channels = 3;
+    image.pixels.assign(static_cast<size_t>(width) * height * 3,
+                        static_cast<unsigned char>(level * 60));
+    std::vector<unsigned char> blocks;
+    BCCodec::encode(image, BlockFormat::BC1, blocks);
+    written.storage.insert(written.storage.end(), blocks.begin(),
+                           blocks.end());
+    written.levels.push_back({width, height, nullptr, blocks.size()});
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+  }
+  size_t offset = 0;
+  for (CompressedLevel &level : written.levels) {
+    level.data = written.storage.data() + offset;
+    offset += level.size;
+  }
+  const std::string ddsPath =
+      (std::filesystem::temp_directory_path() / "scop-bench.dds").string();
+  CompressedImage read;
+  bool roundTrip = CompressedTextureFile::writeDDS(ddsPath, written) &&
+                   CompressedTextureFile::load(ddsPath, read) &&
+                   read.format == written.format &&
+                   read.levels.size() == written.levels.size();
+  for (size_t i = 0; roundTrip && i < read.levels.size(); ++i) {
+    roundTrip = read.levels[i].width == written.levels[i].width &&
+                read.levels[i].height == written.levels[i].height &&
+                read.levels[i].size == written.levels[i].size &&
+                std::memcmp(read.levels[i].data, written.levels[i].data,
+                            read.levels[i].size) == 0;
+  }
+  read = CompressedImage();
+  std::remove(ddsPath.c_str());
+  std::printf("  %-22s %s\n", "DDS round trip", roundTrip ? "ok" : "MISMATCH");
+  allPassed = allPassed && roundTrip;
+
+  std::printf("%s\n", allPassed ? "All checks passed." : "Checks FAILED.");
+  return allPassed;
+}
+
+bool Benchmarks::runOcclusion() {
+  constexpr size_t kTriangles = 4096;
+  constexpr size_t kBoxes = 100000;
+  constexpr int kRepeat = 5;
+  const Matrix4 clip = Matrix4::multiply(
+      Matrix4::perspective(60.0f, 2.0f, 0.1f, 100.0f),
+      Matrix4::lookAt(Vector3(0, 0, 0), Vector3(0, 0, -1), Vector3(0, 1, 0)));
+
+  // Random triangles in front of the camera, some reaching off screen.
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> xy(-6.0f, 6.0f);
+  std::uniform_real_distribution<float> depth(-20.0f, -2.0f);
+  std::uniform_real_distribution<float> spread(-1.5f, 1.5f);
+  std::vector<float> triangles(kTriangles * 9);
+  for (size_t t = 0; t < kTriangles; ++t) {
+    float cx = xy(rng), cy = xy(rng), cz = depth(rng);
+    for (int k = 0; k < 3; ++k) {
+      triangles[t * 9 + k * 3 + 0] = cx + spread(rng);
+      triangles[t * 9 + k * 3 + 1] = cy + spread(rng);
+      triangles[t * 9 + k * 3 + 2] = cz + spread(rng);
+    }
+  }
+
+  std::printf("Occlusion culling, %dx%d depth buffer (best of %d)\n",
+              OcclusionCuller::kWidth, OcclusionCuller::kHeight, kRepeat);
+
+  OcclusionCuller scalar, simd;
+  auto rasterizeAll = [&](OcclusionCuller &culler, bool useSimd) {
+    culler.clear();
+    for (size_t t = 0; t < kTriangles; ++t) {
+      culler.rasterize(clip, &triangles[t * 9], useSimd);
+    }
+  };
+  double scalarMs = bestOf(kRepeat, [&] { rasterizeAll(scalar, false); });
+  double simdMs = bestOf(kRepeat, [&] { rasterizeAll(simd, true); });
+  const size_t pixels =
+      static_cast<size_t>(OcclusionCuller::kWidth) * OcclusionCuller::kHeight;
+  bool exact = std::memcmp(scalar.depth(), simd.depth(),
+                           pixels * sizeof(float)) == 0;
+  report("rasterize", scalarMs, simdMs, kTriangles, exact);
+
+  double pyramidMs = bestOf(kRepeat, [&] { simd.buildPyramid(); });
+  std::vector<AABB> boxes(kBoxes);
+  for (AABB &box : boxes) {
+    Vector3 center(xy(rng), xy(rng), depth(rng) - 5.0f);
+    Vector3 half(0.2f + std::fabs(spread(rng)) * 0.3f,
+                 0.2f + std::fabs(spread(rng)) * 0.3f, 0.2f);
+    box.min = center - half;
+    box.max = center + half;
+  }
+  size_t occluded = 0;
+  double testMs = bestOf(kRepeat, [&] {
+    occluded = 0;
+    for (const AABB &box : boxes) {
+      occluded += simd.isOccluded(clip, box) ? 1 : 0;
+    }
+  });
+  std::printf("  %-22s %8.3f ms\n", "pyramid", pyramidMs);
+  std::printf("  %-22s %8.3f ms  %zu of %zu occluded\n", "box tests", testMs,
+              occluded, kBoxes);
+
+  // A wall across the whole view at z = -5 hides boxes behind it only.
+  const float wall[18] = {-50, -50, -5, 50, -50, -5, 50, 50, -5,
+                          -50, -50, -5, 50, 50, -5, -50, 50, -5};
+  OcclusionCuller culler;
+  culler.clear();
+  culler.rasterize(clip, wall);
+  culler.rasterize(clip, wall + 9);
+  culler.buildPyramid();
+  auto box = [](float x, float y, float z0, float z1) {
+    AABB b;
+    b.min = Vector3(x - 0.5f, y - 0.5f, z0);
+    b.max = Vector3(x + 0.5f, y + 0.5f, z1);
+    return b;
+  };
+  bool conservative = culler.isOccluded(clip, box(0, 0, -12, -11)) &&
+                      culler.isOccluded(clip, box(3, -2, -9, -6)) &&
+                      !culler.isOccluded(clip, box(0, 0, -4, -3)) &&
+                      !culler.isOccluded(clip, box(0, 0, -6, -4.5f)) &&
+                      !culler.isOccluded(clip, box(0, 0, -8, 1));
+  std::printf("  %-22s %s\n", "wall in front / behind",
+              conservative ? "ok" : "MISMATCH");
+
+  // A wall ending 0.6 pixels into texel 128, and a small box behind it
+  // reaching 0.2 pixels past that edge, within the same texel.
+  const float halfWall[18] = {-50, -50, -5, 0.027f, -50, -5, 0.027f, 50, -5,
+                              -50, -50, -5, 0.027f, 50, -5, -50, 50, -5};
+  culler.clear();
+  culler.rasterize(clip, halfWall);
+  culler.rasterize(clip, halfWall + 9);
+  culler.buildPyramid();
+  AABB peeking;
+  peeking.min = Vector3(0.01f, -0.02f, -11.5f);
+  peeking.max = Vector3(0.079f, 0.02f, -11.0f);
+  bool edges = !culler.isOccluded(clip, peeking) &&
+               culler.isOccluded(clip, box(-2, 0, -12, -11));
+  std::printf("  %-22s %s\n", "box past a wall edge",
+              edges ? "ok" : "MISMATCH");
+
+  bool allPassed = exact && conservative && edges;
+  std::printf("%s\n", allPassed ? "All checks passed." : "Checks FAILED.");
+  return allPassed;
+}
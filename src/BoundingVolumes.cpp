@@ -0,0 +1,365 @@
+#include "BoundingVolumes.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kVerticesPerChunk = 1 << 16;
+
+/**
+ * @brief Scalar min/max over [begin, end), folded into box.
+ */
+void extendScalar(const Vertex *vertices, size_t begin, size_t end,
+                  AABB &box) {
+  for (size_t i = begin; i < end; ++i) {
+    const Vertex &v = vertices[i];
+    box.min.x = std::min(box.min.x, v.x);
+    box.min.y = std::min(box.min.y, v.y);
+    box.min.z = std::min(box.min.z, v.z);
+    box.max.x = std::max(box.max.x, v.x);
+    box.max.y = std::max(box.max.y, v.y);
+    box.max.z = std::max(box.max.z, v.z);
+  }
+}
+
+AABB emptyBox() {
+  AABB box;
+  box.min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+  box.max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+  return box;
+}
+
+/**
+ * @brief Branch-free AABB of a vertex range.
+ *
+ * Four packed xyz vertices are exactly three SSE registers whose lanes hold
+ * the fixed component patterns (x y z x), (y z x y) and (z x y z), so the
+ * loop only needs plain loads and min/max; lanes are regrouped by component
+ * once at the end.
+ */
+AABB rangeAABB(const Vertex *vertices, size_t begin, size_t end) {
+  AABB box = emptyBox();
+  size_t i = begin;
+#if defined(__SSE2__)
+  if (end - begin >= 4) {
+    const float *p = &vertices[begin].x;
+    __m128 min0 = _mm_loadu_ps(p), max0 = min0;
+    __m128 min1 = _mm_loadu_ps(p + 4), max1 = min1;
+    __m128 min2 = _mm_loadu_ps(p + 8), max2 = min2;
+    for (i = begin + 4; i + 4 <= end; i += 4) {
+      p = &vertices[i].x;
+      __m128 a = _mm_loadu_ps(p);
+      __m128 b = _mm_loadu_ps(p + 4);
+      __m128 c = _mm_loadu_ps(p + 8);
+      min0 = _mm_min_ps(min0, a);
+      max0 = _mm_max_ps(max0, a);
+      min1 = _mm_min_ps(min1, b);
+      max1 = _mm_max_ps(max1, b);
+      min2 = _mm_min_ps(min2, c);
+      max2 = _mm_max_ps(max2, c);
+    }
+
+    alignas(16) float lo[3][4], hi[3][4];
+    _mm_store_ps(lo[0], min0);
+    _mm_store_ps(lo[1], min1);
+    _mm_store_ps(lo[2], min2);
+    _mm_store_ps(hi[0], max0);
+    _mm_store_ps(hi[1], max1);
+    _mm_store_ps(hi[2], max2);
+    box.min.x = std::min({lo[0][0], lo[0][3], lo[1][2], lo[2][1]});
+    box.min.y = std::min({lo[0][1], lo[1][0], lo[1][3], lo[2][2]});
+    box.min.z = std::min({lo[0][2], lo[1][1], lo[2][0], lo[2][3]});
+    box.max.x = std::max({hi[0][0], hi[0][3], hi[1][2], hi[2][1]});
+    box.max.y = std::max({hi[0][1], hi[1][0], hi[1][3], hi[2][2]});
+    box.max.z = std::max({hi[0][2], hi[1][1], hi[2][0], hi[2][3]});
+  }
+#endif
+  extendScalar(vertices, i, end, box);
+  return box;
+}
+
+float distanceSq(const Vertex &v, const Vector3 &p) {
+  float dx = v.x - p.x, dy = v.y - p.y, dz = v.z - p.z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * @brief Index of the vertex farthest from p (parallel arg-max).
+ */
+size_t farthestFrom(const Vertex *vertices, size_t count, const Vector3 &p) {
+  size_t chunks = Parallel::chunkCount(count, kVerticesPerChunk);
+  std::vector<size_t> bestIndex(chunks, 0);
+  std::vector<float> bestDistance(chunks, -1.0f);
+  Parallel::forChunks(count, kVerticesPerChunk,
+                      [&](size_t chunk, size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; ++i) {
+                          float d = distanceSq(vertices[i], p);
+                          if (d > bestDistance[chunk]) {
+                            bestDistance[chunk] = d;
+                            bestIndex[chunk] = i;
+                          }
+                        }
+                      });
+  size_t best = 0;
+  for (size_t c = 1; c < chunks; ++c) {
+    if (bestDistance[c] > bestDistance[best]) {
+      best = c;
+    }
+  }
+  return bestIndex[best];
+}
+
+/**
+ * @brief Eigen-decomposition of a symmetric 3x3 matrix by cyclic Jacobi
+ * rotations. Columns of `vectors` receive the eigenvectors.
+ */
+void jacobiEigen(double a[3][3], double vectors[3][3]) {
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      vectors[i][j] = (i == j) ? 1.0 : 0.0;
+
+  for (int sweep = 0; sweep < 32; ++sweep) {
+    double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    if (off < 1e-24) {
+      break;
+    }
+    for (int p = 0; p < 2; ++p) {
+      for (int q = p + 1; q < 3; ++q) {
+        if (std::fabs(a[p][q]) < 1e-30) {
+          continue;
+        }
+        double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        double t = (theta >= 0 ? 1.0 : -1.0) /
+                   (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+        double c = 1.0 / std::sqrt(t * t + 1.0);
+        double s = t * c;
+        for (int k = 0; k < 3; ++k) {
+          double akp = a[k][p], akq = a[k][q];
+          a[k][p] = c * akp - s * akq;
+          a[k][q] = s * akp + c * akq;
+        }
+        for (int k = 0; k < 3; ++k) {
+          double apk = a[p][k], aqk = a[q][k];
+          a[p][k] = c * apk - s * aqk;
+          a[q][k] = s * apk + c * aqk;
+        }
+        for (int k = 0; k < 3; ++k) {
+          double vkp = vectors[k][p], vkq = vectors[k][q];
+          vectors[k][p] = c * vkp - s * vkq;
+          vectors[k][q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
+
+} // end anonymous namespace
+
+AABB BoundingVolumes::computeAABB(const Vertex *vertices, size_t count) {
+  size_t chunks = Parallel::chunkCount(count, kVerticesPerChunk);
+  std::vector<AABB> partial(chunks, emptyBox());
+  Parallel::forChunks(count, kVerticesPerChunk,
+                      [&](size_t chunk, size_t begin, size_t end) {
+                        partial[chunk] = rangeAABB(vertices, begin, end);
+                      });
+
+  AABB box = emptyBox();
+  for (const AABB &part : partial) {
+    box.min.x = std::min(box.min.x, part.min.x);
+    box.min.y = std::min(box.min.y, part.min.y);
+    box.min.z = std::min(box.min.z, part.min.z);
+    box.max.x = std::max(box.max.x, part.max.x);
+    box.max.y = std::max(box.max.y, part.max.y);
+    box.max.z = std::max(box.max.z, part.max.z);
+  }
+  return box;
+}
+
+BoundingSphere BoundingVolumes::computeSphere(const Vertex *vertices,
+                                              size_t count) {
+  BoundingSphere sphere;
+  if (count == 0) {
+    return sphere;
+  }
+
+  // Initial diameter: farthest point from an arbitrary point, then the
+  // farthest point from that one.
+  const Vertex &first = vertices[0];
+  size_t a = farthestFrom(vertices, count, Vector3(first.x, first.y, first.z));
+  Vector3 pa(vertices[a].x, vertices[a].y, vertices[a].z);
+  size_t b = farthestFrom(vertices, count, pa);
+  Vector3 pb(vertices[b].x, vertices[b].y, vertices[b].z);
+
+  sphere.center = (pa + pb) * 0.5f;
+  sphere.radius = (pb - pa).length() * 0.5f;
+
+  // Grow to include any outliers.
+  growSphere(sphere, vertices, count);
+  return sphere;
+}
+
+void BoundingVolumes::growSphere(BoundingSphere &sphere,
+                                 const Vertex *vertices, size_t count) {
+  // Order-dependent, so done sequentially.
+  float radiusSq = sphere.radius * sphere.radius;
+  for (size_t i = 0; i < count; ++i) {
+    float dSq = distanceSq(vertices[i], sphere.center);
+    if (dSq > radiusSq) {
+      float d = std::sqrt(dSq);
+      float newRadius = 0.5f * (sphere.radius + d);
+      float shift = newRadius - sphere.radius;
+      Vector3 p(vertices[i].x, vertices[i].y, vertices[i].z);
+      sphere.center = sphere.center + (p - sphere.center) * (shift / d);
+      sphere.radius = newRadius;
+      radiusSq = newRadius * newRadius;
+    }
+  }
+}
+
+OrientedBox BoundingVolumes::computeOrientedBox(const Vertex *vertices,
+                                                size_t count) {
+  OrientedBox box;
+  if (count == 0) {
+    return box;
+  }
+
+  // 1. Mean and covariance, accumulated per chunk in double precision.
+  struct Moments {
+    double sum[3] = {0, 0, 0};
+    double outer[6] = {0, 0, 0, 0, 0, 0}; // xx xy xz yy yz zz
+  };
+  size_t chunks = Parallel::chunkCount(count, kVerticesPerChunk);
+  std::vector<Moments> partial(chunks);
+  Parallel::forChunks(count, kVerticesPerChunk,
+                      [&](size_t chunk, size_t begin, size_t end) {
+                        Moments &m = partial[chunk];
+                        for (size_t i = begin; i < end; ++i) {
+                          double x = vertices[i].x, y = vertices[i].y,
+                                 z = vertices[i].z;
+                          m.sum[0] += x;
+                          m.sum[1] += y;
+                          m.sum[2] += z;
+                          m.outer[0] += x * x;
+                          m.outer[1] += x * y;
+                          m.outer[2] += x * z;
+                          m.outer[3] += y * y;
+                          m.outer[4] += y * z;
+                          m.outer[5] += z * z;
+                        }
+                      });
+
+  Moments total;
+  for (const Moments &m : partial) {
+    for (int k = 0; k < 3; ++k)
+      total.sum[k] += m.sum[k];
+    for (int k = 0; k < 6; ++k)
+      total.outer[k] += m.outer[k];
+  }
+  double n = static_cast<double>(count);
+  double mean[3] = {total.sum[0] / n, total.sum[1] / n, total.sum[2] / n};
+  double cov[3][3];
+  cov[0][0] = total.outer[0] / n - mean[0] * mean[0];
+  cov[0][1] = cov[1][0] = total.outer[1] / n - mean[0] * mean[1];
+  cov[0][2] = cov[2][0] = total.outer[2] / n - mean[0] * mean[2];
+  cov[1][1] = total.outer[3] / n - mean[1] * mean[1];
+  cov[1][2] = cov[2][1] = total.outer[4] / n - mean[1] * mean[2];
+  cov[2][2] = total.outer[5] / n - mean[2] * mean[2];
+
+  // 2. Principal axes; the third is rebuilt as a cross product so the basis
+  //    is right-handed and exactly orthogonal.
+  double eigenVectors[3][3];
+  jacobiEigen(cov, eigenVectors);
+  Vector3 axis0 = Vector3(static_cast<float>(eigenVectors[0][0]),
+                          static_cast<float>(eigenVectors[1][0]),
+                          static_cast<float>(eigenVectors[2][0]))
+                      .normalize();
+  Vector3 axis1 = Vector3(static_cast<float>(eigenVectors[0][1]),
+                          static_cast<float>(eigenVectors[1][1]),
+                          static_cast<float>(eigenVectors[2][1]))
+                      .normalize();
+  if (axis0.length() == 0.0f || axis1.length() == 0.0f) {
+    axis0 = Vector3(1, 0, 0);
+    axis1 = Vector3(0, 1, 0);
+  }
+  box.axes[0] = axis0;
+  box.axes[1] = axis1;
+  box.axes[2] = axis0.cross(axis1).normalize();
+
+  // 3. Extents along the axes (parallel min/max of projections).
+  struct Range {
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+  };
+  std::vector<Range> ranges(chunks);
+  Parallel::forChunks(count, kVerticesPerChunk,
+                      [&](size_t chunk, size_t begin, size_t end) {
+                        Range &r = ranges[chunk];
+                        for (size_t i = begin; i < end; ++i) {
+                          Vector3 p(vertices[i].x, vertices[i].y,
+                                    vertices[i].z);
+                          for (int k = 0; k < 3; ++k) {
+                            float d = p.dot(box.axes[k]);
+                            r.lo[k] = std::min(r.lo[k], d);
+                            r.hi[k] = std::max(r.hi[k], d);
+                          }
+                        }
+                      });
+
+  Range total3;
+  for (const Range &r : ranges) {
+    for (int k = 0; k < 3; ++k) {
+      total3.lo[k] = std::min(total3.lo[k], r.lo[k]);
+      total3.hi[k] = std::max(total3.hi[k], r.hi[k]);
+    }
+  }
+  box.center = Vector3();
+  float half[3];
+  for (int k = 0; k < 3; ++k) {
+    float mid = 0.5f * (total3.lo[k] + total3.hi[k]);
+    half[k] = 0.5f * (total3.hi[k] - total3.lo[k]);
+    box.center += box.axes[k] * mid;
+  }
+  box.halfExtents = Vector3(half[0], half[1], half[2]);
+  return box;
+}
+
+Frustum BoundingVolumes::computeFrustum(const Matrix4 &clipFromObject) {
+  // Row i of the column-major matrix is (m[i], m[4 + i], m[8 + i], m[12 + i]);
+  // each plane is row 3 plus or minus row 0, 1 or 2.
+  const float *m = clipFromObject.m;
+  Frustum frustum;
+  for (int axis = 0; axis < 3; ++axis) {
+    for (int side = 0; side < 2; ++side) {
+      float sign = side == 0 ? 1.0f : -1.0f;
+      float *plane = frustum.planes[axis * 2 + side];
+      for (int k = 0; k < 4; ++k) {
+        plane[k] = m[k * 4 + 3] + sign * m[k * 4 + axis];
+      }
+    }
+  }
+  return frustum;
+}
+
+bool BoundingVolumes::intersects(const Frustum &frustum, const AABB &box) {
+  if (box.isEmpty()) {
+    return false;
+  }
+  for (const float *plane : frustum.planes) {
+    // The box corner furthest along the plane normal.
+    float x = plane[0] >= 0.0f ? box.max.x : box.min.x;
+    float y = plane[1] >= 0.0f ? box.max.y : box.min.y;
+    float z = plane[2] >= 0.0f ? box.max.z : box.min.z;
+    if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,298 @@
+#include "CompressedInput.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define SCOP_HAVE_ZSTD 1
+#endif
+
+namespace {
+
+constexpr unsigned char kGzipMagic[] = {0x1f, 0x8b};
+constexpr unsigned char kZstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+// zlib counts input in uInt, so large mappings are fed in slices.
+constexpr size_t kInflateSlice = size_t(1) << 30;
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+double mibPerSecond(size_t bytes, double millis) {
+  return bytes / (1024.0 * 1024.0) / std::max(millis / 1000.0, 1e-6);
+}
+
+/**
+ * @brief Length of the .gz or .zst extension of the path, 0 if none.
+ */
+size_t compressedExtensionLength(const std::string &filePath) {
+  std::string lower = filePath;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  auto endsWith = [&lower](const std::string &suffix) {
+    return lower.size() > suffix.size() &&
+           lower.compare(lower.size() - suffix.size(), suffix.size(),
+                         suffix) == 0;
+  };
+  if (endsWith(".gz")) {
+    return 3;
+  }
+  if (endsWith(".zst")) {
+    return 4;
+  }
+  return 0;
+}
+
+} // end anonymous namespace
+
+bool CompressedInput::isCompressedPath(const std::string &filePath) {
+  return compressedExtensionLength(filePath) != 0;
+}
+
+std::string CompressedInput::uncompressedPath(const std::string &filePath) {
+  return filePath.substr(0,
+                         filePath.size() - compressedExtensionLength(filePath));
+}
+
+CompressedInput::~CompressedInput() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  drained_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+bool CompressedInput::open(const std::string &filePath) {
+  path_ = filePath;
+  start_ = std::chrono::steady_clock::now();
+  if (!file_.open(filePath)) {
+    return false;
+  }
+
+  const unsigned char *data = file_.data();
+  const size_t size = file_.size();
+  if (size >= sizeof(kGzipMagic) &&
+      std::memcmp(data, kGzipMagic, sizeof(kGzipMagic)) == 0) {
+    format_ = Format::GZIP;
+  } else if (size >= sizeof(kZstdMagic) &&
+             std::memcmp(data, kZstdMagic, sizeof(kZstdMagic)) == 0) {
+#if !defined(SCOP_HAVE_ZSTD)
+    std::cerr << "Error: " << filePath
+              << " is zstd-compressed, but scop was built without zstd\n";
+    return false;
+#endif
+    format_ = Format::ZSTD;
+  } else {
+    std::cerr << "Error: " << filePath << " is not a gzip or zstd file\n";
+    return false;
+  }
+
+  ring_.resize(kBufferCount);
+  for (Buffer &buffer : ring_) {
+    buffer.data.resize(kBufferSize);
+  }
+  ringMemory_ =
+      MemoryTracker::Allocation(MemoryTag::LOADER, kBufferCount * kBufferSize);
+  worker_ = std::thread(&CompressedInput::workerLoop, this);
+  return true;
+}
+
+bool CompressedInput::getline(std::string &line) {
+  line.clear();
+  for (;;) {
+    if (current_ != nullptr) {
+      const char *data = current_->data.data();
+      const char *begin = data + position_;
+      const char *end = data + current_->size;
+      const char *newline =
+          static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+      if (newline != nullptr) {
+        line.append(begin, newline);
+        position_ = newline - data + 1;
+        return true;
+      }
+      // The line continues in the next slot; this one can be refilled.
+      line.append(begin, end);
+      current_ = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++consumed_;
+      }
+      drained_.notify_one();
+    }
+
+    auto waitStart = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    filled_.wait(lock, [this] { return consumed_ < produced_ || finished_; });
+    readerWaitMillis_ += millisSince(waitStart);
+    if (consumed_ < produced_) {
+      current_ = &ring_[consumed_ % kBufferCount];
+      position_ = 0;
+      continue;
+    }
+    readerMillis_ = millisSince(start_);
+    // A last line without '\n' still counts, unless the data was cut short.
+    return !failed_ && !line.empty();
+  }
+}
+
+bool CompressedInput::failed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return failed_;
+}
+
+void CompressedInput::printReport(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const double mib = 1024.0 * 1024.0;
+  const double parseMillis = std::max(readerMillis_ - readerWaitMillis_, 0.0);
+  out << "Decompressed " << path_ << " ("
+      << (format_ == Format::GZIP ? "gzip" : "zstd")
+      << "): " << file_.size() / mib << " MiB -> " << outputBytes_ / mib
+      << " MiB\n"
+      << "  Decompression: " << decodeMillis_ << " ms ("
+      << mibPerSecond(outputBytes_, decodeMillis_) << " MiB/s), waited "
+      << workerWaitMillis_ << " ms for the parser\n"
+      << "  Parsing: " << parseMillis << " ms ("
+      << mibPerSecond(outputBytes_, parseMillis) << " MiB/s), waited "
+      << readerWaitMillis_ << " ms for data\n";
+}
+
+void CompressedInput::workerLoop() {
+  const bool ok = format_ == Format::GZIP ? decodeGzip() : decodeZstd();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    failed_ = !ok && !stopping_;
+    if (failed_) {
+      std::cerr << "Error: " << path_ << " is corrupt or truncated\n";
+    }
+  }
+  filled_.notify_all();
+}
+
+CompressedInput::Buffer *CompressedInput::acquireFree() {
+  auto waitStart = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  drained_.wait(lock, [this] {
+    return produced_ - consumed_ < kBufferCount || stopping_;
+  });
+  workerWaitMillis_ += millisSince(waitStart);
+  if (stopping_) {
+    return nullptr;
+  }
+  return &ring_[produced_ % kBufferCount];
+}
+
+void CompressedInput::publish(size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring_[produced_ % kBufferCount].size = size;
+    ++produced_;
+    outputBytes_ += size;
+  }
+  filled_.notify_one();
+}
+
+bool CompressedInput::decodeGzip() {
+  z_stream stream = {};
+  // 16 + MAX_WBITS: a gzip header and trailer, not a raw zlib stream
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+    return false;
+  }
+  stream.next_in = const_cast<Bytef *>(file_.data());
+  size_t remaining = file_.size();
+
+  bool ok = true;
+  bool ended = false;
+  while (ok && !ended) {
+    Buffer *buffer = acquireFree();
+    if (buffer == nullptr) {
+      break;
+    }
+    stream.next_out = reinterpret_cast<Bytef *>(buffer->data.data());
+    stream.avail_out = static_cast<uInt>(kBufferSize);
+
+    auto start = std::chrono::steady_clock::now();
+    while (stream.avail_out > 0) {
+      if (stream.avail_in == 0 && remaining > 0) {
+        stream.avail_in =
+            static_cast<uInt>(std::min(remaining, kInflateSlice));
+        remaining -= stream.avail_in;
+      }
+      const int status = inflate(&stream, Z_NO_FLUSH);
+      if (status == Z_STREAM_END) {
+        if (stream.avail_in == 0 && remaining == 0) {
+          ended = true;
+          break;
+        }
+        // Concatenated members (e.g. from pigz or cat) follow directly.
+        inflateReset(&stream);
+      } else if (status != Z_OK) {
+        // Z_BUF_ERROR here means the input ended inside a member.
+        ok = false;
+        break;
+      }
+    }
+    decodeMillis_ += millisSince(start);
+
+    const size_t size = kBufferSize - stream.avail_out;
+    if (ok && size > 0) {
+      publish(size);
+    }
+  }
+  inflateEnd(&stream);
+  return ok;
+}
+
+bool CompressedInput::decodeZstd() {
+#if defined(SCOP_HAVE_ZSTD)
+  ZSTD_DStream *stream = ZSTD_createDStream();
+  if (stream == nullptr) {
+    return false;
+  }
+  ZSTD_inBuffer input = {file_.data(), file_.size(), 0};
+  // Nonzero while a frame is incomplete.
+  size_t pending = 0;
+  bool ok = true;
+  while (ok) {
+    Buffer *buffer = acquireFree();
+    if (buffer == nullptr) {
+      break;
+    }
+    ZSTD_outBuffer output = {buffer->data.data(), kBufferSize, 0};
+
+    auto start = std::chrono::steady_clock::now();
+    do {
+      pending = ZSTD_decompressStream(stream, &output, &input);
+      if (ZSTD_isError(pending)) {
+        ok = false;
+        break;
+      }
+    } while (output.pos < output.size && input.pos < input.size);
+    decodeMillis_ += millisSince(start);
+
+    if (ok && output.pos > 0) {
+      publish(output.pos);
+    }
+    // A full buffer may leave decoded data inside the stream.
+    if (input.pos == input.size && output.pos < output.size) {
+      ok = ok && pending == 0;
+      break;
+    }
+  }
+  ZSTD_freeDStream(stream);
+  return ok;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,295 @@
+#include "CompressedTexture.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// DDS_HEADER / DDS_PIXELFORMAT fields (offsets from the start of the file,
+// after the 4-byte "DDS " magic).
+constexpr size_t kDdsHeaderSize = 124;
+constexpr size_t kDdsDataOffset = 4 + kDdsHeaderSize;
+constexpr size_t kDx10HeaderSize = 20;
+constexpr uint32_t kDdsdCaps = 0x1, kDdsdHeight = 0x2, kDdsdWidth = 0x4,
+                   kDdsdPixelFormat = 0x1000, kDdsdMipMapCount = 0x20000,
+                   kDdsdLinearSize = 0x80000;
+constexpr uint32_t kDdpfAlphaPixels = 0x1, kDdpfFourCC = 0x4;
+constexpr uint32_t kDdsCapsComplex = 0x8, kDdsCapsTexture = 0x1000,
+                   kDdsCapsMipMap = 0x400000;
+
+// DXGI_FORMAT values of the DX10 extension header.
+constexpr uint32_t kDxgiBC1 = 71, kDxgiBC1Srgb = 72, kDxgiBC2 = 74,
+                   kDxgiBC2Srgb = 75, kDxgiBC3 = 77, kDxgiBC3Srgb = 78;
+
+// glInternalFormat values used by KTX files.
+constexpr uint32_t kGlRgbDxt1 = 0x83F0, kGlRgbaDxt1 = 0x83F1,
+                   kGlRgbaDxt3 = 0x83F2, kGlRgbaDxt5 = 0x83F3,
+                   kGlSrgbDxt1 = 0x8C4C, kGlSrgbAlphaDxt1 = 0x8C4D,
+                   kGlSrgbAlphaDxt3 = 0x8C4E, kGlSrgbAlphaDxt5 = 0x8C4F;
+
+constexpr unsigned char kKtxIdentifier[12] = {0xAB, 'K',  'T',  'X',
+                                              ' ',  '1',  '1',  0xBB,
+                                              '\r', '\n', 0x1A, '\n'};
+constexpr size_t kKtxHeaderSize = 64;
+
+constexpr uint32_t fourCC(char a, char b, char c, char d) {
+  return static_cast<uint32_t>(static_cast<unsigned char>(a)) |
+         static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8 |
+         static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16 |
+         static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24;
+}
+
+uint32_t read32(const unsigned char *p) {
+  uint32_t value;
+  std::memcpy(&value, p, 4);
+  return value;
+}
+
+void write32(unsigned char *p, uint32_t value) { std::memcpy(p, &value, 4); }
+
+/**
+ * @brief Appends `count` levels laid out back to back from `data`, halving the
+ * size each level. Fails if the file is too short.
+ */
+bool addPackedLevels(const unsigned char *data, size_t size, int width,
+                     int height, int count, CompressedImage &out) {
+  size_t offset = 0;
+  for (int level = 0; level < count; ++level) {
+    size_t levelSize = BCCodec::encodedSize(out.format, width, height);
+    if (offset + levelSize > size) {
+      return false;
+    }
+    out.levels.push_back({width, height, data + offset, levelSize});
+    offset += levelSize;
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
+size_t CompressedImage::byteSize() const {
+  size_t bytes = 0;
+  for (const CompressedLevel &level : levels) {
+    bytes += level.size;
+  }
+  return bytes;
+}
+
+bool CompressedTextureFile::isContainerPath(const std::string &filePath) {
+  std::string ext = filePath.size() >= 4
+                        ? filePath.substr(filePath.size() - 4)
+                        : std::string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return ext == ".dds" || ext == ".ktx";
+}
+
+bool CompressedTextureFile::load(const std::string &filePath,
+                                 CompressedImage &out) {
+  out = CompressedImage();
+  if (!out.file.open(filePath)) {
+    return false;
+  }
+  const unsigned char *data = out.file.data();
+  size_t size = out.file.size();
+
+  bool parsed = false;
+  if (size >= 4 && read32(data) == fourCC('D', 'D', 'S', ' ')) {
+    parsed = parseDDS(data, size, out);
+  } else if (size >= sizeof(kKtxIdentifier) &&
+             std::memcmp(data, kKtxIdentifier, sizeof(kKtxIdentifier)) == 0) {
+    parsed = parseKTX(data, size, out);
+  } else {
+    std::cerr << "Error: " << filePath << " is neither DDS nor KTX\n";
+    return false;
+  }
+  if (!parsed) {
+    std::cerr << "Error: Unsupported or truncated compressed texture "
+              << filePath << " (BC1/BC2/BC3 only)\n";
+    out = CompressedImage();
+  }
+  return parsed;
+}
+
+bool CompressedTextureFile::parseDDS(const unsigned char *data, size_t size,
+                                     CompressedImage &out) {
+  if (size < kDdsDataOffset || read32(data + 4) != kDdsHeaderSize) {
+    return false;
+  }
+  const uint32_t flags = read32(data + 8);
+  const int height = static_cast<int>(read32(data + 12));
+  const int width = static_cast<int>(read32(data + 16));
+  const uint32_t mipCount = read32(data + 28);
+  const uint32_t pfFlags = read32(data + 80);
+  const uint32_t pfFourCC = read32(data + 84);
+  if (width <= 0 || height <= 0 || !(pfFlags & kDdpfFourCC)) {
+    return false;
+  }
+
+  size_t dataOffset = kDdsDataOffset;
+  switch (pfFourCC) {
+  case fourCC('D', 'X', 'T', '1'):
+    out.format =
+        (pfFlags & kDdpfAlphaPixels) ? BlockFormat::BC1A : BlockFormat::BC1;
+    break;
+  case fourCC('D', 'X', 'T', '3'):
+    out.format = BlockFormat::BC2;
+    break;
+  case fourCC('D', 'X', 'T', '5'):
+    out.format = BlockFormat::BC3;
+    break;
+  case fourCC('D', 'X', '1', '0'): {
+    if (size < kDdsDataOffset + kDx10HeaderSize) {
+      return false;
+    }
+    uint32_t dxgi = read32(data + kDdsDataOffset);
+    if (dxgi == kDxgiBC1 || dxgi == kDxgiBC1Srgb) {
+      out.format = BlockFormat::BC1A;
+    } else if (dxgi == kDxgiBC2 || dxgi == kDxgiBC2Srgb) {
+      out.format = BlockFormat::BC2;
+    } else if (dxgi == kDxgiBC3 || dxgi == kDxgiBC3Srgb) {
+      out.format = BlockFormat::BC3;
+    } else {
+      return false;
+    }
+    dataOffset += kDx10HeaderSize;
+    break;
+  }
+  default:
+    return false;
+  }
+
+  int levels = (flags & kDdsdMipMapCount) && mipCount > 0
+                   ? static_cast<int>(std::min<uint32_t>(mipCount, 32))
+                   : 1;
+  return addPackedLevels(data + dataOffset, size - dataOffset, width, height,
+                         levels, out);
+}
+
+bool CompressedTextureFile::parseKTX(const unsigned char *data, size_t size,
+                                     CompressedImage &out) {
+  // Only little-endian files; the endianness field reads 0x04030201 then.
+  if (size < kKtxHeaderSize || read32(data + 12) != 0x04030201) {
+    return false;
+  }
+  const uint32_t glType = read32(data + 16);
+  const uint32_t glInternalFormat = read32(data + 28);
+  const int width = static_cast<int>(read32(data + 36));
+  const int height = static_cast<int>(read32(data + 40));
+  const uint32_t depth = read32(data + 44);
+  const uint32_t arrayElements = read32(data + 48);
+  const uint32_t faces = read32(data + 52);
+  const uint32_t mipCount = read32(data + 56);
+  const uint32_t keyValueBytes = read32(data + 60);
+  if (glType != 0 || width <= 0 || height <= 0 || depth > 1 ||
+      arrayElements > 1 || faces != 1) {
+    return false; // Compressed 2D textures only.
+  }
+  switch (glInternalFormat) {
+  case kGlRgbDxt1:
+  case kGlSrgbDxt1:
+    out.format = BlockFormat::BC1;
+    break;
+  case kGlRgbaDxt1:
+  case kGlSrgbAlphaDxt1:
+    out.format = BlockFormat::BC1A;
+    break;
+  case kGlRgbaDxt3:
+  case kGlSrgbAlphaDxt3:
+    out.format = BlockFormat::BC2;
+    break;
+  case kGlRgbaDxt5:
+  case kGlSrgbAlphaDxt5:
+    out.format = BlockFormat::BC3;
+    break;
+  default:
+    return false;
+  }
+
+  // Each level is prefixed by its imageSize and padded to 4 bytes.
+  size_t offset = kKtxHeaderSize + keyValueBytes;
+  int levelWidth = width, levelHeight = height;
+  const uint32_t levels = std::min<uint32_t>(std::max<uint32_t>(mipCount, 1), 32);
+  for (uint32_t level = 0; level < levels; ++level) {
+    if (offset + 4 > size) {
+      return false;
+    }
+    size_t imageSize = read32(data + offset);
+    offset += 4;
+    if (imageSize < BCCodec::encodedSize(out.format, levelWidth, levelHeight) ||
+        offset + imageSize > size) {
+      return false;
+    }
+    out.levels.push_back({levelWidth, levelHeight, data + offset, imageSize});
+    offset += (imageSize + 3) & ~size_t(3);
+    levelWidth = std::max(1, levelWidth / 2);
+    levelHeight = std::max(1, levelHeight / 2);
+  }
+  return true;
+}
+
+bool CompressedTextureFile::writeDDS(const std::string &filePath,
+                                     const CompressedImage &image) {
+  if (image.levels.empty()) {
+    return false;
+  }
+  unsigned char header[kDdsDataOffset] = {};
+  const bool mipmapped = image.levels.size() > 1;
+  write32(header, fourCC('D', 'D', 'S', ' '));
+  write32(header + 4, kDdsHeaderSize);
+  write32(header + 8, kDdsdCaps | kDdsdHeight | kDdsdWidth | kDdsdPixelFormat |
+                          kDdsdLinearSize |
+                          (mipmapped ? kDdsdMipMapCount : 0));
+  write32(header + 12, static_cast<uint32_t>(image.height()));
+  write32(header + 16, static_cast<uint32_t>(image.width()));
+  write32(header + 20, static_cast<uint32_t>(image.levels[0].size));
+  write32(header + 28, static_cast<uint32_t>(image.levels.size()));
+  write32(header + 76, 32); // DDS_PIXELFORMAT size
+  uint32_t pfFlags = kDdpfFourCC;
+  uint32_t code = fourCC('D', 'X', 'T', '5');
+  switch (image.format) {
+  case BlockFormat::BC1A:
+    pfFlags |= kDdpfAlphaPixels;
+    [[fallthrough]];
+  case BlockFormat::BC1:
+    code = fourCC('D', 'X', 'T', '1');
+    break;
+  case BlockFormat::BC2:
+    code = fourCC('D', 'X', 'T', '3');
+    break;
+  case BlockFormat::BC3:
+    break;
+  }
+  write32(header + 80, pfFlags);
+  write32(header + 84, code);
+  write32(header + 108, kDdsCapsTexture |
+                            (mipmapped ? kDdsCapsComplex | kDdsCapsMipMap : 0));
+
+  // Write next to the target and rename, so readers never see a partial file.
+  const std::string temporary = filePath + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    for (const CompressedLevel &level : image.levels) {
+      file.write(reinterpret_cast<const char *>(level.data),
+                 static_cast<std::streamsize>(level.size));
+    }
+    if (!file) {
+      std::cerr << "Error: Could not write " << temporary << "\n";
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+  if (std::rename(temporary.c_str(), filePath.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,209 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <unordered_set>
+
+#if __has_include(<sys/inotify.h>)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define SCOP_HAVE_INOTIFY 1
+#endif
+
+namespace {
+
+/**
+ * @brief Absolute path with symlinks resolved as far as the file exists, so
+ * that every spelling of a file maps to one key.
+ */
+std::string canonicalPath(const std::string &filePath) {
+  std::error_code error;
+  std::filesystem::path path =
+      std::filesystem::weakly_canonical(std::filesystem::absolute(filePath),
+                                        error);
+  return error ? filePath : path.string();
+}
+
+} // end anonymous namespace
+
+FileWatcher::FileWatcher(std::function<void()> onChange)
+    : onChange_(std::move(onChange)) {
+#if defined(SCOP_HAVE_INOTIFY)
+  inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_ < 0 || pipe2(wake_, O_NONBLOCK | O_CLOEXEC) != 0) {
+    std::cerr << "Warning: cannot watch files for changes: "
+              << std::strerror(errno) << "\n";
+    return;
+  }
+  worker_ = std::thread(&FileWatcher::watchLoop, this);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+#if defined(SCOP_HAVE_INOTIFY)
+  if (worker_.joinable()) {
+    const char byte = 0;
+    (void)!write(wake_[1], &byte, 1);
+    worker_.join();
+  }
+  for (int fd : {inotify_, wake_[0], wake_[1]}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+void FileWatcher::watch(const std::vector<std::string> &filePaths) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  files_.clear();
+  std::unordered_set<std::string> wanted;
+  for (const std::string &filePath : filePaths) {
+    if (filePath.empty()) {
+      continue;
+    }
+    const std::string key = canonicalPath(filePath);
+    std::vector<std::string> &names = files_[key];
+    if (std::find(names.begin(), names.end(), filePath) == names.end()) {
+      names.push_back(filePath);
+    }
+    wanted.insert(std::filesystem::path(key).parent_path().string());
+  }
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    it = files_.count(it->first) != 0 ? std::next(it) : pending_.erase(it);
+  }
+
+#if defined(SCOP_HAVE_INOTIFY)
+  if (inotify_ < 0) {
+    return;
+  }
+  for (auto it = directories_.begin(); it != directories_.end();) {
+    if (wanted.count(it->first) != 0) {
+      ++it;
+      continue;
+    }
+    inotify_rm_watch(inotify_, it->second);
+    directoryOf_.erase(it->second);
+    it = directories_.erase(it);
+  }
+  for (const std::string &directory : wanted) {
+    if (directories_.count(directory) != 0) {
+      continue;
+    }
+    // Close-write and rename cover most saves; plain modifications catch
+    // files appended to while kept open.
+    const int watch = inotify_add_watch(
+        inotify_, directory.c_str(),
+        IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watch < 0) {
+      std::cerr << "Warning: cannot watch " << directory << ": "
+                << std::strerror(errno) << "\n";
+      continue;
+    }
+    directories_[directory] = watch;
+    directoryOf_[watch] = directory;
+  }
+#endif
+}
+
+std::vector<std::string> FileWatcher::takeChanged() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> changed;
+  changed.swap(changed_);
+  return changed;
+}
+
+void FileWatcher::watchLoop() {
+#if defined(SCOP_HAVE_INOTIFY)
+  for (;;) {
+    int timeout = -1;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        return;
+      }
+      if (!pending_.empty()) {
+        timeout = kSettleMillis;
+      }
+    }
+    pollfd fds[2] = {{inotify_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+    if (poll(fds, 2, timeout) < 0 && errno != EINTR) {
+      std::cerr << "Warning: stopped watching files: " << std::strerror(errno)
+                << "\n";
+      return;
+    }
+
+    bool ready = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        return;
+      }
+      readEvents();
+      // Report what has been quiet long enough; a save still in progress
+      // keeps pushing its time back.
+      const Clock::time_point now = Clock::now();
+      for (auto it = pending_.begin(); it != pending_.end();) {
+        if (now - it->second < std::chrono::milliseconds(kSettleMillis)) {
+          ++it;
+          continue;
+        }
+        for (const std::string &name : files_[it->first]) {
+          if (std::find(changed_.begin(), changed_.end(), name) ==
+              changed_.end()) {
+            changed_.push_back(name);
+          }
+        }
+        it = pending_.erase(it);
+        ready = true;
+      }
+    }
+    if (ready) {
+      onChange_();
+    }
+  }
+#endif
+}
+
+void FileWatcher::readEvents() {
+#if defined(SCOP_HAVE_INOTIFY)
+  alignas(inotify_event) char buffer[16 * 1024];
+  const Clock::time_point now = Clock::now();
+  for (;;) {
+    const ssize_t length = read(inotify_, buffer, sizeof(buffer));
+    if (length <= 0) {
+      return; // EAGAIN: no more events
+    }
+    for (const char *p = buffer; p < buffer + length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(p);
+      p += sizeof(inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost: assume every file changed.
+        for (const auto &file : files_) {
+          pending_[file.first] = now;
+        }
+        continue;
+      }
+      auto directory = directoryOf_.find(event->wd);
+      if (directory == directoryOf_.end() || event->len == 0) {
+        continue;
+      }
+      const std::string key =
+          (std::filesystem::path(directory->second) / event->name).string();
+      if (files_.count(key) != 0) {
+        pending_[key] = now;
+      }
+    }
+  }
+#endif
+}
@@ -0,0 +1,72 @@
+#include "FrameScheduler.hpp"
+
+#include "GL.hpp"
+#include <thread>
+
+namespace {
+
+// Upper bound on a single idle wait, so the loop still notices a window close
+// request or a snapshot whose wake-up event got coalesced.
+constexpr double kIdleWaitTimeout = 0.25;
+
+// The OS sleep is only trusted up to this margin before the deadline; the
+// rest is spent yielding, which keeps frame pacing within tens of
+// microseconds without burning a full core.
+constexpr std::chrono::microseconds kSpinMargin(1500);
+
+} // end anonymous namespace
+
+FrameScheduler::FrameScheduler(double fpsCap)
+    : fpsCap_(fpsCap), frameInterval_(Clock::duration::zero()),
+      nextFrame_(Clock::now()), mode_(Mode::ACTIVE), redrawRequested_(true) {
+  if (fpsCap_ > 0.0) {
+    frameInterval_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / fpsCap_));
+  }
+}
+
+void FrameScheduler::requestRedraw() { redrawRequested_ = true; }
+
+bool FrameScheduler::shouldRender(bool newSnapshot) {
+  bool render = newSnapshot || redrawRequested_;
+  redrawRequested_ = false;
+  return render;
+}
+
+void FrameScheduler::beginFrame(bool animating) {
+  mode_ = animating ? Mode::ACTIVE : Mode::IDLE;
+}
+
+void FrameScheduler::waitForNextFrame() {
+  if (mode_ == Mode::IDLE) {
+    glfwWaitEventsTimeout(kIdleWaitTimeout);
+    // Restart pacing from now so the first active frame isn't delayed.
+    nextFrame_ = Clock::now();
+    return;
+  }
+
+  if (frameInterval_ != Clock::duration::zero()) {
+    nextFrame_ += frameInterval_;
+    Clock::time_point now = Clock::now();
+    if (nextFrame_ < now) {
+      // Missed the slot; resynchronize instead of bursting to catch up.
+      nextFrame_ = now;
+    } else {
+      sleepUntil(nextFrame_);
+    }
+  }
+  glfwPollEvents();
+}
+
+const char *FrameScheduler::modeName() const {
+  return mode_ == Mode::ACTIVE ? "Active" : "Idle";
+}
+
+void FrameScheduler::sleepUntil(Clock::time_point deadline) const {
+  if (deadline - Clock::now() > kSpinMargin) {
+    std::this_thread::sleep_until(deadline - kSpinMargin);
+  }
+  while (Clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
@@ -0,0 +1,93 @@
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      open_(std::exchange(other.open_, false)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    open_ = std::exchange(other.open_, false);
+  }
+  return *this;
+}
+
+bool MappedFile::open(const std::string &path) {
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::cerr << "Error: Could not open " << path << ": "
+              << std::strerror(errno) << "\n";
+    return false;
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    std::cerr << "Error: " << path << " is not a regular file.\n";
+    ::close(fd);
+    return false;
+  }
+
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ > 0) {
+    void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      std::cerr << "Error: Could not map " << path << ": "
+                << std::strerror(errno) << "\n";
+      ::close(fd);
+      size_ = 0;
+      return false;
+    }
+    // Decoders stream through the file once, front to back.
+    ::madvise(mapping, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const unsigned char *>(mapping);
+  }
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<unsigned char *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+
+void MappedFile::adviseRandomAccess() const {
+  if (data_ != nullptr) {
+    ::madvise(const_cast<unsigned char *>(data_), size_, MADV_RANDOM);
+  }
+}
+
+void MappedFile::dropRange(size_t offset, size_t length) const {
+  if (data_ == nullptr || offset >= size_) {
+    return;
+  }
+  const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+  size_t end = std::min(size_, offset + length) / pageSize * pageSize;
+  if (begin < end) {
+    ::madvise(const_cast<unsigned char *>(data_) + begin, end - begin,
+              MADV_DONTNEED);
+  }
+}
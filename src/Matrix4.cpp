@@ -0,0 +1,240 @@
+#include "Matrix4.hpp"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+bool Matrix4::inverse(Matrix4 &out) const {
+#if defined(__SSE2__)
+  // Cramer's rule on the transposed matrix (Intel AP-928). Works for
+  // column-major storage as well since inverse(M^T) == inverse(M)^T.
+  __m128 minor0, minor1, minor2, minor3;
+  __m128 row0, row1, row2, row3;
+  __m128 det, tmp1;
+  const __m128 zero = _mm_setzero_ps();
+
+  tmp1 = _mm_loadh_pi(_mm_loadl_pi(zero, reinterpret_cast<const __m64 *>(m)),
+                      reinterpret_cast<const __m64 *>(m + 4));
+  row1 =
+      _mm_loadh_pi(_mm_loadl_pi(zero, reinterpret_cast<const __m64 *>(m + 8)),
+                   reinterpret_cast<const __m64 *>(m + 12));
+  row0 = _mm_shuffle_ps(tmp1, row1, 0x88);
+  row1 = _mm_shuffle_ps(row1, tmp1, 0xDD);
+  tmp1 =
+      _mm_loadh_pi(_mm_loadl_pi(zero, reinterpret_cast<const __m64 *>(m + 2)),
+                   reinterpret_cast<const __m64 *>(m + 6));
+  row3 =
+      _mm_loadh_pi(_mm_loadl_pi(zero, reinterpret_cast<const __m64 *>(m + 10)),
+                   reinterpret_cast<const __m64 *>(m + 14));
+  row2 = _mm_shuffle_ps(tmp1, row3, 0x88);
+  row3 = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+  tmp1 = _mm_mul_ps(row2, row3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor0 = _mm_mul_ps(row1, tmp1);
+  minor1 = _mm_mul_ps(row0, tmp1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+  minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+  minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+  tmp1 = _mm_mul_ps(row1, row2);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+  minor3 = _mm_mul_ps(row0, tmp1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+  minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+  minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+  tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+  minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+  minor2 = _mm_mul_ps(row0, tmp1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+  minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+  minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+  tmp1 = _mm_mul_ps(row0, row1);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+  minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+  minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+  tmp1 = _mm_mul_ps(row0, row3);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+  minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+  minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+  tmp1 = _mm_mul_ps(row0, row2);
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+  minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+  minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+  tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+  minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+  minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+  det = _mm_mul_ps(row0, minor0);
+  det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+  det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+  if (_mm_cvtss_f32(det) == 0.0f) {
+    return false;
+  }
+  // Exact reciprocal rather than _mm_rcp_ss: callers use this for picking.
+  det = _mm_div_ss(_mm_set_ss(1.0f), det);
+  det = _mm_shuffle_ps(det, det, 0x00);
+
+  _mm_store_ps(out.m + 0, _mm_mul_ps(det, minor0));
+  _mm_store_ps(out.m + 4, _mm_mul_ps(det, minor1));
+  _mm_store_ps(out.m + 8, _mm_mul_ps(det, minor2));
+  _mm_store_ps(out.m + 12, _mm_mul_ps(det, minor3));
+  return true;
+#else
+  return inverseScalar(out);
+#endif
+}
+
+void Matrix4::transformPoints(const float *in, float *out,
+                              size_t count) const {
+#if defined(__SSE2__)
+  const __m128 c0 = _mm_load_ps(m + 0);
+  const __m128 c1 = _mm_load_ps(m + 4);
+  const __m128 c2 = _mm_load_ps(m + 8);
+  const __m128 c3 = _mm_load_ps(m + 12);
+  alignas(16) float result[4];
+
+  for (size_t i = 0; i < count; ++i) {
+    const float *p = in + i * 3;
+    // Same association as transform(): ((m0*x + m4*y) + m8*z) + m12
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(p[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+    r = _mm_add_ps(r, c3);
+
+    __m128 w = _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 nonZero = _mm_cmpneq_ps(w, _mm_setzero_ps());
+    __m128 divided = _mm_div_ps(r, w);
+    r = _mm_or_ps(_mm_and_ps(nonZero, divided), _mm_andnot_ps(nonZero, r));
+
+    _mm_store_ps(result, r);
+    float *o = out + i * 3;
+    o[0] = result[0];
+    o[1] = result[1];
+    o[2] = result[2];
+  }
+#else
+  for (size_t i = 0; i < count; ++i) {
+    Vector3 r = transform(Vector3(in[i * 3], in[i * 3 + 1], in[i * 3 + 2]));
+    out[i * 3] = r.x;
+    out[i * 3 + 1] = r.y;
+    out[i * 3 + 2] = r.z;
+  }
+#endif
+}
+
+namespace {
+
+/**
+ * @brief Scalar tail shared by the SoA kernels.
+ */
+void transformSoAScalar(const Matrix4 &mat, const float *x, const float *y,
+                        const float *z, float *outX, float *outY, float *outZ,
+                        size_t begin, size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    Vector3 r = mat.transform(Vector3(x[i], y[i], z[i]));
+    outX[i] = r.x;
+    outY[i] = r.y;
+    outZ[i] = r.z;
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx"))) void
+transformSoAAvx(const Matrix4 &mat, const float *x, const float *y,
+                const float *z, float *outX, float *outY, float *outZ,
+                size_t count) {
+  const float *m = mat.m;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 vx = _mm256_loadu_ps(x + i);
+    __m256 vy = _mm256_loadu_ps(y + i);
+    __m256 vz = _mm256_loadu_ps(z + i);
+
+    __m256 r[4];
+    for (int row = 0; row < 4; ++row) {
+      __m256 acc = _mm256_mul_ps(_mm256_set1_ps(m[row]), vx);
+      acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m[row + 4]), vy));
+      acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m[row + 8]), vz));
+      r[row] = _mm256_add_ps(acc, _mm256_set1_ps(m[row + 12]));
+    }
+
+    __m256 nonZero = _mm256_cmp_ps(r[3], _mm256_setzero_ps(), _CMP_NEQ_UQ);
+    _mm256_storeu_ps(outX + i, _mm256_blendv_ps(
+                                   r[0], _mm256_div_ps(r[0], r[3]), nonZero));
+    _mm256_storeu_ps(outY + i, _mm256_blendv_ps(
+                                   r[1], _mm256_div_ps(r[1], r[3]), nonZero));
+    _mm256_storeu_ps(outZ + i, _mm256_blendv_ps(
+                                   r[2], _mm256_div_ps(r[2], r[3]), nonZero));
+  }
+  transformSoAScalar(mat, x, y, z, outX, outY, outZ, i, count);
+}
+#endif
+
+#if defined(__SSE2__)
+void transformSoASse(const Matrix4 &mat, const float *x, const float *y,
+                     const float *z, float *outX, float *outY, float *outZ,
+                     size_t count) {
+  const float *m = mat.m;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 vx = _mm_loadu_ps(x + i);
+    __m128 vy = _mm_loadu_ps(y + i);
+    __m128 vz = _mm_loadu_ps(z + i);
+
+    __m128 r[4];
+    for (int row = 0; row < 4; ++row) {
+      __m128 acc = _mm_mul_ps(_mm_set1_ps(m[row]), vx);
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m[row + 4]), vy));
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m[row + 8]), vz));
+      r[row] = _mm_add_ps(acc, _mm_set1_ps(m[row + 12]));
+    }
+
+    __m128 nonZero = _mm_cmpneq_ps(r[3], _mm_setzero_ps());
+    for (int row = 0; row < 3; ++row) {
+      __m128 divided = _mm_div_ps(r[row], r[3]);
+      r[row] = _mm_or_ps(_mm_and_ps(nonZero, divided),
+                         _mm_andnot_ps(nonZero, r[row]));
+    }
+    _mm_storeu_ps(outX + i, r[0]);
+    _mm_storeu_ps(outY + i, r[1]);
+    _mm_storeu_ps(outZ + i, r[2]);
+  }
+  transformSoAScalar(mat, x, y, z, outX, outY, outZ, i, count);
+}
+#endif
+
+} // end anonymous namespace
+
+void Matrix4::transformPointsSoA(const float *x, const float *y,
+                                 const float *z, float *outX, float *outY,
+                                 float *outZ, size_t count) const {
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool hasAvx = __builtin_cpu_supports("avx");
+  if (hasAvx) {
+    transformSoAAvx(*this, x, y, z, outX, outY, outZ, count);
+    return;
+  }
+#endif
+#if defined(__SSE2__)
+  transformSoASse(*this, x, y, z, outX, outY, outZ, count);
+#else
+  transformSoAScalar(*this, x, y, z, outX, outY, outZ, 0, count);
+#endif
+}
@@ -0,0 +1,173 @@
+#include "MemoryTracker.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <utility>
+
+namespace {
+
+constexpr size_t kTagCount = static_cast<size_t>(MemoryTag::COUNT);
+
+struct Counter {
+  std::atomic<size_t> current{0};
+  std::atomic<size_t> peak{0};
+};
+
+// One extra slot for the total across all tags.
+std::array<Counter, kTagCount + 1> counters;
+
+Counter &counterFor(MemoryTag tag) {
+  return counters[static_cast<size_t>(tag)];
+}
+
+Counter &totalCounter() { return counters[kTagCount]; }
+
+void add(Counter &counter, size_t bytes) {
+  size_t now =
+      counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  size_t seen = counter.peak.load(std::memory_order_relaxed);
+  while (now > seen && !counter.peak.compare_exchange_weak(
+                           seen, now, std::memory_order_relaxed)) {
+  }
+}
+
+size_t heapBytes(const std::string &s) {
+  // Short strings live inside the object itself.
+  return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+} // end anonymous namespace
+
+MemoryTracker::Allocation::Allocation(MemoryTag tag, size_t bytes)
+    : tag_(tag), bytes_(bytes) {
+  MemoryTracker::allocate(tag_, bytes_);
+}
+
+MemoryTracker::Allocation::~Allocation() {
+  if (tag_ != MemoryTag::COUNT) {
+    MemoryTracker::release(tag_, bytes_);
+  }
+}
+
+MemoryTracker::Allocation::Allocation(Allocation &&other) noexcept
+    : tag_(other.tag_), bytes_(other.bytes_) {
+  other.tag_ = MemoryTag::COUNT;
+  other.bytes_ = 0;
+}
+
+MemoryTracker::Allocation &
+MemoryTracker::Allocation::operator=(Allocation &&other) noexcept {
+  if (this != &other) {
+    if (tag_ != MemoryTag::COUNT) {
+      MemoryTracker::release(tag_, bytes_);
+    }
+    tag_ = std::exchange(other.tag_, MemoryTag::COUNT);
+    bytes_ = std::exchange(other.bytes_, 0);
+  }
+  return *this;
+}
+
+void MemoryTracker::Allocation::resize(size_t bytes) {
+  if (tag_ == MemoryTag::COUNT) {
+    return;
+  }
+  if (bytes > bytes_) {
+    MemoryTracker::allocate(tag_, bytes - bytes_);
+  } else {
+    MemoryTracker::release(tag_, bytes_ - bytes);
+  }
+  bytes_ = bytes;
+}
+
+void MemoryTracker::allocate(MemoryTag tag, size_t bytes) {
+  if (tag == MemoryTag::COUNT || bytes == 0) {
+    return;
+  }
+  add(counterFor(tag), bytes);
+  add(totalCounter(), bytes);
+}
+
+void MemoryTracker::release(MemoryTag tag, size_t bytes) {
+  if (tag == MemoryTag::COUNT || bytes == 0) {
+    return;
+  }
+  counterFor(tag).current.fetch_sub(bytes, std::memory_order_relaxed);
+  totalCounter().current.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::current(MemoryTag tag) {
+  return counterFor(tag).current.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::peak(MemoryTag tag) {
+  return counterFor(tag).peak.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::totalCurrent() {
+  return totalCounter().current.load(std::memory_order_relaxed);
+}
+
+size_t MemoryTracker::totalPeak() {
+  return totalCounter().peak.load(std::memory_order_relaxed);
+}
+
+const char *MemoryTracker::tagName(MemoryTag tag) {
+  static const char *names[] = {"Loader",     "Mesh data",    "Derived data",
+                                "Textures",   "GPU textures", "Mesh pages",
+                                "GPU buffers"};
+  static_assert(sizeof(names) / sizeof(names[0]) == kTagCount);
+  size_t index = static_cast<size_t>(tag);
+  return index < kTagCount ? names[index] : "Total";
+}
+
+void MemoryTracker::formatBytes(size_t bytes, char *buffer,
+                                size_t bufferSize) {
+  static const char *units[] = {"B", "KiB", "MiB", "GiB"};
+  double value = static_cast<double>(bytes);
+  int unit = 0;
+  while (value >= 1024.0 && unit < 3) {
+    value /= 1024.0;
+    ++unit;
+  }
+  if (unit == 0) {
+    std::snprintf(buffer, bufferSize, "%zu B", bytes);
+  } else {
+    std::snprintf(buffer, bufferSize, "%.2f %s", value, units[unit]);
+  }
+}
+
+void MemoryTracker::printReport(std::ostream &out,
+                                const std::string &context) {
+  char current[32], peak[32];
+  out << "Memory (" << context << "), current / peak:\n";
+  for (size_t i = 0; i <= kTagCount; ++i) {
+    const Counter &counter = counters[i];
+    formatBytes(counter.current.load(std::memory_order_relaxed), current,
+                sizeof(current));
+    formatBytes(counter.peak.load(std::memory_order_relaxed), peak,
+                sizeof(peak));
+    char line[96];
+    std::snprintf(line, sizeof(line), "  %-14s %12s / %12s\n",
+                  tagName(static_cast<MemoryTag>(i)), current, peak);
+    out << line;
+  }
+}
+
+size_t MemoryTracker::bytesOf(const OBJModel &model) {
+  size_t bytes = heapBytes(model.objectName) + heapBytes(model.textureName) +
+                 bytesOf(model.vertices) + bytesOf(model.texCoords) +
+                 bytesOf(model.normals) + bytesOf(model.faces);
+  for (const Face &face : model.faces) {
+    bytes += bytesOf(face.vertices);
+  }
+  bytes += bytesOf(model.materials);
+  for (const Material &material : model.materials) {
+    bytes += heapBytes(material.name) + heapBytes(material.diffuseMap);
+  }
+  bytes += bytesOf(model.submeshes);
+  for (const Submesh &submesh : model.submeshes) {
+    bytes += heapBytes(submesh.name);
+  }
+  return bytes;
+}
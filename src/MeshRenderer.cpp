@@ -1,110 +1,399 @@
 #include "MeshRenderer.hpp"
-#include <GLFW/glfw3.h>
+#include "GL.hpp"
+#include <algorithm>
 #include <iostream>
 
-void MeshRenderer::drawAllFaces(
-    const OBJModel &model, RenderMode mode, GLuint textureID,
-    const std::vector<std::array<float, 3>> &faceGrayColors,
-    const std::vector<std::array<float, 3>> &faceRandomColors,
-    const std::vector<std::array<float, 3>> &faceMaterialColors) {
-  // Bind and enable texture if in TEXTURE mode
-  if (mode == RenderMode::TEXTURE && textureID != 0) {
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glEnable(GL_TEXTURE_2D);
+size_t MeshRenderer::drawAllFaces(
+    const DrawBatches &batches, const std::vector<Material> &materials,
+    RenderMode mode, GLuint textureID,
+    const std::vector<GLuint> &materialTextures,
+    const std::vector<unsigned char> &submeshState) {
+  if (batches.cornerCount() == 0) {
+    return 0;
+  }
+  bindBatches(batches, mode);
+  size_t draws = drawBatches(batches, materials, mode, textureID,
+                             materialTextures, submeshState);
+  unbindBatches(mode);
+  return draws;
+}
+
+void MeshRenderer::bindBatches(const DrawBatches &batches, RenderMode mode) {
+  const QuantizedVertices &quantized = batches.quantized;
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  if (quantized.empty()) {
+    glVertexPointer(3, GL_FLOAT, 0, batches.positions.data());
   } else {
-    // Otherwise disable texturing
-    glDisable(GL_TEXTURE_2D);
+    // drawBatches() applies positionDecode on the modelview matrix
+    glVertexPointer(3, GL_SHORT, 4 * sizeof(int16_t),
+                    quantized.positions.data());
   }
 
-  bool hasTexCoords = !model.texCoords.empty();
+  glDisable(GL_TEXTURE_2D);
+  switch (mode) {
+  case RenderMode::GRAYSCALE:
+  case RenderMode::RANDOM_COLOR:
+    // Face colors are baked into the corners
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0,
+                   mode == RenderMode::GRAYSCALE ? batches.grayColors.data()
+                                                 : batches.randomColors.data());
+    break;
 
-  // Handle WIRE_FRAME mode
-  if (mode == RenderMode::WIRE_FRAME) {
-    // Tell OpenGL to draw polygons as lines
+  case RenderMode::WIRE_FRAME:
+    // Tell OpenGL to draw polygons as lines; edge flags hide fan diagonals
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     glColor3f(0.0f, 0.0f, 0.0f); // Black lines
+    glEnableClientState(GL_EDGE_FLAG_ARRAY);
+    glEdgeFlagPointer(0, batches.edgeFlags.data());
+    break;
+
+  case RenderMode::TEXTURE:
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    // The texture matrix holds the decode of quantized coordinates
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    if (quantized.empty()) {
+      glTexCoordPointer(2, GL_FLOAT, 0, batches.texCoords.data());
+    } else {
+      glTexCoordPointer(2, GL_SHORT, 0, quantized.texCoords.data());
+      glLoadMatrixf(quantized.texCoordDecode.m);
+    }
+    glMatrixMode(GL_MODELVIEW);
+    // White so as not to tint the texture
+    glColor3f(1.0f, 1.0f, 1.0f);
+    break;
+
+  case RenderMode::LIT:
+    // Fixed-function headlight driven by the model normals
+    enableHeadlight();
+    glEnableClientState(GL_NORMAL_ARRAY);
+    if (quantized.empty()) {
+      glNormalPointer(GL_FLOAT, 0, batches.normals.data());
+    } else {
+      glNormalPointer(GL_BYTE, 4, quantized.normals.data());
+    }
+    break;
+
+  default:
+    glColor3f(1.0f, 1.0f, 1.0f);
+    break;
   }
+}
 
-  // Iterate through each face
-  for (size_t faceIndex = 0; faceIndex < model.faces.size(); ++faceIndex) {
-    glBegin(GL_POLYGON);
+void MeshRenderer::unbindBatches(RenderMode mode) {
+  switch (mode) {
+  case RenderMode::WIRE_FRAME:
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    break;
+  case RenderMode::TEXTURE:
+    glDisable(GL_TEXTURE_2D);
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    break;
+  case RenderMode::LIT:
+    glPopAttrib();
+    break;
+  default:
+    break;
+  }
+  glPopClientAttrib();
+}
 
-    // Set face color if not in WIRE_FRAME mode
-    if (mode != RenderMode::WIRE_FRAME) {
-      setFaceColor(mode, faceIndex, faceGrayColors, faceRandomColors,
-                   faceMaterialColors);
+size_t MeshRenderer::drawBatches(
+    const DrawBatches &batches, const std::vector<Material> &materials,
+    RenderMode mode, GLuint textureID,
+    const std::vector<GLuint> &materialTextures,
+    const std::vector<unsigned char> &submeshState) {
+  if (batches.cornerCount() == 0) {
+    return 0;
+  }
+  // Quantized positions: fold the decode into the modelview matrix
+  const bool quantized = !batches.quantized.empty();
+  if (quantized) {
+    glPushMatrix();
+    glMultMatrixf(batches.quantized.positionDecode.m);
+  }
+  size_t draws = 0;
+  auto drawCorners = [&](size_t first, size_t count) {
+    glDrawArrays(GL_TRIANGLES, static_cast<GLint>(first),
+                 static_cast<GLsizei>(count));
+    ++draws;
+  };
+  auto isDrawn = [&](size_t submesh) {
+    return submesh >= submeshState.size() || submeshState[submesh] == 0;
+  };
+  auto drawAll = [&] {
+    if (submeshState.empty()) {
+      drawCorners(0, batches.cornerCount());
+      return;
+    }
+    // Submeshes are contiguous in corner order; merge adjacent drawn ones.
+    size_t runFirst = 0, runCount = 0;
+    for (size_t s = 0; s < batches.submeshes.size(); ++s) {
+      const SubmeshRange &submesh = batches.submeshes[s];
+      if (!isDrawn(s) || submesh.cornerCount == 0) {
+        continue;
+      }
+      if (runCount > 0 && runFirst + runCount != submesh.firstCorner) {
+        drawCorners(runFirst, runCount);
+        runCount = 0;
+      }
+      if (runCount == 0) {
+        runFirst = submesh.firstCorner;
+      }
+      runCount += submesh.cornerCount;
     }
+    if (runCount > 0) {
+      drawCorners(runFirst, runCount);
+    }
+  };
+  auto drawRange = [&](const MaterialRange &range) {
+    drawCorners(range.first, range.count);
+  };
+  auto materialOf = [&](const MaterialRange &range) -> const Material * {
+    return (range.material >= 0 &&
+            range.material < static_cast<int>(materials.size()))
+               ? &materials[range.material]
+               : nullptr;
+  };
 
-    // Draw each vertex
-    for (const auto &fv : model.faces[faceIndex].vertices) {
-      if (fv.vertexIndex < 0 ||
-          fv.vertexIndex >= static_cast<int>(model.vertices.size())) {
-        continue; // Skip invalid indices
+  switch (mode) {
+  case RenderMode::TEXTURE: {
+    GLuint bound = 0;
+    for (const MaterialRange &range : batches.ranges) {
+      if (!isDrawn(static_cast<size_t>(range.submesh))) {
+        continue;
       }
+      GLuint texture = textureID;
+      if (range.material >= 0 &&
+          range.material < static_cast<int>(materialTextures.size()) &&
+          materialTextures[range.material] != 0) {
+        texture = materialTextures[range.material];
+      }
+      if (texture != bound || draws == 0) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (texture != 0) {
+          glEnable(GL_TEXTURE_2D);
+        } else {
+          glDisable(GL_TEXTURE_2D);
+        }
+        bound = texture;
+      }
+      drawRange(range);
+    }
+    break;
+  }
 
-      if (mode == RenderMode::TEXTURE) {
-        if (hasTexCoords && fv.texCoordIndex >= 0 &&
-            fv.texCoordIndex < static_cast<int>(model.texCoords.size())) {
-          const auto &tc = model.texCoords[fv.texCoordIndex];
-          glTexCoord2f(tc.u, 1.0f - tc.v); // Flip V
+  case RenderMode::LIT: {
+    // Each material's diffuse color (neutral clay without materials)
+    const Material *current = nullptr;
+    for (const MaterialRange &range : batches.ranges) {
+      if (!isDrawn(static_cast<size_t>(range.submesh))) {
+        continue;
+      }
+      const Material *material = materialOf(range);
+      if (material != current || draws == 0) {
+        if (material) {
+          glColor3fv(material->diffuse.data());
         } else {
-          // Procedural planar mapping (e.g., on the XY plane)
-          const auto &v = model.vertices[fv.vertexIndex];
-          glTexCoord2f(v.x, 1.0f - v.y); // Adjust based on desired mapping
+          glColor3f(0.8f, 0.8f, 0.78f);
         }
+        current = material;
       }
+      drawRange(range);
+    }
+    break;
+  }
 
-      // Specify vertex position
+  default:
+    drawAll();
+    break;
+  }
+  if (quantized) {
+    glPopMatrix();
+  }
+  return draws;
+}
+
+void MeshRenderer::drawFaceHighlight(const OBJModel &model,
+                                     size_t faceIndex) {
+  if (faceIndex >= model.faces.size()) {
+    return;
+  }
+  const auto &corners = model.faces[faceIndex].vertices;
+
+  glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_POLYGON_BIT | GL_LINE_BIT |
+               GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+  glDisable(GL_TEXTURE_2D);
+  glDisable(GL_LIGHTING);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDepthFunc(GL_LEQUAL);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+  // Pull the overlay toward the camera so it wins the depth test
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(-1.0f, -1.0f);
+
+  glColor4f(1.0f, 0.8f, 0.0f, 0.6f);
+  glBegin(GL_POLYGON);
+  for (const auto &fv : corners) {
+    if (fv.vertexIndex >= 0 &&
+        fv.vertexIndex < static_cast<int>(model.vertices.size())) {
       const auto &v = model.vertices[fv.vertexIndex];
       glVertex3f(v.x, v.y, v.z);
     }
+  }
+  glEnd();
 
-    glEnd();
+  glLineWidth(2.0f);
+  glColor4f(1.0f, 0.4f, 0.0f, 1.0f);
+  glBegin(GL_LINE_LOOP);
+  for (const auto &fv : corners) {
+    if (fv.vertexIndex >= 0 &&
+        fv.vertexIndex < static_cast<int>(model.vertices.size())) {
+      const auto &v = model.vertices[fv.vertexIndex];
+      glVertex3f(v.x, v.y, v.z);
+    }
   }
+  glEnd();
+
+  glPopAttrib();
+}
+
+void MeshRenderer::enableHeadlight() {
+  glPushAttrib(GL_LIGHTING_BIT | GL_ENABLE_BIT);
+
+  // Position the light in eye space so it follows the camera
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+  const GLfloat direction[] = {0.3f, 0.5f, 1.0f, 0.0f};
+  const GLfloat ambient[] = {0.15f, 0.15f, 0.15f, 1.0f};
+  const GLfloat diffuse[] = {0.85f, 0.85f, 0.85f, 1.0f};
+  glLightfv(GL_LIGHT0, GL_POSITION, direction);
+  glLightfv(GL_LIGHT0, GL_AMBIENT, ambient);
+  glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+  glPopMatrix();
+
+  glEnable(GL_LIGHTING);
+  glEnable(GL_LIGHT0);
+  // The model matrix scales the mesh; renormalize after transformation
+  glEnable(GL_NORMALIZE);
+  glEnable(GL_COLOR_MATERIAL);
+  glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+  glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+}
 
-  // ------------------------------------------------------------------------
-  // Restore polygon mode if we changed it
-  // ------------------------------------------------------------------------
-  if (mode == RenderMode::WIRE_FRAME) {
+size_t MeshRenderer::drawPagedMesh(const PagedMesh &mesh, RenderMode mode) {
+  const std::vector<MeshPage> &pages = mesh.pages();
+  size_t draws = 0;
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glDisable(GL_TEXTURE_2D);
+
+  const bool wireframe = mode == RenderMode::WIRE_FRAME;
+  if (wireframe) {
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glColor3f(0.0f, 0.0f, 0.0f);
+  } else {
+    enableHeadlight();
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glColor3f(0.8f, 0.8f, 0.78f);
+  }
+  for (size_t i = 0; i < pages.size(); ++i) {
+    const MeshPage &page = pages[i];
+    if (!page.visible || !page.resident()) {
+      continue;
+    }
+    if (mode == RenderMode::RANDOM_COLOR) {
+      // Stable per-page tint, so the page layout is visible
+      uint32_t hash = static_cast<uint32_t>(i) * 2654435761u;
+      glColor3ub(static_cast<GLubyte>(96 + (hash >> 24) % 160),
+                 static_cast<GLubyte>(96 + (hash >> 16) % 160),
+                 static_cast<GLubyte>(96 + (hash >> 8) % 160));
+    }
+    glVertexPointer(3, GL_FLOAT, 0, page.positions.data());
+    if (!wireframe) {
+      glNormalPointer(GL_FLOAT, 0, page.normals.data());
+    }
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(page.triangleCount) * 3);
+    ++draws;
+  }
+  if (wireframe) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  } else {
+    glPopAttrib();
+    glDisableClientState(GL_NORMAL_ARRAY);
   }
 
-  if (mode == RenderMode::TEXTURE && textureID != 0) {
-    glDisable(GL_TEXTURE_2D);
+  // Placeholders: the sample points of pages still loading
+  glPushAttrib(GL_POINT_BIT | GL_CURRENT_BIT);
+  glPointSize(3.0f);
+  glColor3f(0.55f, 0.6f, 0.65f);
+  const std::vector<float> &samples = mesh.samples();
+  for (const MeshPage &page : pages) {
+    if (!page.visible || page.resident() || page.sampleCount == 0) {
+      continue;
+    }
+    glVertexPointer(3, GL_FLOAT, 0, samples.data() + page.firstSample * 3);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(page.sampleCount));
+    ++draws;
   }
-}
+  glPopAttrib();
 
-void MeshRenderer::setFaceColor(
-    RenderMode mode, size_t faceIndex,
-    const std::vector<std::array<float, 3>> &faceGrayColors,
-    const std::vector<std::array<float, 3>> &faceRandomColors,
-    const std::vector<std::array<float, 3>> &faceMaterialColors) {
-  static_cast<void>(faceMaterialColors);
+  glPopClientAttrib();
+  return draws;
+}
 
-  switch (mode) {
-  case RenderMode::GRAYSCALE: {
-    const auto &gc = faceGrayColors[faceIndex];
-    glColor3f(gc[0], gc[1], gc[2]);
-    break;
+size_t MeshRenderer::drawPoints(const PointCloudBuffer &points, size_t budget,
+                                size_t &drawCalls) {
+  drawCalls = 0;
+  const size_t count = points.pointCount();
+  if (count == 0) {
+    return 0;
   }
-  case RenderMode::RANDOM_COLOR: {
-    const auto &rc = faceRandomColors[faceIndex];
-    glColor3f(rc[0], rc[1], rc[2]);
-    break;
-  }
-  case RenderMode::TEXTURE:
-    // White so as not to tint the texture
-    glColor3f(1.0f, 1.0f, 1.0f);
-    break;
+  const size_t drawn = budget > 0 ? std::min(budget, count) : count;
 
-  case RenderMode::WIRE_FRAME:
-    // Wireframe = black contour
-    glColor3f(0.0f, 0.0f, 0.0f);
-    break;
+  glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+  glPushAttrib(GL_POINT_BIT | GL_CURRENT_BIT | GL_ENABLE_BIT);
+  glDisable(GL_TEXTURE_2D);
+  // size = 10 / eye distance, so points thin out as the camera backs off
+  // (2 px at the default framing distance of a normalized model).
+  const GLfloat attenuation[] = {0.0f, 0.0f, 1.0f};
+  glPointSize(10.0f);
+  glPointParameterfv(GL_POINT_DISTANCE_ATTENUATION, attenuation);
+  glPointParameterf(GL_POINT_SIZE_MIN, 1.0f);
+  glPointParameterf(GL_POINT_SIZE_MAX, 6.0f);
+  glColor3f(0.92f, 0.9f, 0.85f);
 
-  default:
-    // Fallback
-    glColor3f(1.0f, 1.0f, 1.0f);
-    break;
+  glEnableClientState(GL_VERTEX_ARRAY);
+  points.bind();
+  if (drawn == count) {
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+    drawCalls = 1;
+  } else {
+    // Each run is in random order, so its first points sample it
+    // uniformly; every run draws its share of the budget.
+    const std::vector<size_t> &runs = points.runs();
+    size_t shareBefore = 0;
+    for (size_t r = 0; r < runs.size(); ++r) {
+      const size_t end = r + 1 < runs.size() ? runs[r + 1] : count;
+      const size_t share = end * drawn / count;
+      if (share > shareBefore) {
+        glDrawArrays(GL_POINTS, static_cast<GLint>(runs[r]),
+                     static_cast<GLsizei>(share - shareBefore));
+        ++drawCalls;
+      }
+      shareBefore = share;
+    }
   }
+  points.unbind();
+
+  glPopAttrib();
+  glPopClientAttrib();
+  return drawn;
 }
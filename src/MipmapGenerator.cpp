@@ -0,0 +1,202 @@
+#include "MipmapGenerator.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Output rows per worker; one row of a 4K texture is ~16 KB of work.
+constexpr size_t kRowsPerChunk = 32;
+
+// Linear values are re-encoded through a table indexed by linear * kEncodeSize.
+// 2^14 steps keep every 8-bit sRGB code reachable, including the dark end
+// where the curve is steepest.
+constexpr int kEncodeSize = 1 << 14;
+
+struct SrgbTables {
+  float toLinear[256];
+  uint8_t toSrgb[kEncodeSize + 1];
+};
+
+float srgbToLinear(float c) {
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float l) {
+  return l <= 0.0031308f ? l * 12.92f
+                         : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+}
+
+const SrgbTables &tables() {
+  static const SrgbTables t = [] {
+    SrgbTables built;
+    for (int i = 0; i < 256; ++i) {
+      built.toLinear[i] = srgbToLinear(i / 255.0f);
+    }
+    for (int i = 0; i <= kEncodeSize; ++i) {
+      float encoded = linearToSrgb(static_cast<float>(i) / kEncodeSize);
+      built.toSrgb[i] = static_cast<uint8_t>(
+          std::lround(std::min(std::max(encoded, 0.0f), 1.0f) * 255.0f));
+    }
+    return built;
+  }();
+  return t;
+}
+
+/**
+ * @brief Expands one row to floats: color channels through the sRGB table,
+ * alpha (channel 3 of RGBA) as plain value / 255.
+ */
+void rowToLinear(const unsigned char *src, float *dst, int width,
+                 int channels, const SrgbTables &t) {
+  size_t count = static_cast<size_t>(width) * channels;
+  if (channels == 4) {
+    for (size_t i = 0; i < count; i += 4) {
+      dst[i] = t.toLinear[src[i]];
+      dst[i + 1] = t.toLinear[src[i + 1]];
+      dst[i + 2] = t.toLinear[src[i + 2]];
+      dst[i + 3] = src[i + 3] * (1.0f / 255.0f);
+    }
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] = t.toLinear[src[i]];
+    }
+  }
+}
+
+/**
+ * @brief sum[i] = a[i] + b[i], four floats per step with SSE2.
+ */
+void addRows(const float *a, const float *b, float *sum, size_t count) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(sum + i,
+                  _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+#endif
+  for (; i < count; ++i) {
+    sum[i] = a[i] + b[i];
+  }
+}
+
+uint8_t encodeColor(float linear, const SrgbTables &t) {
+  int index = static_cast<int>(linear * kEncodeSize + 0.5f);
+  return t.toSrgb[std::min(std::max(index, 0), kEncodeSize)];
+}
+
+uint8_t encodeAlpha(float alpha) {
+  int value = static_cast<int>(alpha * 255.0f + 0.5f);
+  return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+/**
+ * @brief Averages horizontal pixel pairs of a vertically summed row and
+ * writes the encoded output row. A one-pixel-wide source pairs its only
+ * column with itself.
+ */
+void reduceRow(const float *sum, int srcWidth, int channels,
+               unsigned char *dst, int dstWidth, const SrgbTables &t) {
+#if defined(__SSE2__)
+  if (channels == 4) {
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 scale =
+        _mm_setr_ps(kEncodeSize, kEncodeSize, kEncodeSize, 255.0f);
+    alignas(16) int32_t index[4];
+    for (int x = 0; x < dstWidth; ++x) {
+      int x0 = std::min(2 * x, srcWidth - 1);
+      int x1 = std::min(2 * x + 1, srcWidth - 1);
+      __m128 box = _mm_mul_ps(
+          _mm_add_ps(_mm_loadu_ps(sum + x0 * 4), _mm_loadu_ps(sum + x1 * 4)),
+          quarter);
+      // Round to the table index (RGB) or final byte (A) in one conversion.
+      _mm_store_si128(reinterpret_cast<__m128i *>(index),
+                      _mm_cvtps_epi32(_mm_mul_ps(box, scale)));
+      unsigned char *out = dst + static_cast<size_t>(x) * 4;
+      out[0] = t.toSrgb[std::min(std::max(index[0], 0), kEncodeSize)];
+      out[1] = t.toSrgb[std::min(std::max(index[1], 0), kEncodeSize)];
+      out[2] = t.toSrgb[std::min(std::max(index[2], 0), kEncodeSize)];
+      out[3] = static_cast<unsigned char>(std::min(std::max(index[3], 0), 255));
+    }
+    return;
+  }
+#endif
+
+  for (int x = 0; x < dstWidth; ++x) {
+    int x0 = std::min(2 * x, srcWidth - 1);
+    int x1 = std::min(2 * x + 1, srcWidth - 1);
+    for (int c = 0; c < channels; ++c) {
+      float box = (sum[x0 * channels + c] + sum[x1 * channels + c]) * 0.25f;
+      dst[static_cast<size_t>(x) * channels + c] =
+          c == 3 ? encodeAlpha(box) : encodeColor(box, t);
+    }
+  }
+}
+
+} // end anonymous namespace
+
+DecodedImage MipmapGenerator::downsample(const DecodedImage &source) {
+  DecodedImage result;
+  result.width = std::max(1, source.width / 2);
+  result.height = std::max(1, source.height / 2);
+  result.channels = source.channels;
+  if (source.width <= 0 || source.height <= 0 || source.channels <= 0) {
+    return result;
+  }
+  result.pixels.resize(static_cast<size_t>(result.width) * result.height *
+                       result.channels);
+
+  const SrgbTables &t = tables();
+  const int channels = source.channels;
+  const size_t srcStride = static_cast<size_t>(source.width) * channels;
+  const size_t dstStride = static_cast<size_t>(result.width) * channels;
+
+  Parallel::forRange(result.height, kRowsPerChunk, [&](size_t begin,
+                                                       size_t end) {
+    // Scratch rows are per chunk, so workers never share them.
+    std::vector<float> top(srcStride + 4), bottom(srcStride + 4),
+        sum(srcStride + 4);
+    for (size_t y = begin; y < end; ++y) {
+      size_t y0 = std::min<size_t>(2 * y, source.height - 1);
+      size_t y1 = std::min<size_t>(2 * y + 1, source.height - 1);
+      rowToLinear(source.pixels.data() + y0 * srcStride, top.data(),
+                  source.width, channels, t);
+      rowToLinear(source.pixels.data() + y1 * srcStride, bottom.data(),
+                  source.width, channels, t);
+      addRows(top.data(), bottom.data(), sum.data(), srcStride);
+      reduceRow(sum.data(), source.width, channels,
+                result.pixels.data() + y * dstStride, result.width, t);
+    }
+  });
+  return result;
+}
+
+std::vector<DecodedImage>
+MipmapGenerator::buildChain(const DecodedImage &base) {
+  std::vector<DecodedImage> levels;
+  levels.reserve(32);
+  const DecodedImage *previous = &base;
+  while (previous->width > 1 || previous->height > 1) {
+    levels.push_back(downsample(*previous));
+    previous = &levels.back();
+  }
+  return levels;
+}
+
+DecodedImage MipmapGenerator::fitToSize(DecodedImage image, int maxSize) {
+  if (maxSize <= 0) {
+    return image;
+  }
+  while (image.width > maxSize || image.height > maxSize) {
+    image = downsample(image);
+  }
+  return image;
+}
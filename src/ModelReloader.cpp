@@ -0,0 +1,90 @@
+#include "ModelReloader.hpp"
+#include "Scene.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+ModelReloader::ModelReloader(const ViewerOptions &options,
+                             std::function<void()> onFinished)
+    : options_(options), onFinished_(std::move(onFinished)),
+      worker_(&ModelReloader::workerLoop, this) {}
+
+ModelReloader::~ModelReloader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  worker_.join();
+}
+
+void ModelReloader::request(std::shared_ptr<const RenderModel> model) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::string &path = model->model.objectName;
+    if (path == running_) {
+      rerun_ = true;
+      return;
+    }
+    bool queued = std::any_of(
+        queue_.begin(), queue_.end(),
+        [&](const std::shared_ptr<const RenderModel> &waiting) {
+          return waiting->model.objectName == path;
+        });
+    if (queued) {
+      return;
+    }
+    queue_.push_back(std::move(model));
+  }
+  wake_.notify_one();
+}
+
+std::vector<ModelReloader::Result> ModelReloader::takeFinished() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Result> finished;
+  finished.swap(finished_);
+  return finished;
+}
+
+void ModelReloader::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    std::shared_ptr<const RenderModel> current = std::move(queue_.front());
+    queue_.erase(queue_.begin());
+    running_ = current->model.objectName;
+
+    do {
+      rerun_ = false;
+      lock.unlock();
+      std::cout << "Reloading changed file " << running_ << std::endl;
+      bool appended = false;
+      std::shared_ptr<const RenderModel> next;
+      try {
+        next = SceneLoader::reloadModel(current, options_, appended);
+      } catch (const std::exception &error) {
+        // Usually a line caught half-written; the rest of the save triggers
+        // another reload.
+        std::cerr << "Error: cannot parse " << running_ << ": "
+                  << error.what() << "\n";
+      }
+      if (!next) {
+        std::cerr << "Keeping the model loaded before.\n";
+      }
+
+      lock.lock();
+      if (next && next != current) {
+        finished_.push_back({current, next, appended});
+        current = std::move(next);
+        lock.unlock();
+        onFinished_();
+        lock.lock();
+      }
+    } while (rerun_ && !stopping_);
+    running_.clear();
+  }
+}
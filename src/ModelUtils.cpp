@@ -1,8 +1,168 @@
 #include "ModelUtils.hpp"
+#include "Parallel.hpp"
 
-#include <cfloat> // for FLT_MAX
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include <random>
 
+namespace {
+
+// Faces per worker chunk when flattening draw batches.
+constexpr size_t kFacesPerChunk = 16384;
+
+unsigned char toByte(float value) {
+  return static_cast<unsigned char>(
+      std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+/**
+ * @brief true if the corner references an existing vertex; others are
+ * skipped, as the immediate-mode path always did.
+ */
+bool isValidCorner(const OBJModel &model, const FaceVertex &fv) {
+  return fv.vertexIndex >= 0 &&
+         fv.vertexIndex < static_cast<int>(model.vertices.size());
+}
+
+/**
+ * @brief First corner in DrawBatches of every face from `firstFace` on
+ * (indexed from 0), plus the total at the end: polygons with n valid corners
+ * fan into n - 2 triangles.
+ * @param base Corner of `firstFace`.
+ */
+std::vector<size_t> cornerOffsets(const OBJModel &model, size_t firstFace = 0,
+                                  size_t base = 0) {
+  const size_t faceCount = model.faces.size() - firstFace;
+  std::vector<size_t> firstCorner(faceCount + 1, base);
+  for (size_t f = 0; f < faceCount; ++f) {
+    size_t valid = 0;
+    for (const FaceVertex &fv : model.faces[firstFace + f].vertices) {
+      valid += isValidCorner(model, fv) ? 1 : 0;
+    }
+    firstCorner[f + 1] = firstCorner[f] + (valid >= 3 ? (valid - 2) * 3 : 0);
+  }
+  return firstCorner;
+}
+
+/**
+ * @brief The corners of a face that reference existing vertices.
+ */
+void validCorners(const OBJModel &model, const Face &face,
+                  std::vector<const FaceVertex *> &polygon) {
+  polygon.clear();
+  for (const FaceVertex &fv : face.vertices) {
+    if (isValidCorner(model, fv)) {
+      polygon.push_back(&fv);
+    }
+  }
+}
+
+/**
+ * @brief Writes the position, normal and texture coordinate of one corner.
+ */
+void writeCornerVertex(const OBJModel &model, const FaceVertex &fv,
+                       size_t out, DrawBatches &batches) {
+  const Vertex &v = model.vertices[fv.vertexIndex];
+  batches.positions[out * 3 + 0] = v.x;
+  batches.positions[out * 3 + 1] = v.y;
+  batches.positions[out * 3 + 2] = v.z;
+
+  Normal n = {0.0f, 0.0f, 1.0f};
+  if (fv.normalIndex >= 0 &&
+      fv.normalIndex < static_cast<int>(model.normals.size())) {
+    n = model.normals[fv.normalIndex];
+  }
+  batches.normals[out * 3 + 0] = n.x;
+  batches.normals[out * 3 + 1] = n.y;
+  batches.normals[out * 3 + 2] = n.z;
+
+  if (fv.texCoordIndex >= 0 &&
+      fv.texCoordIndex < static_cast<int>(model.texCoords.size())) {
+    const TexCoord &tc = model.texCoords[fv.texCoordIndex];
+    batches.texCoords[out * 2 + 0] = tc.u;
+    batches.texCoords[out * 2 + 1] = 1.0f - tc.v; // Flip V
+  } else {
+    // Procedural planar mapping on the XY plane
+    batches.texCoords[out * 2 + 0] = v.x;
+    batches.texCoords[out * 2 + 1] = 1.0f - v.y;
+  }
+}
+
+/**
+ * @brief Writes the corners, colors and edge flags of the faces from
+ * `firstFace` on.
+ * @param firstCorner From cornerOffsets(model, firstFace).
+ * @param faceGrayColors Per-face colors, also indexed from `firstFace`.
+ */
+void writeFaces(const OBJModel &model, size_t firstFace,
+                const std::vector<size_t> &firstCorner,
+                const std::vector<std::array<float, 3>> &faceGrayColors,
+                const std::vector<std::array<float, 3>> &faceRandomColors,
+                DrawBatches &batches) {
+  const size_t faceCount = model.faces.size() - firstFace;
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    std::vector<const FaceVertex *> polygon;
+    for (size_t f = begin; f < end; ++f) {
+      validCorners(model, model.faces[firstFace + f], polygon);
+      const unsigned char gray[4] = {toByte(faceGrayColors[f][0]),
+                                     toByte(faceGrayColors[f][1]),
+                                     toByte(faceGrayColors[f][2]), 255};
+      const unsigned char random[4] = {toByte(faceRandomColors[f][0]),
+                                       toByte(faceRandomColors[f][1]),
+                                       toByte(faceRandomColors[f][2]), 255};
+
+      size_t out = firstCorner[f];
+      for (size_t t = 1; t + 1 < polygon.size(); ++t) {
+        const size_t fan[3] = {0, t, t + 1};
+        for (size_t k = 0; k < 3; ++k, ++out) {
+          writeCornerVertex(model, *polygon[fan[k]], out, batches);
+          std::copy(gray, gray + 4, &batches.grayColors[out * 4]);
+          std::copy(random, random + 4, &batches.randomColors[out * 4]);
+
+          // The flag marks the edge leaving this corner. Of a fan triangle
+          // (0, t, t + 1) only t -> t + 1 is always a polygon edge.
+          bool edge = (k == 0 && t == 1) || k == 1 ||
+                      (k == 2 && t + 2 == polygon.size());
+          batches.edgeFlags[out] = edge ? 1 : 0;
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @brief Per-submesh bounds over the corners actually drawn, for the
+ * submeshes from `firstSubmesh` on. Corners before `firstCorner` are
+ * already in the bounds and not read again.
+ */
+void updateSubmeshBounds(DrawBatches &batches, size_t firstSubmesh = 0,
+                         size_t firstCorner = 0) {
+  const size_t count = batches.submeshes.size() - firstSubmesh;
+  Parallel::forRange(count, 1, [&](size_t begin, size_t end) {
+    for (size_t s = firstSubmesh + begin; s < firstSubmesh + end; ++s) {
+      SubmeshRange &out = batches.submeshes[s];
+      const size_t from = std::max(out.firstCorner, firstCorner);
+      const size_t to = out.firstCorner + out.cornerCount;
+      AABB box = out.bounds;
+      if (from == out.firstCorner) {
+        box.min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+        box.max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+      }
+      const float *p = batches.positions.data() + from * 3;
+      for (size_t i = from; i < to; ++i, p += 3) {
+        box.min = Vector3(std::min(box.min.x, p[0]), std::min(box.min.y, p[1]),
+                          std::min(box.min.z, p[2]));
+        box.max = Vector3(std::max(box.max.x, p[0]), std::max(box.max.y, p[1]),
+                          std::max(box.max.z, p[2]));
+      }
+      out.bounds = box;
+    }
+  });
+}
+
+} // end anonymous namespace
+
 void ModelUtilities::computeBoundingBox(const OBJModel &model, float &minX,
                                         float &maxX, float &minY, float &maxY,
                                         float &minZ, float &maxZ) {
@@ -13,17 +173,45 @@ void ModelUtilities::computeBoundingBox(const OBJModel &model, float &minX,
     return;
   }
 
-  minX = minY = minZ = FLT_MAX;
-  maxX = maxY = maxZ = -FLT_MAX;
+  AABB box = computeAABB(model);
+  minX = box.min.x;
+  maxX = box.max.x;
+  minY = box.min.y;
+  maxY = box.max.y;
+  minZ = box.min.z;
+  maxZ = box.max.z;
+}
+
+AABB ModelUtilities::computeAABB(const OBJModel &model) {
+  return BoundingVolumes::computeAABB(model.vertices.data(),
+                                      model.vertices.size());
+}
 
-  for (const auto &v : model.vertices) {
-    minX = std::min(minX, v.x);
-    maxX = std::max(maxX, v.x);
-    minY = std::min(minY, v.y);
-    maxY = std::max(maxY, v.y);
-    minZ = std::min(minZ, v.z);
-    maxZ = std::max(maxZ, v.z);
+BoundingSphere ModelUtilities::computeBoundingSphere(const OBJModel &model) {
+  return BoundingVolumes::computeSphere(model.vertices.data(),
+                                        model.vertices.size());
+}
+
+OrientedBox ModelUtilities::computeOrientedBox(const OBJModel &model) {
+  return BoundingVolumes::computeOrientedBox(model.vertices.data(),
+                                             model.vertices.size());
+}
+
+float ModelUtilities::computeNormalizationScale(const AABB &box,
+                                                float desiredSize) {
+  if (box.isEmpty()) {
+    return 1.0f;
   }
+  Vector3 size = box.size();
+  float extent = std::max({size.x, size.y, size.z});
+  return (extent > 1e-5f) ? (desiredSize / extent) : 1.0f;
+}
+
+float ModelUtilities::computeFramingDistance(const BoundingSphere &sphere,
+                                             float fovyDegrees) {
+  float halfFov = 0.5f * fovyDegrees * 3.1415926535f / 180.0f;
+  float s = std::sin(halfFov);
+  return (s > 1e-5f) ? sphere.radius / s : sphere.radius;
 }
 
 void ModelUtilities::computeModelCenter(const OBJModel &model, float &cx,
@@ -38,11 +226,10 @@ void ModelUtilities::computeModelCenter(const OBJModel &model, float &cx,
 
 void ModelUtilities::buildFaceBasedColors(
     const OBJModel &model, std::vector<std::array<float, 3>> &faceGrayColors,
-    std::vector<std::array<float, 3>> &faceRandomColors,
-    std::vector<std::array<float, 3>> &faceMaterialColors) {
-  faceGrayColors.resize(model.faces.size());
-  faceRandomColors.resize(model.faces.size());
-  faceMaterialColors.resize(model.faces.size());
+    std::vector<std::array<float, 3>> &faceRandomColors, size_t firstFace) {
+  firstFace = std::min(firstFace, model.faces.size());
+  faceGrayColors.resize(model.faces.size() - firstFace);
+  faceRandomColors.resize(model.faces.size() - firstFace);
 
   std::mt19937 rng(12345);
   std::uniform_real_distribution<float> dist(0.2f, 0.7f);
@@ -50,15 +237,215 @@ void ModelUtilities::buildFaceBasedColors(
   for (size_t i = 0; i < model.faces.size(); ++i) {
     // Grayscale color
     float grey = dist(rng);
-    faceGrayColors[i] = {grey, grey, grey};
 
     // Random color
     float r = dist(rng);
     float g = dist(rng);
     float b = dist(rng);
-    faceRandomColors[i] = {r, g, b};
+    if (i >= firstFace) {
+      faceGrayColors[i - firstFace] = {grey, grey, grey};
+      faceRandomColors[i - firstFace] = {r, g, b};
+    }
+  }
+}
+
+void ModelUtilities::updateSubmeshRanges(OBJModel &model) {
+  if (model.submeshes.empty() && !model.faces.empty()) {
+    Submesh submesh;
+    submesh.name = "default";
+    model.submeshes.push_back(submesh);
+    for (Face &face : model.faces) {
+      face.submesh = 0;
+    }
+  }
+  for (Submesh &submesh : model.submeshes) {
+    submesh.firstFace = model.faces.size();
+    submesh.faceCount = 0;
+  }
+  for (size_t f = 0; f < model.faces.size(); ++f) {
+    Submesh &submesh = model.submeshes[model.faces[f].submesh];
+    submesh.firstFace = std::min(submesh.firstFace, f);
+    ++submesh.faceCount;
+  }
+}
+
+DrawBatches ModelUtilities::buildDrawBatches(
+    const OBJModel &model,
+    const std::vector<std::array<float, 3>> &faceGrayColors,
+    const std::vector<std::array<float, 3>> &faceRandomColors) {
+  DrawBatches batches;
+  const size_t faceCount = model.faces.size();
+  const std::vector<size_t> firstCorner = cornerOffsets(model);
+  const size_t corners = firstCorner[faceCount];
+  batches.positions.resize(corners * 3);
+  batches.normals.resize(corners * 3);
+  batches.texCoords.resize(corners * 2);
+  batches.grayColors.resize(corners * 4);
+  batches.randomColors.resize(corners * 4);
+  batches.edgeFlags.resize(corners);
+  writeFaces(model, 0, firstCorner, faceGrayColors, faceRandomColors, batches);
+
+  // Faces are grouped by submesh and material, so each run is one range.
+  batches.submeshes.resize(model.submeshes.size());
+  for (size_t s = 0; s < model.submeshes.size(); ++s) {
+    const Submesh &submesh = model.submeshes[s];
+    SubmeshRange &out = batches.submeshes[s];
+    const size_t beginFace = std::min(submesh.firstFace, faceCount);
+    const size_t endFace = std::min(faceCount, beginFace + submesh.faceCount);
+    out.firstRange = batches.ranges.size();
+    out.firstCorner = firstCorner[beginFace];
+    for (size_t f = beginFace; f < endFace; ++f) {
+      size_t count = firstCorner[f + 1] - firstCorner[f];
+      if (count == 0) {
+        continue;
+      }
+      int material = model.faces[f].material;
+      if (batches.ranges.size() == out.firstRange ||
+          batches.ranges.back().material != material) {
+        batches.ranges.push_back(
+            {material, static_cast<int>(s), firstCorner[f], 0});
+      }
+      batches.ranges.back().count += count;
+    }
+    out.rangeCount = batches.ranges.size() - out.firstRange;
+    out.cornerCount = firstCorner[endFace] - out.firstCorner;
+  }
+
+  updateSubmeshBounds(batches);
+  return batches;
+}
+
+void ModelUtilities::appendDrawBatches(
+    const OBJModel &model, size_t firstFace,
+    const std::vector<std::array<float, 3>> &faceGrayColors,
+    const std::vector<std::array<float, 3>> &faceRandomColors,
+    DrawBatches &batches) {
+  const size_t faceCount = model.faces.size();
+  const size_t oldCorners = batches.cornerCount();
+  const size_t oldRanges = batches.ranges.size();
+  const size_t oldSubmeshes = batches.submeshes.size();
+  const std::vector<size_t> firstCorner =
+      cornerOffsets(model, firstFace, oldCorners);
+  const size_t corners = firstCorner.back();
+  batches.positions.resize(corners * 3);
+  batches.normals.resize(corners * 3);
+  batches.texCoords.resize(corners * 2);
+  batches.grayColors.resize(corners * 4);
+  batches.randomColors.resize(corners * 4);
+  batches.edgeFlags.resize(corners);
+  writeFaces(model, firstFace, firstCorner, faceGrayColors, faceRandomColors,
+             batches);
+
+  // The new faces come after the old ones in submesh and material order, so
+  // they extend the last range or start new ones.
+  for (size_t f = firstFace; f < faceCount; ++f) {
+    const size_t count = firstCorner[f - firstFace + 1] -
+                         firstCorner[f - firstFace];
+    if (count == 0) {
+      continue;
+    }
+    const Face &face = model.faces[f];
+    if (batches.ranges.empty() ||
+        batches.ranges.back().material != face.material ||
+        batches.ranges.back().submesh != face.submesh) {
+      batches.ranges.push_back(
+          {face.material, face.submesh, firstCorner[f - firstFace], 0});
+    }
+    batches.ranges.back().count += count;
+  }
+
+  // Submeshes from the one of the first new face on get their ranges again.
+  size_t firstSubmesh = oldSubmeshes;
+  if (firstFace < faceCount) {
+    firstSubmesh =
+        std::min<size_t>(firstSubmesh, model.faces[firstFace].submesh);
+  }
+  batches.submeshes.resize(model.submeshes.size());
+  size_t range = firstSubmesh < oldSubmeshes
+                     ? batches.submeshes[firstSubmesh].firstRange
+                     : oldRanges;
+  for (size_t s = firstSubmesh; s < batches.submeshes.size(); ++s) {
+    SubmeshRange &out = batches.submeshes[s];
+    out.firstRange = range;
+    out.firstCorner =
+        range < batches.ranges.size() ? batches.ranges[range].first : corners;
+    while (range < batches.ranges.size() &&
+           batches.ranges[range].submesh == static_cast<int>(s)) {
+      ++range;
+    }
+    out.rangeCount = range - out.firstRange;
+    out.cornerCount = 0;
+    if (out.rangeCount > 0) {
+      const MaterialRange &last = batches.ranges[range - 1];
+      out.cornerCount = last.first + last.count - out.firstCorner;
+    }
+  }
+  updateSubmeshBounds(batches, firstSubmesh, oldCorners);
+}
+
+bool ModelUtilities::sameTopology(const OBJModel &a, const OBJModel &b) {
+  if (a.vertices.size() != b.vertices.size() ||
+      a.texCoords.size() != b.texCoords.size() ||
+      a.faces.size() != b.faces.size() ||
+      a.submeshes.size() != b.submeshes.size() ||
+      a.materials.size() != b.materials.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.materials.size(); ++i) {
+    if (a.materials[i].diffuse != b.materials[i].diffuse ||
+        a.materials[i].diffuseMap != b.materials[i].diffuseMap) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a.submeshes.size(); ++i) {
+    if (a.submeshes[i].firstFace != b.submeshes[i].firstFace ||
+        a.submeshes[i].faceCount != b.submeshes[i].faceCount) {
+      return false;
+    }
+  }
+  // Normal indices don't matter: normals are copied per corner.
+  for (size_t f = 0; f < a.faces.size(); ++f) {
+    const Face &fa = a.faces[f];
+    const Face &fb = b.faces[f];
+    if (fa.material != fb.material || fa.submesh != fb.submesh ||
+        fa.vertices.size() != fb.vertices.size()) {
+      return false;
+    }
+    for (size_t k = 0; k < fa.vertices.size(); ++k) {
+      if (fa.vertices[k].vertexIndex != fb.vertices[k].vertexIndex ||
+          fa.vertices[k].texCoordIndex != fb.vertices[k].texCoordIndex) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void ModelUtilities::updateDrawBatchVertices(const OBJModel &model,
+                                             DrawBatches &batches) {
+  const size_t faceCount = model.faces.size();
+  const std::vector<size_t> firstCorner = cornerOffsets(model);
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    std::vector<const FaceVertex *> polygon;
+    for (size_t f = begin; f < end; ++f) {
+      validCorners(model, model.faces[f], polygon);
+      size_t out = firstCorner[f];
+      for (size_t t = 1; t + 1 < polygon.size(); ++t) {
+        const size_t fan[3] = {0, t, t + 1};
+        for (size_t k = 0; k < 3; ++k, ++out) {
+          writeCornerVertex(model, *polygon[fan[k]], out, batches);
+        }
+      }
+    }
+  });
+  updateSubmeshBounds(batches);
+}
 
-    // Material color (light blue in this example)
-    faceMaterialColors[i] = {0.3f, 0.6f, 1.0f};
+void ModelUtilities::shufflePoints(OBJModel &model, size_t firstVertex) {
+  if (!model.faces.empty() || firstVertex >= model.vertices.size()) {
+    return; // Faces index the vertices
   }
+  std::mt19937_64 rng(12345);
+  std::shuffle(model.vertices.begin() + firstVertex, model.vertices.end(),
+               rng);
 }
@@ -0,0 +1,352 @@
+#include "NormalGenerator.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kFacesPerChunk = 16384;
+constexpr size_t kVerticesPerChunk = 16384;
+
+/**
+ * @brief Area-weighted normal of an arbitrary polygon (fan triangulation).
+ */
+void polygonNormal(const OBJModel &model, const Face &face, float &outX,
+                   float &outY, float &outZ) {
+  outX = outY = outZ = 0.0f;
+  const auto &corners = face.vertices;
+  const int vertexCount = static_cast<int>(model.vertices.size());
+  if (corners.size() < 3 || corners[0].vertexIndex < 0 ||
+      corners[0].vertexIndex >= vertexCount) {
+    return;
+  }
+
+  const Vertex &p0 = model.vertices[corners[0].vertexIndex];
+  for (size_t i = 1; i + 1 < corners.size(); ++i) {
+    int i1 = corners[i].vertexIndex;
+    int i2 = corners[i + 1].vertexIndex;
+    if (i1 < 0 || i1 >= vertexCount || i2 < 0 || i2 >= vertexCount) {
+      continue;
+    }
+    const Vertex &p1 = model.vertices[i1];
+    const Vertex &p2 = model.vertices[i2];
+    float ax = p1.x - p0.x, ay = p1.y - p0.y, az = p1.z - p0.z;
+    float bx = p2.x - p0.x, by = p2.y - p0.y, bz = p2.z - p0.z;
+    outX += ay * bz - az * by;
+    outY += az * bx - ax * bz;
+    outZ += ax * by - ay * bx;
+  }
+}
+
+/**
+ * @brief true if the face is a triangle whose indices are all valid.
+ */
+bool isValidTriangle(const Face &face, int vertexCount) {
+  if (face.vertices.size() != 3) {
+    return false;
+  }
+  for (const auto &fv : face.vertices) {
+    if (fv.vertexIndex < 0 || fv.vertexIndex >= vertexCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
+void NormalGenerator::computeFaceNormals(const OBJModel &model,
+                                         std::vector<float> &nx,
+                                         std::vector<float> &ny,
+                                         std::vector<float> &nz) {
+  const size_t faceCount = model.faces.size();
+  nx.resize(faceCount);
+  ny.resize(faceCount);
+  nz.resize(faceCount);
+  const int vertexCount = static_cast<int>(model.vertices.size());
+
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    size_t f = begin;
+#if defined(__SSE2__)
+    // Four triangles at a time: gather into SoA registers, one cross product.
+    for (; f + 4 <= end; f += 4) {
+      const Face *faces = &model.faces[f];
+      if (!isValidTriangle(faces[0], vertexCount) ||
+          !isValidTriangle(faces[1], vertexCount) ||
+          !isValidTriangle(faces[2], vertexCount) ||
+          !isValidTriangle(faces[3], vertexCount)) {
+        for (size_t k = 0; k < 4; ++k) {
+          polygonNormal(model, faces[k], nx[f + k], ny[f + k], nz[f + k]);
+        }
+        continue;
+      }
+
+      alignas(16) float px[3][4], py[3][4], pz[3][4];
+      for (int lane = 0; lane < 4; ++lane) {
+        for (int c = 0; c < 3; ++c) {
+          const Vertex &v =
+              model.vertices[faces[lane].vertices[c].vertexIndex];
+          px[c][lane] = v.x;
+          py[c][lane] = v.y;
+          pz[c][lane] = v.z;
+        }
+      }
+
+      __m128 x0 = _mm_load_ps(px[0]), y0 = _mm_load_ps(py[0]),
+             z0 = _mm_load_ps(pz[0]);
+      __m128 ax = _mm_sub_ps(_mm_load_ps(px[1]), x0);
+      __m128 ay = _mm_sub_ps(_mm_load_ps(py[1]), y0);
+      __m128 az = _mm_sub_ps(_mm_load_ps(pz[1]), z0);
+      __m128 bx = _mm_sub_ps(_mm_load_ps(px[2]), x0);
+      __m128 by = _mm_sub_ps(_mm_load_ps(py[2]), y0);
+      __m128 bz = _mm_sub_ps(_mm_load_ps(pz[2]), z0);
+
+      _mm_storeu_ps(&nx[f],
+                    _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by)));
+      _mm_storeu_ps(&ny[f],
+                    _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz)));
+      _mm_storeu_ps(&nz[f],
+                    _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx)));
+    }
+#endif
+    for (; f < end; ++f) {
+      polygonNormal(model, model.faces[f], nx[f], ny[f], nz[f]);
+    }
+  });
+}
+
+size_t NormalGenerator::generate(OBJModel &model, float creaseAngleDegrees) {
+  auto start = std::chrono::steady_clock::now();
+
+  const size_t faceCount = model.faces.size();
+  const size_t vertexCount = model.vertices.size();
+  model.normals.clear();
+  if (faceCount == 0 || vertexCount == 0) {
+    return 0;
+  }
+
+  // 1. Area-weighted face normals (SoA), plus unit versions for the crease
+  //    test. The raw cross product length is twice the face area.
+  std::vector<float> nx, ny, nz;
+  computeFaceNormals(model, nx, ny, nz);
+
+  std::vector<float> ux(faceCount), uy(faceCount), uz(faceCount);
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    size_t f = begin;
+#if defined(__SSE2__)
+    const __m128 epsilon = _mm_set1_ps(1e-20f);
+    for (; f + 4 <= end; f += 4) {
+      __m128 x = _mm_loadu_ps(&nx[f]);
+      __m128 y = _mm_loadu_ps(&ny[f]);
+      __m128 z = _mm_loadu_ps(&nz[f]);
+      __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                _mm_mul_ps(z, z));
+      // Degenerate faces get a zero unit normal and never pass the test.
+      __m128 valid = _mm_cmpgt_ps(lenSq, epsilon);
+      __m128 inv = _mm_and_ps(
+          valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lenSq)));
+      _mm_storeu_ps(&ux[f], _mm_mul_ps(x, inv));
+      _mm_storeu_ps(&uy[f], _mm_mul_ps(y, inv));
+      _mm_storeu_ps(&uz[f], _mm_mul_ps(z, inv));
+    }
+#endif
+    for (; f < end; ++f) {
+      float lenSq = nx[f] * nx[f] + ny[f] * ny[f] + nz[f] * nz[f];
+      float inv = lenSq > 1e-20f ? 1.0f / std::sqrt(lenSq) : 0.0f;
+      ux[f] = nx[f] * inv;
+      uy[f] = ny[f] * inv;
+      uz[f] = nz[f] * inv;
+    }
+  });
+
+  // 2. Vertex -> corner adjacency in CSR form. A corner is (face, slot),
+  //    encoded as firstCorner[face] + slot.
+  std::vector<uint32_t> firstCorner(faceCount + 1, 0);
+  for (size_t f = 0; f < faceCount; ++f) {
+    firstCorner[f + 1] =
+        firstCorner[f] + static_cast<uint32_t>(model.faces[f].vertices.size());
+  }
+  const size_t cornerCount = firstCorner[faceCount];
+
+  std::vector<std::atomic<uint32_t>> degree(vertexCount);
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      for (const auto &fv : model.faces[f].vertices) {
+        if (fv.vertexIndex >= 0 &&
+            static_cast<size_t>(fv.vertexIndex) < vertexCount) {
+          degree[fv.vertexIndex].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }
+  });
+
+  std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    adjacencyStart[v + 1] =
+        adjacencyStart[v] + degree[v].load(std::memory_order_relaxed);
+    degree[v].store(adjacencyStart[v], std::memory_order_relaxed);
+  }
+
+  std::vector<uint32_t> adjacency(adjacencyStart[vertexCount]);
+  std::vector<uint32_t> cornerFace(cornerCount);
+  Parallel::forRange(faceCount, kFacesPerChunk, [&](size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      const auto &corners = model.faces[f].vertices;
+      for (size_t slot = 0; slot < corners.size(); ++slot) {
+        uint32_t corner = firstCorner[f] + static_cast<uint32_t>(slot);
+        cornerFace[corner] = static_cast<uint32_t>(f);
+        int vi = corners[slot].vertexIndex;
+        if (vi >= 0 && static_cast<size_t>(vi) < vertexCount) {
+          adjacency[degree[vi].fetch_add(1, std::memory_order_relaxed)] =
+              corner;
+        }
+      }
+    }
+  });
+
+  // 3. Per vertex: faces around it that share an edge and meet within the
+  //    crease angle join one smoothing group (union-find over the fan, edges
+  //    matched by sorting on their far vertex), and every corner gets the
+  //    normal of its group. Sorting the adjacency makes summation order, and
+  //    therefore output, deterministic.
+  const float cosCrease =
+      std::cos(std::min(creaseAngleDegrees, 180.0f) * 3.1415926535f / 180.0f);
+  const bool smoothAll = creaseAngleDegrees >= 180.0f;
+  std::vector<float> cornerNormal(cornerCount * 3, 0.0f);
+  std::vector<uint32_t> cornerGroup(cornerCount, 0);
+  std::vector<uint32_t> groupCount(vertexCount, 0);
+
+  Parallel::forRange(vertexCount, kVerticesPerChunk, [&](size_t begin,
+                                                         size_t end) {
+    // Per fan slot: parent in the union-find, then group; reused per vertex.
+    std::vector<uint32_t> parent, group;
+    std::vector<std::pair<int, uint32_t>> edges; // (far vertex, fan slot)
+    std::vector<float> sums;
+    auto find = [&](uint32_t i) {
+      while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+      }
+      return i;
+    };
+
+    for (size_t v = begin; v < end; ++v) {
+      uint32_t *first = adjacency.data() + adjacencyStart[v];
+      uint32_t *last = adjacency.data() + adjacencyStart[v + 1];
+      std::sort(first, last);
+      const uint32_t fan = static_cast<uint32_t>(last - first);
+
+      parent.resize(fan);
+      edges.clear();
+      for (uint32_t i = 0; i < fan; ++i) {
+        parent[i] = smoothAll ? 0 : i;
+        const uint32_t f = cornerFace[first[i]];
+        const auto &corners = model.faces[f].vertices;
+        const size_t n = corners.size();
+        const size_t slot = first[i] - firstCorner[f];
+        for (size_t far : {slot + n - 1, slot + 1}) {
+          const int w = corners[far % n].vertexIndex;
+          if (w >= 0 && static_cast<size_t>(w) != v) {
+            edges.emplace_back(w, i);
+          }
+        }
+      }
+      if (!smoothAll) {
+        std::sort(edges.begin(), edges.end());
+        for (size_t e = 1; e < edges.size(); ++e) {
+          if (edges[e].first != edges[e - 1].first) {
+            continue;
+          }
+          const uint32_t f = cornerFace[first[edges[e - 1].second]];
+          const uint32_t g = cornerFace[first[edges[e].second]];
+          float cosAngle = ux[f] * ux[g] + uy[f] * uy[g] + uz[f] * uz[g];
+          if (cosAngle >= cosCrease) {
+            const uint32_t a = find(edges[e - 1].second);
+            const uint32_t b = find(edges[e].second);
+            // The smaller slot stays the root, so groups number in order.
+            parent[std::max(a, b)] = std::min(a, b);
+          }
+        }
+      }
+
+      group.resize(fan);
+      uint32_t groups = 0;
+      for (uint32_t i = 0; i < fan; ++i) {
+        const uint32_t root = find(i);
+        group[i] = root == i ? groups++ : group[root];
+      }
+      sums.assign(groups * 3, 0.0f);
+      for (uint32_t i = 0; i < fan; ++i) {
+        const uint32_t f = cornerFace[first[i]];
+        float *sum = &sums[group[i] * 3];
+        sum[0] += nx[f];
+        sum[1] += ny[f];
+        sum[2] += nz[f];
+      }
+      for (uint32_t k = 0; k < groups; ++k) {
+        float *sum = &sums[k * 3];
+        float len =
+            std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+        float inv = len > 1e-20f ? 1.0f / len : 0.0f;
+        sum[0] *= inv;
+        sum[1] *= inv;
+        sum[2] *= inv;
+      }
+      for (uint32_t i = 0; i < fan; ++i) {
+        std::copy_n(&sums[group[i] * 3], 3, &cornerNormal[first[i] * 3]);
+        cornerGroup[first[i]] = group[i];
+      }
+      groupCount[v] = groups;
+    }
+  });
+
+  // 4. Assign global normal indices (prefix sum) and write them out.
+  std::vector<uint32_t> normalStart(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    normalStart[v + 1] = normalStart[v] + groupCount[v];
+  }
+  model.normals.resize(normalStart[vertexCount]);
+
+  Parallel::forRange(vertexCount, kVerticesPerChunk, [&](size_t begin,
+                                                         size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      const uint32_t *first = adjacency.data() + adjacencyStart[v];
+      const uint32_t *last = adjacency.data() + adjacencyStart[v + 1];
+      for (const uint32_t *corner = first; corner != last; ++corner) {
+        const float *n = &cornerNormal[*corner * 3];
+        const uint32_t index = normalStart[v] + cornerGroup[*corner];
+        model.normals[index] = {n[0], n[1], n[2]};
+        uint32_t f = cornerFace[*corner];
+        model.faces[f].vertices[*corner - firstCorner[f]].normalIndex =
+            static_cast<int>(index);
+      }
+    }
+  });
+
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Generated " << model.normals.size() << " normals for "
+            << faceCount << " faces in " << elapsed << " ms (crease "
+            << creaseAngleDegrees << " deg)\n";
+  return model.normals.size();
+}
+
+bool NormalGenerator::generateIfMissing(OBJModel &model,
+                                        float creaseAngleDegrees) {
+  if (!model.normals.empty() || model.faces.empty()) {
+    return false;
+  }
+  generate(model, creaseAngleDegrees);
+  return true;
+}
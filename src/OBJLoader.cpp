@@ -1,4 +1,119 @@
 #include "OBJLoader.hpp"
+#include "CompressedInput.hpp"
+#include "MemoryTracker.hpp"
+#include "ModelUtils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+namespace {
+
+// Bytes hashed per read when checking the part of a file parsed before.
+constexpr size_t kHashChunk = 1 << 20;
+
+/**
+ * @brief The rest of the stream with surrounding whitespace (and the '\r' of
+ * CRLF files) removed. Names in mtllib/newmtl/map_Kd may contain spaces.
+ */
+std::string remainder(std::istringstream &ss) {
+  std::string rest;
+  std::getline(ss, rest);
+  size_t begin = rest.find_first_not_of(" \t\r");
+  if (begin == std::string::npos) {
+    return std::string();
+  }
+  size_t end = rest.find_last_not_of(" \t\r");
+  return rest.substr(begin, end - begin + 1);
+}
+
+/**
+ * @brief Resolves a path written in an OBJ/MTL file against the directory of
+ * that file. Backslashes from Windows exporters become separators.
+ */
+std::string resolvePath(const std::string &directory, std::string name) {
+  std::replace(name.begin(), name.end(), '\\', '/');
+  std::filesystem::path path(name);
+  if (path.is_absolute() || directory.empty()) {
+    return path.lexically_normal().string();
+  }
+  return (std::filesystem::path(directory) / path).lexically_normal().string();
+}
+
+/**
+ * @brief true if no face from `first` on sorts before the one preceding it
+ * (by submesh, then material), i.e. groupFaces() would leave them in place.
+ */
+bool isGrouped(const OBJModel &model, size_t first) {
+  for (size_t f = std::max<size_t>(first, 1); f < model.faces.size(); ++f) {
+    const Face &a = model.faces[f];
+    const Face &b = model.faces[f - 1];
+    if (a.submesh < b.submesh ||
+        (a.submesh == b.submesh && a.material < b.material)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 64-bit hash of bytes fed in pieces of any size: the same bytes give
+ * the same value however they are split. Eight bytes per step, so hashing a
+ * file again costs much less than parsing it.
+ */
+class StreamHash {
+public:
+  void update(const char *data, size_t size) {
+    total_ += size;
+    if (carried_ > 0) {
+      const size_t take = std::min(size, sizeof(carry_) - carried_);
+      std::memcpy(carry_ + carried_, data, take);
+      carried_ += take;
+      data += take;
+      size -= take;
+      if (carried_ < sizeof(carry_)) {
+        return;
+      }
+      mix(carry_);
+      carried_ = 0;
+    }
+    for (; size >= sizeof(carry_); data += sizeof(carry_)) {
+      mix(data);
+      size -= sizeof(carry_);
+    }
+    std::memcpy(carry_, data, size);
+    carried_ = size;
+  }
+
+  uint64_t value() const {
+    char last[sizeof(carry_)] = {};
+    std::memcpy(last, carry_, carried_);
+    uint64_t word;
+    std::memcpy(&word, last, sizeof(word));
+    uint64_t h = (state_ ^ word ^ total_) * kMultiplier;
+    return h ^ (h >> 29);
+  }
+
+  uint64_t size() const { return total_; }
+
+private:
+  static constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15ull;
+
+  void mix(const char *bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    state_ = (state_ ^ word) * kMultiplier;
+    state_ ^= state_ >> 32;
+  }
+
+  uint64_t state_ = 0;
+  uint64_t total_ = 0;
+  char carry_[8] = {};
+  size_t carried_ = 0;
+};
+
+} // end anonymous namespace
 
 FaceVertex OBJLoader::parseFaceVertex(const std::string &vertexStr) {
   FaceVertex fv = {-1, -1, -1};
@@ -59,16 +174,108 @@ void OBJLoader::parseNormal(std::istringstream &ss, OBJModel &model) {
   model.normals.push_back(normal);
 }
 
-void OBJLoader::parseFace(std::istringstream &ss, OBJModel &model) {
+void OBJLoader::parseFace(std::istringstream &ss, OBJModel &model,
+                          ParseContext &context) {
   Face face;
   std::string vertexStr;
   while (ss >> vertexStr) {
     face.vertices.push_back(parseFaceVertex(vertexStr));
   }
+  face.material = context.currentMaterial;
+
+  if (context.currentSubmesh < 0) {
+    std::string name = context.objectName;
+    if (!context.groupName.empty()) {
+      name += (name.empty() ? "" : "/") + context.groupName;
+    }
+    if (name.empty()) {
+      name = "default";
+    }
+    auto it = context.submeshIndex.find(name);
+    if (it == context.submeshIndex.end()) {
+      Submesh submesh;
+      submesh.name = name;
+      model.submeshes.push_back(submesh);
+      it = context.submeshIndex
+               .emplace(name, static_cast<int>(model.submeshes.size()) - 1)
+               .first;
+    }
+    context.currentSubmesh = it->second;
+  }
+  face.submesh = context.currentSubmesh;
+  face.fileIndex = model.faces.size();
   model.faces.push_back(face);
 }
 
-bool OBJLoader::parseLine(const std::string &line, OBJModel &model) {
+void OBJLoader::parseObjectOrGroup(const std::string &prefix,
+                                   std::istringstream &ss,
+                                   ParseContext &context) {
+  if (prefix == "o") {
+    context.objectName = remainder(ss);
+    context.groupName.clear();
+  } else {
+    context.groupName = remainder(ss);
+  }
+  context.currentSubmesh = -1;
+}
+
+void OBJLoader::parseMaterialLibrary(std::istringstream &ss, OBJModel &model,
+                                     ParseContext &context) {
+  // The spec allows several space-separated names, but exporters also write
+  // single names containing spaces; try the whole remainder first.
+  std::string names = remainder(ss);
+  auto exists = [&](const std::string &name) {
+    std::error_code error;
+    return std::filesystem::is_regular_file(
+        resolvePath(context.directory, name), error);
+  };
+  std::vector<std::string> libraries;
+  if (!exists(names)) {
+    std::istringstream split(names);
+    std::string name;
+    while (split >> name) {
+      if (exists(name)) {
+        libraries.push_back(name);
+      }
+    }
+  }
+  if (libraries.empty()) {
+    libraries.push_back(names); // Reports the missing file below
+  }
+
+  for (const std::string &name : libraries) {
+    std::string path = resolvePath(context.directory, name);
+    if (!loadMTL(path, model.materials)) {
+      std::cerr << "Warning: Cannot open material library " << path
+                << "; using default materials\n";
+    }
+  }
+  for (size_t i = 0; i < model.materials.size(); ++i) {
+    context.materialIndex[model.materials[i].name] = static_cast<int>(i);
+  }
+}
+
+void OBJLoader::parseUseMaterial(std::istringstream &ss, OBJModel &model,
+                                 ParseContext &context) {
+  context.currentMaterial = findOrAddMaterial(remainder(ss), model, context);
+}
+
+int OBJLoader::findOrAddMaterial(const std::string &name, OBJModel &model,
+                                 ParseContext &context) {
+  auto it = context.materialIndex.find(name);
+  if (it != context.materialIndex.end()) {
+    return it->second;
+  }
+  Material material;
+  material.name = name;
+  model.materials.push_back(material);
+  int index = static_cast<int>(model.materials.size()) - 1;
+  context.materialIndex.emplace(name, index);
+  return index;
+}
+
+bool OBJLoader::parseLine(const std::string &line, OBJModel &model,
+                          ParseContext &context) {
   std::istringstream ss(line);
   std::string prefix;
   ss >> prefix;
@@ -84,24 +291,213 @@ bool OBJLoader::parseLine(const std::string &line, OBJModel &model) {
   } else if (prefix == "vn") {
     parseNormal(ss, model);
   } else if (prefix == "f") {
-    parseFace(ss, model);
+    parseFace(ss, model, context);
+  } else if (prefix == "usemtl") {
+    parseUseMaterial(ss, model, context);
+  } else if (prefix == "mtllib") {
+    parseMaterialLibrary(ss, model, context);
+  } else if (prefix == "o" || prefix == "g") {
+    parseObjectOrGroup(prefix, ss, context);
   }
 
   return true;
 }
 
-bool OBJLoader::loadOBJ(const std::string &filePath, OBJModel &model) {
-  std::ifstream inFile(filePath);
+bool OBJLoader::loadOBJ(const std::string &filePath, OBJModel &model,
+                        ResumePoint *resume) {
+  ParseContext context;
+  context.directory = std::filesystem::path(filePath).parent_path().string();
+
+  std::string line;
+  StreamHash hash;
+  bool partialLine = false;
+  const bool compressed = CompressedInput::isCompressedPath(filePath);
+  if (compressed) {
+    CompressedInput input;
+    if (!input.open(filePath)) {
+      return false;
+    }
+    while (input.getline(line)) {
+      parseLine(line, model, context);
+    }
+    if (input.failed()) {
+      return false;
+    }
+    input.printReport(std::cout);
+  } else {
+    std::ifstream inFile(filePath);
+    if (!inFile) {
+      std::cerr << "Cannot open the .obj file: " << filePath << std::endl;
+      return false;
+    }
+    while (std::getline(inFile, line)) {
+      parseLine(line, model, context);
+      // Only a last line without '\n' stops at the end of the file.
+      partialLine = inFile.eof();
+      hash.update(line.data(), line.size());
+      if (!partialLine) {
+        hash.update("\n", 1);
+      }
+    }
+  }
+  groupFaces(model);
+  ModelUtilities::updateSubmeshRanges(model);
+  if (resume) {
+    *resume = ResumePoint();
+    resume->valid = !compressed;
+    resume->size = hash.size();
+    resume->hash = hash.value();
+    resume->partialLine = partialLine;
+    resume->context = std::move(context);
+  }
+
+  // Record the parse footprint, including vector growth slack, as the
+  // loader's peak; the model is charged to MESH once it is handed over.
+  MemoryTracker::Allocation staging(
+      MemoryTag::LOADER, MemoryTracker::bytesOf(model) + line.capacity());
+
+  return true;
+}
+
+OBJLoader::AppendResult OBJLoader::appendOBJ(const std::string &filePath,
+                                             OBJModel &model,
+                                             ResumePoint &resume) {
+  if (!resume.valid) {
+    return AppendResult::REWRITTEN;
+  }
+  // Read, not mapped: an editor may truncate the file meanwhile.
+  std::ifstream inFile(filePath, std::ios::binary);
   if (!inFile) {
     std::cerr << "Cannot open the .obj file: " << filePath << std::endl;
+    return AppendResult::FAILED;
+  }
+  StreamHash hash;
+  std::vector<char> chunk(kHashChunk);
+  for (uint64_t remaining = resume.size; remaining > 0;) {
+    const size_t count =
+        static_cast<size_t>(std::min<uint64_t>(remaining, chunk.size()));
+    if (!inFile.read(chunk.data(), static_cast<std::streamsize>(count))) {
+      return AppendResult::REWRITTEN; // Shorter than before
+    }
+    hash.update(chunk.data(), count);
+    remaining -= count;
+  }
+  if (hash.value() != resume.hash) {
+    return AppendResult::REWRITTEN;
+  }
+  const std::string tail((std::istreambuf_iterator<char>(inFile)),
+                         std::istreambuf_iterator<char>());
+  if (tail.empty()) {
+    return AppendResult::UNCHANGED;
+  }
+  // A last line parsed without its '\n' must not have grown since.
+  size_t position = 0;
+  if (resume.partialLine) {
+    if (tail[0] != '\n') {
+      return AppendResult::REWRITTEN;
+    }
+    position = 1;
+  }
+
+  const size_t firstFace = model.faces.size();
+  std::string line;
+  bool partialLine = false;
+  while (position < tail.size()) {
+    const size_t newline = tail.find('\n', position);
+    const size_t end = newline != std::string::npos ? newline : tail.size();
+    line.assign(tail, position, end - position);
+    parseLine(line, model, resume.context);
+    position = end + 1;
+    partialLine = newline == std::string::npos;
+  }
+  hash.update(tail.data(), tail.size());
+  resume.size = hash.size();
+  resume.hash = hash.value();
+  resume.partialLine = partialLine;
+
+  // New faces that sort after every existing one keep the order; otherwise
+  // they are moved into their submesh and material runs.
+  if (isGrouped(model, firstFace)) {
+    ModelUtilities::updateSubmeshRanges(model);
+    return AppendResult::APPENDED;
+  }
+  groupFaces(model);
+  ModelUtilities::updateSubmeshRanges(model);
+  return AppendResult::REGROUPED;
+}
+
+void OBJLoader::groupFaces(OBJModel &model) {
+  if (isGrouped(model, 0)) {
+    return;
+  }
+
+  // Two stable counting passes (LSD radix): material, then submesh.
+  // Faces without a material (-1) sort first within their submesh.
+  auto countingSort = [&model](size_t keyCount, auto key) {
+    std::vector<size_t> start(keyCount + 1, 0);
+    for (const Face &face : model.faces) {
+      ++start[key(face) + 1];
+    }
+    for (size_t k = 1; k < start.size(); ++k) {
+      start[k] += start[k - 1];
+    }
+    std::vector<Face> sorted(model.faces.size());
+    for (Face &face : model.faces) {
+      sorted[start[key(face)]++] = std::move(face);
+    }
+    model.faces = std::move(sorted);
+  };
+  countingSort(model.materials.size() + 1, [](const Face &face) {
+    return static_cast<size_t>(face.material + 1);
+  });
+  countingSort(model.submeshes.size(), [](const Face &face) {
+    return static_cast<size_t>(face.submesh);
+  });
+}
+
+bool OBJLoader::loadMTL(const std::string &filePath,
+                        std::vector<Material> &materials) {
+  std::ifstream inFile(filePath);
+  if (!inFile) {
     return false;
   }
+  const std::string directory =
+      std::filesystem::path(filePath).parent_path().string();
 
+  Material *current = nullptr;
   std::string line;
   while (std::getline(inFile, line)) {
-    parseLine(line, model);
-  }
+    std::istringstream ss(line);
+    std::string prefix;
+    ss >> prefix;
 
-  inFile.close();
+    if (prefix == "newmtl") {
+      std::string name = remainder(ss);
+      auto it = std::find_if(materials.begin(), materials.end(),
+                             [&](const Material &m) { return m.name == name; });
+      if (it == materials.end()) {
+        materials.push_back(Material());
+        materials.back().name = name;
+        it = materials.end() - 1;
+      }
+      current = &*it;
+    } else if (!current) {
+      continue;
+    } else if (prefix == "Kd") {
+      std::array<float, 3> kd;
+      if (ss >> kd[0] >> kd[1] >> kd[2]) {
+        current->diffuse = kd;
+      }
+    } else if (prefix == "map_Kd") {
+      // Options such as "-s 1 1 1" come first; the file name is last then.
+      std::string name = remainder(ss);
+      if (!name.empty() && name[0] == '-') {
+        name = name.substr(name.find_last_of(" \t") + 1);
+      }
+      if (!name.empty()) {
+        current->diffuseMap = resolvePath(directory, name);
+      }
+    }
+  }
   return true;
 }
@@ -0,0 +1,455 @@
+#include "OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Triangles smaller than this fraction of the squared model diagonal hide
+// too little to be worth rasterizing.
+constexpr float kMinOccluderArea = 1e-4f;
+
+// Below this clip w a point is treated as reaching the camera plane.
+constexpr float kMinClipW = 1e-5f;
+
+// Occluder vertices snap to this many steps per pixel.
+constexpr int64_t kSubpixelSteps = 16;
+
+// Vertices farther off screen than this many pixels skip the occluder, which
+// keeps the fixed-point edge functions well inside 64 bits.
+constexpr float kGuardBand = 1 << 20;
+
+struct ClipPoint {
+  float x, y, z, w;
+};
+
+ClipPoint toClip(const Matrix4 &m, float x, float y, float z) {
+  return {m.m[0] * x + m.m[4] * y + m.m[8] * z + m.m[12],
+          m.m[1] * x + m.m[5] * y + m.m[9] * z + m.m[13],
+          m.m[2] * x + m.m[6] * y + m.m[10] * z + m.m[14],
+          m.m[3] * x + m.m[7] * y + m.m[11] * z + m.m[15]};
+}
+
+/**
+ * @brief Integer division rounding toward minus infinity.
+ */
+int64_t floorDiv(int64_t n, int64_t d) {
+  const int64_t q = n / d;
+  return q * d != n && (n < 0) != (d < 0) ? q - 1 : q;
+}
+
+/**
+ * @brief Integer division rounding toward plus infinity.
+ */
+int64_t ceilDiv(int64_t n, int64_t d) { return -floorDiv(-n, d); }
+
+/**
+ * @brief true if the point lies in front of the near plane.
+ */
+bool inFrontOfNear(const ClipPoint &p) {
+  return p.w > kMinClipW && p.z >= -p.w;
+}
+
+} // end anonymous namespace
+
+OccluderSet OcclusionCuller::selectOccluders(const DrawBatches &batches) {
+  OccluderSet set;
+  const size_t triangles = batches.cornerCount() / 3;
+  if (triangles == 0) {
+    return set;
+  }
+  const float *p = batches.positions.data();
+
+  Vector3 lo(p[0], p[1], p[2]), hi = lo;
+  for (size_t i = 0; i < triangles * 3; ++i) {
+    lo = Vector3(std::min(lo.x, p[i * 3]), std::min(lo.y, p[i * 3 + 1]),
+                 std::min(lo.z, p[i * 3 + 2]));
+    hi = Vector3(std::max(hi.x, p[i * 3]), std::max(hi.y, p[i * 3 + 1]),
+                 std::max(hi.z, p[i * 3 + 2]));
+  }
+  const Vector3 diagonal = hi - lo;
+  const float minArea = kMinOccluderArea * diagonal.dot(diagonal);
+
+  std::vector<std::pair<float, size_t>> candidates;
+  for (size_t t = 0; t < triangles; ++t) {
+    const float *v = p + t * 9;
+    Vector3 e1(v[3] - v[0], v[4] - v[1], v[5] - v[2]);
+    Vector3 e2(v[6] - v[0], v[7] - v[1], v[8] - v[2]);
+    Vector3 n = e1.cross(e2);
+    float area = 0.5f * std::sqrt(n.dot(n));
+    if (area >= minArea) {
+      candidates.emplace_back(area, t);
+    }
+  }
+  if (candidates.size() > kMaxOccludersPerModel) {
+    std::nth_element(candidates.begin(),
+                     candidates.begin() + kMaxOccludersPerModel,
+                     candidates.end(), [](const auto &a, const auto &b) {
+                       return a.first > b.first;
+                     });
+    candidates.resize(kMaxOccludersPerModel);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto &a, const auto &b) { return a.second < b.second; });
+
+  // Submesh of each triangle, from the submesh corner ranges.
+  std::vector<std::pair<size_t, uint32_t>> firstTriangle;
+  for (size_t s = 0; s < batches.submeshes.size(); ++s) {
+    if (batches.submeshes[s].cornerCount > 0) {
+      firstTriangle.emplace_back(batches.submeshes[s].firstCorner / 3,
+                                 static_cast<uint32_t>(s));
+    }
+  }
+  std::sort(firstTriangle.begin(), firstTriangle.end());
+
+  set.positions.reserve(candidates.size() * 9);
+  set.submeshes.reserve(candidates.size());
+  for (const auto &candidate : candidates) {
+    const size_t t = candidate.second;
+    auto it = std::upper_bound(
+        firstTriangle.begin(), firstTriangle.end(), t,
+        [](size_t value, const auto &entry) { return value < entry.first; });
+    uint32_t submesh = it == firstTriangle.begin() ? 0 : std::prev(it)->second;
+    set.positions.insert(set.positions.end(), p + t * 9, p + t * 9 + 9);
+    set.submeshes.push_back(submesh);
+  }
+  return set;
+}
+
+OcclusionCuller::OcclusionCuller()
+    : depth_(static_cast<size_t>(kWidth) * kHeight, 1.0f) {
+  Level level;
+  level.width = kWidth;
+  level.height = kHeight;
+  levels_.push_back(level);
+  size_t pyramidSize = 0;
+  while (level.width > 1 || level.height > 1) {
+    level.offset = pyramidSize;
+    level.width = std::max(1, level.width / 2);
+    level.height = std::max(1, level.height / 2);
+    pyramidSize += static_cast<size_t>(level.width) * level.height;
+    levels_.push_back(level);
+  }
+  pyramid_.assign(pyramidSize, 1.0f);
+  worker_ = std::thread(&OcclusionCuller::workerLoop, this);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  worker_.join();
+}
+
+void OcclusionCuller::submit(const std::vector<OcclusionItem> &items) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ = &items;
+    busy_ = true;
+  }
+  changed_.notify_all();
+}
+
+void OcclusionCuller::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [&] { return !busy_; });
+}
+
+void OcclusionCuller::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    changed_.wait(lock, [&] { return pending_ != nullptr || stopping_; });
+    if (pending_ == nullptr) {
+      return; // Stopping, nothing left to do
+    }
+    const std::vector<OcclusionItem> *items = pending_;
+    pending_ = nullptr;
+    lock.unlock();
+    cull(*items);
+    lock.lock();
+    busy_ = false;
+    changed_.notify_all();
+  }
+}
+
+void OcclusionCuller::cull(const std::vector<OcclusionItem> &items) {
+  const auto start = std::chrono::steady_clock::now();
+  OcclusionStats stats;
+  clear();
+
+  // Occluders: the big triangles of every submesh that is drawn.
+  for (const OcclusionItem &item : items) {
+    if (!item.occluders) {
+      continue;
+    }
+    const OccluderSet &occluders = *item.occluders;
+    const std::vector<unsigned char> &state = *item.state;
+    for (size_t t = 0; t < occluders.triangleCount() &&
+                       stats.occluderTriangles < kMaxOccludersPerPass;
+         ++t) {
+      const uint32_t submesh = occluders.submeshes[t];
+      if (submesh < state.size() && state[submesh] != 0) {
+        continue;
+      }
+      if (rasterize(item.clipFromObject, &occluders.positions[t * 9])) {
+        ++stats.occluderTriangles;
+      }
+    }
+  }
+  buildPyramid();
+
+  for (const OcclusionItem &item : items) {
+    std::vector<unsigned char> &state = *item.state;
+    const std::vector<SubmeshRange> &submeshes = item.batches->submeshes;
+    for (size_t s = 0; s < submeshes.size() && s < state.size(); ++s) {
+      if (state[s] != 0 || submeshes[s].cornerCount == 0) {
+        continue;
+      }
+      ++stats.tested;
+      if (isOccluded(item.clipFromObject, submeshes[s].bounds)) {
+        state[s] = SubmeshState::OCCLUDED;
+        ++stats.occluded;
+      }
+    }
+  }
+
+  stats.micros = std::chrono::duration<double, std::micro>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  stats_ = stats;
+}
+
+void OcclusionCuller::clear() {
+  std::fill(depth_.begin(), depth_.end(), 1.0f);
+}
+
+bool OcclusionCuller::rasterize(const Matrix4 &clipFromObject,
+                                const float *triangle, bool simd) {
+  // Screen positions snapped to kSubpixelSteps per pixel, so that coverage
+  // is decided exactly in integers.
+  int64_t sx[3], sy[3];
+  float sz[3];
+  for (int k = 0; k < 3; ++k) {
+    ClipPoint c = toClip(clipFromObject, triangle[k * 3], triangle[k * 3 + 1],
+                         triangle[k * 3 + 2]);
+    if (!inFrontOfNear(c)) {
+      return false; // Clipping is not worth it for an occluder
+    }
+    const float inv = 1.0f / c.w;
+    const float x = (c.x * inv * 0.5f + 0.5f) * kWidth;
+    const float y = (c.y * inv * 0.5f + 0.5f) * kHeight;
+    if (!(std::fabs(x) < kGuardBand && std::fabs(y) < kGuardBand)) {
+      return false; // Too close to the camera plane (or NaN)
+    }
+    sx[k] = std::llround(x * kSubpixelSteps);
+    sy[k] = std::llround(y * kSubpixelSteps);
+    sz[k] = c.z * inv * 0.5f + 0.5f;
+  }
+
+  // Counter-clockwise on screen, so inside is where all edges are >= 0
+  // (> 0 on edges the triangle doesn't own, see below).
+  int64_t area = (sx[1] - sx[0]) * (sy[2] - sy[0]) -
+                 (sx[2] - sx[0]) * (sy[1] - sy[0]);
+  if (area == 0) {
+    return false; // Degenerate at this resolution
+  }
+  if (area < 0) {
+    std::swap(sx[1], sx[2]);
+    std::swap(sy[1], sy[2]);
+    std::swap(sz[1], sz[2]);
+    area = -area;
+  }
+
+  const int64_t minSx = std::min({sx[0], sx[1], sx[2]});
+  const int64_t maxSx = std::max({sx[0], sx[1], sx[2]});
+  const int64_t minSy = std::min({sy[0], sy[1], sy[2]});
+  const int64_t maxSy = std::max({sy[0], sy[1], sy[2]});
+  if (maxSx < 0 || maxSy < 0 || minSx > kWidth * kSubpixelSteps ||
+      minSy > kHeight * kSubpixelSteps) {
+    return false;
+  }
+  const int64_t minX = std::max<int64_t>(minSx / kSubpixelSteps, 0);
+  const int64_t maxX = std::min<int64_t>(maxSx / kSubpixelSteps, kWidth - 1);
+  const int minY =
+      static_cast<int>(std::max<int64_t>(minSy / kSubpixelSteps, 0));
+  const int maxY = static_cast<int>(
+      std::min<int64_t>(maxSy / kSubpixelSteps, kHeight - 1));
+
+  // Edge i runs from vertex i to vertex i + 1: e = a * x + b * y + c, in
+  // subpixel units. A pixel center exactly on an edge belongs to the
+  // triangle for which that edge has a > 0, or a == 0 and b < 0; the
+  // neighbor across a shared edge sees it reversed, so exactly one of the
+  // two covers it.
+  int64_t a[3], b[3], c[3], bias[3];
+  for (int i = 0; i < 3; ++i) {
+    int j = (i + 1) % 3;
+    a[i] = sy[i] - sy[j];
+    b[i] = sx[j] - sx[i];
+    c[i] = -(a[i] * sx[i] + b[i] * sy[i]);
+    bias[i] = a[i] > 0 || (a[i] == 0 && b[i] < 0) ? 0 : 1;
+  }
+  // Depth gradient per pixel, from the barycentric weights e1 / area
+  // (vertex 0), e2 / area (vertex 1) and e0 / area (vertex 2). Rows start
+  // from vertex 0 in double, as it may lie far off screen.
+  const double dz1 = (sz[1] - sz[0]) / static_cast<double>(area);
+  const double dz2 = (sz[2] - sz[0]) / static_cast<double>(area);
+  const double za = (dz1 * a[2] + dz2 * a[0]) * kSubpixelSteps;
+  const double zb = (dz1 * b[2] + dz2 * b[0]) * kSubpixelSteps;
+  const double x0 = static_cast<double>(sx[0]) / kSubpixelSteps;
+  const double y0 = static_cast<double>(sy[0]) / kSubpixelSteps;
+  const float zaf = static_cast<float>(za);
+
+  constexpr int64_t half = kSubpixelSteps / 2;
+  for (int y = minY; y <= maxY; ++y) {
+    // The pixels of the row inside all three edges form one span:
+    // a * (steps * x + half) + row >= bias bounds x on one side.
+    const int64_t py = static_cast<int64_t>(y) * kSubpixelSteps + half;
+    int64_t first = minX;
+    int64_t last = maxX;
+    for (int i = 0; i < 3 && first <= last; ++i) {
+      const int64_t row = b[i] * py + c[i];
+      const int64_t limit = bias[i] - row - a[i] * half;
+      const int64_t step = a[i] * kSubpixelSteps;
+      if (step > 0) {
+        first = std::max(first, ceilDiv(limit, step));
+      } else if (step < 0) {
+        last = std::min(last, floorDiv(limit, step));
+      } else if (limit > 0) {
+        last = first - 1; // Parallel to the row and outside
+      }
+    }
+    if (first > last) {
+      continue;
+    }
+    const int begin = static_cast<int>(first);
+    const int end = static_cast<int>(last) + 1;
+
+    const float rowZ =
+        static_cast<float>(sz[0] + zb * (y + 0.5 - y0) - za * x0);
+    float *out = depth_.data() + static_cast<size_t>(y) * kWidth;
+    int x = begin;
+#if defined(__SSE2__)
+    if (simd) {
+      const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+      const __m128 vza = _mm_set1_ps(zaf), rz = _mm_set1_ps(rowZ);
+      for (; x + 4 <= end; x += 4) {
+        __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+        __m128 z = _mm_add_ps(_mm_mul_ps(vza, px), rz);
+        _mm_storeu_ps(out + x, _mm_min_ps(_mm_loadu_ps(out + x), z));
+      }
+    }
+#else
+    (void)simd;
+#endif
+    for (; x < end; ++x) {
+      const float px = static_cast<float>(x) + 0.5f;
+      const float z = zaf * px + rowZ;
+      out[x] = std::min(out[x], z);
+    }
+  }
+  return true;
+}
+
+void OcclusionCuller::buildPyramid() {
+  for (size_t k = 1; k < levels_.size(); ++k) {
+    const Level &src = levels_[k - 1];
+    const Level &dst = levels_[k];
+    const float *in = k == 1 ? depth_.data() : pyramid_.data() + src.offset;
+    float *out = pyramid_.data() + dst.offset;
+    for (int y = 0; y < dst.height; ++y) {
+      const size_t y0 = static_cast<size_t>(std::min(2 * y, src.height - 1));
+      const size_t y1 =
+          static_cast<size_t>(std::min(2 * y + 1, src.height - 1));
+      const float *row0 = in + y0 * src.width;
+      const float *row1 = in + y1 * src.width;
+      float *o = out + static_cast<size_t>(y) * dst.width;
+      int x = 0;
+#if defined(__SSE2__)
+      if (src.width == 2 * dst.width) {
+        for (; x + 4 <= dst.width; x += 4) {
+          __m128 lo = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x),
+                                 _mm_loadu_ps(row1 + 2 * x));
+          __m128 hi = _mm_max_ps(_mm_loadu_ps(row0 + 2 * x + 4),
+                                 _mm_loadu_ps(row1 + 2 * x + 4));
+          __m128 even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+          __m128 odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+          _mm_storeu_ps(o + x, _mm_max_ps(even, odd));
+        }
+      }
+#endif
+      for (; x < dst.width; ++x) {
+        const int x0 = std::min(2 * x, src.width - 1);
+        const int x1 = std::min(2 * x + 1, src.width - 1);
+        o[x] = std::max(std::max(row0[x0], row0[x1]),
+                        std::max(row1[x0], row1[x1]));
+      }
+    }
+  }
+}
+
+bool OcclusionCuller::isOccluded(const Matrix4 &clipFromObject,
+                                 const AABB &box) const {
+  if (box.isEmpty()) {
+    return false;
+  }
+  float minSx = kWidth, maxSx = 0.0f, minSy = kHeight, maxSy = 0.0f;
+  float nearest = 1.0f;
+  for (int corner = 0; corner < 8; ++corner) {
+    ClipPoint c = toClip(clipFromObject, corner & 1 ? box.max.x : box.min.x,
+                         corner & 2 ? box.max.y : box.min.y,
+                         corner & 4 ? box.max.z : box.min.z);
+    if (!inFrontOfNear(c)) {
+      return false; // Reaches the camera: treat as visible
+    }
+    const float inv = 1.0f / c.w;
+    const float sx = (c.x * inv * 0.5f + 0.5f) * kWidth;
+    const float sy = (c.y * inv * 0.5f + 0.5f) * kHeight;
+    minSx = std::min(minSx, sx);
+    maxSx = std::max(maxSx, sx);
+    minSy = std::min(minSy, sy);
+    maxSy = std::max(maxSy, sy);
+    nearest = std::min(nearest, c.z * inv * 0.5f + 0.5f);
+  }
+  if (maxSx < 0.0f || maxSy < 0.0f || minSx >= kWidth || minSy >= kHeight) {
+    return false; // Off screen; frustum culling's call
+  }
+  // Texels only know the occluders at their centers, so the footprint grows
+  // by a texel on each side: geometry peeking past an occluder edge within
+  // a covered texel then reaches the texel beyond that edge.
+  int x0 = std::max(static_cast<int>(std::max(minSx, 0.0f)) - 1, 0);
+  int x1 = std::min(static_cast<int>(std::min(maxSx, kWidth - 1.0f)) + 1,
+                    kWidth - 1);
+  int y0 = std::max(static_cast<int>(std::max(minSy, 0.0f)) - 1, 0);
+  int y1 = std::min(static_cast<int>(std::min(maxSy, kHeight - 1.0f)) + 1,
+                    kHeight - 1);
+
+  // Coarsest level at which the footprint spans at most 2 x 2 texels.
+  size_t k = 0;
+  while (k + 1 < levels_.size() &&
+         ((x1 >> k) - (x0 >> k) > 1 || (y1 >> k) - (y0 >> k) > 1)) {
+    ++k;
+  }
+  const Level &level = levels_[k];
+  const float *data = k == 0 ? depth_.data() : pyramid_.data() + level.offset;
+  x0 = std::min(x0 >> k, level.width - 1);
+  x1 = std::min(x1 >> k, level.width - 1);
+  y0 = std::min(y0 >> k, level.height - 1);
+  y1 = std::min(y1 >> k, level.height - 1);
+  float farthest = 0.0f;
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      farthest = std::max(
+          farthest, data[static_cast<size_t>(y) * level.width + x]);
+    }
+  }
+  return nearest > farthest;
+}
@@ -1,6 +1,9 @@
 #include "Overlay.hpp"
-#include <iostream>
-#include <sstream>
+#include "DrawBatches.hpp"
+#include "MemoryTracker.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 static void *BIG_FONT = GLUT_BITMAP_HELVETICA_18;
 
@@ -20,8 +23,12 @@ void Overlay::updateWindowSize(int width, int height) {
 /**
  * @brief Renders the overlay with provided camera information and current mode.
  */
-void Overlay::render(const std::string &cameraInfo, int currentMode,
-                     int totalModes, const OBJModel &model) {
+void Overlay::render(const char *cameraInfo, int currentMode,
+                     int totalModes, const OBJModel &model,
+                     const std::string &textureName, int selectedFace,
+                     double pickMicros,
+                     const std::vector<unsigned char> &submeshState,
+                     int currentSubmesh) {
   glDisable(GL_TEXTURE_2D);
 
   // Save current projection and modelview matrices
@@ -57,6 +64,20 @@ void Overlay::render(const std::string &cameraInfo, int currentMode,
   drawText(leftXPos, leftYPos, "'+'/'-': Adjust rotation speed (Focus Mode).");
   leftYPos -= lineHeight;
   drawText(leftXPos, leftYPos, "Space: Reset camera (Focus Mode).");
+  leftYPos -= lineHeight;
+  drawText(leftXPos, leftYPos, "Left click: Inspect a face.");
+  leftYPos -= lineHeight;
+  drawText(leftXPos, leftYPos, "'['/']': Select part, H: Hide, I: Isolate.");
+  leftYPos -= lineHeight;
+  drawText(leftXPos, leftYPos,
+           "U: Show all parts, C/O: Toggle frustum/occlusion culling.");
+  leftYPos -= lineHeight;
+  drawText(leftXPos, leftYPos, "Shift + drop .obj: Add to the scene.");
+
+  if (model.submeshes.size() > 1) {
+    drawSubmeshList(leftXPos, leftYPos - 2.0f * lineHeight, model,
+                    submeshState, currentSubmesh);
+  }
 
   //
   // 2) Right side: Current camera / rendering data
@@ -67,21 +88,35 @@ void Overlay::render(const std::string &cameraInfo, int currentMode,
   drawText(rightXPos, rightYPos, "Current Data:");
   rightYPos -= lineHeight;
 
-  std::istringstream cameraStream(cameraInfo);
-  std::string line;
-  while (std::getline(cameraStream, line)) {
-    drawText(rightXPos, rightYPos, line);
+  // cameraInfo holds several '\n'-separated lines; draw them in place.
+  const char *lineStart = cameraInfo;
+  while (*lineStart != '\0') {
+    const char *lineEnd = std::strchr(lineStart, '\n');
+    size_t length = lineEnd ? static_cast<size_t>(lineEnd - lineStart)
+                            : std::strlen(lineStart);
+    drawText(rightXPos, rightYPos, lineStart, length);
     rightYPos -= lineHeight;
+    if (!lineEnd) {
+      break;
+    }
+    lineStart = lineEnd + 1;
   }
 
   static const char *modes[] = {"Grayscale", "Random Color", "Wireframe",
-                                "Texture"};
+                                "Texture", "Lit", "Point Cloud"};
   const char *currentModeName = modes[currentMode];
-  std::stringstream ss;
-  ss << "Render Mode: " << currentModeName << " (" << (currentMode + 1) << " / "
-     << totalModes << ")";
+  char text[256];
+  std::snprintf(text, sizeof(text), "Render Mode: %s (%d / %d)",
+                currentModeName, currentMode + 1, totalModes);
 
-  drawText(rightXPos, rightYPos, ss.str());
+  drawText(rightXPos, rightYPos, text);
+  rightYPos -= lineHeight;
+
+  if (selectedFace >= 0 &&
+      static_cast<size_t>(selectedFace) < model.faces.size()) {
+    drawFaceDetails(rightXPos, rightYPos - lineHeight, model,
+                    static_cast<size_t>(selectedFace), pickMicros);
+  }
 
   //
   // 3) Bottom-left corner: Model details
@@ -92,35 +127,38 @@ void Overlay::render(const std::string &cameraInfo, int currentMode,
   drawText(bottomLeftXPos, bottomLeftYPos, "Model Details:");
   bottomLeftYPos -= lineHeight;
   if (model.objectName.find("flip") == std::string::npos) {
-    drawText(bottomLeftXPos, bottomLeftYPos,
-             "Object Name: " + model.objectName);
+    std::snprintf(text, sizeof(text), "Object Name: %s",
+                  model.objectName.c_str());
+    drawText(bottomLeftXPos, bottomLeftYPos, text);
   } else {
     drawText(bottomLeftXPos, bottomLeftYPos,
              "Object Name: special flip object!");
   }
   bottomLeftYPos -= lineHeight;
-  drawText(bottomLeftXPos, bottomLeftYPos,
-           "Texture Name: " + model.textureName);
+  std::snprintf(text, sizeof(text), "Texture Name: %s", textureName.c_str());
+  drawText(bottomLeftXPos, bottomLeftYPos, text);
   bottomLeftYPos -= lineHeight;
 
-  std::stringstream modelDetails;
-  modelDetails << "Vertices: " << model.vertices.size();
-  drawText(bottomLeftXPos, bottomLeftYPos, modelDetails.str());
+  std::snprintf(text, sizeof(text), "Vertices: %zu", model.vertices.size());
+  drawText(bottomLeftXPos, bottomLeftYPos, text);
   bottomLeftYPos -= lineHeight;
 
-  modelDetails.str("");
-  modelDetails << "Texture Coords: " << model.texCoords.size();
-  drawText(bottomLeftXPos, bottomLeftYPos, modelDetails.str());
+  std::snprintf(text, sizeof(text), "Texture Coords: %zu",
+                model.texCoords.size());
+  drawText(bottomLeftXPos, bottomLeftYPos, text);
   bottomLeftYPos -= lineHeight;
 
-  modelDetails.str("");
-  modelDetails << "Normals: " << model.normals.size();
-  drawText(bottomLeftXPos, bottomLeftYPos, modelDetails.str());
+  std::snprintf(text, sizeof(text), "Normals: %zu", model.normals.size());
+  drawText(bottomLeftXPos, bottomLeftYPos, text);
   bottomLeftYPos -= lineHeight;
 
-  modelDetails.str("");
-  modelDetails << "Faces: " << model.faces.size();
-  drawText(bottomLeftXPos, bottomLeftYPos, modelDetails.str());
+  std::snprintf(text, sizeof(text), "Faces: %zu", model.faces.size());
+  drawText(bottomLeftXPos, bottomLeftYPos, text);
+
+  //
+  // 4) Bottom-right corner: Memory accounting
+  //
+  drawMemoryStats(rightXPos, 70.0f + lineHeight * 8);
 
   float openW = 120.0f;
   float openX = (float)m_width - openW - 80.0f;
@@ -142,11 +180,15 @@ void Overlay::render(const std::string &cameraInfo, int currentMode,
  * @brief Draws standard-sized text at the specified (x, y) position
  *        using GLUT_BITMAP_9_BY_15.
  */
-void Overlay::drawText(float x, float y, const std::string &text) {
+void Overlay::drawText(float x, float y, const char *text) {
+  drawText(x, y, text, std::strlen(text));
+}
+
+void Overlay::drawText(float x, float y, const char *text, size_t length) {
   glColor3f(1.0f, 1.0f, 1.0f); // Always render text in white
   glRasterPos2f(x, y);
-  for (char c : text) {
-    glutBitmapCharacter(GLUT_BITMAP_9_BY_15, c);
+  for (size_t i = 0; i < length; ++i) {
+    glutBitmapCharacter(GLUT_BITMAP_9_BY_15, text[i]);
   }
 }
 
@@ -154,10 +196,125 @@ void Overlay::drawText(float x, float y, const std::string &text) {
  * @brief Draws larger text at (x, y) using a bigger GLUT font.
  *        e.g. GLUT_BITMAP_HELVETICA_18 or GLUT_BITMAP_TIMES_ROMAN_24
  */
-void Overlay::drawLargeText(float x, float y, const std::string &text) {
+void Overlay::drawLargeText(float x, float y, const char *text) {
   glColor3f(1.0f, 1.0f, 1.0f);
   glRasterPos2f(x, y);
-  for (char c : text) {
-    glutBitmapCharacter(BIG_FONT, c);
+  for (const char *c = text; *c != '\0'; ++c) {
+    glutBitmapCharacter(BIG_FONT, *c);
+  }
+}
+
+/**
+ * @brief Draws a window of the submesh list centered on the current one.
+ */
+void Overlay::drawSubmeshList(float x, float y, const OBJModel &model,
+                              const std::vector<unsigned char> &submeshState,
+                              int currentSubmesh) {
+  const float lineHeight = 18.0f;
+  const size_t kMaxRows = 10;
+  const size_t count = model.submeshes.size();
+  auto stateOf = [&](size_t i) {
+    return i < submeshState.size() ? submeshState[i] : 0;
+  };
+
+  size_t hidden = 0, culled = 0, occluded = 0;
+  for (size_t i = 0; i < count; ++i) {
+    hidden += (stateOf(i) & SubmeshState::HIDDEN) ? 1 : 0;
+    culled += (stateOf(i) == SubmeshState::CULLED) ? 1 : 0;
+    occluded += (stateOf(i) == SubmeshState::OCCLUDED) ? 1 : 0;
+  }
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "Parts: %zu drawn / %zu (%zu hidden, %zu culled, %zu occluded)",
+                count - hidden - culled - occluded, count, hidden, culled,
+                occluded);
+  drawText(x, y, line);
+  y -= lineHeight;
+
+  size_t current = static_cast<size_t>(std::max(currentSubmesh, 0));
+  size_t first = current > kMaxRows / 2 ? current - kMaxRows / 2 : 0;
+  first = std::min(first, count > kMaxRows ? count - kMaxRows : 0);
+  for (size_t i = first; i < std::min(count, first + kMaxRows); ++i) {
+    unsigned char state = stateOf(i);
+    const char *tag = (state & SubmeshState::HIDDEN)     ? " [hidden]"
+                      : (state & SubmeshState::CULLED)   ? " [culled]"
+                      : (state & SubmeshState::OCCLUDED) ? " [occluded]"
+                                                         : "";
+    std::snprintf(line, sizeof(line), "%s %.48s (%zu faces)%s",
+                  i == current ? ">" : " ", model.submeshes[i].name.c_str(),
+                  model.submeshes[i].faceCount, tag);
+    drawText(x, y, line);
+    y -= lineHeight;
+  }
+}
+
+/**
+ * @brief Draws the details of a picked face, one corner per line.
+ */
+void Overlay::drawFaceDetails(float x, float y, const OBJModel &model,
+                              size_t face, double pickMicros) {
+  const float lineHeight = 18.0f;
+  const size_t kMaxCorners = 6;
+  const auto &corners = model.faces[face].vertices;
+  char line[128];
+
+  // Faces are grouped by part and material on load; show where the face
+  // is in the file.
+  std::snprintf(line, sizeof(line), "Selected Face: %zu (%zu corners, %.1f us)",
+                model.faces[face].fileIndex, corners.size(), pickMicros);
+  drawText(x, y, line);
+  y -= lineHeight;
+  const int material = model.faces[face].material;
+  if (material >= 0 && static_cast<size_t>(material) < model.materials.size()) {
+    std::snprintf(line, sizeof(line), "Material: %.64s",
+                  model.materials[material].name.c_str());
+    drawText(x, y, line);
+  } else {
+    drawText(x, y, "Material: none");
+  }
+  y -= lineHeight;
+
+  for (size_t i = 0; i < corners.size() && i < kMaxCorners; ++i) {
+    const FaceVertex &fv = corners[i];
+    int len = std::snprintf(line, sizeof(line), "  v %d", fv.vertexIndex + 1);
+    if (fv.texCoordIndex >= 0 &&
+        fv.texCoordIndex < static_cast<int>(model.texCoords.size())) {
+      const TexCoord &tc = model.texCoords[fv.texCoordIndex];
+      std::snprintf(line + len, sizeof(line) - len, "  vt %d (%.3f, %.3f)",
+                    fv.texCoordIndex + 1, tc.u, tc.v);
+    } else {
+      std::snprintf(line + len, sizeof(line) - len, "  vt -");
+    }
+    drawText(x, y, line);
+    y -= lineHeight;
+  }
+  if (corners.size() > kMaxCorners) {
+    drawText(x, y, "  ...");
+  }
+}
+
+/**
+ * @brief Draws current / peak bytes per memory tag, one tag per line.
+ */
+void Overlay::drawMemoryStats(float x, float y) {
+  const float lineHeight = 18.0f;
+  char current[32], peak[32], line[96];
+
+  drawText(x, y, "Memory (current / peak):");
+  y -= lineHeight;
+  for (int i = 0; i < static_cast<int>(MemoryTag::COUNT); ++i) {
+    MemoryTag tag = static_cast<MemoryTag>(i);
+    MemoryTracker::formatBytes(MemoryTracker::current(tag), current,
+                               sizeof(current));
+    MemoryTracker::formatBytes(MemoryTracker::peak(tag), peak, sizeof(peak));
+    std::snprintf(line, sizeof(line), "  %s: %s / %s",
+                  MemoryTracker::tagName(tag), current, peak);
+    drawText(x, y, line);
+    y -= lineHeight;
   }
+  MemoryTracker::formatBytes(MemoryTracker::totalCurrent(), current,
+                             sizeof(current));
+  MemoryTracker::formatBytes(MemoryTracker::totalPeak(), peak, sizeof(peak));
+  std::snprintf(line, sizeof(line), "  Total: %s / %s", current, peak);
+  drawText(x, y, line);
 }
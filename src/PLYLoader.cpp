@@ -0,0 +1,630 @@
+#include "PLYLoader.hpp"
+#include "MappedFile.hpp"
+#include "MemoryTracker.hpp"
+#include "ModelUtils.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr size_t kVerticesPerChunk = 65536;
+constexpr size_t kFacesPerChunk = 16384;
+
+// Longer index lists are treated as corruption rather than polygons.
+constexpr double kMaxFaceCorners = 65536.0;
+
+enum class PlyType {
+  NONE,
+  INT8,
+  UINT8,
+  INT16,
+  UINT16,
+  INT32,
+  UINT32,
+  FLOAT32,
+  FLOAT64
+};
+
+enum class PlyFormat { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+
+PlyType parseType(const std::string &name) {
+  if (name == "char" || name == "int8") {
+    return PlyType::INT8;
+  }
+  if (name == "uchar" || name == "uint8") {
+    return PlyType::UINT8;
+  }
+  if (name == "short" || name == "int16") {
+    return PlyType::INT16;
+  }
+  if (name == "ushort" || name == "uint16") {
+    return PlyType::UINT16;
+  }
+  if (name == "int" || name == "int32") {
+    return PlyType::INT32;
+  }
+  if (name == "uint" || name == "uint32") {
+    return PlyType::UINT32;
+  }
+  if (name == "float" || name == "float32") {
+    return PlyType::FLOAT32;
+  }
+  if (name == "double" || name == "float64") {
+    return PlyType::FLOAT64;
+  }
+  return PlyType::NONE;
+}
+
+size_t sizeOf(PlyType type) {
+  switch (type) {
+  case PlyType::INT8:
+  case PlyType::UINT8:
+    return 1;
+  case PlyType::INT16:
+  case PlyType::UINT16:
+    return 2;
+  case PlyType::INT32:
+  case PlyType::UINT32:
+  case PlyType::FLOAT32:
+    return 4;
+  case PlyType::FLOAT64:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+struct PlyProperty {
+  std::string name;
+  PlyType type = PlyType::NONE;      ///< Value type, or list item type.
+  PlyType countType = PlyType::NONE; ///< List length type; NONE for scalars.
+
+  bool isList() const { return countType != PlyType::NONE; }
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PlyProperty> properties;
+
+  /**
+   * @brief Bytes per binary record, or 0 if a list makes it variable.
+   */
+  size_t fixedSize() const {
+    size_t size = 0;
+    for (const PlyProperty &property : properties) {
+      if (property.isList()) {
+        return 0;
+      }
+      size += sizeOf(property.type);
+    }
+    return size;
+  }
+};
+
+struct PlyHeader {
+  PlyFormat format = PlyFormat::ASCII;
+  std::vector<PlyElement> elements;
+  size_t dataOffset = 0; ///< First byte after end_header.
+};
+
+/**
+ * @brief Parses the text header, up to and including end_header.
+ * @return false with the reason in `error`.
+ */
+bool parseHeader(const unsigned char *data, size_t size, PlyHeader &header,
+                 std::string &error) {
+  const char *begin = reinterpret_cast<const char *>(data);
+  const char *p = begin;
+  const char *end = begin + size;
+  bool formatSeen = false;
+  for (size_t lineNumber = 0; p < end; ++lineNumber) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      break;
+    }
+    std::string line(p, lineEnd);
+    p = lineEnd + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    std::istringstream ss(line);
+    std::string keyword;
+    ss >> keyword;
+
+    if (lineNumber == 0) {
+      if (keyword != "ply") {
+        error = "missing the ply magic line";
+        return false;
+      }
+    } else if (keyword == "format") {
+      std::string format;
+      ss >> format;
+      if (format == "ascii") {
+        header.format = PlyFormat::ASCII;
+      } else if (format == "binary_little_endian") {
+        header.format = PlyFormat::BINARY_LITTLE_ENDIAN;
+      } else if (format == "binary_big_endian") {
+        header.format = PlyFormat::BINARY_BIG_ENDIAN;
+      } else {
+        error = "unsupported format " + format;
+        return false;
+      }
+      formatSeen = true;
+    } else if (keyword == "element") {
+      PlyElement element;
+      long long count = -1;
+      ss >> element.name >> count;
+      if (!ss || count < 0) {
+        error = "invalid line \"" + line + "\"";
+        return false;
+      }
+      element.count = static_cast<size_t>(count);
+      header.elements.push_back(element);
+    } else if (keyword == "property") {
+      PlyProperty property;
+      std::string type;
+      ss >> type;
+      if (type == "list") {
+        std::string countType, itemType;
+        ss >> countType >> itemType;
+        property.countType = parseType(countType);
+        property.type = parseType(itemType);
+      } else {
+        property.type = parseType(type);
+      }
+      ss >> property.name;
+      if (!ss || header.elements.empty() || property.type == PlyType::NONE ||
+          (type == "list" && property.countType == PlyType::NONE)) {
+        error = "invalid line \"" + line + "\"";
+        return false;
+      }
+      header.elements.back().properties.push_back(property);
+    } else if (keyword == "end_header") {
+      if (!formatSeen) {
+        error = "missing format line";
+        return false;
+      }
+      header.dataOffset = static_cast<size_t>(p - begin);
+      return true;
+    }
+    // comment, obj_info and unknown keywords are ignored
+  }
+  error = "missing end_header";
+  return false;
+}
+
+template <typename T> T loadValue(const unsigned char *p, bool swap) {
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, p, sizeof(T));
+  if (swap) {
+    std::reverse(bytes, bytes + sizeof(T));
+  }
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+double decodeBinary(const unsigned char *p, PlyType type, bool swap) {
+  switch (type) {
+  case PlyType::INT8:
+    return static_cast<int8_t>(*p);
+  case PlyType::UINT8:
+    return *p;
+  case PlyType::INT16:
+    return loadValue<int16_t>(p, swap);
+  case PlyType::UINT16:
+    return loadValue<uint16_t>(p, swap);
+  case PlyType::INT32:
+    return loadValue<int32_t>(p, swap);
+  case PlyType::UINT32:
+    return loadValue<uint32_t>(p, swap);
+  case PlyType::FLOAT32:
+    return loadValue<float>(p, swap);
+  case PlyType::FLOAT64:
+    return loadValue<double>(p, swap);
+  default:
+    return 0.0;
+  }
+}
+
+/**
+ * @brief Reads PLY values in file order, from binary or ASCII data. Reading
+ * past the end, or a malformed ASCII number, clears ok() and yields 0.
+ */
+class PlyReader {
+public:
+  PlyReader(const unsigned char *begin, const unsigned char *end,
+            PlyFormat format)
+      : p_(begin), end_(end), format_(format),
+        swap_((format == PlyFormat::BINARY_BIG_ENDIAN) !=
+              (std::endian::native == std::endian::big)) {}
+
+  double read(PlyType type) {
+    return format_ == PlyFormat::ASCII ? readAscii() : readBinary(type);
+  }
+
+  /**
+   * @brief Number of items of a list property, 0 (and not ok()) if invalid.
+   */
+  size_t readCount(const PlyProperty &property) {
+    double count = read(property.countType);
+    if (!(count >= 0.0 && count <= kMaxFaceCorners)) {
+      ok_ = false;
+      return 0;
+    }
+    return static_cast<size_t>(count);
+  }
+
+  void skip(const PlyProperty &property) {
+    size_t count = property.isList() ? readCount(property) : 1;
+    if (format_ != PlyFormat::ASCII) {
+      advance(count * sizeOf(property.type));
+      return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      readAscii();
+    }
+  }
+
+  /**
+   * @brief Skips `bytes` of binary data.
+   */
+  void advance(size_t bytes) {
+    if (static_cast<size_t>(end_ - p_) < bytes) {
+      ok_ = false;
+      p_ = end_;
+      return;
+    }
+    p_ += bytes;
+  }
+
+  const unsigned char *position() const { return p_; }
+  bool ok() const { return ok_; }
+  bool swapsBytes() const { return swap_; }
+
+private:
+  double readBinary(PlyType type) {
+    const size_t size = sizeOf(type);
+    if (static_cast<size_t>(end_ - p_) < size) {
+      ok_ = false;
+      return 0.0;
+    }
+    const unsigned char *p = p_;
+    p_ += size;
+    return decodeBinary(p, type, swap_);
+  }
+
+  double readAscii() {
+    while (p_ < end_ && std::isspace(*p_)) {
+      ++p_;
+    }
+    double value = 0.0;
+    auto result = std::from_chars(reinterpret_cast<const char *>(p_),
+                                  reinterpret_cast<const char *>(end_), value);
+    if (result.ec != std::errc()) {
+      ok_ = false;
+      return 0.0;
+    }
+    p_ = reinterpret_cast<const unsigned char *>(result.ptr);
+    return value;
+  }
+
+  const unsigned char *p_;
+  const unsigned char *end_;
+  PlyFormat format_;
+  bool swap_;
+  bool ok_ = true;
+};
+
+// Destination of a vertex property, as an index into the values of
+// readVertex().
+enum VertexSlot { X, Y, Z, NX, NY, NZ, U, V, SLOT_COUNT };
+
+int slotOf(const PlyProperty &property) {
+  const std::string &name = property.name;
+  if (property.isList()) {
+    return -1;
+  }
+  if (name == "x" || name == "y" || name == "z") {
+    return X + (name[0] - 'x');
+  }
+  if (name == "nx" || name == "ny" || name == "nz") {
+    return NX + (name[1] - 'x');
+  }
+  if (name == "u" || name == "s" || name == "texture_u" ||
+      name == "texture_s") {
+    return U;
+  }
+  if (name == "v" || name == "t" || name == "texture_v" ||
+      name == "texture_t") {
+    return V;
+  }
+  return -1;
+}
+
+/**
+ * @brief Reads vertices [begin, end) of the vertex element into the model.
+ */
+void readVertices(PlyReader &reader, const PlyElement &element,
+                  const std::vector<int> &slots, size_t begin, size_t end,
+                  OBJModel &model) {
+  const bool hasNormals = !model.normals.empty();
+  const bool hasTexCoords = !model.texCoords.empty();
+  for (size_t i = begin; i < end && reader.ok(); ++i) {
+    float values[SLOT_COUNT] = {};
+    for (size_t k = 0; k < element.properties.size(); ++k) {
+      const PlyProperty &property = element.properties[k];
+      if (slots[k] < 0) {
+        reader.skip(property);
+      } else {
+        values[slots[k]] = static_cast<float>(reader.read(property.type));
+      }
+    }
+    model.vertices[i] = {values[X], values[Y], values[Z]};
+    if (hasNormals) {
+      model.normals[i] = {values[NX], values[NY], values[NZ]};
+    }
+    if (hasTexCoords) {
+      model.texCoords[i] = {values[U], values[V], 0.0f};
+    }
+  }
+}
+
+/**
+ * @brief A wanted property of a fixed-size binary vertex record.
+ */
+struct VertexField {
+  size_t offset = 0; ///< Bytes from the start of the record.
+  PlyType type = PlyType::NONE;
+  int slot = -1;
+};
+
+/**
+ * @brief Converts vertices [begin, end) of fixed-size binary records at
+ * `base`, reading only the wanted fields.
+ */
+void convertVertices(const unsigned char *base, size_t stride,
+                     const std::vector<VertexField> &fields, bool swap,
+                     size_t begin, size_t end, OBJModel &model) {
+  const bool hasNormals = !model.normals.empty();
+  const bool hasTexCoords = !model.texCoords.empty();
+  for (size_t i = begin; i < end; ++i) {
+    const unsigned char *record = base + i * stride;
+    float values[SLOT_COUNT] = {};
+    for (const VertexField &field : fields) {
+      values[field.slot] = static_cast<float>(
+          decodeBinary(record + field.offset, field.type, swap));
+    }
+    model.vertices[i] = {values[X], values[Y], values[Z]};
+    if (hasNormals) {
+      model.normals[i] = {values[NX], values[NY], values[NZ]};
+    }
+    if (hasTexCoords) {
+      model.texCoords[i] = {values[U], values[V], 0.0f};
+    }
+  }
+}
+
+/**
+ * @brief Face corners read from the face element, flattened: face f uses
+ * indices[first[f]] to indices[first[f + 1]].
+ */
+struct FlatFaces {
+  std::vector<size_t> first{0};
+  std::vector<int> indices;
+  size_t dropped = 0;
+
+  size_t count() const { return first.size() - 1; }
+};
+
+void readFaces(PlyReader &reader, const PlyElement &element,
+               size_t vertexCount, FlatFaces &faces) {
+  size_t listProperty = element.properties.size();
+  for (size_t k = 0; k < element.properties.size(); ++k) {
+    const PlyProperty &property = element.properties[k];
+    if (property.isList() && (property.name == "vertex_indices" ||
+                              property.name == "vertex_index")) {
+      listProperty = k;
+      break;
+    }
+  }
+  faces.first.reserve(element.count + 1);
+  faces.indices.reserve(element.count * 3);
+  for (size_t f = 0; f < element.count && reader.ok(); ++f) {
+    for (size_t k = 0; k < element.properties.size(); ++k) {
+      const PlyProperty &property = element.properties[k];
+      if (k != listProperty) {
+        reader.skip(property);
+        continue;
+      }
+      const size_t count = reader.readCount(property);
+      const size_t start = faces.indices.size();
+      bool valid = count >= 3;
+      for (size_t c = 0; c < count; ++c) {
+        double index = reader.read(property.type);
+        valid = valid && index >= 0.0 &&
+                index < static_cast<double>(vertexCount);
+        faces.indices.push_back(static_cast<int>(valid ? index : 0.0));
+      }
+      if (valid && reader.ok()) {
+        faces.first.push_back(faces.indices.size());
+      } else {
+        faces.indices.resize(start);
+        ++faces.dropped;
+      }
+    }
+  }
+}
+
+} // end anonymous namespace
+
+bool PLYLoader::isPLYPath(const std::string &filePath) {
+  if (filePath.size() < 4) {
+    return false;
+  }
+  std::string extension = filePath.substr(filePath.size() - 4);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == ".ply";
+}
+
+bool PLYLoader::hasPLYMagic(const unsigned char *data, size_t size) {
+  return size >= 4 && std::memcmp(data, "ply", 3) == 0 &&
+         (data[3] == '\n' || data[3] == '\r');
+}
+
+bool PLYLoader::loadPLY(const std::string &filePath, OBJModel &model) {
+  auto start = std::chrono::steady_clock::now();
+  MappedFile file;
+  if (!file.open(filePath)) {
+    return false;
+  }
+  PlyHeader header;
+  std::string error;
+  if (!hasPLYMagic(file.data(), file.size()) ||
+      !parseHeader(file.data(), file.size(), header, error)) {
+    std::cerr << "Error: " << filePath << " is not a valid PLY file"
+              << (error.empty() ? "" : ": " + error) << "\n";
+    return false;
+  }
+
+  // Every record takes at least one byte, which bounds the counts before
+  // anything is allocated for them.
+  size_t vertexCount = 0;
+  for (const PlyElement &element : header.elements) {
+    if (element.count > file.size() - header.dataOffset) {
+      std::cerr << "Error: " << filePath << " is truncated (" << element.count
+                << " " << element.name << " records)\n";
+      return false;
+    }
+    if (element.name == "vertex") {
+      vertexCount = element.count;
+    }
+  }
+
+  PlyReader reader(file.data() + header.dataOffset,
+                   file.data() + file.size(), header.format);
+  FlatFaces faces;
+  for (const PlyElement &element : header.elements) {
+    if (element.name == "vertex") {
+      std::vector<int> slots;
+      bool hasSlot[SLOT_COUNT] = {};
+      for (const PlyProperty &property : element.properties) {
+        slots.push_back(slotOf(property));
+        if (slots.back() >= 0) {
+          hasSlot[slots.back()] = true;
+        }
+      }
+      if (!hasSlot[X] || !hasSlot[Y] || !hasSlot[Z]) {
+        std::cerr << "Error: " << filePath
+                  << ": PLY vertices have no x, y and z properties\n";
+        return false;
+      }
+      model.vertices.resize(element.count);
+      if (hasSlot[NX] && hasSlot[NY] && hasSlot[NZ]) {
+        model.normals.resize(element.count);
+      }
+      if (hasSlot[U] && hasSlot[V]) {
+        model.texCoords.resize(element.count);
+      }
+
+      const size_t stride = element.fixedSize();
+      if (header.format == PlyFormat::ASCII || stride == 0) {
+        readVertices(reader, element, slots, 0, element.count, model);
+        continue;
+      }
+      // Fixed-size binary records: convert in parallel straight from the
+      // mapping, touching only the wanted fields.
+      std::vector<VertexField> fields;
+      size_t offset = 0;
+      for (size_t k = 0; k < element.properties.size(); ++k) {
+        if (slots[k] >= 0) {
+          fields.push_back({offset, element.properties[k].type, slots[k]});
+        }
+        offset += sizeOf(element.properties[k].type);
+      }
+      const unsigned char *base = reader.position();
+      reader.advance(element.count * stride);
+      if (!reader.ok()) {
+        break;
+      }
+      Parallel::forRange(element.count, kVerticesPerChunk,
+                         [&](size_t begin, size_t end) {
+                           convertVertices(base, stride, fields,
+                                           reader.swapsBytes(), begin, end,
+                                           model);
+                         });
+    } else if (element.name == "face") {
+      readFaces(reader, element, vertexCount, faces);
+    } else {
+      const size_t stride = element.fixedSize();
+      if (header.format != PlyFormat::ASCII && stride != 0) {
+        reader.advance(element.count * stride);
+        continue;
+      }
+      for (size_t i = 0; i < element.count && reader.ok(); ++i) {
+        for (const PlyProperty &property : element.properties) {
+          reader.skip(property);
+        }
+      }
+    }
+    if (!reader.ok()) {
+      break;
+    }
+  }
+  if (!reader.ok()) {
+    std::cerr << "Error: " << filePath << " is truncated or malformed\n";
+    return false;
+  }
+
+  // Per-vertex normals and texture coordinates share the position index.
+  const bool hasNormals = !model.normals.empty();
+  const bool hasTexCoords = !model.texCoords.empty();
+  model.faces.resize(faces.count());
+  Parallel::forRange(faces.count(), kFacesPerChunk, [&](size_t begin,
+                                                        size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      model.faces[f].fileIndex = f;
+      std::vector<FaceVertex> &corners = model.faces[f].vertices;
+      corners.resize(faces.first[f + 1] - faces.first[f]);
+      for (size_t c = 0; c < corners.size(); ++c) {
+        const int index = faces.indices[faces.first[f] + c];
+        corners[c] = {index, hasTexCoords ? index : -1,
+                      hasNormals ? index : -1};
+      }
+    }
+  });
+  ModelUtilities::updateSubmeshRanges(model);
+
+  // The flat face arrays are the loader's peak on top of the model.
+  MemoryTracker::Allocation staging(
+      MemoryTag::LOADER, MemoryTracker::bytesOf(model) +
+                             MemoryTracker::bytesOf(faces.first) +
+                             MemoryTracker::bytesOf(faces.indices));
+
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Read PLY: " << model.vertices.size() << " vertices, "
+            << model.faces.size() << " faces";
+  if (faces.dropped > 0) {
+    std::cout << " (" << faces.dropped << " invalid dropped)";
+  }
+  std::cout << " in " << elapsed << " ms ("
+            << file.size() / (1024.0 * 1024.0) /
+                   std::max(elapsed / 1000.0, 1e-6)
+            << " MiB/s)\n";
+  return true;
+}
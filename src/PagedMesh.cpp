@@ -0,0 +1,604 @@
+#include "PagedMesh.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+// Page file layout: FileHeader, one PageRecord per page, the placeholder
+// samples of every page, then each page's triangles (9 floats each) starting
+// on a kDataAlignment boundary so pages can be dropped from the mapping
+// independently.
+constexpr char kMagic[8] = {'S', 'C', 'O', 'P', 'P', 'A', 'G', 'E'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kSamplesPerPage = 64;
+constexpr uint64_t kDataAlignment = 4096;
+constexpr size_t kTriangleBytes = 9 * sizeof(float);
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t pageCount;
+  uint64_t triangleCount;
+  float bounds[6];
+  uint32_t samplesPerPage;
+  uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == 56, "FileHeader must stay packed");
+
+struct PageRecord {
+  float bounds[6];
+  uint64_t triangleOffset;
+  uint32_t triangleCount;
+  uint32_t sampleCount;
+  uint64_t sampleOffset;
+};
+static_assert(sizeof(PageRecord) == 48, "PageRecord must stay packed");
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Spreads the low 21 bits of v so two zero bits follow each one.
+ */
+uint64_t spreadBits(uint64_t v) {
+  v &= 0x1FFFFF;
+  v = (v | v << 32) & 0x1F00000000FFFFULL;
+  v = (v | v << 16) & 0x1F0000FF0000FFULL;
+  v = (v | v << 8) & 0x100F00F00F00F00FULL;
+  v = (v | v << 4) & 0x10C30C30C30C30C3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+
+/**
+ * @brief 63-bit Morton code of a point inside `box`.
+ */
+uint64_t mortonCode(const Vector3 &point, const AABB &box) {
+  const Vector3 size = box.size();
+  auto quantize = [](float value, float lo, float extent) {
+    float t = extent > 0.0f ? (value - lo) / extent : 0.0f;
+    return static_cast<uint64_t>(std::clamp(t, 0.0f, 1.0f) * 2097151.0f);
+  };
+  return spreadBits(quantize(point.x, box.min.x, size.x)) |
+         spreadBits(quantize(point.y, box.min.y, size.y)) << 1 |
+         spreadBits(quantize(point.z, box.min.z, size.z)) << 2;
+}
+
+float distanceToBox(const Vector3 &point, const AABB &box) {
+  float dx = std::max({box.min.x - point.x, 0.0f, point.x - box.max.x});
+  float dy = std::max({box.min.y - point.y, 0.0f, point.y - box.max.y});
+  float dz = std::max({box.min.z - point.z, 0.0f, point.z - box.max.z});
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+const char *skipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * @brief Streaming reader for the parts of an OBJ file pages need: vertex
+ * positions and faces, fan-triangulated into position indices.
+ */
+struct ObjGeometry {
+  std::vector<Vector3> positions;
+  std::vector<uint32_t> triangles; ///< 3 position indices per triangle.
+  size_t skippedFaces = 0;
+
+  void parseVertex(const char *p, const char *end) {
+    float xyz[3] = {0.0f, 0.0f, 0.0f};
+    for (float &value : xyz) {
+      p = skipBlanks(p, end);
+      auto result = std::from_chars(p, end, value);
+      if (result.ec != std::errc()) {
+        break;
+      }
+      p = result.ptr;
+    }
+    positions.emplace_back(xyz[0], xyz[1], xyz[2]);
+  }
+
+  void parseFace(const char *p, const char *end,
+                 std::vector<uint32_t> &corners) {
+    corners.clear();
+    bool valid = true;
+    while ((p = skipBlanks(p, end)) < end && *p != '\r') {
+      long index = 0;
+      auto result = std::from_chars(p, end, index);
+      if (result.ec != std::errc()) {
+        valid = false;
+        break;
+      }
+      // Negative indices count back from the latest vertex.
+      long resolved = index < 0
+                          ? static_cast<long>(positions.size()) + index
+                          : index - 1;
+      valid = valid && resolved >= 0;
+      corners.push_back(static_cast<uint32_t>(std::max(resolved, 0L)));
+      // Skip the texture and normal indices of "v/vt/vn".
+      p = result.ptr;
+      while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        ++p;
+      }
+    }
+    if (!valid || corners.size() < 3) {
+      ++skippedFaces;
+      return;
+    }
+    for (size_t i = 1; i + 1 < corners.size(); ++i) {
+      triangles.insert(triangles.end(),
+                       {corners[0], corners[i], corners[i + 1]});
+    }
+  }
+
+  bool read(const MappedFile &file) {
+    const char *p = reinterpret_cast<const char *>(file.data());
+    const char *end = p + file.size();
+    std::vector<uint32_t> corners;
+    while (p < end) {
+      const char *lineEnd =
+          static_cast<const char *>(std::memchr(p, '\n', end - p));
+      if (lineEnd == nullptr) {
+        lineEnd = end;
+      }
+      if (lineEnd - p >= 2 && (p[1] == ' ' || p[1] == '\t')) {
+        if (p[0] == 'v') {
+          parseVertex(p + 2, lineEnd);
+        } else if (p[0] == 'f') {
+          parseFace(p + 2, lineEnd, corners);
+        }
+      }
+      p = lineEnd + 1;
+    }
+
+    // Forward references are legal in positive indices; check them now.
+    size_t kept = 0;
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+      if (triangles[t] < positions.size() &&
+          triangles[t + 1] < positions.size() &&
+          triangles[t + 2] < positions.size()) {
+        std::copy_n(&triangles[t], 3, &triangles[kept]);
+        kept += 3;
+      } else {
+        ++skippedFaces;
+      }
+    }
+    triangles.resize(kept);
+    return !triangles.empty();
+  }
+};
+
+void writeBounds(const AABB &box, float out[6]) {
+  const float values[6] = {box.min.x, box.min.y, box.min.z,
+                           box.max.x, box.max.y, box.max.z};
+  std::copy_n(values, 6, out);
+}
+
+AABB readBounds(const float in[6]) {
+  AABB box;
+  box.min = Vector3(in[0], in[1], in[2]);
+  box.max = Vector3(in[3], in[4], in[5]);
+  return box;
+}
+
+} // end anonymous namespace
+
+bool PagedMesh::isPagePath(const std::string &filePath) {
+  return filePath.size() >= 5 &&
+         filePath.compare(filePath.size() - 5, 5, ".scpg") == 0;
+}
+
+size_t PagedMesh::pageBytes(const MeshPage &page) {
+  return static_cast<size_t>(page.triangleCount) * kTriangleBytes * 2;
+}
+
+bool PagedMesh::build(const std::string &objPath, const std::string &pagePath,
+                      size_t trianglesPerPage) {
+  if (trianglesPerPage == 0) {
+    std::cerr << "Error: Pages need at least one triangle.\n";
+    return false;
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  ObjGeometry geometry;
+  {
+    MappedFile obj;
+    if (!obj.open(objPath)) {
+      return false;
+    }
+    if (!geometry.read(obj)) {
+      std::cerr << "Error: " << objPath << " has no triangles.\n";
+      return false;
+    }
+  }
+  const std::vector<Vector3> &positions = geometry.positions;
+  const std::vector<uint32_t> &triangles = geometry.triangles;
+  const size_t triangleCount = triangles.size() / 3;
+
+  AABB bounds;
+  bounds.min = bounds.max = positions[triangles[0]];
+  for (const Vector3 &p : positions) {
+    bounds.min = Vector3(std::min(bounds.min.x, p.x),
+                         std::min(bounds.min.y, p.y),
+                         std::min(bounds.min.z, p.z));
+    bounds.max = Vector3(std::max(bounds.max.x, p.x),
+                         std::max(bounds.max.y, p.y),
+                         std::max(bounds.max.z, p.z));
+  }
+
+  // Sort triangles along a Morton curve of their centroids; consecutive
+  // runs of the sorted order are spatially compact pages.
+  std::vector<std::pair<uint64_t, uint32_t>> order(triangleCount);
+  Parallel::forRange(triangleCount, 16384, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+      const Vector3 centroid = (positions[triangles[3 * t]] +
+                                positions[triangles[3 * t + 1]] +
+                                positions[triangles[3 * t + 2]]) *
+                               (1.0f / 3.0f);
+      order[t] = {mortonCode(centroid, bounds), static_cast<uint32_t>(t)};
+    }
+  });
+  std::sort(order.begin(), order.end());
+
+  const size_t pageCount =
+      (triangleCount + trianglesPerPage - 1) / trianglesPerPage;
+  std::vector<PageRecord> records(pageCount);
+  uint64_t sampleOffset = sizeof(FileHeader) + pageCount * sizeof(PageRecord);
+  for (size_t i = 0; i < pageCount; ++i) {
+    size_t count = std::min(trianglesPerPage, triangleCount - i * trianglesPerPage);
+    records[i].triangleCount = static_cast<uint32_t>(count);
+    records[i].sampleCount =
+        static_cast<uint32_t>(std::min<size_t>(count, kSamplesPerPage));
+    records[i].sampleOffset = sampleOffset;
+    sampleOffset += records[i].sampleCount * 3 * sizeof(float);
+  }
+  uint64_t dataOffset = alignUp(sampleOffset, kDataAlignment);
+  for (PageRecord &record : records) {
+    record.triangleOffset = dataOffset;
+    dataOffset = alignUp(dataOffset + record.triangleCount * kTriangleBytes,
+                         kDataAlignment);
+  }
+
+  // Write next to the target and rename, so readers never see a partial file.
+  const std::string temporary = pagePath + ".tmp";
+  std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+  std::vector<float> pageData;
+  std::vector<float> sampleData;
+  for (size_t i = 0; i < pageCount && file; ++i) {
+    PageRecord &record = records[i];
+    const size_t first = i * trianglesPerPage;
+    pageData.clear();
+    AABB pageBounds;
+    pageBounds.min = pageBounds.max = positions[triangles[3 * order[first].second]];
+    for (size_t k = 0; k < record.triangleCount; ++k) {
+      const uint32_t t = order[first + k].second;
+      for (int c = 0; c < 3; ++c) {
+        const Vector3 &p = positions[triangles[3 * t + c]];
+        pageData.insert(pageData.end(), {p.x, p.y, p.z});
+        pageBounds.min = Vector3(std::min(pageBounds.min.x, p.x),
+                                 std::min(pageBounds.min.y, p.y),
+                                 std::min(pageBounds.min.z, p.z));
+        pageBounds.max = Vector3(std::max(pageBounds.max.x, p.x),
+                                 std::max(pageBounds.max.y, p.y),
+                                 std::max(pageBounds.max.z, p.z));
+      }
+    }
+    writeBounds(pageBounds, record.bounds);
+
+    // Placeholder samples: evenly strided triangle centroids.
+    const size_t stride = record.triangleCount / record.sampleCount;
+    for (size_t s = 0; s < record.sampleCount; ++s) {
+      const float *corner = &pageData[9 * s * stride];
+      for (int axis = 0; axis < 3; ++axis) {
+        sampleData.push_back((corner[axis] + corner[3 + axis] + corner[6 + axis]) /
+                             3.0f);
+      }
+    }
+
+    file.seekp(static_cast<std::streamoff>(record.triangleOffset));
+    file.write(reinterpret_cast<const char *>(pageData.data()),
+               static_cast<std::streamsize>(pageData.size() * sizeof(float)));
+  }
+  if (file && pageCount > 0) {
+    // Extend the file to the aligned end of the last page.
+    file.seekp(static_cast<std::streamoff>(dataOffset - 1));
+    file.put('\0');
+  }
+
+  FileHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.pageCount = static_cast<uint32_t>(pageCount);
+  header.triangleCount = triangleCount;
+  writeBounds(bounds, header.bounds);
+  header.samplesPerPage = kSamplesPerPage;
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(records.data()),
+             static_cast<std::streamsize>(records.size() * sizeof(PageRecord)));
+  file.write(reinterpret_cast<const char *>(sampleData.data()),
+             static_cast<std::streamsize>(sampleData.size() * sizeof(float)));
+  file.close();
+  if (!file) {
+    std::cerr << "Error: Could not write " << temporary << "\n";
+    std::remove(temporary.c_str());
+    return false;
+  }
+  if (std::rename(temporary.c_str(), pagePath.c_str()) != 0) {
+    std::cerr << "Error: Could not rename " << temporary << " to " << pagePath
+              << "\n";
+    std::remove(temporary.c_str());
+    return false;
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  std::cout << "Built " << pageCount << " pages (" << triangleCount
+            << " triangles, " << positions.size() << " vertices";
+  if (geometry.skippedFaces > 0) {
+    std::cout << ", " << geometry.skippedFaces << " invalid faces skipped";
+  }
+  std::cout << ") in " << ms << " ms -> " << pagePath << "\n";
+  return true;
+}
+
+std::shared_ptr<PagedMesh> PagedMesh::open(const std::string &pagePath,
+                                           size_t budgetBytes) {
+  std::shared_ptr<PagedMesh> mesh(new PagedMesh());
+  if (!mesh->file_.open(pagePath)) {
+    return nullptr;
+  }
+  const unsigned char *data = mesh->file_.data();
+  const size_t size = mesh->file_.size();
+
+  FileHeader header;
+  bool valid = size >= sizeof(header);
+  if (valid) {
+    std::memcpy(&header, data, sizeof(header));
+    valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+            header.version == kVersion &&
+            sizeof(header) + uint64_t(header.pageCount) * sizeof(PageRecord) <=
+                size;
+  }
+  if (valid) {
+    mesh->pages_.resize(header.pageCount);
+    uint32_t sampleCount = 0;
+    for (uint32_t i = 0; i < header.pageCount && valid; ++i) {
+      PageRecord record;
+      std::memcpy(&record,
+                  data + sizeof(header) + uint64_t(i) * sizeof(PageRecord),
+                  sizeof(record));
+      const uint64_t sampleBytes = uint64_t(record.sampleCount) * 3 * sizeof(float);
+      valid = record.triangleOffset +
+                      uint64_t(record.triangleCount) * kTriangleBytes <=
+                  size &&
+              record.sampleOffset + sampleBytes <= size;
+      if (!valid) {
+        break;
+      }
+      MeshPage &page = mesh->pages_[i];
+      page.bounds = readBounds(record.bounds);
+      page.fileOffset = record.triangleOffset;
+      page.triangleCount = record.triangleCount;
+      page.firstSample = sampleCount;
+      page.sampleCount = record.sampleCount;
+      sampleCount += record.sampleCount;
+
+      const size_t firstFloat = mesh->samples_.size();
+      mesh->samples_.resize(firstFloat + record.sampleCount * 3);
+      std::memcpy(mesh->samples_.data() + firstFloat, data + record.sampleOffset,
+                  sampleBytes);
+    }
+  }
+  if (!valid) {
+    std::cerr << "Error: " << pagePath
+              << " is not a valid page file (build it with scop "
+                 "--build-pages).\n";
+    return nullptr;
+  }
+
+  mesh->bounds_ = readBounds(header.bounds);
+  mesh->triangleCount_ = header.triangleCount;
+  mesh->budgetBytes_ = budgetBytes;
+  const Vector3 size3 = mesh->bounds_.size();
+  mesh->nearDistance_ =
+      0.1f * std::sqrt(size3.x * size3.x + size3.y * size3.y + size3.z * size3.z);
+  mesh->indexMemory_ = MemoryTracker::Allocation(
+      MemoryTag::DERIVED, mesh->pages_.capacity() * sizeof(MeshPage) +
+                              mesh->samples_.capacity() * sizeof(float));
+
+  // Scratch space for update(), so frames don't allocate.
+  mesh->order_.reserve(mesh->pages_.size());
+  mesh->priority_.assign(mesh->pages_.size(), 0.0f);
+  mesh->arrived_.reserve(mesh->pages_.size());
+  mesh->requests_.reserve(mesh->pages_.size());
+  mesh->completed_.reserve(mesh->pages_.size());
+
+  mesh->file_.adviseRandomAccess();
+  mesh->worker_ = std::thread(&PagedMesh::workerLoop, mesh.get());
+
+  char budget[32];
+  MemoryTracker::formatBytes(budgetBytes, budget, sizeof(budget));
+  std::cout << "Opened page file " << pagePath << ": " << mesh->pages_.size()
+            << " pages, " << mesh->triangleCount_ << " triangles, budget "
+            << budget << "\n";
+  return mesh;
+}
+
+PagedMesh::~PagedMesh() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  requestReady_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void PagedMesh::update(const Frustum &frustum, const Vector3 &eye) {
+  ++updateCount_;
+
+  // Take the pages the worker finished since the last call.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    arrived_.swap(completed_);
+  }
+  for (LoadedPage &loaded : arrived_) {
+    MeshPage &page = pages_[loaded.page];
+    if (page.resident()) {
+      continue;
+    }
+    page.positions = std::move(loaded.positions);
+    page.normals = std::move(loaded.normals);
+    const size_t bytes = pageBytes(page);
+    page.memory = MemoryTracker::Allocation(MemoryTag::PAGES, bytes);
+    residentBytes_ += bytes;
+    ++residentPages_;
+  }
+  arrived_.clear();
+
+  // Candidates: pages in view, then pages near the camera, nearest first.
+  order_.clear();
+  for (uint32_t i = 0; i < pages_.size(); ++i) {
+    MeshPage &page = pages_[i];
+    page.visible = BoundingVolumes::intersects(frustum, page.bounds);
+    priority_[i] = distanceToBox(eye, page.bounds);
+    if (page.visible || priority_[i] <= nearDistance_) {
+      order_.push_back(i);
+    }
+  }
+  std::sort(order_.begin(), order_.end(), [this](uint32_t a, uint32_t b) {
+    if (pages_[a].visible != pages_[b].visible) {
+      return pages_[a].visible;
+    }
+    return priority_[a] < priority_[b];
+  });
+
+  // Keep as many as the budget holds.
+  size_t wantedBytes = 0, missingBytes = 0, wanted = 0;
+  for (; wanted < order_.size(); ++wanted) {
+    MeshPage &page = pages_[order_[wanted]];
+    const size_t bytes = pageBytes(page);
+    if (wantedBytes + bytes > budgetBytes_) {
+      break;
+    }
+    wantedBytes += bytes;
+    page.lastUsed = updateCount_;
+    if (!page.resident()) {
+      missingBytes += bytes;
+    }
+  }
+  order_.resize(wanted);
+
+  // Make room for the missing ones, least recently used first. Unwanted
+  // pages otherwise stay resident in case the camera turns back.
+  while (residentBytes_ + missingBytes > budgetBytes_) {
+    MeshPage *victim = nullptr;
+    for (MeshPage &page : pages_) {
+      if (page.resident() && page.lastUsed != updateCount_ &&
+          (!victim || page.lastUsed < victim->lastUsed)) {
+        victim = &page;
+      }
+    }
+    if (!victim) {
+      break;
+    }
+    evict(*victim);
+  }
+
+  // Replace the worker's queue with the missing pages, in priority order.
+  bool queued = false;
+  pendingLoads_ = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.clear();
+    nextRequest_ = 0;
+    for (uint32_t index : order_) {
+      if (pages_[index].resident()) {
+        continue;
+      }
+      ++pendingLoads_;
+      if (index != inFlight_) {
+        requests_.push_back(index);
+      }
+    }
+    queued = !requests_.empty();
+  }
+  if (queued) {
+    requestReady_.notify_one();
+  }
+}
+
+void PagedMesh::evict(MeshPage &page) {
+  residentBytes_ -= pageBytes(page);
+  --residentPages_;
+  std::vector<float>().swap(page.positions);
+  std::vector<float>().swap(page.normals);
+  page.memory = MemoryTracker::Allocation();
+}
+
+void PagedMesh::workerLoop() {
+  LoadedPage loaded;
+  while (true) {
+    uint32_t page;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      requestReady_.wait(lock, [this] {
+        return stopping_ || nextRequest_ < requests_.size();
+      });
+      if (stopping_) {
+        return;
+      }
+      page = requests_[nextRequest_++];
+      inFlight_ = page;
+    }
+
+    loadPage(page, loaded);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    inFlight_ = UINT32_MAX;
+    completed_.push_back(std::move(loaded));
+  }
+}
+
+void PagedMesh::loadPage(uint32_t page, LoadedPage &out) {
+  const MeshPage &source = pages_[page];
+  const size_t floatCount = static_cast<size_t>(source.triangleCount) * 9;
+  out.page = page;
+  out.positions.resize(floatCount);
+  std::memcpy(out.positions.data(), file_.data() + source.fileOffset,
+              floatCount * sizeof(float));
+  // The copy is what counts against the budget; don't keep the file pages.
+  file_.dropRange(source.fileOffset, floatCount * sizeof(float));
+
+  // Flat normals, repeated for the three corners.
+  out.normals.resize(floatCount);
+  for (size_t t = 0; t < floatCount; t += 9) {
+    const float *p = &out.positions[t];
+    Vector3 a(p[0], p[1], p[2]), b(p[3], p[4], p[5]), c(p[6], p[7], p[8]);
+    Vector3 normal = (b - a).cross(c - a);
+    float length = std::sqrt(normal.dot(normal));
+    if (length > 0.0f) {
+      normal = normal * (1.0f / length);
+    }
+    for (size_t corner = 0; corner < 9; corner += 3) {
+      out.normals[t + corner] = normal.x;
+      out.normals[t + corner + 1] = normal.y;
+      out.normals[t + corner + 2] = normal.z;
+    }
+  }
+}
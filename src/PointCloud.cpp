@@ -0,0 +1,112 @@
+#include "PointCloud.hpp"
+#include "ModelUtils.hpp"
+
+#include <algorithm>
+
+namespace {
+
+bool hasVertexBuffers() {
+  return GLEW_VERSION_1_5 || GLEW_ARB_vertex_buffer_object;
+}
+
+/**
+ * @brief The positions of `model` in a random order. Point clouds are
+ * shuffled on load and used as they are; mesh vertices (shown as points in
+ * POINT_CLOUD mode) keep their faces' order, so a shuffled copy of them is
+ * made in `shuffled`.
+ */
+const Vertex *pointOrder(const OBJModel &model, std::vector<Vertex> &shuffled) {
+  if (model.faces.empty()) {
+    shuffled = {};
+    return model.vertices.data();
+  }
+  OBJModel points;
+  points.vertices = model.vertices;
+  ModelUtilities::shufflePoints(points);
+  shuffled = std::move(points.vertices);
+  return shuffled.data();
+}
+
+} // end anonymous namespace
+
+PointCloudBuffer::PointCloudBuffer(const OBJModel &model)
+    : clientVertices_(nullptr), count_(model.vertices.size()),
+      capacity_(count_), runs_{0} {
+  clientVertices_ = pointOrder(model, shuffled_);
+  if (count_ == 0 || !hasVertexBuffers()) {
+    memory_ = MemoryTracker::Allocation(MemoryTag::DERIVED,
+                                        MemoryTracker::bytesOf(shuffled_));
+    return;
+  }
+  const size_t bytes = count_ * sizeof(Vertex);
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes),
+               clientVertices_, GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  memory_ = MemoryTracker::Allocation(MemoryTag::GPU_BUFFERS, bytes);
+  releaseShuffled();
+}
+
+PointCloudBuffer::~PointCloudBuffer() {
+  if (buffer_ != 0) {
+    glDeleteBuffers(1, &buffer_);
+  }
+}
+
+void PointCloudBuffer::update(const OBJModel &model, size_t firstVertex) {
+  count_ = model.vertices.size();
+  // Appended points are shuffled among themselves, so they start a run of
+  // their own. Mesh vertices are shuffled again as a whole.
+  firstVertex = model.faces.empty() ? std::min(firstVertex, count_) : 0;
+  if (firstVertex == 0) {
+    runs_.assign(1, 0);
+  } else if (firstVertex < count_) {
+    runs_.push_back(firstVertex);
+  }
+  clientVertices_ = pointOrder(model, shuffled_);
+  if (buffer_ == 0) {
+    memory_.resize(MemoryTracker::bytesOf(shuffled_));
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  if (count_ > capacity_) {
+    // Growing by half keeps repeated appends from copying every time.
+    capacity_ = std::max(count_, capacity_ + capacity_ / 2);
+    const size_t bytes = capacity_ * sizeof(Vertex);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr,
+                 GL_STATIC_DRAW);
+    memory_ = MemoryTracker::Allocation(MemoryTag::GPU_BUFFERS, bytes);
+    firstVertex = 0;
+  }
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  static_cast<GLintptr>(firstVertex * sizeof(Vertex)),
+                  static_cast<GLsizeiptr>((count_ - firstVertex) *
+                                          sizeof(Vertex)),
+                  clientVertices_ + firstVertex);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  releaseShuffled();
+}
+
+void PointCloudBuffer::releaseShuffled() {
+  // The buffer has its own copy.
+  if (!shuffled_.empty()) {
+    shuffled_ = {};
+    clientVertices_ = nullptr;
+  }
+}
+
+void PointCloudBuffer::bind() const {
+  if (buffer_ != 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+  } else {
+    glVertexPointer(3, GL_FLOAT, 0, clientVertices_);
+  }
+}
+
+void PointCloudBuffer::unbind() const {
+  if (buffer_ != 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
@@ -1,76 +1,142 @@
 #include "Renderer.hpp"
+#include "CompressedTexture.hpp"
 #include "MeshRenderer.hpp"
 #include "ModelUtils.hpp"
+#include "NormalGenerator.hpp"
 #include "OBJLoader.hpp"
-#include "TextureManager.hpp"
+#include "PagedMesh.hpp"
 
 #include <array>
 #include <cfloat>
 #include <cmath>
 #include <cstdio>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
 #include <random>
-#include <sstream>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 namespace {
 
-static bool g_flip42Loaded = false;
-static OBJModel g_flip42Model;
+constexpr const char *kFlip42Path = "objs/resources/flip42.obj";
+constexpr const char *kFlipSspinaPath = "objs/resources/flipSspina.obj";
 
-static bool g_flipSspinaLoaded = false;
-static OBJModel g_flipSspinaModel;
+// Fixed simulation rate of the update thread. Rotation speed is expressed in
+// degrees per tick, which matches the old per-frame behavior at 60 Hz.
+constexpr std::chrono::microseconds kUpdateInterval(1000000 / 60);
+
+// Longest simulation step after the update thread wakes from idle.
+constexpr float kMaxDeltaTime = 0.1f;
+
+// Smallest focus-mode camera distance, used for a single model.
+constexpr float kMinFramingDistance = 5.0f;
 
 /**
- * @brief Loads "objs/resources/flip42.obj" into a static OBJModel once and
- * returns it.
+ * @brief Loads a flip model from disk once and returns the shared render data.
  */
-OBJModel &getFlip42Model() {
-  if (!g_flip42Loaded) {
-    // std::cout << "Loading flip42.obj (static preload)\n";
-    OBJModel temp;
-    if (!OBJLoader::loadOBJ("objs/resources/flip42.obj", temp)) {
-      std::cerr << "Failed to load flip42.obj\n";
-    }
-    g_flip42Model = temp;
-    g_flip42Model.objectName = "objs/resources/flip42.obj";
-    g_flip42Loaded = true;
+std::shared_ptr<const RenderModel> loadFlipModel(const char *path) {
+  OBJModel temp;
+  if (!OBJLoader::loadOBJ(path, temp)) {
+    std::cerr << "Failed to load " << path << "\n";
   }
-  return g_flip42Model;
+  NormalGenerator::generateIfMissing(temp, ViewerOptions().creaseAngle);
+  temp.objectName = path;
+  return SceneLoader::makeRenderModel(std::move(temp));
+}
+
+bool isTexturePath(const std::string &path) {
+  return path.find(".bmp") != std::string::npos ||
+         CompressedTextureFile::isContainerPath(path);
 }
 
 /**
- * @brief Loads "objs/resources/flipSspina.obj" into a static OBJModel once and
- * returns it.
+ * @brief true for files SceneLoader can load: OBJ, PLY, STL (by extension
+ * or content) and page files.
  */
-OBJModel &getFlipSspinaModel() {
-  if (!g_flipSspinaLoaded) {
-    // std::cout << "Loading flipSspina.obj (static preload)\n";
-    OBJModel temp;
-    if (!OBJLoader::loadOBJ("objs/resources/flipSspina.obj", temp)) {
-      std::cerr << "Failed to load flipSspina.obj\n";
+bool isModelPath(const std::string &path) {
+  return !isTexturePath(path) &&
+         SceneLoader::formatOf(path) != ModelFormat::UNKNOWN;
+}
+
+/**
+ * @brief The mode a model is drawn in: models without faces are always
+ * point clouds.
+ */
+RenderMode effectiveMode(const RenderModel &renderModel, RenderMode mode) {
+  return renderModel.model.faces.empty() && !renderModel.pages
+             ? RenderMode::POINT_CLOUD
+             : mode;
+}
+
+/**
+ * @brief true if both material lists use the same texture maps, so a frame
+ * of a sequence can keep the textures of the one before.
+ */
+bool sameMaterialMaps(const std::vector<Material> &a,
+                      const std::vector<Material> &b) {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](const Material &x, const Material &y) {
+                      return x.diffuseMap == y.diffuseMap;
+                    });
+}
+
+/**
+ * @brief Returns "objs/resources/flip42.obj", loaded on first use.
+ */
+const std::shared_ptr<const RenderModel> &getFlip42Model() {
+  static const std::shared_ptr<const RenderModel> model =
+      loadFlipModel(kFlip42Path);
+  return model;
+}
+
+/**
+ * @brief Returns "objs/resources/flipSspina.obj", loaded on first use.
+ */
+const std::shared_ptr<const RenderModel> &getFlipSspinaModel() {
+  static const std::shared_ptr<const RenderModel> model =
+      loadFlipModel(kFlipSspinaPath);
+  return model;
+}
+
+/**
+ * @brief Loads both flip models if one of `nodes` shows either, so the
+ * update thread swaps them without reading files under stateMutex_.
+ */
+void preloadFlipModels(const std::vector<SceneNode> &nodes) {
+  for (const SceneNode &node : nodes) {
+    const std::string &name = node.model->model.objectName;
+    if (name == kFlip42Path || name == kFlipSspinaPath) {
+      getFlip42Model();
+      getFlipSspinaModel();
+      return;
     }
-    g_flipSspinaModel = temp;
-    g_flipSspinaModel.objectName = "objs/resources/flipSspina.obj";
-    g_flipSspinaLoaded = true;
   }
-  return g_flipSspinaModel;
 }
 
 } // end anonymous namespace
 
-Renderer::Renderer(GLFWwindow *window, int width, int height, OBJModel &model)
-    : window_(window), width_(width), height_(height), rotationAngle_(0.0f),
-      rotationSpeed_(0.5f), currentRenderMode_(RenderMode::GRAYSCALE),
-      textureID_(0), overlay_(width, height), isFreeCameraMode_(false),
-      lastFrameTime_(0.0), moveForward_(false), moveBackward_(false),
-      moveLeft_(false), moveRight_(false), moveUp_(false), moveDown_(false),
-      yawDelta_(0.0f), pitchDelta_(0.0f), transitioning_(false),
-      fadeOut_(false), transitionAlpha_(0.0f), transitionDuration_(0.25f),
-      transitionElapsed_(0.0f), lastDeltaTime_(0.0f), nextFlipAngle_(90.0f) {
+Renderer::Renderer(GLFWwindow *window, int width, int height,
+                   const std::vector<SceneEntry> &scene,
+                   const ViewerOptions &options)
+    : options_(options), sceneVersion_(0), window_(window), width_(width),
+      height_(height), rotationAngle_(0.0f), rotationSpeed_(0.5f),
+      currentRenderMode_(RenderMode::GRAYSCALE),
+      textureCache_(options.textureBudgetMB << 20, options.texture),
+      retiredVersion_(0), overlay_(width, height), isFreeCameraMode_(false),
+      moveForward_(false), moveBackward_(false), moveLeft_(false),
+      moveRight_(false), moveUp_(false), moveDown_(false), yawDelta_(0.0f),
+      pitchDelta_(0.0f), transitioning_(false), fadeOut_(false),
+      transitionAlpha_(0.0f), transitionDuration_(0.25f),
+      transitionElapsed_(0.0f), nextFlipAngle_(90.0f), stateDirty_(false),
+      running_(false), scheduler_(options.fpsCap), renderIdle_(false),
+      lastDrawCalls_(0), lastPointsDrawn_(0), lastPointsTotal_(0),
+      pagesLoading_(false), currentNode_(0), currentSubmesh_(0),
+      isolateSubmesh_(false), cullSubmeshes_(true), occlusionCulling_(true),
+      watcher_([] { glfwPostEmptyEvent(); }),
+      reloader_(options, [] { glfwPostEmptyEvent(); }),
+      selectedNode_(0), selectedFace_(-1),
+      lastPickMicros_(0.0) {
   if (!window_) {
     throw std::runtime_error("Renderer received a null GLFWwindow*!");
   }
@@ -88,8 +154,6 @@ Renderer::Renderer(GLFWwindow *window, int width, int height, OBJModel &model)
   camera_.nearZ = 0.1f;
   camera_.farZ = 100.0f;
 
-  modelTranslation_.setIdentity();
-
   // Save defaults for reset
   defaultEye_ = camera_.eye;
   defaultCenter_ = camera_.center;
@@ -102,18 +166,41 @@ Renderer::Renderer(GLFWwindow *window, int width, int height, OBJModel &model)
   glfwSetScrollCallback(window_, Renderer::scrollCallback);
   glfwSetKeyCallback(window_, Renderer::keyCallback);
   glfwSetDropCallback(window_, Renderer::dropCallback);
+  glfwSetMouseButtonCallback(window_, Renderer::mouseButtonCallback);
+  glfwSetWindowRefreshCallback(window_, Renderer::windowRefreshCallback);
+
+  // Nothing is on screen yet, so the first texture loads synchronously. It
+  // is the default for every node without its own; the others decode in
+  // parallel.
+  textureName_ = scene.at(0).texturePath;
+  std::cout << "Loading texture from file: " << textureName_ << std::endl;
+  useTexture(textureCache_.acquire(textureName_), textureName_);
+
+  std::vector<std::string> nodeTexturePaths(scene.size());
+  for (size_t i = 1; i < scene.size(); ++i) {
+    nodeTexturePaths[i] = scene[i].texturePath;
+  }
+  std::vector<TextureCache::Handle> nodeTextures =
+      textureCache_.acquireAll(nodeTexturePaths);
 
-  currentModel_ = model;
+  std::vector<SceneNode> nodes;
+  for (size_t i = 0; i < scene.size(); ++i) {
+    nodes.push_back({scene[i].model, std::move(nodeTextures[i]), Matrix4()});
+  }
+  setScene(std::move(nodes));
 
-  std::cout << "Loading texture from file: " << currentModel_.textureName
-            << std::endl;
-  loadTextureFromFile(currentModel_.textureName);
+  for (const SceneEntry &entry : scene) {
+    if (!entry.sequenceFrames.empty()) {
+      sequence_ = std::make_unique<SequencePlayer>(entry.sequenceFrames,
+                                                   entry.model, options_);
+      watchSceneFiles();
+    }
+  }
 }
 
 Renderer::~Renderer() {
-  if (textureID_ != 0) {
-    glDeleteTextures(1, &textureID_);
-  }
+  stopUpdateThread();
+  sequence_.reset();
 }
 
 void Renderer::initializeGL() {
@@ -128,138 +215,151 @@ void Renderer::initializeGL() {
 }
 
 void Renderer::run() {
-  auto &model = currentModel_;
+  // Publish an initial snapshot so the first frame has something to draw.
+  writeFrameState(frames_.writeBuffer());
+  frames_.publish();
+  frames_.acquire();
 
-  computeModelCenter(model);
-  buildFaceBasedColors(model);
-
-  lastFrameTime_ = glfwGetTime();
+  running_.store(true, std::memory_order_release);
+  updateThread_ = std::thread(&Renderer::updateLoop, this);
 
   while (!glfwWindowShouldClose(window_)) {
-    double currentTime = glfwGetTime();
-    float deltaTime = static_cast<float>(currentTime - lastFrameTime_);
-    lastDeltaTime_ = deltaTime;
-    lastFrameTime_ = currentTime;
-
-    if (isFreeCameraMode_) {
-      handleFreeCameraMovement(deltaTime);
-      handleFreeCameraRotation(deltaTime);
+    // A dropped texture decodes on a worker and uploads a slice per frame;
+    // the old one stays bound until it is complete.
+    if (textureCache_.streaming()) {
+      if (TextureCache::Handle streamed = textureCache_.pollStream()) {
+        useTexture(std::move(streamed), textureName_);
+        scheduler_.requestRedraw();
+      }
     }
 
-    renderFrame(currentModel_);
-    glfwSwapBuffers(window_);
-    glfwPollEvents();
+    // Sequence frames are swapped in between frames, once decoded.
+    if (sequence_) {
+      advanceSequence();
+    }
+    // So are models and textures reloaded after their files changed.
+    processFileChanges();
+
+    // Never wait on the update thread: draw whatever is newest, and only
+    // when something actually changed.
+    bool newSnapshot = frames_.acquire();
+    if ((!retiredTextures_.empty() || !retiredPointBuffers_.empty()) &&
+        frames_.readBuffer().sceneVersion == retiredVersion_) {
+      // No frame that can still be drawn binds them any more.
+      retiredTextures_.clear();
+      retiredPointBuffers_.clear();
+      textureCache_.trim();
+    }
+    if (scheduler_.shouldRender(newSnapshot)) {
+      const FrameState &frame = frames_.readBuffer();
+      allocationGuard_.beginFrame();
+      // Stay active while streaming so uploads keep advancing at frame pace.
+      scheduler_.beginFrame(frame.animating || textureCache_.streaming() ||
+                            pagesLoading_ || sequence_ != nullptr);
+      renderIdle_.store(scheduler_.isIdle(), std::memory_order_release);
+      renderFrame(frame);
+      glfwSwapBuffers(window_);
+      allocationGuard_.endFrame();
+
+      if (options_.benchFrames > 0 &&
+          allocationGuard_.frameCount() >= options_.benchFrames) {
+        glfwSetWindowShouldClose(window_, GLFW_TRUE);
+      }
+    }
+    scheduler_.waitForNextFrame();
   }
+
+  stopUpdateThread();
+  allocationGuard_.printSummary(std::cout);
 }
 
-void Renderer::renderFrame(const OBJModel &model) {
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+bool Renderer::allocationCheckFailed() const {
+  return allocationGuard_.failed();
+}
 
-  // Setup projection matrix
-  glMatrixMode(GL_PROJECTION);
-  glLoadIdentity();
-  Matrix4 projectionMatrix = camera_.getProjectionMatrix();
-  glLoadMatrixf(projectionMatrix.m);
+void Renderer::stopUpdateThread() {
+  {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    running_.store(false, std::memory_order_release);
+  }
+  stateChanged_.notify_all();
+  if (updateThread_.joinable()) {
+    updateThread_.join();
+  }
+}
 
-  // Setup modelview matrix
-  glMatrixMode(GL_MODELVIEW);
-  glLoadIdentity();
-  Matrix4 viewMatrix = isFreeCameraMode_ ? camera_.getViewMatrix(true)
-                                         : camera_.getViewMatrix(false);
-  glLoadMatrixf(viewMatrix.m);
-
-  // Compute model transformation and draw model
-  if (!model.vertices.empty()) {
-    float minX = FLT_MAX, maxX = -FLT_MAX;
-    float minY = FLT_MAX, maxY = -FLT_MAX;
-    float minZ = FLT_MAX, maxZ = -FLT_MAX;
-    for (const auto &v : model.vertices) {
-      if (v.x < minX)
-        minX = v.x;
-      if (v.x > maxX)
-        maxX = v.x;
-      if (v.y < minY)
-        minY = v.y;
-      if (v.y > maxY)
-        maxY = v.y;
-      if (v.z < minZ)
-        minZ = v.z;
-      if (v.z > maxZ)
-        maxZ = v.z;
-    }
-
-    float sizeX = maxX - minX;
-    float sizeY = maxY - minY;
-    float sizeZ = maxZ - minZ;
-    float extent = std::max({sizeX, sizeY, sizeZ});
-    float desiredSize = 2.0f;
-    float scaleFactor = (extent > 1e-5f) ? (desiredSize / extent) : 1.0f;
-
-    Matrix4 scale;
-    scale.setIdentity();
-    scale.m[0] = scaleFactor;
-    scale.m[5] = scaleFactor;
-    scale.m[10] = scaleFactor;
-
-    Matrix4 rotation;
-    rotation.setIdentity();
+void Renderer::updateLoop() {
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point lastTick = Clock::now();
+  Clock::time_point nextTick = lastTick + kUpdateInterval;
+
+  while (running_.load(std::memory_order_acquire)) {
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    if (!isAnimating() && !stateDirty_) {
+      // Static scene: sleep until input changes something.
+      stateChanged_.wait(lock, [this] {
+        return stateDirty_ || !running_.load(std::memory_order_acquire);
+      });
+      lastTick = Clock::now();
+      nextTick = lastTick;
+    }
 
-    if (!isFreeCameraMode_) {
-      // Increase rotation each frame in Focus (classic) mode
-      rotationAngle_ += rotationSpeed_;
-
-      // Check if the current model is one of the two flip models
-      bool isFlip42 = (currentModel_.objectName == "objs/resources/flip42.obj");
-      bool isFlipSspina =
-          (currentModel_.objectName == "objs/resources/flipSspina.obj");
-
-      // 1. If rotationAngle_ >= nextFlipAngle_, do a flip
-      if (rotationAngle_ >= nextFlipAngle_ && (isFlip42 || isFlipSspina)) {
-        // Toggle the model
-        if (isFlip42) {
-          // Currently flip42 -> switch to flipSspina
-          OBJModel &newModel = getFlipSspinaModel();
-          newModel.textureName = currentModel_.textureName;
-          computeModelCenter(newModel);
-          buildFaceBasedColors(newModel);
-
-          currentModel_ = newModel;
-        } else {
-          // Currently flipSspina -> switch to flip42
-          OBJModel &newModel = getFlip42Model();
-          newModel.textureName = currentModel_.textureName;
-          computeModelCenter(newModel);
-          buildFaceBasedColors(newModel);
-
-          currentModel_ = newModel;
-        }
+    Clock::time_point now = Clock::now();
+    float deltaTime = std::min(
+        std::chrono::duration<float>(now - lastTick).count(), kMaxDeltaTime);
+    lastTick = now;
 
-        // 2. Increase nextFlipAngle_ by +180
-        nextFlipAngle_ += 180.0f;
-      }
+    stepSimulation(deltaTime);
+    stateDirty_ = false;
+    writeFrameState(frames_.writeBuffer());
+    lock.unlock();
 
-      // Convert rotationAngle_ to radians and build rotation matrix
-      float radians = rotationAngle_ * 3.1415926535f / 180.0f;
-      rotation.m[0] = cosf(radians);
-      rotation.m[2] = sinf(radians);
-      rotation.m[8] = -sinf(radians);
-      rotation.m[10] = cosf(radians);
+    frames_.publish();
+    if (renderIdle_.load(std::memory_order_acquire)) {
+      // The render thread is blocked waiting for events; wake it up.
+      glfwPostEmptyEvent();
     }
 
-    Matrix4 scaledMatrix = Matrix4::multiply(scale, modelTranslation_);
-    Matrix4 modelMatrix = Matrix4::multiply(rotation, scaledMatrix);
-    Matrix4 modelViewMatrix = Matrix4::multiply(viewMatrix, modelMatrix);
+    std::this_thread::sleep_until(nextTick);
+    nextTick += kUpdateInterval;
+    if (nextTick < Clock::now()) {
+      // Fell behind (e.g. the machine was busy); don't try to catch up.
+      nextTick = Clock::now() + kUpdateInterval;
+    }
+  }
+}
 
-    glLoadMatrixf(modelViewMatrix.m);
+void Renderer::stepSimulation(float deltaTime) {
+  if (isFreeCameraMode_) {
+    handleFreeCameraMovement(deltaTime);
+    handleFreeCameraRotation(deltaTime);
   } else {
-    glLoadMatrixf(viewMatrix.m);
+    // Increase rotation each tick in Focus (classic) mode
+    rotationAngle_ += rotationSpeed_;
+
+    // If rotationAngle_ >= nextFlipAngle_, swap every node showing one of
+    // the two flip models to the other one
+    if (rotationAngle_ >= nextFlipAngle_) {
+      bool flipped = false;
+      for (SceneNode &node : nodes_) {
+        const std::string &name = node.model->model.objectName;
+        bool isFlip42 = (name == kFlip42Path);
+        bool isFlipSspina = (name == kFlipSspinaPath);
+        if (isFlip42 || isFlipSspina) {
+          node.model = isFlip42 ? getFlipSspinaModel() : getFlip42Model();
+          flipped = true;
+        }
+      }
+      if (flipped) {
+        nextFlipAngle_ += 180.0f;
+      }
+    }
   }
 
-  drawAllFaces(model);
-
-  // Handle fade transition overlay if transitioning
+  // Advance the fade transition for smooth mode changes
   if (transitioning_) {
-    transitionElapsed_ += lastDeltaTime_;
+    transitionElapsed_ += deltaTime;
     float progress = transitionElapsed_ / transitionDuration_;
     if (progress > 1.0f)
       progress = 1.0f;
@@ -278,76 +378,442 @@ void Renderer::renderFrame(const OBJModel &model) {
         transitionAlpha_ = 0.0f;
       }
     }
+  }
+}
+
+bool Renderer::isAnimating() const {
+  if (transitioning_) {
+    return true;
+  }
+  if (isFreeCameraMode_) {
+    return moveForward_ || moveBackward_ || moveLeft_ || moveRight_ ||
+           moveUp_ || moveDown_ || yawDelta_ != 0.0f || pitchDelta_ != 0.0f;
+  }
+  return rotationSpeed_ > 0.0f;
+}
+
+void Renderer::markStateDirty() {
+  // Caller holds stateMutex_.
+  stateDirty_ = true;
+  stateChanged_.notify_one();
+}
+
+void Renderer::writeFrameState(FrameState &frame) const {
+  frame.camera = camera_;
+  frame.projection = camera_.getProjectionMatrix();
+  frame.view = camera_.getViewMatrix(isFreeCameraMode_);
+  // Only grows the node array when the scene does; steady ticks just copy.
+  frame.nodes.resize(nodes_.size());
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const SceneNode &node = nodes_[i];
+    frame.nodes[i].model = node.model;
+    frame.nodes[i].modelMatrix = computeModelMatrix(node);
+    frame.nodes[i].texture = node.texture ? node.texture->id : 0;
+  }
+  frame.sceneVersion = sceneVersion_;
+  frame.renderMode = currentRenderMode_;
+  frame.transitioning = transitioning_;
+  frame.transitionAlpha = transitionAlpha_;
+  frame.rotationSpeed = rotationSpeed_;
+  frame.freeCameraMode = isFreeCameraMode_;
+  frame.animating = isAnimating();
+}
+
+Matrix4 Renderer::computeModelMatrix(const SceneNode &node) const {
+  const RenderModel &renderModel = *node.model;
+  if (renderModel.model.vertices.empty() && !renderModel.pages) {
+    return node.placement;
+  }
+
+  // Bounds are cached in the RenderModel; nothing here walks the vertices.
+  float scaleFactor = renderModel.scaleFactor;
+
+  Matrix4 scale;
+  scale.setIdentity();
+  scale.m[0] = scaleFactor;
+  scale.m[5] = scaleFactor;
+  scale.m[10] = scaleFactor;
+
+  Matrix4 rotation;
+  rotation.setIdentity();
+
+  if (!isFreeCameraMode_) {
+    // Convert rotationAngle_ to radians and build rotation matrix
+    float radians = rotationAngle_ * 3.1415926535f / 180.0f;
+    rotation.m[0] = cosf(radians);
+    rotation.m[2] = sinf(radians);
+    rotation.m[8] = -sinf(radians);
+    rotation.m[10] = cosf(radians);
+  }
+
+  // The whole scene turns around the origin in Focus mode
+  Matrix4 scaledMatrix = Matrix4::multiply(scale, renderModel.translation);
+  Matrix4 placed = Matrix4::multiply(node.placement, scaledMatrix);
+  return Matrix4::multiply(rotation, placed);
+}
+
+void Renderer::renderFrame(const FrameState &frame) {
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  // Setup projection matrix
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  glLoadMatrixf(frame.projection.m);
+
+  glMatrixMode(GL_MODELVIEW);
+  if (currentNode_ >= frame.nodes.size()) {
+    currentNode_ = 0;
+  }
+  const GLuint defaultTexture = texture_ ? texture_->id : 0;
+  lastDrawCalls_ = 0;
+  pagesLoading_ = false;
+
+  // Submesh states of every mesh node first (hidden, outside the frustum),
+  // then the occlusion worker marks the parts hidden behind others. The
+  // point budget is shared by every point cloud in the scene, in proportion
+  // to their sizes.
+  lastPointsTotal_ = 0;
+  lastPointsDrawn_ = 0;
+  nodeStates_.resize(frame.nodes.size());
+  occlusionItems_.clear();
+  for (size_t i = 0; i < frame.nodes.size(); ++i) {
+    const FrameNode &node = frame.nodes[i];
+    const RenderModel &renderModel = *node.model;
+    nodeStates_[i].clear();
+    if (renderModel.pages) {
+      continue;
+    }
+    if (effectiveMode(renderModel, frame.renderMode) ==
+        RenderMode::POINT_CLOUD) {
+      lastPointsTotal_ += renderModel.model.vertices.size();
+      continue;
+    }
+    Matrix4 clipFromObject = Matrix4::multiply(
+        frame.projection, Matrix4::multiply(frame.view, node.modelMatrix));
+    updateSubmeshState(node.model, clipFromObject, i == currentNode_,
+                       nodeStates_[i]);
+    if (occlusionCulling_) {
+      OcclusionItem item;
+      item.batches = &renderModel.batches;
+      item.occluders = &renderModel.occluders;
+      item.clipFromObject = clipFromObject;
+      item.state = &nodeStates_[i];
+      occlusionItems_.push_back(item);
+    }
+  }
+  if (!occlusionItems_.empty()) {
+    occlusion_.submit(occlusionItems_);
+  }
+
+  // Paged meshes and point clouds don't need the states: draw them while
+  // the occlusion pass runs. Then each mesh's arrays are bound once, and
+  // every node placing it is drawn with its own modelview matrix.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t first = 0; first < frame.nodes.size();) {
+      const std::shared_ptr<const RenderModel> &model =
+          frame.nodes[first].model;
+      size_t end = first + 1;
+      while (end < frame.nodes.size() && frame.nodes[end].model == model) {
+        ++end;
+      }
+      const RenderModel &renderModel = *model;
+      const bool points = effectiveMode(renderModel, frame.renderMode) ==
+                          RenderMode::POINT_CLOUD;
+      if (pass == 0 && renderModel.pages) {
+        drawPagedNodes(frame, first, end);
+      } else if (pass == 0 && points && !renderModel.pages) {
+        drawPointNodes(frame, first, end);
+      } else if (pass == 1 && !renderModel.pages && !points) {
+        drawMeshNodes(frame, first, end, defaultTexture);
+      }
+      first = end;
+    }
+    if (pass == 0 && !occlusionItems_.empty()) {
+      occlusion_.wait();
+    }
+  }
 
-    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0, width_, 0, height_, -1, 1);
-
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-
-    glColor4f(0.0f, 0.0f, 0.0f, transitionAlpha_);
-    glBegin(GL_QUADS);
-    glVertex2f(0, 0);
-    glVertex2f(width_, 0);
-    glVertex2f(width_, height_);
-    glVertex2f(0, height_);
-    glEnd();
-
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
-    glPopAttrib();
-    glMatrixMode(GL_MODELVIEW);
-  }
-
-  // Render camera and mode info overlay
-  std::stringstream cameraInfoStream;
-  cameraInfoStream << std::fixed << std::setprecision(2) << "Camera Eye: ("
-                   << camera_.eye.x << ", " << camera_.eye.y << ", "
-                   << camera_.eye.z << ")\n"
-                   << "Camera Center: (" << camera_.center.x << ", "
-                   << camera_.center.y << ", " << camera_.center.z << ")\n"
-                   << "Camera Up: (" << camera_.up.x << ", " << camera_.up.y
-                   << ", " << camera_.up.z << ")\n"
-                   << "FOV: " << camera_.fovy << " deg\n"
-                   << "Rotation Speed: " << rotationSpeed_ << " deg/frame";
-
-  std::string cameraInfo = cameraInfoStream.str();
-  overlay_.render(cameraInfo, static_cast<int>(currentRenderMode_),
-                  static_cast<int>(RenderMode::COUNT), model);
+  // A selection only applies to the node and model it was picked on
+  const std::shared_ptr<const RenderModel> selectedModel =
+      selectedModel_.lock();
+  int selectedFace = -1;
+  if (selectedModel && selectedNode_ < frame.nodes.size() &&
+      frame.nodes[selectedNode_].model == selectedModel) {
+    selectedFace = selectedFace_;
+  }
+  if (selectedFace >= 0) {
+    Matrix4 modelViewMatrix = Matrix4::multiply(
+        frame.view, frame.nodes[selectedNode_].modelMatrix);
+    glLoadMatrixf(modelViewMatrix.m);
+    MeshRenderer::drawFaceHighlight(selectedModel->model,
+                                    static_cast<size_t>(selectedFace));
+  }
+  const RenderModel &currentModel = *frame.nodes[currentNode_].model;
 
-  glfwSetMouseButtonCallback(window_, Renderer::mouseButtonCallback);
+  // Handle fade transition overlay if transitioning
+  if (frame.transitioning) {
+    drawTransitionOverlay(frame.transitionAlpha);
+  }
+
+  // Render camera and mode info overlay. Formatted into a fixed buffer so a
+  // steady frame never touches the heap.
+  const Camera &camera = frame.camera;
+  char cameraInfo[1024];
+  int length = std::snprintf(
+      cameraInfo, sizeof(cameraInfo),
+      "Camera Eye: (%.2f, %.2f, %.2f)\n"
+      "Camera Center: (%.2f, %.2f, %.2f)\n"
+      "Camera Up: (%.2f, %.2f, %.2f)\n"
+      "FOV: %.2f deg\n"
+      "Rotation Speed: %.2f deg/frame\n"
+      "Draw Calls: %zu (%zu nodes, %zu materials)\n"
+      "Loop: %s",
+      camera.eye.x, camera.eye.y, camera.eye.z, camera.center.x,
+      camera.center.y, camera.center.z, camera.up.x, camera.up.y, camera.up.z,
+      camera.fovy, frame.rotationSpeed, lastDrawCalls_, frame.nodes.size(),
+      currentModel.model.materials.size(), scheduler_.modeName());
+  if (lastPointsTotal_ > 0 && length > 0 &&
+      static_cast<size_t>(length) < sizeof(cameraInfo)) {
+    length += std::snprintf(cameraInfo + length, sizeof(cameraInfo) - length,
+                            "\nPoints: %zu / %zu", lastPointsDrawn_,
+                            lastPointsTotal_);
+  }
+  if (!currentModel.batches.quantized.empty() && length > 0 &&
+      static_cast<size_t>(length) < sizeof(cameraInfo)) {
+    const QuantizedVertices &quantized = currentModel.batches.quantized;
+    length += std::snprintf(
+        cameraInfo + length, sizeof(cameraInfo) - length,
+        "\nVertices: quantized, %.1f MiB (%.1f MiB as floats)",
+        quantized.memoryBytes() / (1024.0 * 1024.0),
+        quantized.floatBytes / (1024.0 * 1024.0));
+  }
+  if (!occlusionItems_.empty() && length > 0 &&
+      static_cast<size_t>(length) < sizeof(cameraInfo)) {
+    const OcclusionStats &occlusion = occlusion_.stats();
+    length += std::snprintf(
+        cameraInfo + length, sizeof(cameraInfo) - length,
+        "\nOcclusion: %zu / %zu parts culled (%zu occluder tris, %.2f ms)",
+        occlusion.occluded, occlusion.tested, occlusion.occluderTriangles,
+        occlusion.micros / 1000.0);
+  }
+  if (currentModel.pages && length > 0 &&
+      static_cast<size_t>(length) < sizeof(cameraInfo)) {
+    const PagedMesh &pages = *currentModel.pages;
+    length += std::snprintf(
+        cameraInfo + length, sizeof(cameraInfo) - length,
+        "\nPages: %zu / %zu resident (%.1f / %.1f MiB)",
+        pages.residentPages(), pages.pages().size(),
+        pages.residentBytes() / (1024.0 * 1024.0),
+        pages.budgetBytes() / (1024.0 * 1024.0));
+  }
+  if (sequence_ && length > 0 &&
+      static_cast<size_t>(length) < sizeof(cameraInfo)) {
+    // One cell per prefetch slot, '#' once decoded
+    const SequenceStats sequence = sequence_->stats();
+    char depth[33];
+    const size_t cells = std::min(sequence.depth, sizeof(depth) - 1);
+    for (size_t i = 0; i < cells; ++i) {
+      depth[i] = i < sequence.prefetched ? '#' : '.';
+    }
+    depth[cells] = '\0';
+    length += std::snprintf(
+        cameraInfo + length, sizeof(cameraInfo) - length,
+        "\nSequence: frame %zu / %zu at %.0f fps, %zu dropped\n"
+        "Prefetch: [%s] %zu / %zu (%.1f ms/frame, %zu / %zu reused)",
+        sequence.frame + 1, sequence.frameCount, options_.sequenceFps,
+        sequence.dropped, depth, sequence.prefetched, sequence.depth,
+        sequence.decodeMillis, sequence.reused, sequence.decoded);
+  }
+  if (scheduler_.fpsCap() > 0.0 && length > 0 &&
+      static_cast<size_t>(length) < sizeof(cameraInfo)) {
+    std::snprintf(cameraInfo + length, sizeof(cameraInfo) - length,
+                  " (cap %.0f fps)", scheduler_.fpsCap());
+  }
+
+  const RenderMode currentMode = effectiveMode(currentModel, frame.renderMode);
+  overlay_.render(cameraInfo, static_cast<int>(currentMode),
+                  static_cast<int>(RenderMode::COUNT), currentModel.model,
+                  textureName_, selectedNode_ == currentNode_ ? selectedFace : -1,
+                  lastPickMicros_, nodeStates_[currentNode_],
+                  currentSubmesh_);
+}
+
+void Renderer::drawMeshNodes(const FrameState &frame, size_t first,
+                             size_t end, GLuint defaultTexture) {
+  const RenderModel &renderModel = *frame.nodes[first].model;
+  const std::vector<GLuint> &materialTextures =
+      materialTextureIds(renderModel);
+  MeshRenderer::bindBatches(renderModel.batches, frame.renderMode);
+  for (size_t i = first; i < end; ++i) {
+    const FrameNode &node = frame.nodes[i];
+    Matrix4 modelViewMatrix = Matrix4::multiply(frame.view, node.modelMatrix);
+    glLoadMatrixf(modelViewMatrix.m);
+    lastDrawCalls_ += MeshRenderer::drawBatches(
+        renderModel.batches, renderModel.model.materials, frame.renderMode,
+        node.texture ? node.texture : defaultTexture, materialTextures,
+        nodeStates_[i]);
+  }
+  MeshRenderer::unbindBatches(frame.renderMode);
+}
+
+void Renderer::drawPagedNodes(const FrameState &frame, size_t first,
+                              size_t end) {
+  const PagedMesh &mesh = *frame.nodes[first].model->pages;
+  for (size_t i = first; i < end; ++i) {
+    const FrameNode &node = frame.nodes[i];
+    Matrix4 modelViewMatrix = Matrix4::multiply(frame.view, node.modelMatrix);
+    glLoadMatrixf(modelViewMatrix.m);
+
+    // Residency follows the first node placing the mesh; the others draw
+    // whatever that view made resident.
+    if (i == first) {
+      Matrix4 objectFromEye;
+      if (modelViewMatrix.inverse(objectFromEye)) {
+        Frustum frustum = BoundingVolumes::computeFrustum(
+            Matrix4::multiply(frame.projection, modelViewMatrix));
+        node.model->pages->update(frustum,
+                                  objectFromEye.transform(Vector3(0, 0, 0)));
+      }
+    }
+    lastDrawCalls_ += MeshRenderer::drawPagedMesh(mesh, frame.renderMode);
+  }
+  pagesLoading_ = pagesLoading_ || mesh.loading();
+}
+
+void Renderer::drawPointNodes(const FrameState &frame, size_t first,
+                              size_t end) {
+  const std::shared_ptr<const RenderModel> &model = frame.nodes[first].model;
+  const PointCloudBuffer &points = pointBuffer(model);
+  size_t budget = 0;
+  if (options_.pointBudget > 0 && lastPointsTotal_ > options_.pointBudget) {
+    budget = std::max<size_t>(
+        1, static_cast<size_t>(static_cast<double>(options_.pointBudget) *
+                               points.pointCount() / lastPointsTotal_));
+  }
+  for (size_t i = first; i < end; ++i) {
+    Matrix4 modelViewMatrix =
+        Matrix4::multiply(frame.view, frame.nodes[i].modelMatrix);
+    glLoadMatrixf(modelViewMatrix.m);
+    size_t drawCalls = 0;
+    lastPointsDrawn_ += MeshRenderer::drawPoints(points, budget, drawCalls);
+    lastDrawCalls_ += drawCalls;
+  }
+}
+
+const PointCloudBuffer &
+Renderer::pointBuffer(const std::shared_ptr<const RenderModel> &model) {
+  PointBuffer &entry = pointBuffers_[model.get()];
+  if (!entry.buffer) {
+    // Uploaded on first use, so meshes only pay for it in POINT_CLOUD mode.
+    entry.model = model;
+    entry.buffer = std::make_unique<PointCloudBuffer>(model->model);
+  }
+  return *entry.buffer;
 }
 
-void Renderer::drawAllFaces(const OBJModel &model) {
-  MeshRenderer::drawAllFaces(model, currentRenderMode_, textureID_,
-                             faceGrayColors_, faceRandomColors_,
-                             faceMaterialColors_);
+void Renderer::updateSubmeshState(
+    const std::shared_ptr<const RenderModel> &model,
+    const Matrix4 &clipFromObject, bool currentNode,
+    std::vector<unsigned char> &state) {
+  const DrawBatches &batches = model->batches;
+  const size_t count = batches.submeshes.size();
+  if (currentNode && model != submeshModel_) {
+    submeshModel_ = model;
+    submeshHidden_.assign(count, 0);
+    currentSubmesh_ = 0;
+    isolateSubmesh_ = false;
+  }
+
+  // Capacity only grows, so steady frames never allocate here.
+  state.resize(count);
+  const Frustum frustum = BoundingVolumes::computeFrustum(clipFromObject);
+  for (size_t i = 0; i < count; ++i) {
+    bool hidden =
+        currentNode &&
+        (submeshHidden_[i] ||
+         (isolateSubmesh_ && static_cast<int>(i) != currentSubmesh_));
+    unsigned char bits = hidden ? SubmeshState::HIDDEN : 0;
+    if (!hidden && cullSubmeshes_ &&
+        !BoundingVolumes::intersects(frustum, batches.submeshes[i].bounds)) {
+      bits = SubmeshState::CULLED;
+    }
+    state[i] = bits;
+  }
 }
 
-void Renderer::computeModelCenter(const OBJModel &model) {
-  if (model.vertices.empty()) {
+void Renderer::onSubmeshKey(int key) {
+  const size_t count = submeshHidden_.size();
+  if (key == GLFW_KEY_C) {
+    cullSubmeshes_ = !cullSubmeshes_;
+    std::cout << "Submesh frustum culling "
+              << (cullSubmeshes_ ? "enabled" : "disabled") << ".\n";
+    return;
+  }
+  if (key == GLFW_KEY_O) {
+    occlusionCulling_ = !occlusionCulling_;
+    std::cout << "Occlusion culling "
+              << (occlusionCulling_ ? "enabled" : "disabled") << ".\n";
+    return;
+  }
+  if (count == 0 || !submeshModel_) {
+    return;
+  }
+  const std::vector<Submesh> &submeshes = submeshModel_->model.submeshes;
+  const size_t current = static_cast<size_t>(currentSubmesh_);
+  switch (key) {
+  case GLFW_KEY_RIGHT_BRACKET:
+    currentSubmesh_ = static_cast<int>((current + 1) % count);
+    break;
+  case GLFW_KEY_LEFT_BRACKET:
+    currentSubmesh_ = static_cast<int>((current + count - 1) % count);
+    break;
+  case GLFW_KEY_H:
+    submeshHidden_[current] = !submeshHidden_[current];
+    break;
+  case GLFW_KEY_I:
+    isolateSubmesh_ = !isolateSubmesh_;
+    break;
+  case GLFW_KEY_U:
+    std::fill(submeshHidden_.begin(), submeshHidden_.end(), 0);
+    isolateSubmesh_ = false;
+    break;
+  default:
     return;
   }
-  float cx, cy, cz;
-  ModelUtilities::computeModelCenter(model, cx, cy, cz);
-  modelTranslation_.setIdentity();
-  modelTranslation_.m[12] = -cx;
-  modelTranslation_.m[13] = -cy;
-  modelTranslation_.m[14] = -cz;
+  std::cout << "Part " << currentSubmesh_ + 1 << "/" << count << ": "
+            << submeshes[currentSubmesh_].name
+            << (submeshHidden_[currentSubmesh_] ? " (hidden)" : "")
+            << (isolateSubmesh_ ? " (isolated)" : "") << "\n";
 }
 
-void Renderer::buildFaceBasedColors(const OBJModel &model) {
-  ModelUtilities::buildFaceBasedColors(model, faceGrayColors_,
-                                       faceRandomColors_, faceMaterialColors_);
+void Renderer::drawTransitionOverlay(float alpha) {
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  glMatrixMode(GL_PROJECTION);
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(0, width_, 0, height_, -1, 1);
+
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  glLoadIdentity();
+
+  glColor4f(0.0f, 0.0f, 0.0f, alpha);
+  glBegin(GL_QUADS);
+  glVertex2f(0, 0);
+  glVertex2f(width_, 0);
+  glVertex2f(width_, height_);
+  glVertex2f(0, height_);
+  glEnd();
+
+  glPopMatrix();
+  glMatrixMode(GL_PROJECTION);
+  glPopMatrix();
+  glPopAttrib();
+  glMatrixMode(GL_MODELVIEW);
 }
 
 void Renderer::scrollCallback(GLFWwindow *window, double xoffset,
@@ -360,11 +826,13 @@ void Renderer::scrollCallback(GLFWwindow *window, double xoffset,
 }
 
 void Renderer::onScroll(double /*xoffset*/, double yoffset) {
+  std::lock_guard<std::mutex> lock(stateMutex_);
   camera_.fovy -= static_cast<float>(yoffset);
   if (camera_.fovy < 1.0f)
     camera_.fovy = 1.0f;
   if (camera_.fovy > 150.0f)
     camera_.fovy = 150.0f;
+  markStateDirty();
 }
 
 void Renderer::keyCallback(GLFWwindow *window, int key, int scancode,
@@ -377,6 +845,8 @@ void Renderer::keyCallback(GLFWwindow *window, int key, int scancode,
 }
 
 void Renderer::onKey(int key, int /*scancode*/, int action, int /*mods*/) {
+  std::lock_guard<std::mutex> lock(stateMutex_);
+  markStateDirty();
   if (action == GLFW_PRESS || action == GLFW_REPEAT) {
     switch (key) {
     case GLFW_KEY_F:
@@ -404,6 +874,16 @@ void Renderer::onKey(int key, int /*scancode*/, int action, int /*mods*/) {
       resetToDefaults();
       break;
 
+    case GLFW_KEY_LEFT_BRACKET:
+    case GLFW_KEY_RIGHT_BRACKET:
+    case GLFW_KEY_H:
+    case GLFW_KEY_I:
+    case GLFW_KEY_U:
+    case GLFW_KEY_C:
+    case GLFW_KEY_O:
+      onSubmeshKey(key);
+      break;
+
     case GLFW_KEY_T:
       if (!transitioning_) {
         int next = static_cast<int>(currentRenderMode_) + 1;
@@ -504,7 +984,7 @@ void Renderer::onKey(int key, int /*scancode*/, int action, int /*mods*/) {
 }
 
 void Renderer::resetToDefaults() {
-  // Reset camera parameters
+  // Caller holds stateMutex_. Reset camera parameters
   camera_.eye = defaultEye_;
   camera_.center = defaultCenter_;
   camera_.up = defaultUp_;
@@ -531,47 +1011,463 @@ void Renderer::onDrop(int count, const char **paths) {
   std::string droppedFile = paths[0];
   std::cout << "Dropped file: " << droppedFile << std::endl;
 
-  if (droppedFile.find(".bmp") != std::string::npos) {
+  // With Shift held, every dropped model is added to the scene instead of
+  // replacing it.
+  if (glfwGetKey(window_, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ||
+      glfwGetKey(window_, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS) {
+    std::vector<std::string> modelPaths;
+    for (int i = 0; i < count; ++i) {
+      std::string path = paths[i];
+      if (isModelPath(path)) {
+        modelPaths.push_back(path);
+      }
+    }
+    if (!modelPaths.empty()) {
+      addModelsToScene(modelPaths);
+      return;
+    }
+  }
+
+  if (SequencePlayer::isSequencePath(droppedFile)) {
+    playSequence(droppedFile);
+  } else if (isTexturePath(droppedFile)) {
     loadTextureFromFile(droppedFile);
-    currentModel_.textureName = droppedFile;
-  } else if (droppedFile.find(".obj") != std::string::npos) {
+    textureName_ = droppedFile;
+    watchSceneFiles();
+    scheduler_.requestRedraw();
+  } else if (isModelPath(droppedFile)) {
     loadModelFromFile(droppedFile);
-    currentModel_.objectName = droppedFile;
   }
 }
 
 void Renderer::loadTextureFromFile(const std::string &filePath) {
   std::cout << "Attempting to load texture: " << filePath << std::endl;
-  GLuint newTexture = TextureManager::loadBMPTexture(filePath);
-
-  if (newTexture == 0) {
-    std::cerr << "Failed to load texture. Generating white fallback texture.\n";
-    newTexture = TextureManager::generateWhiteTexture(64, 64);
+  TextureCache::Handle cached = textureCache_.request(filePath);
+  if (cached) {
+    useTexture(std::move(cached), filePath);
+    return;
   }
+  std::cout << "Streaming texture in the background: " << filePath
+            << std::endl;
+}
 
-  if (textureID_ != 0) {
-    glDeleteTextures(1, &textureID_);
+void Renderer::useTexture(TextureCache::Handle newTexture,
+                          const std::string &filePath) {
+  if (textureCache_.isFallback(newTexture)) {
+    std::cerr << "Failed to load texture. Using white fallback texture.\n";
   }
-  textureID_ = newTexture;
 
-  std::cout << "Texture loaded successfully. Texture ID: " << textureID_
+  // The previous texture stays cached (idle) until the budget needs room.
+  texture_ = std::move(newTexture);
+  textureCache_.trim();
+
+  std::cout << "Texture ready. Texture ID: " << texture_->id << " ("
+            << textureCache_.size() << " cached, "
+            << (textureCache_.residentBytes() >> 10) << " KiB resident)"
             << std::endl;
+  MemoryTracker::printReport(std::cout, "after loading " + filePath);
+}
+
+void Renderer::loadMaterialTextures(const std::vector<SceneNode> &nodes) {
+  // Collect the maps of every model not seen yet, to decode them together.
+  std::vector<const RenderModel *> added;
+  std::vector<std::string> maps;
+  size_t mapCount = 0;
+  for (const SceneNode &node : nodes) {
+    const RenderModel *key = node.model.get();
+    if (materialTextures_.count(key) != 0) {
+      continue;
+    }
+    MaterialTextures &entry = materialTextures_[key];
+    entry.model = node.model;
+    added.push_back(key);
+    for (const Material &material : node.model->model.materials) {
+      maps.push_back(material.diffuseMap);
+      mapCount += material.diffuseMap.empty() ? 0 : 1;
+    }
+  }
+  if (mapCount == 0) {
+    for (const RenderModel *key : added) {
+      materialTextures_[key].ids.assign(key->model.materials.size(), 0);
+    }
+    return;
+  }
+
+  std::cout << "Loading " << mapCount << " material texture(s)" << std::endl;
+  std::vector<TextureCache::Handle> textures = textureCache_.acquireAll(maps);
+  size_t next = 0;
+  for (const RenderModel *key : added) {
+    MaterialTextures &entry = materialTextures_[key];
+    const size_t count = key->model.materials.size();
+    entry.textures.assign(textures.begin() + next,
+                          textures.begin() + next + count);
+    entry.ids.assign(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+      if (entry.textures[i]) {
+        entry.ids[i] = entry.textures[i]->id;
+      }
+    }
+    next += count;
+  }
+}
+
+const std::vector<GLuint> &
+Renderer::materialTextureIds(const RenderModel &model) const {
+  static const std::vector<GLuint> noMaterialTextures;
+  auto it = materialTextures_.find(&model);
+  return it != materialTextures_.end() ? it->second.ids : noMaterialTextures;
+}
+
+void Renderer::setScene(std::vector<SceneNode> nodes) {
+  // Keep nodes that share a model adjacent, in order of first appearance,
+  // then lay them out on a grid.
+  std::unordered_map<const RenderModel *, size_t> firstUse;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    firstUse.emplace(nodes[i].model.get(), i);
+  }
+  std::stable_sort(nodes.begin(), nodes.end(),
+                   [&](const SceneNode &a, const SceneNode &b) {
+                     return firstUse.at(a.model.get()) <
+                            firstUse.at(b.model.get());
+                   });
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].placement = SceneLoader::gridPlacement(i, nodes.size());
+  }
+  loadMaterialTextures(nodes);
+  preloadFlipModels(nodes);
+
+  BoundingSphere bounds;
+  bounds.radius = SceneLoader::gridRadius(nodes.size());
+  float distance = std::max(
+      kMinFramingDistance,
+      ModelUtilities::computeFramingDistance(bounds, defaultFovy_));
+
+  // Only the swap happens under the lock; the update thread picks the new
+  // scene up on its next tick.
+  std::vector<SceneNode> previous;
+  {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    previous.swap(nodes_);
+    nodes_ = std::move(nodes);
+    ++sceneVersion_;
+    defaultEye_ = Vector3(0.0f, 0.0f, distance);
+    if (!isFreeCameraMode_) {
+      camera_.eye = defaultEye_;
+    }
+    markStateDirty();
+  }
+
+  // Frames already published may still bind the old textures; hold on to
+  // them until one of the new scene is drawn.
+  for (SceneNode &node : previous) {
+    if (node.texture) {
+      retiredTextures_.push_back(std::move(node.texture));
+    }
+  }
+  retireUnusedResources();
+  watchSceneFiles();
+}
+
+void Renderer::retireUnusedResources() {
+  // Resources of models no node shows any more; frames already published
+  // may still bind them, so they are kept until one of the current scene
+  // is drawn.
+  for (auto it = materialTextures_.begin(); it != materialTextures_.end();) {
+    bool used = std::any_of(nodes_.begin(), nodes_.end(),
+                            [&](const SceneNode &node) {
+                              return node.model.get() == it->first;
+                            });
+    if (used) {
+      ++it;
+      continue;
+    }
+    for (TextureCache::Handle &texture : it->second.textures) {
+      if (texture) {
+        retiredTextures_.push_back(std::move(texture));
+      }
+    }
+    it = materialTextures_.erase(it);
+  }
+  for (auto it = pointBuffers_.begin(); it != pointBuffers_.end();) {
+    bool used = std::any_of(nodes_.begin(), nodes_.end(),
+                            [&](const SceneNode &node) {
+                              return node.model.get() == it->first;
+                            });
+    if (used) {
+      ++it;
+      continue;
+    }
+    retiredPointBuffers_.push_back(std::move(it->second));
+    it = pointBuffers_.erase(it);
+  }
+  retiredVersion_ = sceneVersion_;
 }
 
 void Renderer::loadModelFromFile(const std::string &filePath) {
   std::cout << "Attempting to load model: " << filePath << std::endl;
-  OBJModel newModel;
-  bool isValid = OBJLoader::loadOBJ(filePath, newModel);
-  if (isValid) {
-    std::cout << "Model loaded successfully.\n";
-    computeModelCenter(newModel);
-    buildFaceBasedColors(newModel);
-    newModel.objectName = filePath;
-    newModel.textureName = currentModel_.textureName;
-    currentModel_ = newModel;
-  } else {
+  std::shared_ptr<const RenderModel> renderModel =
+      SceneLoader::loadModel(filePath, options_);
+  if (!renderModel) {
+    std::cerr << "Failed to load model.\n";
+    return;
+  }
+  std::cout << "Model loaded successfully.\n";
+
+  std::vector<SceneNode> nodes;
+  nodes.push_back({std::move(renderModel), nullptr, Matrix4()});
+  sequence_.reset();
+  setScene(std::move(nodes));
+  MemoryTracker::printReport(std::cout, "after loading " + filePath);
+}
+
+void Renderer::playSequence(const std::string &path) {
+  std::vector<std::string> frames = SequencePlayer::listFrames(path);
+  if (frames.size() < 2) {
+    std::cerr << "Sequence " << path << " needs at least two model files.\n";
+    return;
+  }
+  std::cout << "Loading sequence " << path << " (" << frames.size()
+            << " frames)" << std::endl;
+  std::shared_ptr<const RenderModel> first =
+      SceneLoader::loadModel(frames[0], options_);
+  if (!first) {
     std::cerr << "Failed to load model.\n";
+    return;
+  }
+
+  std::vector<SceneNode> nodes;
+  nodes.push_back({first, nullptr, Matrix4()});
+  sequence_.reset();
+  setScene(std::move(nodes));
+  sequence_ =
+      std::make_unique<SequencePlayer>(std::move(frames), first, options_);
+  watchSceneFiles();
+}
+
+void Renderer::advanceSequence() {
+  std::shared_ptr<const RenderModel> previous = sequence_->current();
+  std::shared_ptr<const RenderModel> next = sequence_->advance();
+  if (next) {
+    replaceModel(previous, next, false);
+  }
+}
+
+void Renderer::replaceModel(const std::shared_ptr<const RenderModel> &previous,
+                            const std::shared_ptr<const RenderModel> &next,
+                            bool appended) {
+  // The new model takes over what the previous one had on the GPU: point
+  // buffers only get the changed positions uploaded, and textures stay
+  // bound while the maps don't change.
+  auto points = pointBuffers_.find(previous.get());
+  if (points != pointBuffers_.end()) {
+    PointBuffer entry = std::move(points->second);
+    pointBuffers_.erase(points);
+    entry.buffer->update(next->model,
+                         appended ? previous->model.vertices.size() : 0);
+    entry.model = next;
+    pointBuffers_[next.get()] = std::move(entry);
+  }
+  auto textures = materialTextures_.find(previous.get());
+  if (textures != materialTextures_.end() &&
+      sameMaterialMaps(previous->model.materials, next->model.materials)) {
+    MaterialTextures entry = std::move(textures->second);
+    materialTextures_.erase(textures);
+    entry.model = next;
+    materialTextures_[next.get()] = std::move(entry);
+  }
+  // Hidden and isolated parts carry over while the parts are the same;
+  // appended parts start out visible.
+  if (submeshModel_ == previous) {
+    if (appended) {
+      submeshHidden_.resize(next->batches.submeshes.size(), 0);
+    }
+    if (next->batches.submeshes.size() == submeshHidden_.size()) {
+      submeshModel_ = next;
+    }
   }
+  // Appending keeps the face indices, so the picked face stays picked.
+  if (selectedModel_.lock() == previous) {
+    if (appended) {
+      selectedModel_ = next;
+    } else {
+      selectedModel_.reset();
+      selectedFace_ = -1;
+    }
+  }
+
+  std::vector<SceneNode> nodes;
+  {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    for (SceneNode &node : nodes_) {
+      if (node.model == previous) {
+        node.model = next;
+      }
+    }
+    ++sceneVersion_;
+    markStateDirty();
+    nodes = nodes_;
+  }
+  loadMaterialTextures(nodes);
+  retireUnusedResources();
+}
+
+void Renderer::watchSceneFiles() {
+  if (!options_.watchFiles) {
+    return;
+  }
+  std::vector<std::string> files = {textureName_};
+  for (const SceneNode &node : nodes_) {
+    // Sequence frames change by themselves, and page files are built
+    // offline; only their textures are watched.
+    if (!sequence_ && !node.model->pages) {
+      files.push_back(node.model->model.objectName);
+    }
+    if (node.texture) {
+      files.push_back(node.texture->path);
+    }
+    for (const Material &material : node.model->model.materials) {
+      files.push_back(material.diffuseMap);
+    }
+  }
+  watcher_.watch(files);
+}
+
+void Renderer::processFileChanges() {
+  for (const std::string &filePath : watcher_.takeChanged()) {
+    std::cout << "File changed: " << filePath << std::endl;
+    reloadChangedFile(filePath);
+  }
+
+  bool replaced = false;
+  for (const ModelReloader::Result &result : reloader_.takeFinished()) {
+    // The scene may have moved on while the file was reloading.
+    bool shown = std::any_of(nodes_.begin(), nodes_.end(),
+                             [&](const SceneNode &node) {
+                               return node.model == result.previous;
+                             });
+    if (shown) {
+      replaceModel(result.previous, result.model, result.appended);
+      replaced = true;
+    }
+  }
+  if (replaced) {
+    // The materials, and so the maps to watch, may have changed.
+    watchSceneFiles();
+    MemoryTracker::printReport(std::cout, "after reloading");
+  }
+}
+
+void Renderer::reloadChangedFile(const std::string &filePath) {
+  // Models: each distinct one loaded from the file reloads in the
+  // background and is swapped in by processFileChanges().
+  if (!sequence_) {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      const std::shared_ptr<const RenderModel> &model = nodes_[i].model;
+      if (!model->pages && model->model.objectName == filePath &&
+          (i == 0 || nodes_[i - 1].model != model)) {
+        reloader_.request(model);
+      }
+    }
+  }
+
+  // The default texture streams in like a dropped one.
+  if (filePath == textureName_) {
+    loadTextureFromFile(textureName_);
+  }
+
+  // Node textures: frames bind their IDs, so the old ones are retired.
+  bool nodeTexture = std::any_of(nodes_.begin(), nodes_.end(),
+                                 [&](const SceneNode &node) {
+                                   return node.texture &&
+                                          node.texture->path == filePath;
+                                 });
+  if (nodeTexture) {
+    TextureCache::Handle texture = textureCache_.acquire(filePath);
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    for (SceneNode &node : nodes_) {
+      if (node.texture && node.texture->path == filePath) {
+        retiredTextures_.push_back(std::move(node.texture));
+        node.texture = texture;
+      }
+    }
+    ++sceneVersion_;
+    retiredVersion_ = sceneVersion_;
+    markStateDirty();
+  }
+
+  // Material maps: looked up when drawing, so the models using the file
+  // just load their maps again.
+  bool maps = false;
+  for (auto it = materialTextures_.begin(); it != materialTextures_.end();) {
+    const std::vector<Material> &materials = it->second.model->model.materials;
+    bool uses = std::any_of(materials.begin(), materials.end(),
+                            [&](const Material &material) {
+                              return material.diffuseMap == filePath;
+                            });
+    if (!uses) {
+      ++it;
+      continue;
+    }
+    for (TextureCache::Handle &texture : it->second.textures) {
+      if (texture) {
+        retiredTextures_.push_back(std::move(texture));
+      }
+    }
+    it = materialTextures_.erase(it);
+    maps = true;
+  }
+  if (maps) {
+    loadMaterialTextures(nodes_);
+    retiredVersion_ = sceneVersion_;
+    scheduler_.requestRedraw();
+  }
+}
+
+void Renderer::addModelsToScene(const std::vector<std::string> &filePaths) {
+  std::vector<SceneNode> nodes;
+  {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    nodes = nodes_;
+  }
+
+  // Models already in the scene are placed again; the rest load in
+  // parallel.
+  std::vector<std::shared_ptr<const RenderModel>> models(filePaths.size());
+  std::vector<std::string> missing;
+  for (size_t i = 0; i < filePaths.size(); ++i) {
+    for (const SceneNode &node : nodes) {
+      if (node.model->model.objectName == filePaths[i]) {
+        models[i] = node.model;
+        break;
+      }
+    }
+    if (!models[i]) {
+      missing.push_back(filePaths[i]);
+    }
+  }
+  std::cout << "Adding " << filePaths.size() << " model(s) to the scene ("
+            << missing.size() << " to load)" << std::endl;
+  std::vector<std::shared_ptr<const RenderModel>> loaded =
+      SceneLoader::loadModels(missing, options_);
+
+  size_t added = 0;
+  for (size_t i = 0, next = 0; i < filePaths.size(); ++i) {
+    if (!models[i]) {
+      models[i] = loaded[next++];
+    }
+    if (!models[i]) {
+      std::cerr << "Failed to load model: " << filePaths[i] << "\n";
+      continue;
+    }
+    nodes.push_back({models[i], nullptr, Matrix4()});
+    ++added;
+  }
+  if (added == 0) {
+    return;
+  }
+  setScene(std::move(nodes));
+  std::cout << "Scene has " << nodes_.size() << " nodes." << std::endl;
+  MemoryTracker::printReport(std::cout, "after adding to the scene");
 }
 
 void Renderer::handleFreeCameraMovement(float deltaTime) {
@@ -606,6 +1502,14 @@ void Renderer::mouseButtonCallback(GLFWwindow *window, int button, int action,
   }
 }
 
+void Renderer::windowRefreshCallback(GLFWwindow *window) {
+  auto *renderer =
+      reinterpret_cast<Renderer *>(glfwGetWindowUserPointer(window));
+  if (renderer) {
+    renderer->scheduler_.requestRedraw();
+  }
+}
+
 void Renderer::onMouseButton(int button, int action, int mods) {
   static_cast<void>(mods);
   if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
@@ -623,6 +1527,76 @@ void Renderer::onMouseButton(int button, int action, int mods) {
     if (mouseX >= openX && mouseX <= (openX + openW) && clickY >= openY &&
         clickY <= (openY + openH)) {
       system("xdg-open ./objs");
+      return;
+    }
+
+    pickFace(rawMouseX, rawMouseY);
+    scheduler_.requestRedraw();
+  }
+}
+
+void Renderer::pickFace(double cursorX, double cursorY) {
+  auto start = std::chrono::steady_clock::now();
+
+  // Pick against exactly what is on screen: the last drawn snapshot. Every
+  // node's hit is a parameter along the same near-to-far segment, so the
+  // smallest one is the front-most across the scene.
+  const FrameState &frame = frames_.readBuffer();
+  float ndcX = 2.0f * static_cast<float>(cursorX) / width_ - 1.0f;
+  float ndcY = 1.0f - 2.0f * static_cast<float>(cursorY) / height_;
+  RayHit best;
+  size_t bestNode = 0;
+  for (size_t i = 0; i < frame.nodes.size(); ++i) {
+    const FrameNode &node = frame.nodes[i];
+    Matrix4 modelView = Matrix4::multiply(frame.view, node.modelMatrix);
+    Matrix4 mvp = Matrix4::multiply(frame.projection, modelView);
+    Matrix4 inverseMvp;
+    if (!node.model || !mvp.inverse(inverseMvp)) {
+      continue;
     }
+
+    // Unproject the cursor at the near and far planes into object space.
+    Vector3 nearPoint = inverseMvp.transform(Vector3(ndcX, ndcY, -1.0f));
+    Vector3 farPoint = inverseMvp.transform(Vector3(ndcX, ndcY, 1.0f));
+
+    // Only what was drawn can be picked.
+    const std::vector<Face> &faces = node.model->model.faces;
+    const std::vector<unsigned char> *state =
+        i < nodeStates_.size() &&
+                nodeStates_[i].size() == node.model->batches.submeshes.size()
+            ? &nodeStates_[i]
+            : nullptr;
+    RayHit hit = node.model->bvh.intersect(
+        nearPoint, farPoint - nearPoint, [&](size_t face) {
+          return !state || (*state)[faces[face].submesh] == 0;
+        });
+    if (hit.hit && (!best.hit || hit.distance < best.distance)) {
+      best = hit;
+      bestNode = i;
+    }
+  }
+  lastPickMicros_ = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  if (best.hit) {
+    const std::shared_ptr<const RenderModel> &model = frame.nodes[bestNode].model;
+    selectedModel_ = model;
+    selectedNode_ = bestNode;
+    selectedFace_ = static_cast<int>(best.faceIndex);
+    if (bestNode != currentNode_ || model != submeshModel_) {
+      // Part controls follow the picked node
+      currentNode_ = bestNode;
+      submeshModel_ = model;
+      submeshHidden_.assign(model->batches.submeshes.size(), 0);
+      isolateSubmesh_ = false;
+    }
+    currentSubmesh_ = model->model.faces[best.faceIndex].submesh;
+    std::cout << "Picked face "
+              << model->model.faces[best.faceIndex].fileIndex << " of node "
+              << bestNode << " in " << lastPickMicros_ << " us\n";
+  } else {
+    selectedModel_.reset();
+    selectedFace_ = -1;
   }
 }
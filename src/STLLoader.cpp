@@ -0,0 +1,215 @@
+#include "STLLoader.hpp"
+#include "MappedFile.hpp"
+#include "MemoryTracker.hpp"
+#include "ModelUtils.hpp"
+#include "Parallel.hpp"
+#include "VertexWelder.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Binary layout: an 80-byte header, a little-endian triangle count, then per
+// triangle a normal, three corners (12 floats) and 2 attribute bytes.
+constexpr size_t kHeaderSize = 80;
+constexpr size_t kTriangleSize = 50;
+constexpr size_t kTrianglesPerChunk = 65536;
+
+uint32_t loadU32(const unsigned char *p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+float loadFloat(const unsigned char *p) {
+  uint32_t bits = loadU32(p);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+const char *skipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+    ++p;
+  }
+  return p;
+}
+
+bool startsWith(const char *p, const char *end, const char *word) {
+  const size_t length = std::strlen(word);
+  return static_cast<size_t>(end - p) >= length &&
+         std::memcmp(p, word, length) == 0;
+}
+
+/**
+ * @brief true if the triangle count of the header is nonzero and its
+ * triangles fit in a file of `fileSize` bytes, leaving at most `maxPadding`
+ * bytes after them.
+ */
+bool binarySizeFits(const unsigned char *data, size_t size, size_t fileSize,
+                    size_t maxPadding) {
+  if (size < kHeaderSize + 4) {
+    return false;
+  }
+  const uint64_t count = loadU32(data + kHeaderSize);
+  const uint64_t needed = kHeaderSize + 4 + count * kTriangleSize;
+  return count != 0 && needed <= fileSize && fileSize - needed <= maxPadding;
+}
+
+/**
+ * @brief true if `data` reads as ASCII STL: "solid", then a "facet" within
+ * STLLoader::kMagicBytes. Many binary headers start with "solid" too.
+ */
+bool looksAscii(const unsigned char *data, size_t size) {
+  const char *text = reinterpret_cast<const char *>(data);
+  const char *end = text + std::min(size, STLLoader::kMagicBytes);
+  return startsWith(skipBlanks(text, end), end, "solid") &&
+         std::search(text, end, "facet", "facet" + 5) != end;
+}
+
+/**
+ * @brief true if a file known to be STL is binary: its triangles fit, with
+ * any padding after them, and it doesn't read as ASCII unless they fill
+ * the file exactly.
+ */
+bool isBinarySTL(const unsigned char *data, size_t fileSize) {
+  if (!binarySizeFits(data, fileSize, fileSize, SIZE_MAX)) {
+    return false;
+  }
+  const uint64_t count = loadU32(data + kHeaderSize);
+  return kHeaderSize + 4 + count * kTriangleSize == fileSize ||
+         !looksAscii(data, fileSize);
+}
+
+/**
+ * @brief Collects the corners of every facet of an ASCII STL file, three per
+ * triangle; loops with more than three vertices are fanned.
+ * @return false if a vertex line is malformed.
+ */
+bool readAscii(const char *p, const char *end, std::vector<Vertex> &corners) {
+  std::vector<Vertex> loop;
+  while (p < end) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+    p = skipBlanks(p, lineEnd);
+    if (startsWith(p, lineEnd, "vertex")) {
+      float xyz[3];
+      p += 6;
+      for (float &value : xyz) {
+        p = skipBlanks(p, lineEnd);
+        auto result = std::from_chars(p, lineEnd, value);
+        if (result.ec != std::errc()) {
+          return false;
+        }
+        p = result.ptr;
+      }
+      loop.push_back({xyz[0], xyz[1], xyz[2]});
+    } else if (startsWith(p, lineEnd, "endloop")) {
+      for (size_t i = 1; i + 1 < loop.size(); ++i) {
+        corners.insert(corners.end(), {loop[0], loop[i], loop[i + 1]});
+      }
+      loop.clear();
+    } else if (startsWith(p, lineEnd, "outer")) {
+      loop.clear();
+    }
+    p = lineEnd + 1;
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
+bool STLLoader::isSTLPath(const std::string &filePath) {
+  if (filePath.size() < 4) {
+    return false;
+  }
+  std::string extension = filePath.substr(filePath.size() - 4);
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return extension == ".stl";
+}
+
+bool STLLoader::hasSTLMagic(const unsigned char *data, size_t size,
+                            size_t fileSize) {
+  // Without the extension, only trust a binary count that leaves less than
+  // a triangle of padding, and files that can only be read one way.
+  const bool binary = binarySizeFits(data, size, fileSize, kTriangleSize - 1);
+  return binary != looksAscii(data, size);
+}
+
+bool STLLoader::loadSTL(const std::string &filePath, OBJModel &model) {
+  auto start = std::chrono::steady_clock::now();
+  MappedFile file;
+  if (!file.open(filePath)) {
+    return false;
+  }
+
+  // Binary files may also start with "solid" (see isBinarySTL()).
+  const bool binary = isBinarySTL(file.data(), file.size());
+  if (binary) {
+    const size_t count = loadU32(file.data() + kHeaderSize);
+    const unsigned char *triangles = file.data() + kHeaderSize + 4;
+    model.vertices.resize(count * 3);
+    Parallel::forRange(count, kTrianglesPerChunk, [&](size_t begin,
+                                                      size_t end) {
+      for (size_t t = begin; t < end; ++t) {
+        // Skip the facet normal
+        const unsigned char *p = triangles + t * kTriangleSize + 12;
+        for (size_t k = 0; k < 3; ++k, p += 12) {
+          model.vertices[t * 3 + k] = {loadFloat(p), loadFloat(p + 4),
+                                       loadFloat(p + 8)};
+        }
+      }
+    });
+  } else {
+    const char *text = reinterpret_cast<const char *>(file.data());
+    const char *textEnd = text + file.size();
+    if (!startsWith(skipBlanks(text, textEnd), textEnd, "solid") ||
+        !readAscii(text, textEnd, model.vertices)) {
+      std::cerr << "Error: " << filePath << " is not a valid STL file\n";
+      return false;
+    }
+  }
+  if (model.vertices.empty()) {
+    std::cerr << "Error: " << filePath << " has no triangles\n";
+    return false;
+  }
+
+  const size_t triangleCount = model.vertices.size() / 3;
+  model.faces.resize(triangleCount);
+  Parallel::forRange(triangleCount, kTrianglesPerChunk, [&](size_t begin,
+                                                            size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+      const int first = static_cast<int>(t * 3);
+      model.faces[t].fileIndex = t;
+      model.faces[t].vertices = {
+          {first, -1, -1}, {first + 1, -1, -1}, {first + 2, -1, -1}};
+    }
+  });
+  ModelUtilities::updateSubmeshRanges(model);
+
+  // Unwelded corners are the loader's peak.
+  MemoryTracker::Allocation staging(MemoryTag::LOADER,
+                                    MemoryTracker::bytesOf(model));
+
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Read " << (binary ? "binary" : "ASCII") << " STL: "
+            << triangleCount << " triangles in " << elapsed << " ms ("
+            << file.size() / (1024.0 * 1024.0) /
+                   std::max(elapsed / 1000.0, 1e-6)
+            << " MiB/s)\n";
+
+  VertexWelder::weld(model, 0.0f);
+  return true;
+}
@@ -0,0 +1,411 @@
+#include "Scene.hpp"
+#include "CompressedInput.hpp"
+#include "ModelUtils.hpp"
+#include "NormalGenerator.hpp"
+#include "OBJLoader.hpp"
+#include "OcclusionCuller.hpp"
+#include "PLYLoader.hpp"
+#include "PagedMesh.hpp"
+#include "Parallel.hpp"
+#include "STLLoader.hpp"
+#include "VertexQuantizer.hpp"
+#include "VertexWelder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+// Models are scaled so their largest bounding box side has this length.
+constexpr float kNormalizedSize = 2.0f;
+
+// Distance between neighbouring grid slots; leaves a gap between models.
+constexpr float kGridSpacing = 2.5f;
+
+/**
+ * @brief Fills the bounds and the transform that centers the model and fits
+ * it to kNormalizedSize.
+ */
+void setBounds(RenderModel &renderModel, const AABB &bounds) {
+  renderModel.bounds = bounds;
+  renderModel.scaleFactor =
+      ModelUtilities::computeNormalizationScale(bounds, kNormalizedSize);
+
+  Vector3 center = bounds.center();
+  renderModel.translation.m[12] = -center.x;
+  renderModel.translation.m[13] = -center.y;
+  renderModel.translation.m[14] = -center.z;
+}
+
+// Bytes read from files with an unknown extension to recognize them.
+constexpr size_t kMagicBytes = STLLoader::kMagicBytes;
+
+size_t gridColumns(size_t count) {
+  return static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+}
+
+/**
+ * @brief makeRenderModel(), but the result can still be changed.
+ */
+std::shared_ptr<RenderModel> buildRenderModel(OBJModel &&loaded,
+                                              QuantizeMode quantize) {
+  auto renderModel = std::make_shared<RenderModel>();
+  renderModel->model = std::move(loaded);
+  OBJModel &model = renderModel->model;
+  model.vertices.shrink_to_fit();
+  model.texCoords.shrink_to_fit();
+  model.normals.shrink_to_fit();
+  model.faces.shrink_to_fit();
+
+  if (!model.vertices.empty()) {
+    setBounds(*renderModel, ModelUtilities::computeAABB(model));
+    renderModel->sphere = ModelUtilities::computeBoundingSphere(model);
+  }
+
+  if (model.faces.empty()) {
+    // A point cloud: drawn from the vertices alone, so nothing per-face is
+    // built.
+    ModelUtilities::shufflePoints(model);
+    renderModel->meshMemory = MemoryTracker::Allocation(
+        MemoryTag::MESH, MemoryTracker::bytesOf(model));
+    return renderModel;
+  }
+
+  {
+    std::vector<std::array<float, 3>> faceGrayColors, faceRandomColors;
+    ModelUtilities::buildFaceBasedColors(model, faceGrayColors,
+                                         faceRandomColors);
+    renderModel->batches = ModelUtilities::buildDrawBatches(
+        model, faceGrayColors, faceRandomColors);
+  }
+  renderModel->bvh.build(renderModel->model);
+  renderModel->occluders =
+      OcclusionCuller::selectOccluders(renderModel->batches);
+  if (VertexQuantizer::shouldQuantize(quantize,
+                                      renderModel->batches.cornerCount())) {
+    // Last: the bounds and occluders above read the float positions.
+    VertexQuantizer::quantize(renderModel->batches);
+  }
+
+  renderModel->meshMemory = MemoryTracker::Allocation(
+      MemoryTag::MESH, MemoryTracker::bytesOf(model));
+  renderModel->derivedMemory = MemoryTracker::Allocation(
+      MemoryTag::DERIVED, renderModel->batches.memoryBytes() +
+                              renderModel->bvh.memoryBytes() +
+                              renderModel->occluders.memoryBytes());
+  return renderModel;
+}
+
+/**
+ * @brief Fills the render data of `next`, whose model is the one of
+ * `current` with records appended after its faces, by extending the render
+ * data of `current`. The framing stays that of `current` so the model
+ * doesn't jump while it grows. The batches of `current` must not be
+ * quantized if faces were appended.
+ *
+ * `current` stays shared with frames in flight, so its batches and BVH are
+ * copied before the new faces are appended, and the occluders are picked
+ * again over every triangle: the cost grows with the model, not just with
+ * the appended records.
+ */
+void extendRenderModel(const RenderModel &current, RenderModel &next) {
+  OBJModel &model = next.model;
+  const size_t firstVertex = current.model.vertices.size();
+  const size_t firstFace = current.model.faces.size();
+
+  // Only the new points of a cloud are shuffled; the old ones keep their
+  // place in the vertex buffer.
+  ModelUtilities::shufflePoints(model, firstVertex);
+  next.translation = current.translation;
+  next.scaleFactor = current.scaleFactor;
+  next.bounds = current.bounds;
+  next.sphere = current.sphere;
+  if (firstVertex == 0 && !model.vertices.empty()) {
+    // Nothing was on screen yet, so there is no framing to keep.
+    setBounds(next, ModelUtilities::computeAABB(model));
+    next.sphere = ModelUtilities::computeBoundingSphere(model);
+  } else if (model.vertices.size() > firstVertex) {
+    const Vertex *added = model.vertices.data() + firstVertex;
+    const size_t count = model.vertices.size() - firstVertex;
+    const AABB box = BoundingVolumes::computeAABB(added, count);
+    next.bounds.min =
+        Vector3(std::min(box.min.x, next.bounds.min.x),
+                std::min(box.min.y, next.bounds.min.y),
+                std::min(box.min.z, next.bounds.min.z));
+    next.bounds.max =
+        Vector3(std::max(box.max.x, next.bounds.max.x),
+                std::max(box.max.y, next.bounds.max.y),
+                std::max(box.max.z, next.bounds.max.z));
+    BoundingVolumes::growSphere(next.sphere, added, count);
+  }
+
+  next.batches = current.batches;
+  next.bvh = current.bvh;
+  next.occluders = current.occluders;
+  if (model.faces.size() > firstFace) {
+    std::vector<std::array<float, 3>> faceGrayColors, faceRandomColors;
+    ModelUtilities::buildFaceBasedColors(model, faceGrayColors,
+                                         faceRandomColors, firstFace);
+    ModelUtilities::appendDrawBatches(model, firstFace, faceGrayColors,
+                                      faceRandomColors, next.batches);
+    next.bvh.append(model, firstFace);
+    next.occluders = OcclusionCuller::selectOccluders(next.batches);
+  }
+
+  next.meshMemory = MemoryTracker::Allocation(MemoryTag::MESH,
+                                              MemoryTracker::bytesOf(model));
+  next.derivedMemory = MemoryTracker::Allocation(
+      MemoryTag::DERIVED, next.batches.memoryBytes() +
+                              next.bvh.memoryBytes() +
+                              next.occluders.memoryBytes());
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // end anonymous namespace
+
+std::shared_ptr<const RenderModel>
+SceneLoader::makeRenderModel(OBJModel &&loaded, QuantizeMode quantize) {
+  return buildRenderModel(std::move(loaded), quantize);
+}
+
+ModelFormat SceneLoader::formatOf(const std::string &filePath) {
+  const bool compressed = CompressedInput::isCompressedPath(filePath);
+  std::string extension =
+      std::filesystem::path(CompressedInput::uncompressedPath(filePath))
+          .extension()
+          .string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (compressed) {
+    // Only OBJ is text read line by line; the other importers map the file.
+    return extension == ".obj" ? ModelFormat::OBJ : ModelFormat::UNKNOWN;
+  }
+  if (extension == ".obj") {
+    return ModelFormat::OBJ;
+  }
+  if (PLYLoader::isPLYPath(filePath)) {
+    return ModelFormat::PLY;
+  }
+  if (STLLoader::isSTLPath(filePath)) {
+    return ModelFormat::STL;
+  }
+  if (PagedMesh::isPagePath(filePath)) {
+    return ModelFormat::PAGES;
+  }
+
+  // Scanner output often comes without the usual extension.
+  std::error_code error;
+  const auto fileSize = std::filesystem::file_size(filePath, error);
+  std::ifstream file(filePath, std::ios::binary);
+  if (error || !file) {
+    return ModelFormat::UNKNOWN;
+  }
+  unsigned char header[kMagicBytes];
+  file.read(reinterpret_cast<char *>(header), sizeof(header));
+  const size_t size = static_cast<size_t>(file.gcount());
+  if (PLYLoader::hasPLYMagic(header, size)) {
+    return ModelFormat::PLY;
+  }
+  if (STLLoader::hasSTLMagic(header, size, static_cast<size_t>(fileSize))) {
+    return ModelFormat::STL;
+  }
+  return ModelFormat::UNKNOWN;
+}
+
+std::shared_ptr<const RenderModel>
+SceneLoader::loadModel(const std::string &filePath,
+                       const ViewerOptions &options) {
+  const ModelFormat format = formatOf(filePath);
+  if (format == ModelFormat::PAGES) {
+    // Out-of-core: only the page index is loaded; pages stream in per view.
+    auto renderModel = std::make_shared<RenderModel>();
+    renderModel->pages = PagedMesh::open(filePath, options.pageBudgetMB << 20);
+    if (!renderModel->pages) {
+      return nullptr;
+    }
+    renderModel->model.objectName = filePath;
+    const AABB &bounds = renderModel->pages->bounds();
+    setBounds(*renderModel, bounds);
+    renderModel->sphere.center = bounds.center();
+    renderModel->sphere.radius =
+        std::sqrt(bounds.size().dot(bounds.size())) * 0.5f;
+    return renderModel;
+  }
+
+  OBJModel model;
+  OBJLoader::ResumePoint resume;
+  if (!loadMesh(filePath, options, model, &resume)) {
+    return nullptr;
+  }
+  std::shared_ptr<RenderModel> renderModel =
+      buildRenderModel(std::move(model), options.quantize);
+  renderModel->resume = std::move(resume);
+  return renderModel;
+}
+
+std::shared_ptr<const RenderModel>
+SceneLoader::reloadModel(const std::shared_ptr<const RenderModel> &current,
+                         const ViewerOptions &options, bool &appended) {
+  appended = false;
+  const std::string &filePath = current->model.objectName;
+  if (current->resume.valid) {
+    auto start = std::chrono::steady_clock::now();
+    auto next = std::make_shared<RenderModel>();
+    next->model = current->model;
+    next->resume = current->resume;
+    const OBJLoader::AppendResult result =
+        OBJLoader::appendOBJ(filePath, next->model, next->resume);
+    if (result == OBJLoader::AppendResult::UNCHANGED) {
+      return current;
+    }
+
+    const OBJModel &before = current->model;
+    const OBJModel &after = next->model;
+    const bool newFaces = after.faces.size() > before.faces.size();
+    const bool parsed = result == OBJLoader::AppendResult::APPENDED ||
+                        result == OBJLoader::AppendResult::REGROUPED;
+    // Faces can't index the shuffled points of a cloud, and normals read
+    // from the file don't mix with generated ones: both load again.
+    const bool reusable =
+        parsed && !(newFaces && before.faces.empty() &&
+                    !before.vertices.empty()) &&
+        !(current->resume.normalsGenerated &&
+          after.normals.size() > before.normals.size());
+    if (reusable) {
+      std::cout << "Appended to " << filePath << ": "
+                << after.vertices.size() - before.vertices.size()
+                << " vertices, " << after.faces.size() - before.faces.size()
+                << " faces" << std::endl;
+    }
+    if (reusable && result == OBJLoader::AppendResult::APPENDED &&
+        (!newFaces || (current->batches.quantized.empty() &&
+                       !current->resume.normalsGenerated))) {
+      extendRenderModel(*current, *next);
+      appended = true;
+      std::cout << "Extended the render data in " << millisSince(start)
+                << " ms" << std::endl;
+      return next;
+    }
+    if (reusable) {
+      // Regrouped faces, generated normals and quantized vertices depend on
+      // every face: rebuild from the parsed model, keeping the framing.
+      OBJLoader::ResumePoint resume = std::move(next->resume);
+      if (resume.normalsGenerated) {
+        NormalGenerator::generate(next->model, options.creaseAngle);
+      }
+      std::shared_ptr<RenderModel> rebuilt =
+          buildRenderModel(std::move(next->model), options.quantize);
+      rebuilt->translation = current->translation;
+      rebuilt->scaleFactor = current->scaleFactor;
+      rebuilt->resume = std::move(resume);
+      std::cout << "Rebuilt the render data in " << millisSince(start)
+                << " ms" << std::endl;
+      return rebuilt;
+    }
+  }
+  std::cout << "Reloading " << filePath << std::endl;
+  return loadModel(filePath, options);
+}
+
+bool SceneLoader::loadMesh(const std::string &filePath,
+                           const ViewerOptions &options, OBJModel &model,
+                           OBJLoader::ResumePoint *resume) {
+  bool loaded = false;
+  switch (formatOf(filePath)) {
+  case ModelFormat::PLY:
+    loaded = PLYLoader::loadPLY(filePath, model);
+    break;
+  case ModelFormat::STL:
+    loaded = STLLoader::loadSTL(filePath, model);
+    break;
+  default:
+    loaded = OBJLoader::loadOBJ(filePath, model, resume);
+    break;
+  }
+  if (!loaded) {
+    std::cerr << "Failed to load model file: " << filePath << "\n";
+    return false;
+  }
+  if (options.weldEpsilon >= 0.0f) {
+    VertexWelder::weld(model, options.weldEpsilon);
+    if (resume) {
+      resume->valid = false; // Appended records index unwelded vertices
+    }
+  }
+  const bool generated =
+      NormalGenerator::generateIfMissing(model, options.creaseAngle);
+  if (resume) {
+    resume->normalsGenerated = generated;
+  }
+  model.objectName = filePath;
+  return true;
+}
+
+std::vector<std::shared_ptr<const RenderModel>>
+SceneLoader::loadModels(const std::vector<std::string> &filePaths,
+                        const ViewerOptions &options) {
+  // Load each distinct file once; repeats share the result.
+  std::vector<std::string> unique;
+  std::vector<size_t> slotOf(filePaths.size());
+  std::unordered_map<std::string, size_t> slots;
+  for (size_t i = 0; i < filePaths.size(); ++i) {
+    auto [it, inserted] = slots.emplace(filePaths[i], unique.size());
+    if (inserted) {
+      unique.push_back(filePaths[i]);
+    }
+    slotOf[i] = it->second;
+  }
+
+  std::vector<std::shared_ptr<const RenderModel>> loaded(unique.size());
+  Parallel::forRange(unique.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      loaded[i] = loadModel(unique[i], options);
+    }
+  });
+
+  std::vector<std::shared_ptr<const RenderModel>> models(filePaths.size());
+  for (size_t i = 0; i < filePaths.size(); ++i) {
+    models[i] = loaded[slotOf[i]];
+  }
+  return models;
+}
+
+Matrix4 SceneLoader::gridPlacement(size_t index, size_t count) {
+  Matrix4 placement;
+  if (count <= 1) {
+    return placement;
+  }
+  const size_t columns = gridColumns(count);
+  const size_t rows = (count + columns - 1) / columns;
+  const float column = static_cast<float>(index % columns);
+  const float row = static_cast<float>(index / columns);
+  placement.m[12] = (column - (columns - 1) * 0.5f) * kGridSpacing;
+  placement.m[13] = ((rows - 1) * 0.5f - row) * kGridSpacing;
+  return placement;
+}
+
+float SceneLoader::gridRadius(size_t count) {
+  // A normalized model fits in a cube of side kNormalizedSize.
+  const float modelRadius = 0.5f * kNormalizedSize * std::sqrt(3.0f);
+  if (count <= 1) {
+    return modelRadius;
+  }
+  const size_t columns = gridColumns(count);
+  const size_t rows = (count + columns - 1) / columns;
+  const float halfWidth = (columns - 1) * 0.5f * kGridSpacing;
+  const float halfHeight = (rows - 1) * 0.5f * kGridSpacing;
+  return std::sqrt(halfWidth * halfWidth + halfHeight * halfHeight) +
+         modelRadius;
+}
@@ -0,0 +1,291 @@
+#include "SequencePlayer.hpp"
+#include "ModelUtils.hpp"
+#include "OcclusionCuller.hpp"
+#include "Parallel.hpp"
+#include "Scene.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+bool isDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+/**
+ * @brief String order that compares digit runs by value, so frame_2 sorts
+ * before frame_10.
+ */
+bool naturalLess(const std::string &a, const std::string &b) {
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (!isDigit(a[i]) || !isDigit(b[j])) {
+      if (a[i] != b[j]) {
+        return a[i] < b[j];
+      }
+      ++i;
+      ++j;
+      continue;
+    }
+    size_t endA = i;
+    size_t endB = j;
+    while (endA < a.size() && isDigit(a[endA])) {
+      ++endA;
+    }
+    while (endB < b.size() && isDigit(b[endB])) {
+      ++endB;
+    }
+    // Without leading zeros, a longer run is a larger number.
+    while (i + 1 < endA && a[i] == '0') {
+      ++i;
+    }
+    while (j + 1 < endB && b[j] == '0') {
+      ++j;
+    }
+    if (endA - i != endB - j) {
+      return endA - i < endB - j;
+    }
+    const int order = a.compare(i, endA - i, b, j, endB - j);
+    if (order != 0) {
+      return order < 0;
+    }
+    i = endA;
+    j = endB;
+  }
+  return a.size() - i < b.size() - j;
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // end anonymous namespace
+
+bool SequencePlayer::isSequencePath(const std::string &path) {
+  std::error_code error;
+  if (std::filesystem::is_directory(path, error)) {
+    return true;
+  }
+  const std::string name = std::filesystem::path(path).filename().string();
+  return std::count(name.begin(), name.end(), '*') == 1;
+}
+
+std::vector<std::string> SequencePlayer::listFrames(const std::string &path) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  fs::path directory = path;
+  std::string prefix;
+  std::string suffix;
+  if (!fs::is_directory(path, error)) {
+    const fs::path pattern(path);
+    directory = pattern.has_parent_path() ? pattern.parent_path() : ".";
+    const std::string name = pattern.filename().string();
+    const size_t star = name.find('*');
+    prefix = name.substr(0, star);
+    suffix = name.substr(star + 1);
+  }
+
+  std::vector<std::string> frames;
+  for (fs::directory_iterator it(directory, error), end;
+       !error && it != end; it.increment(error)) {
+    const std::string name = it->path().filename().string();
+    if (name.size() < prefix.size() + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) !=
+            0) {
+      continue;
+    }
+    std::error_code typeError;
+    const std::string file = it->path().string();
+    if (!it->is_regular_file(typeError)) {
+      continue;
+    }
+    const ModelFormat format = SceneLoader::formatOf(file);
+    if (format != ModelFormat::UNKNOWN && format != ModelFormat::PAGES) {
+      frames.push_back(file);
+    }
+  }
+  if (error) {
+    std::cerr << "Error: cannot list " << directory.string() << ": "
+              << error.message() << "\n";
+    return {};
+  }
+  std::sort(frames.begin(), frames.end(), naturalLess);
+  return frames;
+}
+
+SequencePlayer::SequencePlayer(std::vector<std::string> framePaths,
+                               std::shared_ptr<const RenderModel> first,
+                               const ViewerOptions &options)
+    : framePaths_(std::move(framePaths)), options_(options),
+      fps_(options.sequenceFps), translation_(first->translation),
+      scaleFactor_(first->scaleFactor),
+      start_(std::chrono::steady_clock::now()), current_(std::move(first)) {
+  ring_.resize(std::max<size_t>(1, options.sequencePrefetch));
+  const size_t decoders = std::clamp<size_t>(
+      Parallel::workerCount() / 2, 1, std::min(kMaxDecoders, ring_.size()));
+  for (size_t i = 0; i < decoders; ++i) {
+    decoders_.emplace_back(&SequencePlayer::decoderLoop, this);
+  }
+  std::cout << "Playing " << framePaths_.size() << " frames at " << fps_
+            << " fps, " << ring_.size() << " prefetched by " << decoders
+            << " decoder thread(s)\n";
+}
+
+SequencePlayer::~SequencePlayer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &decoder : decoders_) {
+    decoder.join();
+  }
+}
+
+std::shared_ptr<const RenderModel> SequencePlayer::advance() {
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count();
+  const size_t due = static_cast<size_t>(seconds * fps_);
+  if (due <= shownTick_) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const RenderModel> next;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The newest decoded frame that is due; the ones before it are dropped.
+    // A slow decode may finish long after its tick came up.
+    const Slot *best = nullptr;
+    for (const Slot &slot : ring_) {
+      if (slot.ready && slot.model && slot.tick > shownTick_ &&
+          slot.tick <= due && (!best || slot.tick > best->tick)) {
+        best = &slot;
+      }
+    }
+    if (best) {
+      dropped_ += best->tick - shownTick_ - 1;
+      shownTick_ = best->tick;
+      next = best->model;
+    }
+    // Frames already late are not worth decoding any more.
+    playhead_ = std::max({playhead_, shownTick_ + 1, due});
+  }
+  wake_.notify_all();
+  if (next) {
+    current_ = next;
+  }
+  return next;
+}
+
+SequenceStats SequencePlayer::stats() const {
+  SequenceStats stats;
+  stats.frame = shownTick_ % framePaths_.size();
+  stats.frameCount = framePaths_.size();
+  stats.depth = ring_.size();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Slot &slot : ring_) {
+    if (slot.ready && slot.model && slot.tick > shownTick_) {
+      ++stats.prefetched;
+    }
+  }
+  stats.dropped = dropped_;
+  stats.decoded = decoded_;
+  stats.reused = reused_;
+  stats.decodeMillis = decoded_ > 0 ? decodeMillis_ / decoded_ : 0.0;
+  return stats;
+}
+
+void SequencePlayer::decoderLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] {
+      return stopping_ || nextTick_ < playhead_ + ring_.size();
+    });
+    if (stopping_) {
+      return;
+    }
+    const size_t tick = std::max(nextTick_, playhead_);
+    nextTick_ = tick + 1;
+    Slot &slot = ring_[tick % ring_.size()];
+    std::shared_ptr<const RenderModel> stale = std::move(slot.model);
+    slot.tick = tick;
+    slot.ready = false;
+    std::shared_ptr<const RenderModel> topology = topology_;
+    lock.unlock();
+
+    // The old frame is freed and the new one decoded outside the lock.
+    stale.reset();
+    auto start = std::chrono::steady_clock::now();
+    bool reused = false;
+    std::shared_ptr<const RenderModel> model =
+        decode(framePaths_[tick % framePaths_.size()], topology, reused);
+    const double millis = millisSince(start);
+
+    lock.lock();
+    ++decoded_;
+    reused_ += reused ? 1 : 0;
+    decodeMillis_ += millis;
+    if (model && !reused && !model->model.faces.empty()) {
+      topology_ = model;
+    }
+    // A slow decode may have been overtaken by the playhead and its slot
+    // handed to a later tick.
+    if (slot.tick == tick) {
+      slot.model = std::move(model);
+      slot.ready = true;
+    }
+  }
+}
+
+std::shared_ptr<const RenderModel>
+SequencePlayer::decode(const std::string &filePath,
+                       const std::shared_ptr<const RenderModel> &topology,
+                       bool &reused) const {
+  reused = false;
+  auto renderModel = std::make_shared<RenderModel>();
+  OBJModel &model = renderModel->model;
+  if (!SceneLoader::loadMesh(filePath, options_, model)) {
+    return nullptr;
+  }
+
+  renderModel->translation = translation_;
+  renderModel->scaleFactor = scaleFactor_;
+  if (!model.vertices.empty()) {
+    renderModel->bounds = ModelUtilities::computeAABB(model);
+    renderModel->sphere = ModelUtilities::computeBoundingSphere(model);
+  }
+
+  if (model.faces.empty()) {
+    // The same fixed shuffle as every point cloud, so equal point counts
+    // keep their order from frame to frame.
+    ModelUtilities::shufflePoints(model);
+  } else if (topology &&
+             ModelUtilities::sameTopology(model, topology->model)) {
+    renderModel->batches = topology->batches;
+    ModelUtilities::updateDrawBatchVertices(model, renderModel->batches);
+    reused = true;
+  } else {
+    std::vector<std::array<float, 3>> faceGrayColors, faceRandomColors;
+    ModelUtilities::buildFaceBasedColors(model, faceGrayColors,
+                                         faceRandomColors);
+    renderModel->batches = ModelUtilities::buildDrawBatches(
+        model, faceGrayColors, faceRandomColors);
+  }
+  renderModel->occluders =
+      OcclusionCuller::selectOccluders(renderModel->batches);
+
+  renderModel->meshMemory = MemoryTracker::Allocation(
+      MemoryTag::MESH, MemoryTracker::bytesOf(model));
+  renderModel->derivedMemory = MemoryTracker::Allocation(
+      MemoryTag::DERIVED, renderModel->batches.memoryBytes() +
+                              renderModel->occluders.memoryBytes());
+  return renderModel;
+}
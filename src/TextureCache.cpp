@@ -0,0 +1,230 @@
+#include "TextureCache.hpp"
+#include "MemoryTracker.hpp"
+#include "Parallel.hpp"
+#include "TextureManager.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+
+namespace {
+
+constexpr unsigned kFallbackSize = 64;
+
+// Bytes a streamed texture may upload per frame: a 1024x1024 RGBA level fits
+// in one frame, a 4096x4096 one takes about sixteen.
+constexpr size_t kStreamBytesPerFrame = 4u << 20;
+
+} // end anonymous namespace
+
+CachedTexture::~CachedTexture() { TextureManager::deleteTexture(id); }
+
+TextureCache::TextureCache(size_t budgetBytes, const TextureSettings &settings)
+    : settings_(settings), budgetBytes_(budgetBytes),
+      streamer_(settings, kStreamBytesPerFrame) {}
+
+TextureCache::Handle TextureCache::acquire(const std::string &filePath) {
+  std::string key;
+  std::filesystem::file_time_type modified;
+  if (!identify(filePath, key, modified)) {
+    return fallback();
+  }
+  if (Handle cached = findCurrent(key, modified)) {
+    return cached;
+  }
+
+  GLuint id = TextureManager::loadTexture(key, settings_);
+  if (id == 0) {
+    return fallback();
+  }
+  return insert(key, modified, id);
+}
+
+std::vector<TextureCache::Handle>
+TextureCache::acquireAll(const std::vector<std::string> &filePaths) {
+  struct Miss {
+    std::string key;
+    std::filesystem::file_time_type modified;
+    std::vector<size_t> slots; ///< Indices into filePaths using this file.
+    TextureData data;
+    bool decoded = false;
+  };
+
+  std::vector<Handle> textures(filePaths.size());
+  std::vector<Miss> misses;
+  for (size_t i = 0; i < filePaths.size(); ++i) {
+    if (filePaths[i].empty()) {
+      continue;
+    }
+    std::string key;
+    std::filesystem::file_time_type modified;
+    if (!identify(filePaths[i], key, modified)) {
+      textures[i] = fallback();
+    } else if (Handle cached = findCurrent(key, modified)) {
+      textures[i] = std::move(cached);
+    } else {
+      auto same = std::find_if(misses.begin(), misses.end(),
+                               [&](const Miss &m) { return m.key == key; });
+      if (same == misses.end()) {
+        misses.push_back({key, modified, {}, TextureData(), false});
+        same = misses.end() - 1;
+      }
+      same->slots.push_back(i);
+    }
+  }
+  if (misses.empty()) {
+    return textures;
+  }
+
+  // Decoding touches no GL state; one file per worker.
+  const TextureLimits limits = TextureManager::queryLimits(settings_);
+  Parallel::forRange(misses.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      misses[i].decoded = TextureManager::decodeTexture(
+          misses[i].key, settings_, limits, misses[i].data);
+    }
+  });
+
+  size_t decodedBytes = 0;
+  for (const Miss &miss : misses) {
+    decodedBytes += miss.data.cpuBytes();
+  }
+  MemoryTracker::Allocation decoded(MemoryTag::TEXTURES, decodedBytes);
+
+  for (Miss &miss : misses) {
+    Handle texture = fallback();
+    if (miss.decoded) {
+      GLuint id = TextureManager::uploadTexture(miss.key, miss.data, settings_);
+      texture = insert(miss.key, miss.modified, id);
+    }
+    decodedBytes -= miss.data.cpuBytes();
+    decoded.resize(decodedBytes);
+    miss.data = TextureData();
+    for (size_t slot : miss.slots) {
+      textures[slot] = texture;
+    }
+  }
+  return textures;
+}
+
+TextureCache::Handle TextureCache::request(const std::string &filePath) {
+  std::string key;
+  std::filesystem::file_time_type modified;
+  if (!identify(filePath, key, modified)) {
+    streamer_.cancel();
+    return fallback();
+  }
+  if (Handle cached = findCurrent(key, modified)) {
+    streamer_.cancel();
+    return cached;
+  }
+
+  streamKey_ = key;
+  streamModified_ = modified;
+  streamer_.start(key);
+  return nullptr;
+}
+
+TextureCache::Handle TextureCache::pollStream() {
+  GLuint id = 0;
+  switch (streamer_.pump(id)) {
+  case TextureStreamer::Status::DONE:
+    return insert(streamKey_, streamModified_, id);
+  case TextureStreamer::Status::FAILED:
+    return fallback();
+  default:
+    return nullptr;
+  }
+}
+
+bool TextureCache::identify(const std::string &filePath, std::string &key,
+                            std::filesystem::file_time_type &modified) {
+  std::error_code error;
+  std::filesystem::path canonical =
+      std::filesystem::canonical(filePath, error);
+  if (!error) {
+    modified = std::filesystem::last_write_time(canonical, error);
+  }
+  if (error) {
+    std::cerr << "Error: Could not open texture " << filePath << ": "
+              << error.message() << "\n";
+    return false;
+  }
+  key = canonical.string();
+  return true;
+}
+
+TextureCache::Handle
+TextureCache::findCurrent(const std::string &key,
+                          std::filesystem::file_time_type modified) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  if (it->second.modified == modified) {
+    it->second.lastUse = ++useClock_;
+    std::cout << "Texture cache hit: " << key << "\n";
+    return it->second.texture;
+  }
+  // Changed on disk: anyone still holding the old handle keeps it alive.
+  erase(it);
+  return nullptr;
+}
+
+TextureCache::Handle
+TextureCache::insert(const std::string &key,
+                     std::filesystem::file_time_type modified, GLuint id) {
+  auto existing = entries_.find(key);
+  if (existing != entries_.end()) {
+    erase(existing);
+  }
+
+  auto texture = std::make_shared<CachedTexture>();
+  texture->id = id;
+  texture->gpuBytes = TextureManager::textureBytes(id);
+  texture->path = key;
+
+  Entry &entry = entries_[key];
+  entry.texture = texture;
+  entry.modified = modified;
+  entry.lastUse = ++useClock_;
+  residentBytes_ += texture->gpuBytes;
+
+  trim();
+  return texture;
+}
+
+TextureCache::Handle TextureCache::fallback() {
+  if (!fallback_) {
+    auto texture = std::make_shared<CachedTexture>();
+    texture->id =
+        TextureManager::generateWhiteTexture(kFallbackSize, kFallbackSize);
+    texture->gpuBytes = TextureManager::textureBytes(texture->id);
+    fallback_ = texture;
+  }
+  return fallback_;
+}
+
+void TextureCache::trim() {
+  while (residentBytes_ > budgetBytes_) {
+    // Least recently used texture that only the cache still references.
+    auto victim = entries_.end();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second.texture.use_count() == 1 &&
+          (victim == entries_.end() ||
+           it->second.lastUse < victim->second.lastUse)) {
+        victim = it;
+      }
+    }
+    if (victim == entries_.end()) {
+      return; // Everything over budget is in use.
+    }
+    std::cout << "Texture cache: evicting " << victim->first << "\n";
+    erase(victim);
+  }
+}
+
+void TextureCache::erase(std::unordered_map<std::string, Entry>::iterator it) {
+  residentBytes_ -= it->second.texture->gpuBytes;
+  entries_.erase(it);
+}
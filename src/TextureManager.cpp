@@ -1,134 +1,494 @@
 #include "TextureManager.hpp"
+#include "BCCodec.hpp"
+#include "BMPDecoder.hpp"
+#include "MemoryTracker.hpp"
+#include "MipmapGenerator.hpp"
 
-#include <cstring>
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
-GLuint TextureManager::loadBMPTexture(const std::string &filePath) {
-  // Open the BMP file
-  std::ifstream file(filePath, std::ios::binary);
-  if (!file.is_open()) {
-    std::cerr << "Error: Could not open BMP file: " << filePath << std::endl;
-    return 0;
+namespace {
+
+// GPU memory charged per live texture. Only touched from the GL thread.
+std::unordered_map<GLuint, MemoryTracker::Allocation> gpuAllocations;
+
+// Part of every cache key; bump it whenever BCCodec output changes so stale
+// cache entries are ignored.
+constexpr uint64_t kEncoderVersion = 1;
+
+/**
+ * @brief Estimated GPU size of an uncompressed texture. Drivers store RGB8 as
+ * RGBA8, so 4 bytes per texel is the realistic estimate; a full mip chain
+ * adds a third on top of level 0.
+ */
+size_t uncompressedBytes(size_t width, size_t height, bool mipmapped) {
+  size_t bytes = width * height * 4;
+  if (mipmapped) {
+    bytes += bytes / 3;
   }
+  return bytes;
+}
 
-  // Read the BMP header (14 bytes)
-  unsigned char fileHeader[14];
-  file.read(reinterpret_cast<char *>(fileHeader), 14);
-  if (file.gcount() != 14) {
-    std::cerr << "Error: Failed to read BMP file header.\n";
-    return 0;
+/**
+ * @brief Charges an uploaded texture to GPU_TEXTURES.
+ */
+void trackUpload(GLuint texID, size_t bytes) {
+  gpuAllocations[texID] =
+      MemoryTracker::Allocation(MemoryTag::GPU_TEXTURES, bytes);
+}
+
+bool hasGenerateMipmap() {
+  return GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object;
+}
+
+GLenum formatOf(const DecodedImage &image) {
+  return image.channels == 4 ? GL_RGBA : GL_RGB;
+}
+
+GLenum glFormatOf(BlockFormat format) {
+  switch (format) {
+  case BlockFormat::BC1:
+    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  case BlockFormat::BC1A:
+    return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+  case BlockFormat::BC2:
+    return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+  case BlockFormat::BC3:
+    break;
   }
+  return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
 
-  // Verify the BMP signature
-  if (fileHeader[0] != 'B' || fileHeader[1] != 'M') {
-    std::cerr << "Error: File is not a valid BMP: " << filePath << std::endl;
-    return 0;
+/**
+ * @brief BMP -> level 0 fitted to maxSize, plus the CPU mip chain for
+ * MipmapMode::CPU.
+ */
+bool decodeBMPLevels(const std::string &filePath,
+                     const TextureSettings &settings, int maxSize,
+                     std::vector<DecodedImage> &levels) {
+  DecodedImage image;
+  if (!BMPDecoder::load(filePath, image)) {
+    return false;
   }
 
-  // Read the DIB header (BITMAPINFOHEADER - 40 bytes)
-  unsigned char infoHeader[40];
-  file.read(reinterpret_cast<char *>(infoHeader), 40);
-  if (file.gcount() != 40) {
-    std::cerr << "Error: Failed to read BMP info header.\n";
-    return 0;
+  const int sourceWidth = image.width, sourceHeight = image.height;
+  if (image.width > maxSize || image.height > maxSize) {
+    image = MipmapGenerator::fitToSize(std::move(image), maxSize);
+    std::cout << "Downscaled " << filePath << " from " << sourceWidth << "x"
+              << sourceHeight << " to " << image.width << "x" << image.height
+              << " (max texture size " << maxSize << ")\n";
   }
 
-  // Extract image dimensions and properties
-  int width = *reinterpret_cast<int *>(&infoHeader[4]);
-  int height = *reinterpret_cast<int *>(&infoHeader[8]);
-  short planes = *reinterpret_cast<short *>(&infoHeader[12]);
-  short bpp = *reinterpret_cast<short *>(&infoHeader[14]);
-  int compression = *reinterpret_cast<int *>(&infoHeader[16]);
+  std::vector<DecodedImage> chain;
+  if (settings.mipmaps == MipmapMode::CPU) {
+    chain = MipmapGenerator::buildChain(image);
+  }
+  levels.reserve(chain.size() + 1);
+  levels.push_back(std::move(image));
+  for (DecodedImage &level : chain) {
+    levels.push_back(std::move(level));
+  }
+  return true;
+}
 
-  // Validate BMP format
-  if (planes != 1) {
-    std::cerr << "Error: BMP planes (" << planes << ") is not 1.\n";
-    return 0;
+std::string defaultCacheDir() {
+  if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    return std::string(xdg) + "/scop/textures";
   }
-  if (bpp != 24) {
-    std::cerr << "Error: BMP bit depth (" << bpp << ") is not 24.\n";
-    return 0;
+  if (const char *home = std::getenv("HOME"); home && *home) {
+    return std::string(home) + "/.cache/scop/textures";
   }
-  if (compression != 0) {
-    std::cerr << "Error: BMP compression (" << compression
-              << ") is not supported.\n";
-    return 0;
+  return ".scop-cache/textures";
+}
+
+/**
+ * @brief Cache file for an encoded BMP. The name hashes (FNV-1a) everything
+ * the encoded result depends on: path, size and mtime of the source, the
+ * size limit, whether a chain is built, and the encoder version.
+ * @return "" if the source can't be inspected.
+ */
+std::string cachePathFor(const std::string &filePath,
+                         const TextureSettings &settings, int maxSize) {
+  std::error_code error;
+  auto modified = std::filesystem::last_write_time(filePath, error);
+  uintmax_t size = error ? 0 : std::filesystem::file_size(filePath, error);
+  if (error) {
+    return "";
+  }
+
+  uint64_t hash = 1469598103934665603ull;
+  auto mix = [&hash](const void *data, size_t bytes) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < bytes; ++i) {
+      hash = (hash ^ p[i]) * 1099511628211ull;
+    }
+  };
+  int64_t ticks = modified.time_since_epoch().count();
+  bool chain = settings.mipmaps != MipmapMode::OFF;
+  mix(filePath.data(), filePath.size());
+  mix(&ticks, sizeof(ticks));
+  mix(&size, sizeof(size));
+  mix(&maxSize, sizeof(maxSize));
+  mix(&chain, sizeof(chain));
+  mix(&kEncoderVersion, sizeof(kEncoderVersion));
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.dds",
+                static_cast<unsigned long long>(hash));
+  std::string dir =
+      settings.cacheDir.empty() ? defaultCacheDir() : settings.cacheDir;
+  return dir + "/" + name;
+}
+
+void reportCompression(const std::string &filePath,
+                       const CompressedImage &image, double milliseconds) {
+  char before[32], after[32], saved[32];
+  size_t compressedBytes = image.byteSize();
+  size_t rgbaBytes = uncompressedBytes(image.width(), image.height(),
+                                       image.levels.size() > 1);
+  MemoryTracker::formatBytes(rgbaBytes, before, sizeof(before));
+  MemoryTracker::formatBytes(compressedBytes, after, sizeof(after));
+  MemoryTracker::formatBytes(
+      rgbaBytes > compressedBytes ? rgbaBytes - compressedBytes : 0, saved,
+      sizeof(saved));
+  std::cout << (milliseconds < 0.0 ? "Compressed texture cache hit: "
+                                   : "Compressed ")
+            << filePath << " as "
+            << TextureManager::blockFormatName(image.format) << " ("
+            << image.width() << "x" << image.height() << ", "
+            << image.levels.size() << " levels";
+  if (milliseconds >= 0.0) {
+    char timing[32];
+    std::snprintf(timing, sizeof(timing), ", %.1f ms", milliseconds);
+    std::cout << timing;
   }
+  std::cout << "): " << before << " -> " << after << " GPU, saved " << saved
+            << "\n";
+}
 
-  // Check if height is negative (top-down BMP)
-  bool bottomUp = true;
-  if (height < 0) {
-    bottomUp = false;
-    height = -height;
-    std::cerr << "Warning: BMP is top-down. Processing as bottom-up.\n";
+/**
+ * @brief --texture-compression path for BMPs: reuse the cached encoding if
+ * the source is unchanged, otherwise decode, encode every level to BC1 (or
+ * BC3 when any texel is translucent) and store the result.
+ */
+bool compressBMP(const std::string &filePath, const TextureSettings &settings,
+                 const TextureLimits &limits, CompressedImage &out) {
+  const std::string cachePath =
+      cachePathFor(filePath, settings, limits.maxSize);
+  std::error_code error;
+  if (!cachePath.empty() && std::filesystem::exists(cachePath, error) &&
+      CompressedTextureFile::load(cachePath, out)) {
+    reportCompression(filePath, out, -1.0);
+    return true;
   }
 
-  // Calculate row padding
-  int rowSize =
-      (width * 3 + 3) & (~3); // Each row padded to multiple of 4 bytes
+  // Drivers can't generate mipmaps for compressed textures, so the chain is
+  // built on the CPU unless mipmaps are off.
+  TextureSettings chainSettings = settings;
+  if (chainSettings.mipmaps == MipmapMode::GL) {
+    chainSettings.mipmaps = MipmapMode::CPU;
+  }
+  std::vector<DecodedImage> levels;
+  if (!decodeBMPLevels(filePath, chainSettings, limits.maxSize, levels)) {
+    return false;
+  }
 
-  // Move to the pixel data offset (from file header)
-  int dataOffset = *reinterpret_cast<int *>(&fileHeader[10]);
-  file.seekg(dataOffset, std::ios::beg);
+  auto start = std::chrono::steady_clock::now();
+  out = CompressedImage();
+  out.format = BCCodec::isOpaque(levels[0]) ? BlockFormat::BC1
+                                            : BlockFormat::BC3;
+  size_t total = 0;
+  for (const DecodedImage &level : levels) {
+    total += BCCodec::encodedSize(out.format, level.width, level.height);
+  }
+  out.storage.reserve(total);
+  std::vector<unsigned char> blocks;
+  for (const DecodedImage &level : levels) {
+    BCCodec::encode(level, out.format, blocks);
+    out.storage.insert(out.storage.end(), blocks.begin(), blocks.end());
+  }
+  // Point the levels at storage only once it stopped growing.
+  size_t offset = 0;
+  for (const DecodedImage &level : levels) {
+    size_t size = BCCodec::encodedSize(out.format, level.width, level.height);
+    out.levels.push_back(
+        {level.width, level.height, out.storage.data() + offset, size});
+    offset += size;
+  }
+  double milliseconds = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  reportCompression(filePath, out, milliseconds);
 
-  // Read pixel data
-  std::vector<unsigned char> bmpData(rowSize * height);
-  file.read(reinterpret_cast<char *>(bmpData.data()), bmpData.size());
-  if (file.gcount() != static_cast<std::streamsize>(bmpData.size())) {
-    std::cerr << "Error: Failed to read BMP pixel data.\n";
-    return 0;
+  if (!cachePath.empty()) {
+    std::filesystem::create_directories(
+        std::filesystem::path(cachePath).parent_path(), error);
+    if (error || !CompressedTextureFile::writeDDS(cachePath, out)) {
+      std::cerr << "Warning: Could not cache compressed texture in "
+                << cachePath << "\n";
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief DDS/KTX: pass the blocks through untouched, skipping stored levels
+ * above the size limit. Without S3TC, or when even the smallest stored level
+ * is too large, level 0 is decompressed and treated like a BMP.
+ */
+bool loadContainer(const std::string &filePath,
+                   const TextureSettings &settings,
+                   const TextureLimits &limits, TextureData &data) {
+  CompressedImage image;
+  if (!CompressedTextureFile::load(filePath, image)) {
+    return false;
+  }
+  auto fits = [&limits](const CompressedLevel &level) {
+    return level.width <= limits.maxSize && level.height <= limits.maxSize;
+  };
+  size_t first = 0;
+  while (first + 1 < image.levels.size() && !fits(image.levels[first])) {
+    ++first;
   }
-  file.close();
+  image.levels.erase(image.levels.begin(), image.levels.begin() + first);
 
-  // Convert BMP data (BGR) to RGB and flip vertically if needed
-  std::vector<unsigned char> pixels(width * height * 3, 0);
-  for (int y = 0; y < height; ++y) {
-    int bmpY = bottomUp ? (height - 1 - y) : y;
-    for (int x = 0; x < width; ++x) {
-      int bmpIndex = y * rowSize + x * 3;
-      int pixelIndex = (bmpY * width + x) * 3;
+  if (limits.s3tc && fits(image.levels[0])) {
+    data.compressed = std::move(image);
+    return true;
+  }
 
-      // BMP stores pixels in BGR format
-      pixels[pixelIndex + 0] = bmpData[bmpIndex + 2]; // R
-      pixels[pixelIndex + 1] = bmpData[bmpIndex + 1]; // G
-      pixels[pixelIndex + 2] = bmpData[bmpIndex + 0]; // B
+  std::cout << (limits.s3tc ? "Compressed texture too large, decompressing "
+                            : "S3TC not supported, decompressing ")
+            << filePath << "\n";
+  DecodedImage level;
+  const CompressedLevel &base = image.levels[0];
+  if (!BCCodec::decode(base.data, base.size, image.format, base.width,
+                       base.height, level)) {
+    return false;
+  }
+  if (level.width > limits.maxSize || level.height > limits.maxSize) {
+    level = MipmapGenerator::fitToSize(std::move(level), limits.maxSize);
+  }
+  std::vector<DecodedImage> chain;
+  if (settings.mipmaps == MipmapMode::CPU) {
+    chain = MipmapGenerator::buildChain(level);
+  }
+  data.levels.push_back(std::move(level));
+  for (DecodedImage &reduced : chain) {
+    data.levels.push_back(std::move(reduced));
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
+int TextureData::width() const {
+  return isCompressed() ? compressed.width()
+                        : (levels.empty() ? 0 : levels[0].width);
+}
+
+int TextureData::height() const {
+  return isCompressed() ? compressed.height()
+                        : (levels.empty() ? 0 : levels[0].height);
+}
+
+size_t TextureData::cpuBytes() const {
+  size_t bytes = MemoryTracker::bytesOf(compressed.storage);
+  for (const DecodedImage &level : levels) {
+    bytes += MemoryTracker::bytesOf(level.pixels);
+  }
+  return bytes;
+}
+
+TextureLimits TextureManager::queryLimits(const TextureSettings &settings) {
+  TextureLimits limits;
+  GLint driverMax = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &driverMax);
+  limits.maxSize = driverMax > 0 ? driverMax : INT_MAX;
+  if (settings.maxSize > 0) {
+    limits.maxSize = std::min(limits.maxSize, settings.maxSize);
+  }
+  limits.s3tc = GLEW_EXT_texture_compression_s3tc;
+  return limits;
+}
+
+bool TextureManager::decodeTexture(const std::string &filePath,
+                                   const TextureSettings &settings,
+                                   const TextureLimits &limits,
+                                   TextureData &data) {
+  data = TextureData();
+  if (CompressedTextureFile::isContainerPath(filePath)) {
+    return loadContainer(filePath, settings, limits, data);
+  }
+  if (settings.compress) {
+    if (limits.s3tc) {
+      return compressBMP(filePath, settings, limits, data.compressed);
     }
+    std::cout << "S3TC not supported, loading " << filePath
+              << " uncompressed\n";
+  }
+  return decodeBMPLevels(filePath, settings, limits.maxSize, data.levels);
+}
+
+size_t TextureManager::uploadLevelCount(const TextureData &data,
+                                        const TextureSettings &settings) {
+  if (data.isCompressed()) {
+    return settings.mipmaps == MipmapMode::OFF ? 1
+                                               : data.compressed.levels.size();
   }
+  return data.levels.size();
+}
 
+GLuint TextureManager::createTexture(const TextureData &data,
+                                     const TextureSettings &settings,
+                                     bool withPixels) {
   // Generate OpenGL texture
   GLuint texID;
   glGenTextures(1, &texID);
   glBindTexture(GL_TEXTURE_2D, texID);
 
+  const size_t levelCount = uploadLevelCount(data, settings);
+  const bool driverMipmaps =
+      settings.mipmaps == MipmapMode::GL && !data.isCompressed();
+  const bool mipmapped = levelCount > 1 || driverMipmaps;
+
   // Set texture parameters
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if (!driverMipmaps) {
+    // Stored chains may stop short of 1x1; the texture is complete anyway.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                    static_cast<GLint>(levelCount) - 1);
+  }
 
-  // Upload texture data to GPU
-  glTexImage2D(GL_TEXTURE_2D,
-               0,                // mipmap level
-               GL_RGB,           // internal format
-               width, height,    // width and height
-               0,                // border
-               GL_RGB,           // format
-               GL_UNSIGNED_BYTE, // data type
-               pixels.data()     // pointer to data
-  );
-
-  std::cout << "Loaded BMP texture: " << filePath << " (Width: " << width
-            << ", Height: " << height << ", Texture ID: " << texID << ")\n";
+  if (data.isCompressed()) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < levelCount; ++i) {
+      const CompressedLevel &level = data.compressed.levels[i];
+      if (withPixels) {
+        uploadCompressedLevel(static_cast<GLint>(i), data.compressed.format,
+                              level, level.data);
+      }
+      bytes += level.size;
+    }
+    trackUpload(texID, bytes);
+    return texID;
+  }
 
+  // Pre-3.0 drivers only build mipmaps as a side effect of level 0 uploads.
+  if (driverMipmaps && !hasGenerateMipmap()) {
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+  }
+
+  // Decoded rows are tightly packed, which RGB widths not divisible by 4
+  // violate under the default 4-byte unpack alignment.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // Upload texture data to GPU, or only reserve storage for it
+  for (size_t i = 0; i < levelCount; ++i) {
+    const DecodedImage &level = data.levels[i];
+    GLenum format = formatOf(level);
+    glTexImage2D(GL_TEXTURE_2D,
+                 static_cast<GLint>(i),                     // mipmap level
+                 format,                                    // internal format
+                 level.width,                               // width
+                 level.height,                              // height
+                 0,                                         // border
+                 format,                                    // format
+                 GL_UNSIGNED_BYTE,                          // data type
+                 withPixels ? level.pixels.data() : nullptr // data
+    );
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+  trackUpload(texID,
+              uncompressedBytes(data.width(), data.height(), mipmapped));
   return texID;
 }
 
+void TextureManager::uploadRows(GLint level, const DecodedImage &image,
+                                int firstRow, int rowCount,
+                                const void *pixels) {
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  GLenum format = formatOf(image);
+  glTexSubImage2D(GL_TEXTURE_2D, level, 0, firstRow, image.width, rowCount,
+                  format, GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureManager::uploadCompressedLevel(GLint level, BlockFormat format,
+                                           const CompressedLevel &image,
+                                           const void *pixels) {
+  glCompressedTexImage2D(GL_TEXTURE_2D, level, glFormatOf(format),
+                         image.width, image.height, 0,
+                         static_cast<GLsizei>(image.size), pixels);
+}
+
+void TextureManager::finishTexture(GLuint textureID, const TextureData &data,
+                                   const TextureSettings &settings) {
+  if (settings.mipmaps == MipmapMode::GL && !data.isCompressed() &&
+      hasGenerateMipmap()) {
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+}
+
+GLuint TextureManager::loadTexture(const std::string &filePath,
+                                   const TextureSettings &settings) {
+  TextureData data;
+  if (!decodeTexture(filePath, settings, queryLimits(settings), data)) {
+    return 0;
+  }
+  MemoryTracker::Allocation decoded(MemoryTag::TEXTURES, data.cpuBytes());
+  return uploadTexture(filePath, data, settings);
+}
+
+GLuint TextureManager::uploadTexture(const std::string &filePath,
+                                     const TextureData &data,
+                                     const TextureSettings &settings) {
+  GLuint texID = createTexture(data, settings, true);
+  finishTexture(texID, data, settings);
+
+  std::cout << "Loaded texture: " << filePath << " (Width: " << data.width()
+            << ", Height: " << data.height() << ", ";
+  if (data.isCompressed()) {
+    std::cout << blockFormatName(data.compressed.format);
+  } else {
+    std::cout << data.levels[0].channels * 8 << "-bit";
+  }
+  std::cout << ", mipmaps: " << mipmapModeName(settings.mipmaps)
+            << ", Texture ID: " << texID << ")\n";
+
+  return texID;
+}
+
+const char *TextureManager::mipmapModeName(MipmapMode mode) {
+  static const char *names[] = {"cpu", "gl", "off"};
+  return names[static_cast<int>(mode)];
+}
+
+const char *TextureManager::blockFormatName(BlockFormat format) {
+  static const char *names[] = {"BC1", "BC1 (1-bit alpha)", "BC2", "BC3"};
+  return names[static_cast<int>(format)];
+}
+
 GLuint TextureManager::generateWhiteTexture(unsigned int width,
                                             unsigned int height) {
   // Create a white pixel array
   std::vector<unsigned char> whitePixels(width * height * 3, 255);
+  MemoryTracker::Allocation decoded(MemoryTag::TEXTURES,
+                                    MemoryTracker::bytesOf(whitePixels));
 
   // Generate OpenGL texture
   GLuint texID = 0;
@@ -151,8 +511,23 @@ GLuint TextureManager::generateWhiteTexture(unsigned int width,
                GL_UNSIGNED_BYTE,    // data type
                whitePixels.data()); // pointer to data
 
+  trackUpload(texID, uncompressedBytes(width, height, false));
+
   std::cout << "Generated a solid white texture (Texture ID: " << texID
             << ", Size: " << width << "x" << height << ")\n";
 
   return texID;
 }
+
+void TextureManager::deleteTexture(GLuint textureID) {
+  if (textureID == 0) {
+    return;
+  }
+  glDeleteTextures(1, &textureID);
+  gpuAllocations.erase(textureID);
+}
+
+size_t TextureManager::textureBytes(GLuint textureID) {
+  auto it = gpuAllocations.find(textureID);
+  return it != gpuAllocations.end() ? it->second.bytes() : 0;
+}
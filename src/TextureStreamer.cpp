@@ -0,0 +1,213 @@
+#include "TextureStreamer.hpp"
+#include "TextureManager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+bool hasPixelBuffers() {
+  return GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object;
+}
+
+} // end anonymous namespace
+
+TextureStreamer::TextureStreamer(const TextureSettings &settings,
+                                 size_t uploadBytesPerFrame)
+    : settings_(settings),
+      uploadBytesPerFrame_(std::max<size_t>(uploadBytesPerFrame, 1)) {
+  worker_ = std::thread(&TextureStreamer::workerLoop, this);
+}
+
+TextureStreamer::~TextureStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  jobReady_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  releaseUpload();
+  if (pixelBuffer_ != 0) {
+    glDeleteBuffers(1, &pixelBuffer_);
+  }
+}
+
+void TextureStreamer::start(const std::string &filePath) {
+  releaseUpload();
+  if (!limitsKnown_) {
+    limits_ = TextureManager::queryLimits(settings_);
+    limitsKnown_ = true;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_.generation = ++latestGeneration_;
+    job_.path = filePath;
+    job_.limits = limits_;
+    hasJob_ = true;
+    hasResult_ = false;
+  }
+  jobReady_.notify_one();
+  active_ = true;
+  path_ = filePath;
+  frames_ = 0;
+}
+
+void TextureStreamer::cancel() {
+  releaseUpload();
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++latestGeneration_; // Whatever the worker is decoding is now stale.
+  hasJob_ = false;
+  hasResult_ = false;
+}
+
+TextureStreamer::Status TextureStreamer::pump(GLuint &textureID) {
+  if (!active_) {
+    return Status::IDLE;
+  }
+
+  if (texture_ == 0) {
+    Result result;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!hasResult_) {
+        return Status::BUSY; // Still decoding.
+      }
+      result = std::move(result_);
+      hasResult_ = false;
+    }
+    if (!result.ok) {
+      active_ = false;
+      return Status::FAILED;
+    }
+    data_ = std::move(result.data);
+    decodedMemory_ =
+        MemoryTracker::Allocation(MemoryTag::TEXTURES, data_.cpuBytes());
+    texture_ = TextureManager::createTexture(data_, settings_, false);
+    levelCount_ = TextureManager::uploadLevelCount(data_, settings_);
+    level_ = 0;
+    row_ = 0;
+  }
+
+  // Upload until this frame's budget is spent: whole compressed levels, or
+  // bands of whole rows.
+  ++frames_;
+  glBindTexture(GL_TEXTURE_2D, texture_);
+  size_t budget = uploadBytesPerFrame_;
+  while (level_ < levelCount_ && budget > 0) {
+    const GLint levelIndex = static_cast<GLint>(level_);
+    if (data_.isCompressed()) {
+      const CompressedLevel &level = data_.compressed.levels[level_];
+      const void *pixels = stage(level.data, level.size);
+      TextureManager::uploadCompressedLevel(
+          levelIndex, data_.compressed.format, level, pixels);
+      unstage();
+      budget -= std::min(budget, level.size);
+      ++level_;
+      continue;
+    }
+
+    const DecodedImage &level = data_.levels[level_];
+    size_t rowBytes = static_cast<size_t>(level.width) * level.channels;
+    int rows = static_cast<int>(std::min<size_t>(
+        std::max<size_t>(budget / rowBytes, 1), level.height - row_));
+    const void *pixels =
+        stage(level.pixels.data() + row_ * rowBytes, rows * rowBytes);
+    TextureManager::uploadRows(levelIndex, level, row_, rows, pixels);
+    unstage();
+    budget -= std::min(budget, rows * rowBytes);
+    row_ += rows;
+    if (row_ >= level.height) {
+      ++level_;
+      row_ = 0;
+    }
+  }
+  if (level_ < levelCount_) {
+    return Status::BUSY;
+  }
+
+  TextureManager::finishTexture(texture_, data_, settings_);
+  std::cout << "Streamed texture: " << path_ << " (Width: " << data_.width()
+            << ", Height: " << data_.height() << ", ";
+  if (data_.isCompressed()) {
+    std::cout << TextureManager::blockFormatName(data_.compressed.format);
+  } else {
+    std::cout << data_.levels[0].channels * 8 << "-bit";
+  }
+  std::cout << ", mipmaps: "
+            << TextureManager::mipmapModeName(settings_.mipmaps) << ", "
+            << frames_ << " frame(s), Texture ID: " << texture_ << ")\n";
+
+  textureID = std::exchange(texture_, 0);
+  data_ = TextureData();
+  decodedMemory_ = MemoryTracker::Allocation();
+  active_ = false;
+  return Status::DONE;
+}
+
+const void *TextureStreamer::stage(const unsigned char *src, size_t bytes) {
+  if (!hasPixelBuffers()) {
+    return src;
+  }
+  if (pixelBuffer_ == 0) {
+    glGenBuffers(1, &pixelBuffer_);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer_);
+  // Orphan the previous upload's storage so mapping never waits for the GPU
+  // to finish reading it.
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  void *mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+  if (mapped) {
+    std::memcpy(mapped, src, bytes);
+    if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE) {
+      return nullptr; // Offset 0 into the bound buffer.
+    }
+  }
+  // The mapping failed or was lost: upload from client memory instead.
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  return src;
+}
+
+void TextureStreamer::unstage() {
+  if (pixelBuffer_ != 0) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+}
+
+void TextureStreamer::releaseUpload() {
+  if (texture_ != 0) {
+    TextureManager::deleteTexture(texture_);
+    texture_ = 0;
+  }
+  data_ = TextureData();
+  decodedMemory_ = MemoryTracker::Allocation();
+  active_ = false;
+}
+
+void TextureStreamer::workerLoop() {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobReady_.wait(lock, [this] { return stopping_ || hasJob_; });
+      if (stopping_) {
+        return;
+      }
+      job = std::move(job_);
+      hasJob_ = false;
+    }
+
+    Result result;
+    result.ok = TextureManager::decodeTexture(job.path, settings_,
+                                              job.limits, result.data);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (job.generation == latestGeneration_) {
+      result_ = std::move(result);
+      hasResult_ = true;
+    }
+  }
+}
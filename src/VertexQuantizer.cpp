@@ -0,0 +1,205 @@
+#include "VertexQuantizer.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kCornersPerChunk = 65536;
+
+// Largest magnitude of a quantized 16-bit value; symmetric around zero.
+constexpr float kShortRange = 32767.0f;
+
+// GL maps signed bytes c to c / 127 for normalized attributes.
+constexpr float kByteRange = 127.0f;
+
+/**
+ * @brief Center and step of a 16-bit encoding of [lo, hi]: value =
+ * center + q * step for q in [-32767, 32767].
+ */
+struct Encoding {
+  float center = 0.0f;
+  float step = 1.0f;
+
+  Encoding(float lo, float hi) {
+    if (lo > hi) {
+      return; // No values
+    }
+    center = (lo + hi) * 0.5f;
+    const float half = (hi - lo) * 0.5f;
+    step = half > 0.0f ? half / kShortRange : 1.0f;
+  }
+
+  int16_t encode(float value) const {
+    float q = std::round((value - center) / step);
+    return static_cast<int16_t>(std::clamp(q, -kShortRange, kShortRange));
+  }
+
+  float decode(int16_t q) const { return center + q * step; }
+};
+
+/**
+ * @brief Per-component range of an interleaved float array.
+ */
+template <size_t N>
+void componentRange(const std::vector<float> &values, float (&lo)[N],
+                    float (&hi)[N]) {
+  const size_t count = values.size() / N;
+  const size_t chunks = Parallel::chunkCount(count, kCornersPerChunk);
+  std::vector<float> chunkLo(chunks * N, FLT_MAX);
+  std::vector<float> chunkHi(chunks * N, -FLT_MAX);
+  Parallel::forChunks(count, kCornersPerChunk, [&](size_t chunk, size_t begin,
+                                                   size_t end) {
+    float *l = &chunkLo[chunk * N];
+    float *h = &chunkHi[chunk * N];
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t c = 0; c < N; ++c) {
+        l[c] = std::min(l[c], values[i * N + c]);
+        h[c] = std::max(h[c], values[i * N + c]);
+      }
+    }
+  });
+  for (size_t c = 0; c < N; ++c) {
+    lo[c] = FLT_MAX;
+    hi[c] = -FLT_MAX;
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+      lo[c] = std::min(lo[c], chunkLo[chunk * N + c]);
+      hi[c] = std::max(hi[c], chunkHi[chunk * N + c]);
+    }
+  }
+}
+
+/**
+ * @brief Largest error found by each chunk of the encoding pass.
+ */
+struct ChunkErrors {
+  float position = 0.0f;
+  float normalCos = 1.0f; ///< Smallest cosine between original and decoded.
+  float texCoord = 0.0f;
+};
+
+} // end anonymous namespace
+
+bool VertexQuantizer::shouldQuantize(QuantizeMode mode, size_t corners) {
+  switch (mode) {
+  case QuantizeMode::ON:
+    return corners > 0;
+  case QuantizeMode::AUTO:
+    return corners >= kAutoMinCorners;
+  default:
+    return false;
+  }
+}
+
+void VertexQuantizer::quantize(DrawBatches &batches) {
+  const size_t corners = batches.cornerCount();
+  if (corners == 0 || batches.positions.size() != corners * 3) {
+    return; // Empty, or already quantized
+  }
+  auto start = std::chrono::steady_clock::now();
+
+  float positionLo[3], positionHi[3], uvLo[2], uvHi[2];
+  componentRange(batches.positions, positionLo, positionHi);
+  componentRange(batches.texCoords, uvLo, uvHi);
+  const Encoding position[3] = {{positionLo[0], positionHi[0]},
+                                {positionLo[1], positionHi[1]},
+                                {positionLo[2], positionHi[2]}};
+  const Encoding uv[2] = {{uvLo[0], uvHi[0]}, {uvLo[1], uvHi[1]}};
+
+  QuantizedVertices &out = batches.quantized;
+  out.positions.resize(corners * 4);
+  out.normals.resize(corners * 4);
+  out.texCoords.resize(corners * 2);
+  out.floatBytes = (batches.positions.size() + batches.normals.size() +
+                    batches.texCoords.size()) *
+                   sizeof(float);
+
+  std::vector<ChunkErrors> errors(
+      Parallel::chunkCount(corners, kCornersPerChunk));
+  Parallel::forChunks(corners, kCornersPerChunk, [&](size_t chunk,
+                                                     size_t begin,
+                                                     size_t end) {
+    ChunkErrors &error = errors[chunk];
+    for (size_t i = begin; i < end; ++i) {
+      const float *p = &batches.positions[i * 3];
+      int16_t *qp = &out.positions[i * 4];
+      float distance2 = 0.0f;
+      for (size_t c = 0; c < 3; ++c) {
+        qp[c] = position[c].encode(p[c]);
+        float d = position[c].decode(qp[c]) - p[c];
+        distance2 += d * d;
+      }
+      qp[3] = 0;
+      error.position = std::max(error.position, std::sqrt(distance2));
+
+      const float *n = &batches.normals[i * 3];
+      int8_t *qn = &out.normals[i * 4];
+      float dot = 0.0f, decodedLength2 = 0.0f;
+      for (size_t c = 0; c < 3; ++c) {
+        float q = std::round(n[c] * kByteRange);
+        qn[c] = static_cast<int8_t>(std::clamp(q, -kByteRange, kByteRange));
+        float decoded = qn[c] / kByteRange;
+        dot += decoded * n[c];
+        decodedLength2 += decoded * decoded;
+      }
+      qn[3] = 0;
+      const float length2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+      if (length2 > 0.0f && decodedLength2 > 0.0f) {
+        error.normalCos = std::min(
+            error.normalCos, dot / std::sqrt(length2 * decodedLength2));
+      }
+
+      const float *t = &batches.texCoords[i * 2];
+      int16_t *qt = &out.texCoords[i * 2];
+      for (size_t c = 0; c < 2; ++c) {
+        qt[c] = uv[c].encode(t[c]);
+        error.texCoord =
+            std::max(error.texCoord, std::fabs(uv[c].decode(qt[c]) - t[c]));
+      }
+    }
+  });
+
+  float normalCos = 1.0f;
+  for (const ChunkErrors &error : errors) {
+    out.maxPositionError = std::max(out.maxPositionError, error.position);
+    out.maxTexCoordError = std::max(out.maxTexCoordError, error.texCoord);
+    normalCos = std::min(normalCos, error.normalCos);
+  }
+  out.maxNormalError = std::acos(std::clamp(normalCos, -1.0f, 1.0f)) *
+                       (180.0f / 3.14159265358979323846f);
+
+  // Decoding is a per-axis scale and offset: position = center + q * step.
+  out.positionDecode = Matrix4();
+  out.texCoordDecode = Matrix4();
+  for (size_t c = 0; c < 3; ++c) {
+    out.positionDecode.m[c * 5] = position[c].step;
+    out.positionDecode.m[12 + c] = position[c].center;
+  }
+  for (size_t c = 0; c < 2; ++c) {
+    out.texCoordDecode.m[c * 5] = uv[c].step;
+    out.texCoordDecode.m[12 + c] = uv[c].center;
+  }
+
+  std::vector<float>().swap(batches.positions);
+  std::vector<float>().swap(batches.normals);
+  std::vector<float>().swap(batches.texCoords);
+
+  float extent = 0.0f;
+  for (size_t c = 0; c < 3; ++c) {
+    extent = std::max(extent, positionHi[c] - positionLo[c]);
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Quantized " << corners << " corners: "
+            << out.floatBytes / (1024.0 * 1024.0) << " -> "
+            << out.memoryBytes() / (1024.0 * 1024.0)
+            << " MiB; max error position " << out.maxPositionError << " ("
+            << (extent > 0.0f ? out.maxPositionError / extent * 100.0f : 0.0f)
+            << "% of size), normal " << out.maxNormalError << " deg, uv "
+            << out.maxTexCoordError << " in " << elapsed << " ms\n";
+}
@@ -0,0 +1,202 @@
+#include "VertexWelder.hpp"
+#include "ModelUtils.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kVerticesPerChunk = 16384;
+constexpr size_t kFacesPerChunk = 16384;
+
+struct CellCoord {
+  int64_t x, y, z;
+};
+
+/**
+ * @brief Mixes three cell coordinates into a bucket hash.
+ */
+uint64_t hashCell(int64_t x, int64_t y, int64_t z) {
+  uint64_t h = static_cast<uint64_t>(x) * 0x9E3779B185EBCA87ull;
+  h ^= static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full;
+  h ^= static_cast<uint64_t>(z) * 0x165667B19E3779F9ull;
+  return h ^ (h >> 29);
+}
+
+size_t nextPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // end anonymous namespace
+
+size_t VertexWelder::weld(OBJModel &model, float epsilon) {
+  auto start = std::chrono::steady_clock::now();
+
+  const size_t vertexCount = model.vertices.size();
+  if (vertexCount < 2 || epsilon < 0.0f) {
+    return 0;
+  }
+
+  // 1. Cell size: epsilon, or a tiny fraction of the extent when only exact
+  //    duplicates are merged (any size works then; this keeps buckets small).
+  float extent = 0.0f;
+  {
+    Vertex lo = model.vertices[0], hi = model.vertices[0];
+    for (const Vertex &v : model.vertices) {
+      lo = {std::min(lo.x, v.x), std::min(lo.y, v.y), std::min(lo.z, v.z)};
+      hi = {std::max(hi.x, v.x), std::max(hi.y, v.y), std::max(hi.z, v.z)};
+    }
+    extent = std::max({hi.x - lo.x, hi.y - lo.y, hi.z - lo.z});
+  }
+  float cellSize = epsilon > 0.0f ? epsilon : extent * 1e-6f;
+  if (!(cellSize > 0.0f)) {
+    cellSize = 1.0f; // all vertices coincide
+  }
+  const float invCell = 1.0f / cellSize;
+  const float epsilonSq = epsilon * epsilon;
+
+  // 2. Spatial hash in CSR form: count per bucket, prefix sum, scatter.
+  const size_t bucketCount = nextPowerOfTwo(vertexCount * 2);
+  const uint64_t bucketMask = bucketCount - 1;
+  std::vector<CellCoord> cells(vertexCount);
+  std::vector<std::atomic<uint32_t>> bucketFill(bucketCount);
+
+  Parallel::forRange(vertexCount, kVerticesPerChunk,
+                     [&](size_t begin, size_t end) {
+                       for (size_t i = begin; i < end; ++i) {
+                         const Vertex &v = model.vertices[i];
+                         CellCoord c{
+                             static_cast<int64_t>(std::floor(v.x * invCell)),
+                             static_cast<int64_t>(std::floor(v.y * invCell)),
+                             static_cast<int64_t>(std::floor(v.z * invCell))};
+                         cells[i] = c;
+                         bucketFill[hashCell(c.x, c.y, c.z) & bucketMask]
+                             .fetch_add(1, std::memory_order_relaxed);
+                       }
+                     });
+
+  std::vector<uint32_t> bucketStart(bucketCount + 1, 0);
+  for (size_t b = 0; b < bucketCount; ++b) {
+    bucketStart[b + 1] =
+        bucketStart[b] + bucketFill[b].load(std::memory_order_relaxed);
+    bucketFill[b].store(bucketStart[b], std::memory_order_relaxed);
+  }
+
+  std::vector<uint32_t> bucketItems(vertexCount);
+  Parallel::forRange(vertexCount, kVerticesPerChunk,
+                     [&](size_t begin, size_t end) {
+                       for (size_t i = begin; i < end; ++i) {
+                         const CellCoord &c = cells[i];
+                         uint64_t b = hashCell(c.x, c.y, c.z) & bucketMask;
+                         bucketItems[bucketFill[b].fetch_add(
+                             1, std::memory_order_relaxed)] =
+                             static_cast<uint32_t>(i);
+                       }
+                     });
+
+  // 3. Representative = lowest index within epsilon in the 27 neighbouring
+  //    cells (hash collisions are rejected by the distance test).
+  std::vector<uint32_t> representative(vertexCount);
+  Parallel::forRange(vertexCount, kVerticesPerChunk, [&](size_t begin,
+                                                         size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Vertex &v = model.vertices[i];
+      const CellCoord &c = cells[i];
+      uint32_t best = static_cast<uint32_t>(i);
+      for (int64_t dz = -1; dz <= 1; ++dz) {
+        for (int64_t dy = -1; dy <= 1; ++dy) {
+          for (int64_t dx = -1; dx <= 1; ++dx) {
+            uint64_t b = hashCell(c.x + dx, c.y + dy, c.z + dz) & bucketMask;
+            for (uint32_t k = bucketStart[b]; k < bucketStart[b + 1]; ++k) {
+              uint32_t j = bucketItems[k];
+              if (j >= best) {
+                continue;
+              }
+              const Vertex &w = model.vertices[j];
+              float ex = w.x - v.x, ey = w.y - v.y, ez = w.z - v.z;
+              if (ex * ex + ey * ey + ez * ez <= epsilonSq) {
+                best = j;
+              }
+            }
+          }
+        }
+      }
+      representative[i] = best;
+    }
+  });
+
+  // 4. Collapse chains (representatives always point to lower indices, so
+  //    a forward pass sees final values) and compact the survivors.
+  std::vector<int> remap(vertexCount);
+  size_t kept = 0;
+  for (size_t i = 0; i < vertexCount; ++i) {
+    uint32_t r = representative[i];
+    if (r == i) {
+      remap[i] = static_cast<int>(kept);
+      model.vertices[kept++] = model.vertices[i];
+    } else {
+      remap[i] = remap[r];
+    }
+  }
+  model.vertices.resize(kept);
+  const size_t removed = vertexCount - kept;
+
+  // 5. Remap faces, removing corners that collapsed onto their predecessor.
+  std::vector<uint8_t> degenerate(model.faces.size(), 0);
+  Parallel::forRange(model.faces.size(), kFacesPerChunk, [&](size_t begin,
+                                                             size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      auto &corners = model.faces[f].vertices;
+      for (auto &fv : corners) {
+        if (fv.vertexIndex >= 0 &&
+            static_cast<size_t>(fv.vertexIndex) < vertexCount) {
+          fv.vertexIndex = remap[fv.vertexIndex];
+        }
+      }
+      if (removed > 0) {
+        auto last = std::unique(corners.begin(), corners.end(),
+                                [](const FaceVertex &a, const FaceVertex &b) {
+                                  return a.vertexIndex == b.vertexIndex;
+                                });
+        corners.erase(last, corners.end());
+        while (corners.size() > 1 &&
+               corners.front().vertexIndex == corners.back().vertexIndex) {
+          corners.pop_back();
+        }
+      }
+      degenerate[f] = removed > 0 && corners.size() < 3;
+    }
+  });
+
+  size_t keptFaces = 0;
+  for (size_t f = 0; f < model.faces.size(); ++f) {
+    if (!degenerate[f]) {
+      if (keptFaces != f) {
+        model.faces[keptFaces] = std::move(model.faces[f]);
+      }
+      ++keptFaces;
+    }
+  }
+  const size_t droppedFaces = model.faces.size() - keptFaces;
+  model.faces.resize(keptFaces);
+  if (droppedFaces > 0) {
+    ModelUtilities::updateSubmeshRanges(model);
+  }
+
+  auto elapsed = std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "Welded vertices (epsilon " << epsilon << "): removed "
+            << removed << " of " << vertexCount << ", dropped "
+            << droppedFaces << " degenerate faces in " << elapsed << " ms\n";
+  return removed;
+}
@@ -10,6 +10,20 @@ bool WindowManager::initializeGLFW() {
   return true;
 }
 
+bool WindowManager::initializeGLEW() {
+  // Core-profile and newer drivers don't always advertise every entry point
+  // GLEW checks by default.
+  glewExperimental = GL_TRUE;
+  GLenum status = glewInit();
+  if (status != GLEW_OK) {
+    std::cerr << "Failed to initialize GLEW: "
+              << reinterpret_cast<const char *>(glewGetErrorString(status))
+              << "\n";
+    return false;
+  }
+  return true;
+}
+
 GLFWwindow *WindowManager::createWindow(Window windowConfig) {
   int width = windowConfig.width;
   int height = windowConfig.height;
@@ -1,8 +1,13 @@
 #include "ArgumentParser.hpp"
+#include "Benchmarks.hpp"
+#include "PagedMesh.hpp"
 #include "Renderer.hpp"
 #include "Window.hpp"
 
+#include <cstdlib>
+#include <iostream>
 #include <memory>
+#include <string>
 
 /**
  * @brief Program entry point.
@@ -12,11 +17,29 @@
  * @return int Exit code.
  */
 int main(int argc, char **argv) {
-  OBJModel model;
+  // 0. Headless benchmark mode: scop --bench <suite>
+  if (argc == 3 && std::string(argv[1]) == "--bench") {
+    return Benchmarks::run(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  // 0b. Offline page build for out-of-core viewing:
+  //     scop --build-pages <model.obj> <model.scpg> [triangles per page]
+  if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--build-pages") {
+    long perPage = argc == 5 ? std::atol(argv[4])
+                             : static_cast<long>(PagedMesh::kDefaultTrianglesPerPage);
+    if (perPage <= 0) {
+      std::cerr << "Triangles per page must be positive.\n";
+      return EXIT_FAILURE;
+    }
+    return PagedMesh::build(argv[2], argv[3], static_cast<size_t>(perPage))
+               ? EXIT_SUCCESS
+               : EXIT_FAILURE;
+  }
+
   glutInit(&argc, argv);
 
-  // 1. Parse command-line arguments & load the model
-  Parser argumentParser(argc, argv, model);
+  // 1. Parse command-line arguments & load the models
+  Parser argumentParser(argc, argv);
   if (!argumentParser.getSuccess()) {
     return EXIT_FAILURE;
   }
@@ -33,18 +56,28 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;  // createWindow already prints error + terminates
   }
 
-  // 4. Make the context current AFTER the window has been created
+  // 4. Make the context current AFTER the window has been created, then load
+  //    the GL entry points for it
   glfwMakeContextCurrent(window);
+  if (!WindowManager::initializeGLEW()) {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return EXIT_FAILURE;
+  }
 
   // 5. Create a Renderer using this window
-  auto renderer = std::make_unique<Renderer>(window, kDefaultWidth, kDefaultHeight, model);
+  auto renderer = std::make_unique<Renderer>(window, kDefaultWidth, kDefaultHeight,
+                                             argumentParser.getScene(),
+                                             argumentParser.getOptions());
 
   // 6. Run the rendering / main loop
   renderer->run();
+  bool allocationCheckFailed = renderer->allocationCheckFailed();
+  renderer.reset();
 
   // 7. Clean up
   glfwDestroyWindow(window);
   glfwTerminate();
 
-  return EXIT_SUCCESS;
+  return allocationCheckFailed ? EXIT_FAILURE : EXIT_SUCCESS;
 }